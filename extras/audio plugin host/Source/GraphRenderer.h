@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-9 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_GRAPHRENDERER_JUCEHEADER__
+#define __JUCE_GRAPHRENDERER_JUCEHEADER__
+
+#include "FilterGraph.h"
+#include "InternalFilters.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/resource.h>
+#endif
+
+
+//==============================================================================
+/**
+    Renders a saved filter graph to a wav file without any audio hardware, and
+    prints some timing statistics.
+
+    This is run when the host is launched with a command line like:
+
+    --render mygraph.filtergraph output.wav [--seconds 60] [--rate 44100] [--block 512] [--channels 2]
+
+    The graph's audio input is fed with silence. The time taken by each call to
+    processBlock() is measured, so the results can be used to compare the performance
+    of the same session between different builds.
+*/
+class GraphRenderer
+{
+public:
+    GraphRenderer()
+        : numSeconds (10.0), sampleRate (44100.0), blockSize (512), numChannels (2)
+    {
+    }
+
+    /** Returns true if the command line asks for a render. */
+    static bool isRenderCommand (const String& commandLine)
+    {
+        return commandLine.trimStart().startsWith ("--render");
+    }
+
+    /** Parses the command line, does the render and prints the results.
+        Returns false (after printing an error) if something went wrong.
+    */
+    bool run (const String& commandLine)
+    {
+        if (! parseCommandLine (commandLine))
+        {
+            std::cout << "Usage: --render graphFile outputFile.wav [--seconds 10] [--rate 44100] [--block 512] [--channels 2]" << std::endl;
+            return false;
+        }
+
+        AudioPluginFormatManager formatManager;
+        formatManager.addDefaultFormats();
+        formatManager.addFormat (new InternalPluginFormat());
+
+        FilterGraph filterGraph (formatManager);
+        const Result loadResult (filterGraph.loadDocument (graphFile));
+
+        if (loadResult.failed())
+            return fail ("Couldn't load " + graphFile.getFullPathName() + ": " + loadResult.getErrorMessage());
+
+        outputFile.deleteFile();
+        ScopedPointer<FileOutputStream> outStream (outputFile.createOutputStream());
+
+        if (outStream == nullptr)
+            return fail ("Couldn't write to " + outputFile.getFullPathName());
+
+        WavAudioFormat wavFormat;
+        ScopedPointer<AudioFormatWriter> writer (wavFormat.createWriterFor (outStream, sampleRate, (unsigned int) numChannels,
+                                                                            24, StringPairArray(), 0));
+        if (writer == nullptr)
+            return fail ("Couldn't create a wav writer");
+
+        outStream.release();
+
+        std::cout << "Rendering " << graphFile.getFileName().toUTF8().getAddress()
+                  << " (" << filterGraph.getNumFilters() << " filters)" << std::endl;
+
+        return render (filterGraph.getGraph(), *writer);
+    }
+
+private:
+    //==============================================================================
+    File graphFile, outputFile;
+    double numSeconds, sampleRate;
+    int blockSize, numChannels;
+
+    bool parseCommandLine (const String& commandLine)
+    {
+        StringArray args;
+        args.addTokens (commandLine, true);
+        args.trim();
+        args.removeEmptyStrings();
+
+        for (int i = 0; i < args.size(); ++i)
+            args.set (i, args[i].unquoted());
+
+        const int renderIndex = args.indexOf ("--render");
+
+        if (renderIndex < 0 || renderIndex + 2 >= args.size())
+            return false;
+
+        const File cwd (File::getCurrentWorkingDirectory());
+        graphFile  = cwd.getChildFile (args [renderIndex + 1]);
+        outputFile = cwd.getChildFile (args [renderIndex + 2]);
+
+        for (int i = renderIndex + 3; i < args.size() - 1; i += 2)
+        {
+            const String option (args[i]), value (args[i + 1]);
+
+            if      (option == "--seconds")   numSeconds  = value.getDoubleValue();
+            else if (option == "--rate")      sampleRate  = value.getDoubleValue();
+            else if (option == "--block")     blockSize   = value.getIntValue();
+            else if (option == "--channels")  numChannels = value.getIntValue();
+            else return false;
+        }
+
+        return numSeconds > 0 && sampleRate > 0 && blockSize > 0 && numChannels > 0;
+    }
+
+    static bool fail (const String& message)
+    {
+        std::cout << "Error: " << message.toUTF8().getAddress() << std::endl;
+        return false;
+    }
+
+    bool render (AudioProcessorGraph& graph, AudioFormatWriter& writer)
+    {
+        graph.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+        graph.setNonRealtime (true);
+        graph.prepareToPlay (sampleRate, blockSize);
+
+        const int64 totalSamples = (int64) (numSeconds * sampleRate);
+        const int numBlocks = (int) ((totalSamples + blockSize - 1) / blockSize);
+
+        AudioSampleBuffer buffer (numChannels, blockSize);
+        MidiBuffer midi;
+        Array<double> blockTimes;
+        blockTimes.ensureStorageAllocated (numBlocks);
+
+        const int64 startTicks = Time::getHighResolutionTicks();
+
+        for (int64 pos = 0; pos < totalSamples; pos += blockSize)
+        {
+            const int numThisTime = (int) jmin ((int64) blockSize, totalSamples - pos);
+
+            buffer.clear();
+            midi.clear();
+
+            const int64 blockStart = Time::getHighResolutionTicks();
+            graph.processBlock (buffer, midi);
+            blockTimes.add (1000.0 * Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - blockStart));
+
+            writer.writeFromAudioSampleBuffer (buffer, 0, numThisTime);
+        }
+
+        const double totalTime = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+        graph.releaseResources();
+
+        printResults (blockTimes, totalSamples / sampleRate, totalTime);
+        return true;
+    }
+
+    void printResults (Array<double>& blockTimes, const double audioSeconds, const double renderSeconds) const
+    {
+        DefaultElementComparator<double> comparator;
+        blockTimes.sort (comparator);
+
+        const double blockDeadline = 1000.0 * blockSize / sampleRate;
+
+        std::cout << "Rendered " << audioSeconds << " seconds to " << outputFile.getFullPathName().toUTF8().getAddress() << std::endl
+                  << "Time taken:       " << renderSeconds << " seconds" << std::endl
+                  << "Realtime factor:  " << (renderSeconds > 0 ? audioSeconds / renderSeconds : 0.0) << "x" << std::endl
+                  << "Block size:       " << blockSize << " (" << blockDeadline << " ms)" << std::endl
+                  << "Block time (ms):  50% " << getPercentile (blockTimes, 50.0)
+                  << ", 90% " << getPercentile (blockTimes, 90.0)
+                  << ", 99% " << getPercentile (blockTimes, 99.0)
+                  << ", max " << getPercentile (blockTimes, 100.0) << std::endl;
+
+        const int64 peakMemory = getPeakMemoryUsage();
+
+        if (peakMemory > 0)
+            std::cout << "Peak memory:      " << File::descriptionOfSizeInBytes (peakMemory).toUTF8().getAddress() << std::endl;
+    }
+
+    static double getPercentile (const Array<double>& sortedValues, const double percent)
+    {
+        if (sortedValues.size() == 0)
+            return 0;
+
+        return sortedValues [jlimit (0, sortedValues.size() - 1,
+                                     (int) (percent * sortedValues.size() / 100.0))];
+    }
+
+    static int64 getPeakMemoryUsage()
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        struct rusage usage;
+
+        if (getrusage (RUSAGE_SELF, &usage) == 0)
+           #if JUCE_MAC
+            return (int64) usage.ru_maxrss;          // (bytes on OSX)
+           #else
+            return (int64) usage.ru_maxrss * 1024;   // (kilobytes on linux)
+           #endif
+       #endif
+
+        return 0;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (GraphRenderer)
+};
+
+
+#endif   // __JUCE_GRAPHRENDERER_JUCEHEADER__
@@ -26,6 +26,7 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainHostWindow.h"
 #include "InternalFilters.h"
+#include "GraphRenderer.h"
 
 #if ! (JUCE_PLUGINHOST_VST || JUCE_PLUGINHOST_AU)
  #error "If you're building the audio plugin host, you probably want to enable VST and/or AU support"
@@ -57,6 +58,18 @@ public:
         appProperties = new ApplicationProperties();
         appProperties->setStorageParameters (options);
 
+        if (GraphRenderer::isRenderCommand (commandLine))
+        {
+            // headless mode: render a graph file and quit without opening any windows
+            GraphRenderer renderer;
+
+            if (! renderer.run (commandLine))
+                setApplicationReturnValue (1);
+
+            quit();
+            return;
+        }
+
         commandManager = new ApplicationCommandManager();
 
         mainWindow = new MainHostWindow();
@@ -0,0 +1,360 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+AudioBlock::AudioBlock() noexcept
+    : channels (nullptr), numChannels (0), startSample (0), numSamples (0)
+{
+}
+
+AudioBlock::AudioBlock (float* const* const channelData,
+                        const int numChannels_,
+                        const int startSample_,
+                        const int numSamples_) noexcept
+    : channels (channelData),
+      numChannels (numChannels_),
+      startSample (startSample_),
+      numSamples (numSamples_)
+{
+    jassert (channelData != nullptr || numChannels_ == 0);
+    jassert (numChannels_ >= 0 && startSample_ >= 0 && numSamples_ >= 0);
+}
+
+AudioBlock::AudioBlock (AudioSampleBuffer& buffer) noexcept
+    : channels (buffer.getArrayOfChannels()),
+      numChannels (buffer.getNumChannels()),
+      startSample (0),
+      numSamples (buffer.getNumSamples())
+{
+}
+
+AudioBlock::AudioBlock (AudioSampleBuffer& buffer,
+                        const int startSample_,
+                        const int numSamples_) noexcept
+    : channels (buffer.getArrayOfChannels()),
+      numChannels (buffer.getNumChannels()),
+      startSample (startSample_),
+      numSamples (numSamples_)
+{
+    jassert (startSample_ >= 0 && numSamples_ >= 0 && startSample_ + numSamples_ <= buffer.getNumSamples());
+}
+
+//==============================================================================
+AudioBlock AudioBlock::getSubBlock (const int startSampleInBlock, const int numSamplesToUse) const noexcept
+{
+    jassert (startSampleInBlock >= 0 && numSamplesToUse >= 0 && startSampleInBlock + numSamplesToUse <= numSamples);
+    return AudioBlock (channels, numChannels, startSample + startSampleInBlock, numSamplesToUse);
+}
+
+AudioBlock AudioBlock::getSubsetChannelBlock (const int firstChannel, const int numChannelsToUse) const noexcept
+{
+    jassert (firstChannel >= 0 && numChannelsToUse >= 0 && firstChannel + numChannelsToUse <= numChannels);
+    return AudioBlock (channels + firstChannel, numChannelsToUse, startSample, numSamples);
+}
+
+AudioBlock AudioBlock::getSingleChannelBlock (const int channel) const noexcept
+{
+    return getSubsetChannelBlock (channel, 1);
+}
+
+//==============================================================================
+void AudioBlock::clear() const noexcept
+{
+    for (int i = 0; i < numChannels; ++i)
+        zeromem (getChannelPointer (i), sizeof (float) * (size_t) numSamples);
+}
+
+void AudioBlock::applyGain (const float gain) const noexcept
+{
+    if (gain == 0.0f)
+    {
+        clear();
+    }
+    else if (gain != 1.0f)
+    {
+        for (int i = 0; i < numChannels; ++i)
+        {
+            float* d = getChannelPointer (i);
+
+            for (int j = numSamples; --j >= 0;)
+                *d++ *= gain;
+        }
+    }
+}
+
+void AudioBlock::applyGainRamp (const float startGain, const float endGain) const noexcept
+{
+    if (startGain == endGain)
+    {
+        applyGain (startGain);
+    }
+    else if (numSamples > 0)
+    {
+        const float increment = (endGain - startGain) / numSamples;
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            float* d = getChannelPointer (i);
+            float gain = startGain;
+
+            for (int j = numSamples; --j >= 0;)
+            {
+                *d++ *= gain;
+                gain += increment;
+            }
+        }
+    }
+}
+
+void AudioBlock::copyFrom (const AudioBlock& source) const noexcept
+{
+    jassert (source.numSamples == numSamples);
+
+    const int numChans = jmin (numChannels, source.numChannels);
+    const int num = jmin (numSamples, source.numSamples);
+
+    for (int i = 0; i < numChans; ++i)
+        memmove (getChannelPointer (i), source.getChannelPointer (i), sizeof (float) * (size_t) num);
+}
+
+void AudioBlock::addFrom (const AudioBlock& source, const float gain) const noexcept
+{
+    jassert (source.numSamples == numSamples);
+
+    if (gain != 0.0f)
+    {
+        const int numChans = jmin (numChannels, source.numChannels);
+        const int num = jmin (numSamples, source.numSamples);
+
+        for (int i = 0; i < numChans; ++i)
+        {
+            float* d = getChannelPointer (i);
+            const float* s = source.getChannelPointer (i);
+
+            if (gain != 1.0f)
+            {
+                for (int j = num; --j >= 0;)
+                    *d++ += gain * *s++;
+            }
+            else
+            {
+                for (int j = num; --j >= 0;)
+                    *d++ += *s++;
+            }
+        }
+    }
+}
+
+void AudioBlock::addFromWithRamp (const AudioBlock& source, const float startGain, const float endGain) const noexcept
+{
+    jassert (source.numSamples == numSamples);
+
+    if (startGain == endGain)
+    {
+        addFrom (source, startGain);
+    }
+    else
+    {
+        const int numChans = jmin (numChannels, source.numChannels);
+        const int num = jmin (numSamples, source.numSamples);
+        const float increment = (endGain - startGain) / num;
+
+        for (int i = 0; i < numChans; ++i)
+        {
+            float* d = getChannelPointer (i);
+            const float* s = source.getChannelPointer (i);
+            float gain = startGain;
+
+            for (int j = num; --j >= 0;)
+            {
+                *d++ += gain * *s++;
+                gain += increment;
+            }
+        }
+    }
+}
+
+//==============================================================================
+float AudioBlock::getMagnitude (const int channel) const noexcept
+{
+    if (numSamples <= 0)
+        return 0.0f;
+
+    float mn, mx;
+    findMinAndMax (getChannelPointer (channel), numSamples, mn, mx);
+    return jmax (mn, -mn, mx, -mx);
+}
+
+float AudioBlock::getMagnitude() const noexcept
+{
+    float mag = 0.0f;
+
+    for (int i = 0; i < numChannels; ++i)
+        mag = jmax (mag, getMagnitude (i));
+
+    return mag;
+}
+
+float AudioBlock::getRMSLevel (const int channel) const noexcept
+{
+    if (numSamples <= 0)
+        return 0.0f;
+
+    const float* const data = getChannelPointer (channel);
+    double sum = 0.0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float sample = data [i];
+        sum += sample * sample;
+    }
+
+    return (float) std::sqrt (sum / numSamples);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioBlockTests  : public UnitTest
+{
+public:
+    AudioBlockTests() : UnitTest ("AudioBlock") {}
+
+    static bool isAligned (const AudioSampleBuffer& buffer)
+    {
+        for (int i = 0; i < buffer.getNumChannels(); ++i)
+            if ((reinterpret_cast <pointer_sized_int> (buffer.getSampleData (i)) & 31) != 0)
+                return false;
+
+        return true;
+    }
+
+    void runTest()
+    {
+        beginTest ("Buffer alignment");
+
+        AudioSampleBuffer buffer (3, 101);
+        expect (isAligned (buffer));
+
+        buffer.setSize (5, 77, true, true, false);
+        expect (isAligned (buffer));
+
+        buffer.setSize (2, 13, false, false, true);
+        expect (isAligned (buffer));
+
+        beginTest ("Sub-blocks");
+
+        buffer.setSize (2, 100);
+        buffer.clear();
+
+        AudioSampleBuffer source (1, 10);
+
+        for (int i = 0; i < 10; ++i)
+            source.getSampleData (0)[i] = 1.0f;
+
+        const AudioBlock block (buffer);
+        const AudioBlock middle (block.getSubBlock (40, 20).getSingleChannelBlock (1));
+        expectEquals (middle.getNumChannels(), 1);
+        expectEquals (middle.getNumSamples(), 20);
+        expect (middle.getChannelPointer (0) == buffer.getSampleData (1, 40));
+
+        middle.getSubBlock (5, 10).addFrom (AudioBlock (source), 0.5f);
+        expectEquals (buffer.getMagnitude (0, 0, 100), 0.0f);
+        expectEquals (buffer.getMagnitude (1, 40, 5), 0.0f);
+        expectEquals (buffer.getMagnitude (1, 45, 10), 0.5f);
+        expectEquals (buffer.getMagnitude (1, 55, 45), 0.0f);
+        expectEquals (middle.getMagnitude(), 0.5f);
+
+        middle.applyGain (2.0f);
+        expectEquals (block.getMagnitude(), 1.0f);
+
+        middle.clear();
+        expectEquals (block.getMagnitude(), 0.0f);
+
+        beginTest ("Gain ramps");
+
+        for (int i = 0; i < 100; ++i)
+        {
+            *buffer.getSampleData (0, i) = 1.0f;
+            *buffer.getSampleData (1, i) = -2.0f;
+        }
+
+        block.getSubBlock (10, 4).applyGainRamp (0.0f, 1.0f);
+        expectEquals (*buffer.getSampleData (0, 9),  1.0f);
+        expectEquals (*buffer.getSampleData (0, 10), 0.0f);
+        expectEquals (*buffer.getSampleData (0, 11), 0.25f);
+        expectEquals (*buffer.getSampleData (0, 12), 0.5f);
+        expectEquals (*buffer.getSampleData (0, 13), 0.75f);
+        expectEquals (*buffer.getSampleData (0, 14), 1.0f);
+        expectEquals (*buffer.getSampleData (1, 13), -1.5f);
+
+        AudioSampleBuffer ramped (1, 4);
+        ramped.clear();
+
+        AudioBlock (ramped).addFromWithRamp (block.getSubsetChannelBlock (1, 1).getSubBlock (50, 4), 1.0f, 0.5f);
+        expectEquals (*ramped.getSampleData (0, 0), -2.0f);
+        expectEquals (*ramped.getSampleData (0, 1), -1.75f);
+        expectEquals (*ramped.getSampleData (0, 2), -1.5f);
+        expectEquals (*ramped.getSampleData (0, 3), -1.25f);
+
+        beginTest ("Copying");
+
+        // the channels that the blocks don't have in common are left alone
+        AudioSampleBuffer copy (3, 4);
+        copy.clear();
+
+        AudioBlock (copy).copyFrom (block.getSubBlock (50, 4));
+        expectEquals (copy.getMagnitude (0, 0, 4), 1.0f);
+        expectEquals (copy.getMagnitude (1, 0, 4), 2.0f);
+        expectEquals (copy.getMagnitude (2, 0, 4), 0.0f);
+        expectEquals (*copy.getSampleData (1, 3), -2.0f);
+
+        // overlapping regions of the same buffer
+        for (int i = 0; i < 100; ++i)
+            *buffer.getSampleData (0, i) = (float) i;
+
+        block.getSubsetChannelBlock (0, 1).getSubBlock (1, 50).copyFrom (block.getSubsetChannelBlock (0, 1).getSubBlock (0, 50));
+        expectEquals (*buffer.getSampleData (0, 0), 0.0f);
+        expectEquals (*buffer.getSampleData (0, 1), 0.0f);
+        expectEquals (*buffer.getSampleData (0, 50), 49.0f);
+        expectEquals (*buffer.getSampleData (0, 51), 51.0f);
+
+        beginTest ("RMS level");
+
+        for (int i = 0; i < 100; ++i)
+        {
+            *buffer.getSampleData (0, i) = (i & 1) != 0 ? 0.5f : -0.5f;
+            *buffer.getSampleData (1, i) = i < 50 ? 0.0f : 2.0f;
+        }
+
+        expectEquals (block.getRMSLevel (0), 0.5f);
+        expect (std::abs (block.getRMSLevel (1) - std::sqrt (2.0f)) < 1.0e-6f);
+        expectEquals (block.getSubBlock (50, 50).getRMSLevel (1), 2.0f);
+        expectEquals (block.getSubBlock (0, 0).getRMSLevel (0), 0.0f);
+    }
+};
+
+static AudioBlockTests audioBlockTests;
+
+#endif
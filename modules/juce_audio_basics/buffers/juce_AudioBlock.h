@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_AUDIOBLOCK_JUCEHEADER__
+#define __JUCE_AUDIOBLOCK_JUCEHEADER__
+
+#include "juce_AudioSampleBuffer.h"
+
+
+//==============================================================================
+/**
+    A lightweight view onto a region of some multi-channel audio data.
+
+    An AudioBlock doesn't own or allocate any memory - it just holds a pointer to an
+    array of channel pointers, plus a range of channels and samples within them. This
+    makes it cheap to create and pass around by value, and lets you work on a sub-range
+    of an AudioSampleBuffer (or on a subset of its channels) without having to build a
+    new buffer or copy any data.
+
+    The data that the block refers to must stay valid while the block is being used.
+    If you create a block from an AudioSampleBuffer, bear in mind that resizing the
+    buffer will invalidate the block.
+
+    The methods that change the audio are const, because they modify the data that the
+    block refers to rather than the block itself. For the same reason, a block can only
+    be made from a non-const AudioSampleBuffer.
+
+    e.g. @code
+    void addToOutput (AudioSampleBuffer& output, AudioSampleBuffer& input, int offset, int num)
+    {
+        AudioBlock (output, offset, num)
+            .getSubsetChannelBlock (0, 2)
+            .addFrom (AudioBlock (input, 0, num).getSubsetChannelBlock (0, 2), 0.5f);
+    }
+    @endcode
+
+    @see AudioSampleBuffer, AudioSourceChannelInfo::getActiveBlock
+*/
+class JUCE_API  AudioBlock
+{
+public:
+    //==============================================================================
+    /** Creates an empty block, with no channels or samples. */
+    AudioBlock() noexcept;
+
+    /** Creates a block that refers to some channel data.
+
+        @param channelData      an array of pointers to the data for each channel. This array
+                                isn't copied, so it must remain valid while the block is in use
+        @param numChannels      the number of channels to use
+        @param startSample      the offset within each channel at which the block begins
+        @param numSamples       the number of samples in the block
+    */
+    AudioBlock (float* const* channelData,
+                int numChannels,
+                int startSample,
+                int numSamples) noexcept;
+
+    /** Creates a block that refers to the whole of a buffer. */
+    AudioBlock (AudioSampleBuffer& buffer) noexcept;
+
+    /** Creates a block that refers to a range of samples in all of a buffer's channels. */
+    AudioBlock (AudioSampleBuffer& buffer,
+                int startSample,
+                int numSamples) noexcept;
+
+    //==============================================================================
+    /** Returns the number of channels in the block. */
+    int getNumChannels() const noexcept                 { return numChannels; }
+
+    /** Returns the number of samples in the block. */
+    int getNumSamples() const noexcept                  { return numSamples; }
+
+    /** Returns a pointer to the first sample of one of the block's channels.
+        For speed, this doesn't check whether the channel number is out of range,
+        so be careful when using it!
+    */
+    float* getChannelPointer (const int channel) const noexcept
+    {
+        jassert (isPositiveAndBelow (channel, numChannels));
+        return channels [channel] + startSample;
+    }
+
+    //==============================================================================
+    /** Returns a block that refers to a range of samples within this one. */
+    AudioBlock getSubBlock (int startSampleInBlock, int numSamplesToUse) const noexcept;
+
+    /** Returns a block that refers to a range of this block's channels. */
+    AudioBlock getSubsetChannelBlock (int firstChannel, int numChannelsToUse) const noexcept;
+
+    /** Returns a block that refers to just one of this block's channels. */
+    AudioBlock getSingleChannelBlock (int channel) const noexcept;
+
+    //==============================================================================
+    /** Clears all the samples in the block. */
+    void clear() const noexcept;
+
+    /** Multiplies all the samples in the block by a gain. */
+    void applyGain (float gain) const noexcept;
+
+    /** Applies a gain that starts at startGain on the first sample and changes linearly
+        towards endGain.
+
+        Like AudioSampleBuffer::applyGainRamp(), the gain changes by
+        (endGain - startGain) / getNumSamples() for each sample, so the last sample gets
+        one step short of endGain. This means that a following block which starts its own
+        ramp at endGain carries on smoothly from this one.
+    */
+    void applyGainRamp (float startGain, float endGain) const noexcept;
+
+    /** Copies the samples from another block into this one.
+        The blocks must have the same number of samples. If they have different numbers
+        of channels, only the channels that they have in common are copied.
+    */
+    void copyFrom (const AudioBlock& source) const noexcept;
+
+    /** Adds the samples from another block to this one, with an optional gain.
+        The blocks must have the same number of samples. If they have different numbers
+        of channels, only the channels that they have in common are mixed.
+    */
+    void addFrom (const AudioBlock& source, float gainToApplyToSource = 1.0f) const noexcept;
+
+    /** Adds the samples from another block to this one, applying a gain that starts at
+        startGain and changes linearly towards endGain.
+        As with applyGainRamp(), the last sample's gain is one step short of endGain.
+        @see addFrom, applyGainRamp
+    */
+    void addFromWithRamp (const AudioBlock& source, float startGain, float endGain) const noexcept;
+
+    //==============================================================================
+    /** Finds the highest absolute sample value in one of the block's channels. */
+    float getMagnitude (int channel) const noexcept;
+
+    /** Finds the highest absolute sample value in all of the block's channels. */
+    float getMagnitude() const noexcept;
+
+    /** Returns the root mean squared level of one of the block's channels. */
+    float getRMSLevel (int channel) const noexcept;
+
+private:
+    //==============================================================================
+    float* const* channels;
+    int numChannels, startSample, numSamples;
+};
+
+
+#endif   // __JUCE_AUDIOBLOCK_JUCEHEADER__
@@ -23,6 +23,47 @@
   ==============================================================================
 */
 
+namespace AudioSampleBufferHelpers
+{
+    // The channels that a buffer allocates for itself each start on a boundary of this
+    // many bytes, and are padded to a multiple of it, so that SIMD code can use aligned
+    // loads and stores on whole blocks.
+    enum { channelAlignment = 32 };
+
+    inline int getChannelStride (const int numSamples) noexcept
+    {
+        const int samplesPerBoundary = channelAlignment / (int) sizeof (float);
+        return (numSamples + samplesPerBoundary - 1) & ~(samplesPerBoundary - 1);
+    }
+
+    inline size_t getNumBytesNeeded (const int numChannels, const int numSamples) noexcept
+    {
+        return sizeof (float*) * (size_t) (numChannels + 1)
+                + sizeof (float) * (size_t) numChannels * (size_t) getChannelStride (numSamples)
+                + channelAlignment;
+    }
+
+    // Lays out the channel list and the aligned channel data inside a block of memory that
+    // is at least getNumBytesNeeded() bytes long
+    float** setChannelPointers (char* const data, const int numChannels, const int numSamples) noexcept
+    {
+        float** const channels = reinterpret_cast <float**> (data);
+        const pointer_sized_int channelData = reinterpret_cast <pointer_sized_int> (data + sizeof (float*) * (size_t) (numChannels + 1));
+        float* chan = reinterpret_cast <float*> ((channelData + channelAlignment - 1) & ~(pointer_sized_int) (channelAlignment - 1));
+        const int stride = getChannelStride (numSamples);
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            channels[i] = chan;
+            chan += stride;
+        }
+
+        channels [numChannels] = 0;
+        return channels;
+    }
+}
+
+//==============================================================================
 AudioSampleBuffer::AudioSampleBuffer (const int numChannels_,
                                       const int numSamples) noexcept
   : numChannels (numChannels_),
@@ -47,19 +88,9 @@ AudioSampleBuffer::AudioSampleBuffer (const AudioSampleBuffer& other) noexcept
 
 void AudioSampleBuffer::allocateData()
 {
-    const size_t channelListSize = sizeof (float*) * (size_t) (numChannels + 1);
-    allocatedBytes = (size_t) numChannels * (size_t) size * sizeof (float) + channelListSize + 32;
+    allocatedBytes = AudioSampleBufferHelpers::getNumBytesNeeded (numChannels, size);
     allocatedData.malloc (allocatedBytes);
-    channels = reinterpret_cast <float**> (allocatedData.getData());
-
-    float* chan = (float*) (allocatedData + channelListSize);
-    for (int i = 0; i < numChannels; ++i)
-    {
-        channels[i] = chan;
-        chan += size;
-    }
-
-    channels [numChannels] = 0;
+    channels = AudioSampleBufferHelpers::setChannelPointers (allocatedData, numChannels, size);
 }
 
 AudioSampleBuffer::AudioSampleBuffer (float* const* dataToReferTo,
@@ -154,8 +185,7 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
 
     if (newNumSamples != size || newNumChannels != numChannels)
     {
-        const size_t channelListSize = sizeof (float*) * (size_t) (newNumChannels + 1);
-        const size_t newTotalBytes = ((size_t) newNumChannels * (size_t) newNumSamples * sizeof (float)) + channelListSize + 32;
+        const size_t newTotalBytes = AudioSampleBufferHelpers::getNumBytesNeeded (newNumChannels, newNumSamples);
 
         if (keepExistingContent)
         {
@@ -164,14 +194,7 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
 
             const size_t numBytesToCopy = sizeof (float) * (size_t) jmin (newNumSamples, size);
 
-            float** const newChannels = reinterpret_cast <float**> (newData.getData());
-            float* newChan = reinterpret_cast <float*> (newData + channelListSize);
-
-            for (int j = 0; j < newNumChannels; ++j)
-            {
-                newChannels[j] = newChan;
-                newChan += newNumSamples;
-            }
+            float** const newChannels = AudioSampleBufferHelpers::setChannelPointers (newData, newNumChannels, newNumSamples);
 
             const int numChansToCopy = jmin (numChannels, newNumChannels);
             for (int i = 0; i < numChansToCopy; ++i)
@@ -192,18 +215,11 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
             {
                 allocatedBytes = newTotalBytes;
                 allocatedData.allocate (newTotalBytes, clearExtraSpace);
-                channels = reinterpret_cast <float**> (allocatedData.getData());
             }
 
-            float* chan = reinterpret_cast <float*> (allocatedData + channelListSize);
-            for (int i = 0; i < newNumChannels; ++i)
-            {
-                channels[i] = chan;
-                chan += newNumSamples;
-            }
+            channels = AudioSampleBufferHelpers::setChannelPointers (allocatedData, newNumChannels, newNumSamples);
         }
 
-        channels [newNumChannels] = 0;
         size = newNumSamples;
         numChannels = newNumChannels;
     }
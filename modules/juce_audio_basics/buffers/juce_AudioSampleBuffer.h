@@ -31,6 +31,14 @@
 /**
     A multi-channel buffer of 32-bit floating point audio samples.
 
+    When the buffer allocates its own memory, each channel's data starts on a 32-byte
+    boundary and is padded out to a multiple of 32 bytes, so it's safe to use aligned
+    SIMD loads and stores on it. Buffers that refer to external data (and sub-ranges
+    of channels) make no such guarantee.
+
+    To work on part of a buffer without copying it, use an AudioBlock.
+
+    @see AudioBlock
 */
 class JUCE_API  AudioSampleBuffer
 {
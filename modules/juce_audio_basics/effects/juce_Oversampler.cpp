@@ -0,0 +1,375 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+namespace OversamplerHelpers
+{
+    static float dotProduct (const float* a, const float* b, int num) noexcept
+    {
+        float total = 0;
+
+       #if JUCE_USE_SSE2_INTRINSICS
+        __m128 sum = _mm_setzero_ps();
+
+        for (; num >= 4; num -= 4)
+        {
+            sum = _mm_add_ps (sum, _mm_mul_ps (_mm_loadu_ps (a), _mm_loadu_ps (b)));
+            a += 4;
+            b += 4;
+        }
+
+        float sums[4];
+        _mm_storeu_ps (sums, sum);
+        total = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+       #elif JUCE_USE_ARM_NEON
+        float32x4_t sum = vdupq_n_f32 (0);
+
+        for (; num >= 4; num -= 4)
+        {
+            sum = vmlaq_f32 (sum, vld1q_f32 (a), vld1q_f32 (b));
+            a += 4;
+            b += 4;
+        }
+
+        float sums[4];
+        vst1q_f32 (sums, sum);
+        total = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+       #endif
+
+        while (--num >= 0)
+            total += *a++ * *b++;
+
+        return total;
+    }
+
+    static double besselI0 (const double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int i = 1; i < 50 && term > sum * 1.0e-12; ++i)
+        {
+            const double t = x / (2 * i);
+            term *= t * t;
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    /*  A half-band FIR has a centre tap of 0.5, and every other tap is zero, so only
+        the odd taps either side of the centre need to be stored. They're symmetrical,
+        so this fills in 2 * halfLength coefficients as (a[n-1] .. a[0], a[0] .. a[n-1]),
+        which is the polyphase branch that gets applied to a contiguous run of samples.
+        The taps are a Kaiser-windowed sinc, normalised for unity gain at DC.
+    */
+    static void designHalfBandFilter (float* const coefficients, const int halfLength)
+    {
+        const double beta = 8.0; // about 80dB of stop-band attenuation
+        HeapBlock<double> taps ((size_t) halfLength);
+        double sum = 0;
+
+        for (int i = 0; i < halfLength; ++i)
+        {
+            const int n = 2 * i + 1;
+            const double x = n / (2.0 * halfLength);
+            const double window = besselI0 (beta * std::sqrt (1.0 - x * x)) / besselI0 (beta);
+
+            taps[i] = ((i & 1) != 0 ? -1.0 : 1.0) / (double_Pi * n) * window;
+            sum += taps[i];
+        }
+
+        for (int i = 0; i < halfLength; ++i)
+        {
+            const float c = (float) (taps[i] * 0.25 / sum);
+            coefficients [halfLength - 1 - i] = c;
+            coefficients [halfLength + i] = c;
+        }
+    }
+}
+
+//==============================================================================
+/*  A 2x stage. The samples at the lower rate are copied onto the end of a history
+    buffer for each channel, so that every output sample is a dot-product of the
+    coefficients with a contiguous run of that buffer.
+
+    Upsampling: the samples that fall on the filter's centre tap are just the input
+    delayed, and the ones in between are the polyphase branch applied to the input.
+
+    Downsampling: the high-rate signal is split into its even and odd samples. Each
+    output is the branch applied to the even ones, plus half of the odd sample that
+    falls on the centre tap.
+*/
+class Oversampler::Stage
+{
+public:
+    Stage (const int numChannels, const int halfLength_, const int maxNumSamples)
+        : halfLength (halfLength_),
+          filterLength (2 * halfLength_),
+          historyLength (2 * halfLength_ - 1),
+          upHistory (numChannels, historyLength + maxNumSamples),
+          evenHistory (numChannels, historyLength + maxNumSamples),
+          oddHistory (numChannels, historyLength + maxNumSamples),
+          buffer (numChannels, maxNumSamples * 2)
+    {
+        coefficients.malloc ((size_t) filterLength);
+        upCoefficients.malloc ((size_t) filterLength);
+
+        OversamplerHelpers::designHalfBandFilter (coefficients, halfLength);
+
+        // the upsampler needs a gain of 2 to make up for the zeros it inserts
+        for (int i = 0; i < filterLength; ++i)
+            upCoefficients[i] = coefficients[i] * 2.0f;
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        upHistory.clear();
+        evenHistory.clear();
+        oddHistory.clear();
+        buffer.clear();
+    }
+
+    // The round-trip delay, in samples at the lower rate
+    int getLatency() const noexcept         { return historyLength; }
+
+    void processUp (const float* const source, float* const dest, const int channel, const int numSamples) noexcept
+    {
+        float* const history = upHistory.getSampleData (channel);
+        memcpy (history + historyLength, source, sizeof (float) * (size_t) numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dest [2 * i]     = OversamplerHelpers::dotProduct (upCoefficients, history + i, filterLength);
+            dest [2 * i + 1] = history [i + halfLength];
+        }
+
+        memmove (history, history + numSamples, sizeof (float) * (size_t) historyLength);
+    }
+
+    void processDown (const float* const source, float* const dest, const int channel, const int numSamples) noexcept
+    {
+        float* const even = evenHistory.getSampleData (channel);
+        float* const odd  = oddHistory.getSampleData (channel);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            even [historyLength + i] = source [2 * i];
+            odd  [historyLength + i] = source [2 * i + 1];
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = OversamplerHelpers::dotProduct (coefficients, even + i, filterLength)
+                        + 0.5f * odd [i + halfLength - 1];
+
+        memmove (even, even + numSamples, sizeof (float) * (size_t) historyLength);
+        memmove (odd,  odd  + numSamples, sizeof (float) * (size_t) historyLength);
+    }
+
+    const int halfLength, filterLength, historyLength;
+    HeapBlock<float> coefficients, upCoefficients;
+    AudioSampleBuffer upHistory, evenHistory, oddHistory;
+
+    // holds this stage's high-rate signal
+    AudioSampleBuffer buffer;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (Stage)
+};
+
+//==============================================================================
+Oversampler::Oversampler (const int numChannels_, const int factorLog2, const int maxBlockSize_)
+    : numChannels (jmax (1, numChannels_)),
+      maxBlockSize (jmax (1, maxBlockSize_)),
+      oversampledBlock (1, 1)
+{
+    jassert (factorLog2 >= 1 && factorLog2 <= 4);
+
+    const int numStages = jlimit (1, 4, factorLog2);
+
+    // The first stage has to cut off sharply at the original Nyquist frequency, but
+    // the later ones have much more room for their transition bands.
+    for (int i = 0; i < numStages; ++i)
+        stages.add (new Stage (numChannels, i == 0 ? 16 : 8, maxBlockSize << i));
+}
+
+Oversampler::~Oversampler()
+{
+}
+
+float Oversampler::getLatencyInSamples() const noexcept
+{
+    float latency = 0;
+
+    for (int i = 0; i < stages.size(); ++i)
+        latency += stages.getUnchecked(i)->getLatency() / (float) (1 << i);
+
+    return latency;
+}
+
+void Oversampler::reset() noexcept
+{
+    for (int i = stages.size(); --i >= 0;)
+        stages.getUnchecked(i)->reset();
+}
+
+//==============================================================================
+AudioSampleBuffer& Oversampler::processSamplesUp (const AudioSampleBuffer& source,
+                                                  const int startSample, const int numSamples) noexcept
+{
+    jassert (numSamples <= maxBlockSize);
+    jassert (source.getNumChannels() >= numChannels);
+
+    for (int chan = 0; chan < numChannels; ++chan)
+    {
+        const float* input = source.getSampleData (chan, startSample);
+        int num = numSamples;
+
+        for (int i = 0; i < stages.size(); ++i)
+        {
+            Stage& stage = *stages.getUnchecked(i);
+            float* const output = stage.buffer.getSampleData (chan);
+
+            stage.processUp (input, output, chan, num);
+            input = output;
+            num *= 2;
+        }
+    }
+
+    oversampledBlock.setDataToReferTo (stages.getLast()->buffer.getArrayOfChannels(),
+                                       numChannels, numSamples * getOversamplingFactor());
+    return oversampledBlock;
+}
+
+void Oversampler::processSamplesDown (AudioSampleBuffer& destination,
+                                      const int startSample, const int numSamples) noexcept
+{
+    jassert (numSamples <= maxBlockSize);
+    jassert (destination.getNumChannels() >= numChannels);
+
+    for (int chan = 0; chan < numChannels; ++chan)
+    {
+        int num = numSamples << (stages.size() - 1);
+
+        for (int i = stages.size(); --i >= 0;)
+        {
+            Stage& stage = *stages.getUnchecked(i);
+            float* const output = i > 0 ? stages.getUnchecked (i - 1)->buffer.getSampleData (chan)
+                                        : destination.getSampleData (chan, startSample);
+
+            stage.processDown (stage.buffer.getSampleData (chan), output, chan, num);
+            num /= 2;
+        }
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class OversamplerTests  : public UnitTest
+{
+public:
+    OversamplerTests() : UnitTest ("Oversampler") {}
+
+    static void fillWithSine (AudioSampleBuffer& buffer, const double cyclesPerSample, const int64 startPos)
+    {
+        for (int chan = 0; chan < buffer.getNumChannels(); ++chan)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                *buffer.getSampleData (chan, i) = (float) std::sin ((startPos + i) * cyclesPerSample * 2.0 * double_Pi);
+    }
+
+    void runTest()
+    {
+        beginTest ("Latency and pass-band");
+
+        for (int factorLog2 = 1; factorLog2 <= 4; ++factorLog2)
+        {
+            const int blockSize = 100;
+            const double cyclesPerSample = 1000.0 / 44100.0;
+            Oversampler oversampler (2, factorLog2, blockSize);
+            const double latency = oversampler.getLatencyInSamples();
+
+            AudioSampleBuffer buffer (2, blockSize);
+            double maxError = 0;
+
+            for (int block = 0; block < 20; ++block)
+            {
+                fillWithSine (buffer, cyclesPerSample, block * blockSize);
+
+                AudioSampleBuffer& up = oversampler.processSamplesUp (buffer, 0, blockSize);
+                expectEquals (up.getNumSamples(), blockSize << factorLog2);
+                oversampler.processSamplesDown (buffer, 0, blockSize);
+
+                if (block > 2)
+                {
+                    for (int i = 0; i < blockSize; ++i)
+                    {
+                        const double expected = std::sin ((block * blockSize + i - latency) * cyclesPerSample * 2.0 * double_Pi);
+                        maxError = jmax (maxError, std::abs (*buffer.getSampleData (1, i) - expected));
+                    }
+                }
+            }
+
+            expect (maxError < 0.001, "factor " + String (1 << factorLog2) + ": error " + String (maxError));
+        }
+
+        beginTest ("Performance");
+
+        const int channelCounts[] = { 1, 2, 8 };
+        const int blockSize = 512;
+        const int numBlocks = 44100 / blockSize;
+
+        for (int factorLog2 = 1; factorLog2 <= 4; ++factorLog2)
+        {
+            for (int i = 0; i < numElementsInArray (channelCounts); ++i)
+            {
+                const int numChannels = channelCounts[i];
+                Oversampler oversampler (numChannels, factorLog2, blockSize);
+                AudioSampleBuffer buffer (numChannels, blockSize);
+                fillWithSine (buffer, 0.01, 0);
+
+                const double startTime = Time::getMillisecondCounterHiRes();
+
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    oversampler.processSamplesUp (buffer, 0, blockSize);
+                    oversampler.processSamplesDown (buffer, 0, blockSize);
+                }
+
+                const double elapsed = Time::getMillisecondCounterHiRes() - startTime;
+                const double secondsOfAudio = numBlocks * blockSize / 44100.0;
+
+                logMessage (String (1 << factorLog2) + "x, " + String (numChannels) + " channels: "
+                             + String (100.0 * elapsed / (secondsOfAudio * 1000.0), 3)
+                             + "% of one core at 44.1kHz");
+            }
+        }
+    }
+};
+
+static OversamplerTests oversamplerTests;
+
+#endif
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_OVERSAMPLER_JUCEHEADER__
+#define __JUCE_OVERSAMPLER_JUCEHEADER__
+
+#include "../buffers/juce_AudioSampleBuffer.h"
+
+
+//==============================================================================
+/**
+    Upsamples a signal by 2, 4, 8 or 16 times, and then brings it back down again.
+
+    This is for wrapping processing such as saturation or compression, which would
+    otherwise create aliasing. You pass each block of input to processSamplesUp(),
+    process the oversampled buffer that it returns, and then call processSamplesDown()
+    to filter and decimate the result back to the original rate.
+
+    The rate is changed by a cascade of 2x stages. Each of them uses a linear-phase
+    half-band FIR filter, split into its polyphase branches so that the filtering is
+    done at the lower of the two rates. The first stage uses a longer filter than the
+    others, because the ones after it only need to remove images that lie far above
+    the original signal's bandwidth.
+
+    All the memory is allocated by the constructor, so the processing methods are safe
+    to call from the audio thread.
+
+    @code
+    Oversampler oversampler (2, 2, 512); // 4x oversampling for a stereo signal
+
+    void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)
+    {
+        AudioSampleBuffer& upsampled = oversampler.processSamplesUp (buffer, 0, buffer.getNumSamples());
+        applySaturation (upsampled);
+        oversampler.processSamplesDown (buffer, 0, buffer.getNumSamples());
+    }
+    @endcode
+
+    @see IIRFilter, ResamplingAudioSource
+*/
+class JUCE_API  Oversampler
+{
+public:
+    //==============================================================================
+    /** Creates an oversampler.
+
+        @param numChannels      the number of channels that will be processed
+        @param factorLog2       the number of 2x stages to use: 1 for 2x oversampling, 2 for
+                                4x, 3 for 8x or 4 for 16x
+        @param maxBlockSize     the largest number of samples (at the original rate) that
+                                will be passed to processSamplesUp() in one go
+    */
+    Oversampler (int numChannels, int factorLog2, int maxBlockSize);
+
+    /** Destructor. */
+    ~Oversampler();
+
+    //==============================================================================
+    /** Returns the oversampling factor, i.e. 2, 4, 8 or 16. */
+    int getOversamplingFactor() const noexcept                  { return 1 << stages.size(); }
+
+    /** Returns the delay, in samples at the original rate, that a signal passing up and
+        back down through the oversampler will have.
+
+        With more than two stages, this isn't a whole number of samples, so if you need to
+        report it to a host, you'll need to round it.
+    */
+    float getLatencyInSamples() const noexcept;
+
+    /** Clears the filters' internal state, ready to start a new stream of data. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Upsamples a block of audio.
+
+        @param source       the audio to upsample. It must have at least as many channels
+                            as the oversampler
+        @param startSample  the first sample in the source to use
+        @param numSamples   the number of samples to use - this mustn't be more than the
+                            maxBlockSize that was passed to the constructor
+        @returns a buffer containing numSamples * getOversamplingFactor() samples of the
+                 oversampled signal. This belongs to the oversampler, and you can process
+                 it in-place before passing it back with processSamplesDown()
+    */
+    AudioSampleBuffer& processSamplesUp (const AudioSampleBuffer& source,
+                                         int startSample, int numSamples) noexcept;
+
+    /** Filters and decimates the buffer that was returned by the last call to
+        processSamplesUp(), writing the result at the original rate into a buffer.
+
+        @param destination  the buffer to write into. It must have at least as many
+                            channels as the oversampler
+        @param startSample  the first sample in the destination to write to
+        @param numSamples   the number of samples to write - this must be the same as the
+                            number that was passed to processSamplesUp()
+    */
+    void processSamplesDown (AudioSampleBuffer& destination,
+                             int startSample, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    class Stage;
+    friend class OwnedArray <Stage>;
+
+    const int numChannels, maxBlockSize;
+    OwnedArray <Stage> stages;
+    AudioSampleBuffer oversampledBlock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Oversampler)
+};
+
+
+#endif   // __JUCE_OVERSAMPLER_JUCEHEADER__
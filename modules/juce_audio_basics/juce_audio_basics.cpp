@@ -38,17 +38,26 @@
 
 #include "juce_audio_basics.h"
 
+#if JUCE_USE_SSE2_INTRINSICS
+ #include <emmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
 namespace juce
 {
 
 // START_AUTOINCLUDE buffers/*.cpp, effects/*.cpp, midi/*.cpp, sources/*.cpp, synthesisers/*.cpp
+#include "buffers/juce_AudioBlock.cpp"
 #include "buffers/juce_AudioDataConverters.cpp"
 #include "buffers/juce_AudioSampleBuffer.cpp"
 #include "effects/juce_IIRFilter.cpp"
+#include "effects/juce_Oversampler.cpp"
 #include "midi/juce_MidiBuffer.cpp"
 #include "midi/juce_MidiFile.cpp"
 #include "midi/juce_MidiKeyboardState.cpp"
 #include "midi/juce_MidiMessage.cpp"
+#include "midi/juce_MidiMessageFifo.cpp"
 #include "midi/juce_MidiMessageSequence.cpp"
 #include "sources/juce_BufferingAudioSource.cpp"
 #include "sources/juce_ChannelRemappingAudioSource.cpp"
@@ -33,6 +33,9 @@ namespace juce
 {
 
 // START_AUTOINCLUDE buffers, effects, midi, sources, synthesisers
+#ifndef __JUCE_AUDIOBLOCK_JUCEHEADER__
+ #include "buffers/juce_AudioBlock.h"
+#endif
 #ifndef __JUCE_AUDIODATACONVERTERS_JUCEHEADER__
  #include "buffers/juce_AudioDataConverters.h"
 #endif
@@ -45,6 +48,9 @@ namespace juce
 #ifndef __JUCE_IIRFILTER_JUCEHEADER__
  #include "effects/juce_IIRFilter.h"
 #endif
+#ifndef __JUCE_OVERSAMPLER_JUCEHEADER__
+ #include "effects/juce_Oversampler.h"
+#endif
 #ifndef __JUCE_REVERB_JUCEHEADER__
  #include "effects/juce_Reverb.h"
 #endif
@@ -60,6 +66,9 @@ namespace juce
 #ifndef __JUCE_MIDIMESSAGE_JUCEHEADER__
  #include "midi/juce_MidiMessage.h"
 #endif
+#ifndef __JUCE_MIDIMESSAGEFIFO_JUCEHEADER__
+ #include "midi/juce_MidiMessageFifo.h"
+#endif
 #ifndef __JUCE_MIDIMESSAGESEQUENCE_JUCEHEADER__
  #include "midi/juce_MidiMessageSequence.h"
 #endif
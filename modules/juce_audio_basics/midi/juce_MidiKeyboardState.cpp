@@ -24,8 +24,10 @@
 */
 
 MidiKeyboardState::MidiKeyboardState()
+    : eventsToAdd (8192),
+      notificationsToSend (8192)
 {
-    zerostruct (noteStates);
+    pendingEvents.ensureSize (8192);
 }
 
 MidiKeyboardState::~MidiKeyboardState()
@@ -35,9 +37,12 @@ MidiKeyboardState::~MidiKeyboardState()
 //==============================================================================
 void MidiKeyboardState::reset()
 {
-    const ScopedLock sl (lock);
-    zerostruct (noteStates);
-    eventsToAdd.clear();
+    for (int i = 0; i < 128; ++i)
+        noteStates[i] = 0;
+
+    // any events that were queued before now are tagged with an older generation,
+    // so processNextMidiBuffer() will throw them away when it reads them
+    ++resetGeneration;
 }
 
 bool MidiKeyboardState::isNoteOn (const int midiChannel, const int n) const noexcept
@@ -45,72 +50,63 @@ bool MidiKeyboardState::isNoteOn (const int midiChannel, const int n) const noex
     jassert (midiChannel >= 0 && midiChannel <= 16);
 
     return isPositiveAndBelow (n, (int) 128)
-            && (noteStates[n] & (1 << (midiChannel - 1))) != 0;
+            && (noteStates[n].get() & (1 << (midiChannel - 1))) != 0;
 }
 
 bool MidiKeyboardState::isNoteOnForChannels (const int midiChannelMask, const int n) const noexcept
 {
     return isPositiveAndBelow (n, (int) 128)
-            && (noteStates[n] & midiChannelMask) != 0;
+            && (noteStates[n].get() & midiChannelMask) != 0;
 }
 
-void MidiKeyboardState::noteOn (const int midiChannel, const int midiNoteNumber, const float velocity)
+bool MidiKeyboardState::setNoteState (const int midiChannel, const int midiNoteNumber, const bool isOn) noexcept
 {
-    jassert (midiChannel >= 0 && midiChannel <= 16);
-    jassert (isPositiveAndBelow (midiNoteNumber, (int) 128));
-
-    const ScopedLock sl (lock);
+    const int bit = 1 << (midiChannel - 1);
 
-    if (isPositiveAndBelow (midiNoteNumber, (int) 128))
+    for (;;)
     {
-        const int timeNow = (int) Time::getMillisecondCounter();
-        eventsToAdd.addEvent (MidiMessage::noteOn (midiChannel, midiNoteNumber, velocity), timeNow);
-        eventsToAdd.clear (0, timeNow - 500);
+        const int oldState = noteStates [midiNoteNumber].get();
+        const int newState = isOn ? (oldState | bit) : (oldState & ~bit);
 
-        noteOnInternal (midiChannel, midiNoteNumber, velocity);
-    }
-}
+        if (newState == oldState)
+            return false;
 
-void MidiKeyboardState::noteOnInternal  (const int midiChannel, const int midiNoteNumber, const float velocity)
-{
-    if (isPositiveAndBelow (midiNoteNumber, (int) 128))
-    {
-        noteStates [midiNoteNumber] |= (1 << (midiChannel - 1));
-
-        for (int i = listeners.size(); --i >= 0;)
-            listeners.getUnchecked(i)->handleNoteOn (this, midiChannel, midiNoteNumber, velocity);
+        if (noteStates [midiNoteNumber].compareAndSetBool (newState, oldState))
+            return true;
     }
 }
 
-void MidiKeyboardState::noteOff (const int midiChannel, const int midiNoteNumber)
+void MidiKeyboardState::noteOn (const int midiChannel, const int midiNoteNumber, const float velocity)
 {
-    const ScopedLock sl (lock);
+    jassert (midiChannel >= 0 && midiChannel <= 16);
+    jassert (isPositiveAndBelow (midiNoteNumber, (int) 128));
 
-    if (isNoteOn (midiChannel, midiNoteNumber))
+    if (isPositiveAndBelow (midiNoteNumber, (int) 128))
     {
-        const int timeNow = (int) Time::getMillisecondCounter();
-        eventsToAdd.addEvent (MidiMessage::noteOff (midiChannel, midiNoteNumber), timeNow);
-        eventsToAdd.clear (0, timeNow - 500);
+        MidiMessage m (MidiMessage::noteOn (midiChannel, midiNoteNumber, velocity));
+        m.setTimeStamp (Time::getMillisecondCounter());
+        eventsToAdd.push (m, resetGeneration.get());
 
-        noteOffInternal (midiChannel, midiNoteNumber);
+        setNoteState (midiChannel, midiNoteNumber, true);
+        callListenersForNoteOn (midiChannel, midiNoteNumber, velocity);
     }
 }
 
-void MidiKeyboardState::noteOffInternal  (const int midiChannel, const int midiNoteNumber)
+void MidiKeyboardState::noteOff (const int midiChannel, const int midiNoteNumber)
 {
     if (isNoteOn (midiChannel, midiNoteNumber))
     {
-        noteStates [midiNoteNumber] &= ~(1 << (midiChannel - 1));
+        MidiMessage m (MidiMessage::noteOff (midiChannel, midiNoteNumber));
+        m.setTimeStamp (Time::getMillisecondCounter());
+        eventsToAdd.push (m, resetGeneration.get());
 
-        for (int i = listeners.size(); --i >= 0;)
-            listeners.getUnchecked(i)->handleNoteOff (this, midiChannel, midiNoteNumber);
+        if (setNoteState (midiChannel, midiNoteNumber, false))
+            callListenersForNoteOff (midiChannel, midiNoteNumber);
     }
 }
 
 void MidiKeyboardState::allNotesOff (const int midiChannel)
 {
-    const ScopedLock sl (lock);
-
     if (midiChannel <= 0)
     {
         for (int i = 1; i <= 16; ++i)
@@ -125,18 +121,27 @@ void MidiKeyboardState::allNotesOff (const int midiChannel)
 
 void MidiKeyboardState::processNextMidiEvent (const MidiMessage& message)
 {
+    const int channel = message.getChannel();
+
     if (message.isNoteOn())
     {
-        noteOnInternal (message.getChannel(), message.getNoteNumber(), message.getFloatVelocity());
+        if (isPositiveAndBelow (message.getNoteNumber(), (int) 128))
+        {
+            setNoteState (channel, message.getNoteNumber(), true);
+            keyChanged (message);
+        }
     }
     else if (message.isNoteOff())
     {
-        noteOffInternal (message.getChannel(), message.getNoteNumber());
+        if (isPositiveAndBelow (message.getNoteNumber(), (int) 128)
+             && setNoteState (channel, message.getNoteNumber(), false))
+            keyChanged (message);
     }
     else if (message.isAllNotesOff())
     {
         for (int i = 0; i < 128; ++i)
-            noteOffInternal (message.getChannel(), i);
+            if (setNoteState (channel, i, false))
+                keyChanged (MidiMessage::noteOff (channel, i));
     }
 }
 
@@ -149,16 +154,30 @@ void MidiKeyboardState::processNextMidiBuffer (MidiBuffer& buffer,
     MidiMessage message (0xf4, 0.0);
     int time;
 
-    const ScopedLock sl (lock);
-
     while (i.getNextEvent (message, time))
         processNextMidiEvent (message);
 
-    if (injectIndirectEvents)
+    pendingEvents.clear();
+
     {
-        MidiBuffer::Iterator i2 (eventsToAdd);
-        const int firstEventToAdd = eventsToAdd.getFirstEventTime();
-        const double scaleFactor = numSamples / (double) (eventsToAdd.getLastEventTime() + 1 - firstEventToAdd);
+        const int generation = resetGeneration.get();
+        uint8 data [16];
+        int numBytes, tag;
+        double timeStamp;
+
+        while (eventsToAdd.pop (data, sizeof (data), numBytes, timeStamp, &tag))
+            if (numBytes > 0 && tag == generation)
+                pendingEvents.addEvent (data, numBytes, (int) timeStamp);
+    }
+
+    if (injectIndirectEvents && ! pendingEvents.isEmpty())
+    {
+        const int lastEventTime = pendingEvents.getLastEventTime();
+        pendingEvents.clear (0, lastEventTime - 500);
+
+        MidiBuffer::Iterator i2 (pendingEvents);
+        const int firstEventToAdd = pendingEvents.getFirstEventTime();
+        const double scaleFactor = numSamples / (double) (lastEventTime + 1 - firstEventToAdd);
 
         while (i2.getNextEvent (message, time))
         {
@@ -166,11 +185,71 @@ void MidiKeyboardState::processNextMidiBuffer (MidiBuffer& buffer,
             buffer.addEvent (message, startSample + pos);
         }
     }
+}
 
-    eventsToAdd.clear();
+void MidiKeyboardState::keyChanged (const MidiMessage& message)
+{
+    // processNextMidiEvent() is normally called on the audio thread, so if something is
+    // dispatching the notifications from the message thread, the listeners are left for
+    // it to call rather than taking their lock here.
+    if (numDeferringClients.get() > 0)
+        notificationsToSend.push (message);
+    else if (message.isNoteOn())
+        callListenersForNoteOn (message.getChannel(), message.getNoteNumber(), message.getFloatVelocity());
+    else
+        callListenersForNoteOff (message.getChannel(), message.getNoteNumber());
+}
+
+void MidiKeyboardState::startDeferringNotifications()
+{
+    ++numDeferringClients;
+}
+
+void MidiKeyboardState::stopDeferringNotifications()
+{
+    jassert (numDeferringClients.get() > 0);
+
+    if (--numDeferringClients == 0)
+        dispatchPendingNotifications();
+}
+
+void MidiKeyboardState::dispatchPendingNotifications()
+{
+    uint8 data [16];
+    int numBytes;
+    double timeStamp;
+
+    while (notificationsToSend.pop (data, sizeof (data), numBytes, timeStamp))
+    {
+        if (numBytes > 0)
+        {
+            const MidiMessage m (data, numBytes);
+
+            if (m.isNoteOn())
+                callListenersForNoteOn (m.getChannel(), m.getNoteNumber(), m.getFloatVelocity());
+            else if (m.isNoteOff())
+                callListenersForNoteOff (m.getChannel(), m.getNoteNumber());
+        }
+    }
 }
 
 //==============================================================================
+void MidiKeyboardState::callListenersForNoteOn (const int midiChannel, const int midiNoteNumber, const float velocity)
+{
+    const ScopedLock sl (lock);
+
+    for (int i = listeners.size(); --i >= 0;)
+        listeners.getUnchecked(i)->handleNoteOn (this, midiChannel, midiNoteNumber, velocity);
+}
+
+void MidiKeyboardState::callListenersForNoteOff (const int midiChannel, const int midiNoteNumber)
+{
+    const ScopedLock sl (lock);
+
+    for (int i = listeners.size(); --i >= 0;)
+        listeners.getUnchecked(i)->handleNoteOff (this, midiChannel, midiNoteNumber);
+}
+
 void MidiKeyboardState::addListener (MidiKeyboardStateListener* const listener)
 {
     const ScopedLock sl (lock);
@@ -182,3 +261,120 @@ void MidiKeyboardState::removeListener (MidiKeyboardStateListener* const listene
     const ScopedLock sl (lock);
     listeners.removeFirstMatchingValue (listener);
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MidiKeyboardStateTests  : public UnitTest,
+                                private MidiKeyboardStateListener
+{
+public:
+    MidiKeyboardStateTests() : UnitTest ("MidiKeyboardState") {}
+
+    void runTest()
+    {
+        beginTest ("Indirect events");
+
+        MidiKeyboardState state;
+        MidiBuffer buffer;
+
+        state.noteOn (1, 60, 1.0f);
+        state.noteOff (1, 60);
+        state.processNextMidiBuffer (buffer, 0, 256, true);
+
+        expectEquals (buffer.getNumEvents(), 2);
+        expect (getNoteNumbers (buffer) == "60 60");
+
+        beginTest ("Reset discards queued events");
+
+        buffer.clear();
+        state.noteOn (1, 61, 1.0f);
+        state.reset();
+        state.noteOn (1, 62, 1.0f);
+        state.processNextMidiBuffer (buffer, 0, 256, true);
+
+        expect (getNoteNumbers (buffer) == "62");
+        expect (state.isNoteOn (1, 62) && ! state.isNoteOn (1, 61));
+
+        beginTest ("Listener callbacks");
+
+        state.reset();
+        state.addListener (this);
+        notesOn.clear();
+        notesOff.clear();
+
+        buffer.clear();
+        buffer.addEvent (MidiMessage::noteOn (4, 70, 0.5f), 0);
+        state.processNextMidiBuffer (buffer, 0, 256, false);
+        expect (notesOn.size() == 1 && notesOn[0] == 70); // with nothing deferring them, callbacks are synchronous
+
+        buffer.clear();
+        buffer.addEvent (MidiMessage::noteOff (4, 70), 0);
+        state.processNextMidiBuffer (buffer, 0, 256, false);
+        expect (notesOff.size() == 1 && notesOff[0] == 70);
+
+        notesOn.clear();
+        notesOff.clear();
+        state.startDeferringNotifications();
+
+        state.noteOn (2, 40, 0.5f);
+        expect (notesOn.size() == 1 && notesOn[0] == 40); // direct calls are still synchronous
+
+        buffer.clear();
+        buffer.addEvent (MidiMessage::noteOn (3, 50, 0.5f), 0);
+        buffer.addEvent (MidiMessage::noteOff (2, 40), 10);
+        state.processNextMidiBuffer (buffer, 0, 256, false);
+
+        // the key states change straight away, but the callbacks wait for the dispatch..
+        expect (state.isNoteOn (3, 50) && ! state.isNoteOn (2, 40));
+        expectEquals (notesOn.size(), 1);
+        expectEquals (notesOff.size(), 0);
+
+        state.dispatchPendingNotifications();
+        expect (notesOn.size() == 2 && notesOn[1] == 50);
+        expect (notesOff.size() == 1 && notesOff[0] == 40);
+
+        // ..and an all-notes-off only reports the notes that were actually on
+        buffer.clear();
+        buffer.addEvent (MidiMessage::allNotesOff (3), 0);
+        state.processNextMidiBuffer (buffer, 0, 256, false);
+        state.dispatchPendingNotifications();
+
+        expect (notesOff.size() == 2 && notesOff[1] == 50);
+        expect (! state.isNoteOn (3, 50));
+
+        // anything still queued when the deferral stops gets delivered then
+        buffer.clear();
+        buffer.addEvent (MidiMessage::noteOn (3, 51, 0.5f), 0);
+        state.processNextMidiBuffer (buffer, 0, 256, false);
+        expectEquals (notesOn.size(), 2);
+
+        state.stopDeferringNotifications();
+        expect (notesOn.size() == 3 && notesOn[2] == 51);
+
+        state.removeListener (this);
+    }
+
+private:
+    Array<int> notesOn, notesOff;
+
+    void handleNoteOn (MidiKeyboardState*, int, int midiNoteNumber, float)  { notesOn.add (midiNoteNumber); }
+    void handleNoteOff (MidiKeyboardState*, int, int midiNoteNumber)        { notesOff.add (midiNoteNumber); }
+
+    static String getNoteNumbers (const MidiBuffer& buffer)
+    {
+        StringArray notes;
+        MidiBuffer::Iterator i (buffer);
+        MidiMessage message (0xf4, 0.0);
+        int time;
+
+        while (i.getNextEvent (message, time))
+            notes.add (String (message.getNoteNumber()));
+
+        return notes.joinIntoString (" ");
+    }
+};
+
+static MidiKeyboardStateTests midiKeyboardStateTests;
+
+#endif
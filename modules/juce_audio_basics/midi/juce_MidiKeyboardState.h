@@ -27,6 +27,7 @@
 #define __JUCE_MIDIKEYBOARDSTATE_JUCEHEADER__
 
 #include "juce_MidiBuffer.h"
+#include "juce_MidiMessageFifo.h"
 class MidiKeyboardState;
 
 
@@ -46,24 +47,32 @@ public:
     //==============================================================================
     /** Called when one of the MidiKeyboardState's keys is pressed.
 
-        This will be called synchronously when the state is either processing a
-        buffer in its MidiKeyboardState::processNextMidiBuffer() method, or
-        when a note is being played with its MidiKeyboardState::noteOn() method.
+        This will be called synchronously when a note is being played with the
+        MidiKeyboardState::noteOn() method, or by the midi that's passed to
+        MidiKeyboardState::processNextMidiBuffer(). If something has called
+        MidiKeyboardState::startDeferringNotifications(), the keys pressed by
+        processNextMidiBuffer() are reported later instead, by
+        MidiKeyboardState::dispatchPendingNotifications().
 
-        Note that this callback could happen from an audio callback thread, so be
-        careful not to block, and avoid any UI activity in the callback.
+        Note that noteOn() and processNextMidiBuffer() could be called from an audio
+        callback thread, so be careful not to block, and avoid any UI activity in the
+        callback.
     */
     virtual void handleNoteOn (MidiKeyboardState* source,
                                int midiChannel, int midiNoteNumber, float velocity) = 0;
 
     /** Called when one of the MidiKeyboardState's keys is released.
 
-        This will be called synchronously when the state is either processing a
-        buffer in its MidiKeyboardState::processNextMidiBuffer() method, or
-        when a note is being played with its MidiKeyboardState::noteOff() method.
+        This will be called synchronously when a note is being released with the
+        MidiKeyboardState::noteOff() method, or by the midi that's passed to
+        MidiKeyboardState::processNextMidiBuffer(). If something has called
+        MidiKeyboardState::startDeferringNotifications(), the keys released by
+        processNextMidiBuffer() are reported later instead, by
+        MidiKeyboardState::dispatchPendingNotifications().
 
-        Note that this callback could happen from an audio callback thread, so be
-        careful not to block, and avoid any UI activity in the callback.
+        Note that noteOff() and processNextMidiBuffer() could be called from an audio
+        callback thread, so be careful not to block, and avoid any UI activity in the
+        callback.
     */
     virtual void handleNoteOff (MidiKeyboardState* source,
                                 int midiChannel, int midiNoteNumber) = 0;
@@ -82,6 +91,16 @@ public:
     It also allows key up/down events to be triggered with its noteOn() and noteOff()
     methods, and midi messages for these events will be merged into the
     midi stream that gets processed by processNextMidiBuffer().
+
+    The key states are updated atomically, and the events generated by noteOn() and
+    noteOff() are passed to processNextMidiBuffer() through a lock-free queue.
+
+    By default, the key changes that processNextMidiBuffer() finds are sent to the
+    listeners straight away, on whatever thread called it, which means taking the
+    listener lock. If something calls startDeferringNotifications(), they're passed
+    back through another queue instead, and the listeners only hear about them when
+    dispatchPendingNotifications() is called, so the audio thread never has to take
+    a lock. A MidiKeyboardComponent does this for the state that it's showing.
 */
 class JUCE_API  MidiKeyboardState
 {
@@ -151,6 +170,10 @@ public:
     //==============================================================================
     /** Looks at a key-up/down event and uses it to update the state of this object.
 
+        Any resulting key changes are sent to the listeners, either straight away or,
+        if notifications are being deferred, by the next call to
+        dispatchPendingNotifications().
+
         To process a buffer full of midi messages, use the processNextMidiBuffer() method
         instead.
     */
@@ -159,7 +182,8 @@ public:
     /** Scans a midi stream for up/down events and adds its own events to it.
 
         This will look for any up/down events and use them to update the internal state,
-        synchronously making suitable callbacks to the listeners.
+        making suitable callbacks to the listeners, or queueing them for
+        dispatchPendingNotifications() if notifications are being deferred.
 
         If injectIndirectEvents is true, then midi events to produce the recent noteOn()
         and noteOff() calls will be added into the buffer.
@@ -179,6 +203,36 @@ public:
                                 int numSamples,
                                 bool injectIndirectEvents);
 
+    /** Makes processNextMidiBuffer() queue its listener callbacks rather than making them.
+
+        Once this has been called, it's up to the caller to call dispatchPendingNotifications()
+        regularly from the message thread (e.g. in a timer callback), which is where the
+        listeners will then hear about the key changes that processNextMidiBuffer() finds.
+        Each call must be balanced by a call to stopDeferringNotifications().
+
+        @see stopDeferringNotifications, dispatchPendingNotifications
+    */
+    void startDeferringNotifications();
+
+    /** Undoes a call to startDeferringNotifications().
+
+        When the last caller stops deferring, any notifications that are still queued get
+        dispatched, and processNextMidiBuffer() goes back to calling the listeners directly.
+    */
+    void stopDeferringNotifications();
+
+    /** Calls the listeners for any key changes that processNextMidiBuffer() has queued.
+
+        Changes are only queued while notifications are being deferred - see
+        startDeferringNotifications(). This doesn't get called automatically, so whatever
+        deferred them needs to call it regularly from the message thread, e.g. in a timer
+        callback. It must only be called by one thread at a time.
+
+        If it isn't called for a long time, changes will be discarded once the queue
+        is full, but the key states themselves will still be correct.
+    */
+    void dispatchPendingNotifications();
+
     //==============================================================================
     /** Registers a listener for callbacks when keys go up or down.
 
@@ -195,12 +249,16 @@ public:
 private:
     //==============================================================================
     CriticalSection lock;
-    uint16 noteStates [128];
-    MidiBuffer eventsToAdd;
+    Atomic<int> noteStates [128];
+    MidiMessageFifo eventsToAdd, notificationsToSend;
+    MidiBuffer pendingEvents;
+    Atomic<int> resetGeneration, numDeferringClients;
     Array <MidiKeyboardStateListener*> listeners;
 
-    void noteOnInternal (int midiChannel, int midiNoteNumber, float velocity);
-    void noteOffInternal (int midiChannel, int midiNoteNumber);
+    void callListenersForNoteOn (int midiChannel, int midiNoteNumber, float velocity);
+    void callListenersForNoteOff (int midiChannel, int midiNoteNumber);
+    void keyChanged (const MidiMessage&);
+    bool setNoteState (int midiChannel, int midiNoteNumber, bool isOn) noexcept;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiKeyboardState)
 };
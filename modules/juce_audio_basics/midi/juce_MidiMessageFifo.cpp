@@ -0,0 +1,258 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+MidiMessageFifo::MidiMessageFifo (const int capacityInBytes)
+    : fifo (jmax (64, capacityInBytes)),
+      buffer ((size_t) fifo.getTotalSize())
+{
+}
+
+MidiMessageFifo::~MidiMessageFifo()
+{
+}
+
+//==============================================================================
+namespace MidiFifoHelpers
+{
+    struct BlockWriter
+    {
+        BlockWriter (uint8* const buffer_, const int start1, const int size1, const int start2, const int size2) noexcept
+            : buffer (buffer_), pos (start1), remainingInBlock (size1), nextStart (start2), nextSize (size2)
+        {}
+
+        void write (const void* source, int numBytes) noexcept
+        {
+            const uint8* src = static_cast <const uint8*> (source);
+
+            while (numBytes > 0)
+            {
+                if (remainingInBlock == 0)
+                {
+                    jassert (nextSize > 0);
+                    pos = nextStart;
+                    remainingInBlock = nextSize;
+                    nextSize = 0;
+                }
+
+                const int num = jmin (numBytes, remainingInBlock);
+                memcpy (buffer + pos, src, (size_t) num);
+                src += num;
+                pos += num;
+                numBytes -= num;
+                remainingInBlock -= num;
+            }
+        }
+
+        uint8* buffer;
+        int pos, remainingInBlock, nextStart, nextSize;
+    };
+}
+
+bool MidiMessageFifo::push (const void* const midiData, const int numBytes, const double timeStamp, const int tag) noexcept
+{
+    jassert (midiData != nullptr && numBytes > 0);
+
+    MessageHeader header;
+    header.timeStamp = timeStamp;
+    header.numBytes = numBytes;
+    header.tag = tag;
+
+    const int totalSize = (int) sizeof (header) + numBytes;
+
+    const SpinLock::ScopedLockType sl (writerLock);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (totalSize, start1, size1, start2, size2);
+
+    if (size1 + size2 < totalSize)
+    {
+        ++numDropped;
+        return false;
+    }
+
+    MidiFifoHelpers::BlockWriter writer (buffer, start1, size1, start2, size2);
+    writer.write (&header, (int) sizeof (header));
+    writer.write (midiData, numBytes);
+
+    fifo.finishedWrite (totalSize);
+    return true;
+}
+
+bool MidiMessageFifo::push (const MidiMessage& message, const int tag) noexcept
+{
+    return push (message.getRawData(), message.getRawDataSize(), message.getTimeStamp(), tag);
+}
+
+//==============================================================================
+void MidiMessageFifo::readFromFifo (void* const dest, const int numBytes) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (numBytes, start1, size1, start2, size2);
+    jassert (size1 + size2 == numBytes);
+
+    if (dest != nullptr)
+    {
+        memcpy (dest, buffer + start1, (size_t) size1);
+
+        if (size2 > 0)
+            memcpy (static_cast <uint8*> (dest) + size1, buffer + start2, (size_t) size2);
+    }
+
+    fifo.finishedRead (size1 + size2);
+}
+
+bool MidiMessageFifo::pop (uint8* const destData, const int destDataSize, int& numBytes, double& timeStamp, int* const tag) noexcept
+{
+    if (fifo.getNumReady() < (int) sizeof (MessageHeader))
+        return false;
+
+    MessageHeader header;
+    readFromFifo (&header, (int) sizeof (header));
+
+    timeStamp = header.timeStamp;
+
+    if (tag != nullptr)
+        *tag = header.tag;
+
+    if (header.numBytes <= destDataSize)
+    {
+        numBytes = header.numBytes;
+        readFromFifo (destData, header.numBytes);
+    }
+    else
+    {
+        numBytes = 0;
+        readFromFifo (nullptr, header.numBytes);
+    }
+
+    return true;
+}
+
+bool MidiMessageFifo::isEmpty() const noexcept
+{
+    return fifo.getNumReady() == 0;
+}
+
+void MidiMessageFifo::reset() noexcept
+{
+    fifo.reset();
+    numDropped = 0;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MidiMessageFifoTests  : public UnitTest
+{
+public:
+    MidiMessageFifoTests() : UnitTest ("MidiMessageFifo") {}
+
+    class WriteThread  : public Thread
+    {
+    public:
+        WriteThread (MidiMessageFifo& fifo_, const int numToWrite_)
+            : Thread ("MidiMessageFifo writer"), fifo (fifo_), numToWrite (numToWrite_)
+        {
+            startThread (0);
+        }
+
+        ~WriteThread()
+        {
+            stopThread (5000);
+        }
+
+        void run()
+        {
+            for (int i = 0; i < numToWrite && ! threadShouldExit();)
+            {
+                const uint8 data[] = { 0x90, (uint8) (i & 0x7f), (uint8) ((i >> 7) & 0x7f) };
+
+                if (fifo.push (data, 3, (double) i))
+                    ++i;
+                else
+                    wait (1);
+            }
+        }
+
+    private:
+        MidiMessageFifo& fifo;
+        const int numToWrite;
+    };
+
+    void runTest()
+    {
+        beginTest ("Ordering and wrap-around");
+
+        const int numMessages = 20000;
+        MidiMessageFifo fifo (512);
+        WriteThread writer (fifo, numMessages);
+
+        int numRead = 0;
+        bool allInOrder = true;
+        uint8 data [16];
+
+        while (numRead < numMessages)
+        {
+            int numBytes;
+            double timeStamp;
+
+            if (fifo.pop (data, sizeof (data), numBytes, timeStamp))
+            {
+                allInOrder = allInOrder
+                              && numBytes == 3
+                              && timeStamp == (double) numRead
+                              && data[1] == (numRead & 0x7f)
+                              && data[2] == ((numRead >> 7) & 0x7f);
+                ++numRead;
+            }
+            else
+            {
+                Thread::yield();
+            }
+        }
+
+        expect (allInOrder);
+        expect (fifo.isEmpty());
+
+        beginTest ("Overflow");
+
+        fifo.reset();
+        const uint8 sysex [200] = { 0 };
+
+        expect (fifo.push (sysex, 200, 1.0));
+        expect (fifo.push (sysex, 200, 2.0));
+        expect (! fifo.push (sysex, 200, 3.0));
+        expectEquals (fifo.getNumDroppedMessages(), 1);
+
+        int numBytes;
+        double timeStamp;
+        expect (fifo.pop (data, sizeof (data), numBytes, timeStamp));
+        expect (numBytes == 0 && timeStamp == 1.0);
+    }
+};
+
+static MidiMessageFifoTests midiMessageFifoTests;
+
+#endif
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_MIDIMESSAGEFIFO_JUCEHEADER__
+#define __JUCE_MIDIMESSAGEFIFO_JUCEHEADER__
+
+#include "juce_MidiMessage.h"
+
+
+//==============================================================================
+/**
+    A fixed-size, lock-free queue of time-stamped midi messages.
+
+    This is designed for passing midi data from threads such as a midi input or
+    the message thread to an audio callback. All the storage is allocated when the
+    object is created, and the reading side never takes a lock or allocates any
+    memory, so it's safe to drain the queue from a real-time thread.
+
+    Messages of any length (including sysex) can be queued. If the queue is full,
+    new messages are discarded and counted, rather than making the writer wait.
+
+    Any number of threads can push messages, but only one thread at a time may
+    read them. Writers are serialised among themselves by a SpinLock, which the
+    reader never touches.
+
+    @see MidiMessageCollector, MidiKeyboardState
+*/
+class JUCE_API  MidiMessageFifo
+{
+public:
+    //==============================================================================
+    /** Creates a queue.
+        @param capacityInBytes  the amount of storage to allocate. Each message uses its
+                                size in bytes plus a small header.
+    */
+    explicit MidiMessageFifo (int capacityInBytes = 32768);
+
+    /** Destructor. */
+    ~MidiMessageFifo();
+
+    //==============================================================================
+    /** Adds some raw midi data to the queue.
+
+        The tag is an arbitrary number that's stored with the message and handed back by
+        pop(), e.g. so that the reader can recognise messages that were queued before
+        some kind of reset.
+
+        @returns false if there wasn't enough room for it, in which case it's discarded.
+    */
+    bool push (const void* midiData, int numBytes, double timeStamp, int tag = 0) noexcept;
+
+    /** Adds a message to the queue, using its time-stamp.
+        @returns false if there wasn't enough room for it, in which case it's discarded.
+    */
+    bool push (const MidiMessage& message, int tag = 0) noexcept;
+
+    //==============================================================================
+    /** Removes the oldest message from the queue.
+
+        This should only be called by the reading thread.
+
+        @param destData         the buffer to copy the message's data into
+        @param destDataSize     the size of destData. If the next message is bigger than
+                                this, it is removed from the queue but numBytes is set to 0
+        @param numBytes         on return, the number of bytes that were copied
+        @param timeStamp        on return, the time-stamp that was pushed with the message
+        @param tag              if this isn't null, it's set to the tag that was pushed
+                                with the message
+        @returns false if the queue was empty
+    */
+    bool pop (uint8* destData, int destDataSize, int& numBytes, double& timeStamp, int* tag = nullptr) noexcept;
+
+    /** Returns true if there are no messages waiting. */
+    bool isEmpty() const noexcept;
+
+    /** Empties the queue.
+        This must only be called when no other thread is reading or writing.
+    */
+    void reset() noexcept;
+
+    /** Returns the number of messages that have been discarded since the last reset()
+        because the queue was full.
+    */
+    int getNumDroppedMessages() const noexcept              { return numDropped.get(); }
+
+private:
+    //==============================================================================
+    struct MessageHeader
+    {
+        double timeStamp;
+        int32 numBytes, tag;
+    };
+
+    AbstractFifo fifo;
+    HeapBlock<uint8> buffer;
+    SpinLock writerLock;
+    Atomic<int> numDropped;
+
+    void readFromFifo (void* dest, int numBytes) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiMessageFifo)
+};
+
+
+#endif   // __JUCE_MIDIMESSAGEFIFO_JUCEHEADER__
@@ -26,7 +26,7 @@
 #ifndef __JUCE_AUDIOSOURCE_JUCEHEADER__
 #define __JUCE_AUDIOSOURCE_JUCEHEADER__
 
-#include "../buffers/juce_AudioSampleBuffer.h"
+#include "../buffers/juce_AudioBlock.h"
 
 
 //==============================================================================
@@ -92,6 +92,15 @@ struct JUCE_API  AudioSourceChannelInfo
         if (buffer != nullptr)
             buffer->clear (startSample, numSamples);
     }
+
+    /** Returns a block that refers to the active region of the buffer, which can be
+        used to process it, or to pass just that part of it on, without copying.
+    */
+    AudioBlock getActiveBlock() const noexcept
+    {
+        jassert (buffer != nullptr);
+        return AudioBlock (*buffer, startSample, numSamples);
+    }
 };
 
 
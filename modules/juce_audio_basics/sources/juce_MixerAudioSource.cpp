@@ -138,16 +138,15 @@ void MixerAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
         if (inputs.size() > 1)
         {
             tempBuffer.setSize (jmax (1, info.buffer->getNumChannels()),
-                                info.buffer->getNumSamples());
+                                info.buffer->getNumSamples(), false, false, true);
 
             AudioSourceChannelInfo info2 (&tempBuffer, 0, info.numSamples);
+            const AudioBlock output (info.getActiveBlock());
 
             for (int i = 1; i < inputs.size(); ++i)
             {
                 inputs.getUnchecked(i)->getNextAudioBlock (info2);
-
-                for (int chan = 0; chan < info.buffer->getNumChannels(); ++chan)
-                    info.buffer->addFrom (chan, info.startSample, tempBuffer, chan, 0, info.numSamples);
+                output.addFrom (info2.getActiveBlock());
             }
         }
     }
@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+AudioCallbackTimingStatistics::Snapshot::Snapshot() noexcept
+    : sampleRate (0),
+      blockSize (0),
+      overloadThreshold (0),
+      numCallbacks (0),
+      numOverloads (0),
+      numDeadlineMisses (0),
+      minDurationMs (0),
+      maxDurationMs (0),
+      averageDurationMs (0),
+      maxIntervalMs (0)
+{
+    zeromem (durationHistogram, sizeof (durationHistogram));
+    zeromem (intervalHistogram, sizeof (intervalHistogram));
+}
+
+var AudioCallbackTimingStatistics::Snapshot::toVar() const
+{
+    DynamicObject* const obj = new DynamicObject();
+    var result (obj);
+
+    obj->setProperty ("sampleRate", sampleRate);
+    obj->setProperty ("blockSize", blockSize);
+    obj->setProperty ("overloadThreshold", overloadThreshold);
+    obj->setProperty ("numCallbacks", numCallbacks);
+    obj->setProperty ("numOverloads", numOverloads);
+    obj->setProperty ("numDeadlineMisses", numDeadlineMisses);
+    obj->setProperty ("minDurationMs", minDurationMs);
+    obj->setProperty ("maxDurationMs", maxDurationMs);
+    obj->setProperty ("averageDurationMs", averageDurationMs);
+    obj->setProperty ("maxIntervalMs", maxIntervalMs);
+    obj->setProperty ("histogramBinWidth", 0.05);
+
+    var durations, intervals, overloads;
+    durations.resize (numHistogramBins);
+    intervals.resize (numHistogramBins);
+    overloads.resize (worstOverloads.size());
+
+    for (int i = 0; i < numHistogramBins; ++i)
+    {
+        durations[i] = durationHistogram[i];
+        intervals[i] = intervalHistogram[i];
+    }
+
+    for (int i = 0; i < worstOverloads.size(); ++i)
+    {
+        const Overload& o = worstOverloads.getReference (i);
+
+        DynamicObject* const overload = new DynamicObject();
+        overloads[i] = var (overload);
+        overload->setProperty ("time", o.time);
+        overload->setProperty ("durationMs", o.durationMs);
+        overload->setProperty ("proportionOfBlockDuration", o.proportionOfBlockDuration);
+    }
+
+    obj->setProperty ("durationHistogram", durations);
+    obj->setProperty ("intervalHistogram", intervals);
+    obj->setProperty ("worstOverloads", overloads);
+
+    return result;
+}
+
+String AudioCallbackTimingStatistics::Snapshot::toJSON() const
+{
+    return JSON::toString (toVar());
+}
+
+//==============================================================================
+AudioCallbackTimingStatistics::AudioCallbackTimingStatistics()
+    : sampleRate (0),
+      blockSize (0),
+      overloadThresholdPercent (80),
+      lastStartTimeMs (0),
+      lastBlockDurationMs (0),
+      overloadFifo (64),
+      pendingOverloads ((size_t) overloadFifo.getTotalSize())
+{
+    clearCounters();
+}
+
+AudioCallbackTimingStatistics::~AudioCallbackTimingStatistics()
+{
+}
+
+void AudioCallbackTimingStatistics::prepare (const double newSampleRate, const int newBlockSize) noexcept
+{
+    sampleRate = newSampleRate;
+    blockSize = newBlockSize;
+    lastStartTimeMs = 0;
+    lastBlockDurationMs = 0;
+    resetPending = 0;
+    clearCounters();
+
+    const ScopedLock sl (readerLock);
+    collectPendingOverloads();
+    worstOverloads.clearQuick();
+}
+
+void AudioCallbackTimingStatistics::reset()
+{
+    // The counters belong to the audio thread, so rather than clearing them from here,
+    // this asks addCallback() to do it. Until it has, the snapshots are left empty, and
+    // any overloads that were queued before the reset get thrown away.
+    const ScopedLock sl (readerLock);
+    resetPending = 1;
+    collectPendingOverloads();
+    worstOverloads.clearQuick();
+}
+
+void AudioCallbackTimingStatistics::clearCounters() noexcept
+{
+    numCallbacks = 0;
+    numOverloads = 0;
+    numDeadlineMisses = 0;
+    totalDurationMicros = 0;
+    minDurationMicros = std::numeric_limits<int64>::max();
+    maxDurationMicros = 0;
+    maxIntervalMicros = 0;
+
+    for (int i = 0; i < numHistogramBins; ++i)
+    {
+        durationHistogram[i] = 0;
+        intervalHistogram[i] = 0;
+    }
+}
+
+void AudioCallbackTimingStatistics::setOverloadThreshold (const double proportionOfBlockDuration) noexcept
+{
+    overloadThresholdPercent = jmax (1, roundToInt (proportionOfBlockDuration * 100.0));
+}
+
+double AudioCallbackTimingStatistics::getOverloadThreshold() const noexcept
+{
+    return overloadThresholdPercent.get() * 0.01;
+}
+
+int AudioCallbackTimingStatistics::getBinForProportion (const double proportion) noexcept
+{
+    return jlimit (0, (int) numHistogramBins - 1, (int) (proportion * 20.0));
+}
+
+//==============================================================================
+void AudioCallbackTimingStatistics::addCallback (const double startTimeMs, const double endTimeMs,
+                                                 const int numSamples) noexcept
+{
+    if (resetPending.get() != 0)
+    {
+        clearCounters();
+        resetPending = 0;
+    }
+
+    const double blockDurationMs = sampleRate > 0 ? numSamples * 1000.0 / sampleRate : 0.0;
+    const double durationMs = endTimeMs - startTimeMs;
+    const int64 durationMicros = (int64) (durationMs * 1000.0);
+
+    ++numCallbacks;
+    totalDurationMicros += durationMicros;
+
+    // (only the audio thread writes to these, so there's no need for a compare-and-swap)
+    if (durationMicros < minDurationMicros.get())  minDurationMicros = durationMicros;
+    if (durationMicros > maxDurationMicros.get())  maxDurationMicros = durationMicros;
+
+    if (lastStartTimeMs > 0)
+    {
+        const double intervalMs = startTimeMs - lastStartTimeMs;
+        const int64 intervalMicros = (int64) (intervalMs * 1000.0);
+
+        if (intervalMicros > maxIntervalMicros.get())
+            maxIntervalMicros = intervalMicros;
+
+        if (lastBlockDurationMs > 0)
+            ++intervalHistogram [getBinForProportion (intervalMs / lastBlockDurationMs)];
+    }
+
+    lastStartTimeMs = startTimeMs;
+    lastBlockDurationMs = blockDurationMs;
+
+    if (blockDurationMs > 0)
+    {
+        const double proportion = durationMs / blockDurationMs;
+        ++durationHistogram [getBinForProportion (proportion)];
+
+        if (proportion >= 1.0)
+            ++numDeadlineMisses;
+
+        if (proportion * 100.0 > overloadThresholdPercent.get())
+        {
+            ++numOverloads;
+
+            int start1, size1, start2, size2;
+            overloadFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+            // if the reader hasn't kept up, the overload is still counted but its details are lost
+            if (size1 > 0)
+            {
+                PendingOverload& o = pendingOverloads [start1];
+                o.startTimeMs = startTimeMs;
+                o.durationMs = durationMs;
+                o.proportionOfBlockDuration = proportion;
+                overloadFifo.finishedWrite (1);
+            }
+        }
+    }
+}
+
+//==============================================================================
+void AudioCallbackTimingStatistics::collectPendingOverloads()
+{
+    const int64 now = Time::currentTimeMillis();
+    const double nowMs = Time::getMillisecondCounterHiRes();
+
+    int start1, size1, start2, size2;
+    overloadFifo.prepareToRead (overloadFifo.getNumReady(), start1, size1, start2, size2);
+
+    // anything that's queued while a reset is still pending happened before the reset
+    if (resetPending.get() != 0)
+    {
+        overloadFifo.finishedRead (size1 + size2);
+        return;
+    }
+
+    for (int i = 0; i < size1 + size2; ++i)
+    {
+        const PendingOverload& p = pendingOverloads [i < size1 ? start1 + i : start2 + i - size1];
+
+        Overload o;
+        o.time = now - (int64) (nowMs - p.startTimeMs);
+        o.durationMs = p.durationMs;
+        o.proportionOfBlockDuration = p.proportionOfBlockDuration;
+
+        int insertIndex = 0;
+        while (insertIndex < worstOverloads.size()
+                && worstOverloads.getReference (insertIndex).durationMs >= o.durationMs)
+            ++insertIndex;
+
+        if (insertIndex < maxWorstOverloads)
+        {
+            worstOverloads.insert (insertIndex, o);
+
+            if (worstOverloads.size() > maxWorstOverloads)
+                worstOverloads.removeLast();
+        }
+    }
+
+    overloadFifo.finishedRead (size1 + size2);
+}
+
+AudioCallbackTimingStatistics::Snapshot AudioCallbackTimingStatistics::getSnapshot()
+{
+    Snapshot s;
+    s.sampleRate = sampleRate;
+    s.blockSize = blockSize;
+    s.overloadThreshold = getOverloadThreshold();
+
+    if (resetPending.get() != 0)
+        return s;
+
+    s.numCallbacks = numCallbacks.get();
+    s.numOverloads = numOverloads.get();
+    s.numDeadlineMisses = numDeadlineMisses.get();
+
+    if (s.numCallbacks > 0)
+    {
+        s.minDurationMs = minDurationMicros.get() * 0.001;
+        s.maxDurationMs = maxDurationMicros.get() * 0.001;
+        s.averageDurationMs = totalDurationMicros.get() * 0.001 / (double) s.numCallbacks;
+        s.maxIntervalMs = maxIntervalMicros.get() * 0.001;
+    }
+
+    for (int i = 0; i < numHistogramBins; ++i)
+    {
+        s.durationHistogram[i] = durationHistogram[i].get();
+        s.intervalHistogram[i] = intervalHistogram[i].get();
+    }
+
+    const ScopedLock sl (readerLock);
+    collectPendingOverloads();
+    s.worstOverloads = worstOverloads;
+    return s;
+}
+
+String AudioCallbackTimingStatistics::toJSON()
+{
+    return getSnapshot().toJSON();
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioCallbackTimingStatisticsTests  : public UnitTest
+{
+public:
+    AudioCallbackTimingStatisticsTests() : UnitTest ("Audio callback timing statistics") {}
+
+    void runTest()
+    {
+        beginTest ("Histograms and overloads");
+
+        AudioCallbackTimingStatistics stats;
+        stats.prepare (48000.0, 480);   // 10ms blocks
+        stats.setOverloadThreshold (0.5);
+
+        const double durations[] = { 1.0, 2.0, 6.0, 12.0, 1.0 };
+        double startTime = 1000.0;
+
+        for (int i = 0; i < numElementsInArray (durations); ++i)
+        {
+            stats.addCallback (startTime, startTime + durations[i], 480);
+            startTime += 10.0;
+        }
+
+        AudioCallbackTimingStatistics::Snapshot s (stats.getSnapshot());
+
+        expectEquals ((int) s.numCallbacks, 5);
+        expectEquals ((int) s.numOverloads, 2);
+        expectEquals ((int) s.numDeadlineMisses, 1);
+        expectEquals ((int) s.durationHistogram[2], 2);     // 10%
+        expectEquals ((int) s.durationHistogram[4], 1);     // 20%
+        expectEquals ((int) s.durationHistogram[12], 1);    // 60%
+        expectEquals ((int) s.durationHistogram[24], 1);    // 120%
+        expectEquals ((int) s.intervalHistogram[20], 4);    // 100%
+        expect (std::abs (s.maxDurationMs - 12.0) < 0.01);
+        expect (std::abs (s.averageDurationMs - 4.4) < 0.01);
+
+        expectEquals (s.worstOverloads.size(), 2);
+        expect (std::abs (s.worstOverloads[0].durationMs - 12.0) < 0.01);
+        expect (std::abs (s.worstOverloads[1].durationMs - 6.0) < 0.01);
+
+        const var parsed (JSON::parse (s.toJSON()));
+        expectEquals ((int) parsed ["numOverloads"], 2);
+        expectEquals (parsed ["durationHistogram"].size(), (int) AudioCallbackTimingStatistics::numHistogramBins);
+        expectEquals (parsed ["worstOverloads"].size(), 2);
+
+        expect (std::abs (s.worstOverloads[0].time - s.worstOverloads[1].time - 10) <= 1);
+
+        stats.reset();
+        expectEquals ((int) stats.getSnapshot().numCallbacks, 0);
+        expectEquals (stats.getSnapshot().worstOverloads.size(), 0);
+
+        // the counters are cleared by the next callback, so only its overload should remain
+        stats.addCallback (startTime, startTime + 8.0, 480);
+        s = stats.getSnapshot();
+        expectEquals ((int) s.numCallbacks, 1);
+        expectEquals ((int) s.numOverloads, 1);
+        expectEquals ((int) s.durationHistogram[2], 0);
+        expectEquals (s.worstOverloads.size(), 1);
+        expect (std::abs (s.maxDurationMs - 8.0) < 0.01);
+    }
+};
+
+static AudioCallbackTimingStatisticsTests audioCallbackTimingStatisticsTests;
+
+#endif
@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_AUDIOCALLBACKTIMINGSTATISTICS_JUCEHEADER__
+#define __JUCE_AUDIOCALLBACKTIMINGSTATISTICS_JUCEHEADER__
+
+
+//==============================================================================
+/**
+    Collects detailed timing information about a stream of audio callbacks.
+
+    Whereas AudioDeviceManager::getCpuUsage() gives a single smoothed figure, this
+    keeps histograms of how long each callback took and how regularly the callbacks
+    arrived, counts the callbacks that used more than a given proportion of the time
+    available to them, and remembers the worst of those, with the time they happened.
+
+    All the times are measured as a proportion of the block's duration (i.e. the
+    number of samples divided by the sample rate), which is the time that the callback
+    has to do its work before the device needs the data.
+
+    The audio thread records its timings with addCallback(), which never locks or
+    allocates. Any other thread can call getSnapshot() or toJSON() to read the data,
+    but only one thread should be doing so at a time. Because the counters are
+    updated independently, a snapshot taken while the audio is running may be very
+    slightly out-of-step between its different values.
+
+    An AudioDeviceManager keeps one of these for its device - see
+    AudioDeviceManager::getCallbackTimingStatistics().
+*/
+class JUCE_API  AudioCallbackTimingStatistics
+{
+public:
+    //==============================================================================
+    /** Creates an empty set of statistics. */
+    AudioCallbackTimingStatistics();
+
+    /** Destructor. */
+    ~AudioCallbackTimingStatistics();
+
+    //==============================================================================
+    enum
+    {
+        /** The number of bins in each histogram. Each bin covers 5% of the block
+            duration, and the last one also contains any values beyond that.
+        */
+        numHistogramBins = 41,
+
+        /** The maximum number of overloads that a snapshot will list. */
+        maxWorstOverloads = 16
+    };
+
+    /** Clears the statistics and sets the block size and rate that are expected.
+        This must be called before the callbacks start, rather than while they're running.
+    */
+    void prepare (double sampleRate, int blockSize) noexcept;
+
+    /** Clears all the statistics that have been gathered so far.
+
+        This can be called while the callbacks are running. The audio thread's counters
+        are only cleared at the start of the next callback, but snapshots taken before
+        then will already be empty.
+    */
+    void reset();
+
+    /** Sets the proportion of the block duration above which a callback is
+        counted as an overload. The default is 0.8.
+    */
+    void setOverloadThreshold (double proportionOfBlockDuration) noexcept;
+
+    /** Returns the threshold that was set with setOverloadThreshold(). */
+    double getOverloadThreshold() const noexcept;
+
+    //==============================================================================
+    /** Records the timing of a callback.
+
+        This is designed to be called on the audio thread, and is lock-free.
+
+        @param startTimeMs  the time, from Time::getMillisecondCounterHiRes(), at which the
+                            callback began
+        @param endTimeMs    the time, from Time::getMillisecondCounterHiRes(), at which it returned
+        @param numSamples   the number of samples that the callback processed
+    */
+    void addCallback (double startTimeMs, double endTimeMs, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Describes a callback which took longer than the overload threshold. */
+    struct JUCE_API  Overload
+    {
+        int64 time;                         /**< When the callback started, in milliseconds since the epoch. */
+        double durationMs;                  /**< How long it took. */
+        double proportionOfBlockDuration;   /**< Its duration, relative to the block duration. */
+    };
+
+    /** A copy of the statistics at a moment in time. */
+    struct JUCE_API  Snapshot
+    {
+        Snapshot() noexcept;
+
+        double sampleRate;                  /**< The rate that was passed to prepare(). */
+        int blockSize;                      /**< The block size that was passed to prepare(). */
+        double overloadThreshold;           /**< The current overload threshold. */
+
+        int64 numCallbacks;                 /**< The number of callbacks that were recorded. */
+        int64 numOverloads;                 /**< The number that took longer than the overload threshold. */
+        int64 numDeadlineMisses;            /**< The number that took longer than their block duration. */
+        double minDurationMs;               /**< The quickest callback. */
+        double maxDurationMs;               /**< The slowest callback. */
+        double averageDurationMs;           /**< The mean time taken by the callbacks. */
+        double maxIntervalMs;               /**< The longest gap between the starts of two callbacks. */
+
+        /** The numbers of callbacks whose duration fell into each 5% band of the block duration. */
+        int64 durationHistogram [numHistogramBins];
+
+        /** The numbers of gaps between the start of one callback and the next, in 5% bands of the
+            first callback's block duration. For a steady device, these will cluster around 100%.
+        */
+        int64 intervalHistogram [numHistogramBins];
+
+        /** The slowest callbacks that exceeded the overload threshold, slowest first. */
+        Array<Overload> worstOverloads;
+
+        /** Returns the statistics as a set of nested DynamicObjects and arrays. */
+        var toVar() const;
+
+        /** Returns the statistics formatted as JSON.
+            The times of the overloads are written as milliseconds since the epoch.
+        */
+        String toJSON() const;
+    };
+
+    /** Returns the current statistics. */
+    Snapshot getSnapshot();
+
+    /** Returns the current statistics formatted as JSON.
+        This is the same as calling getSnapshot().toJSON().
+    */
+    String toJSON();
+
+private:
+    //==============================================================================
+    double sampleRate;
+    int blockSize;
+    Atomic<int> overloadThresholdPercent;
+
+    Atomic<int64> numCallbacks, numOverloads, numDeadlineMisses;
+    Atomic<int64> totalDurationMicros, minDurationMicros, maxDurationMicros, maxIntervalMicros;
+    Atomic<int64> durationHistogram [numHistogramBins];
+    Atomic<int64> intervalHistogram [numHistogramBins];
+    double lastStartTimeMs, lastBlockDurationMs;
+    Atomic<int> resetPending;
+
+    struct PendingOverload
+    {
+        double startTimeMs, durationMs, proportionOfBlockDuration;
+    };
+
+    AbstractFifo overloadFifo;
+    HeapBlock<PendingOverload> pendingOverloads;
+    CriticalSection readerLock;
+    Array<Overload> worstOverloads;
+
+    static int getBinForProportion (double proportion) noexcept;
+    void clearCounters() noexcept;
+    void collectPendingOverloads();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioCallbackTimingStatistics)
+};
+
+
+#endif   // __JUCE_AUDIOCALLBACKTIMINGSTATISTICS_JUCEHEADER__
@@ -161,8 +161,14 @@ void AudioDeviceManager::createAudioDeviceTypes (OwnedArray <AudioIODeviceType>&
 
 void AudioDeviceManager::addAudioDeviceType (AudioIODeviceType* newDeviceType)
 {
-    jassert (newDeviceType != nullptr);
-    availableDeviceTypes.add (newDeviceType);
+    if (newDeviceType != nullptr)
+    {
+        jassert (lastDeviceTypeConfigs.size() == availableDeviceTypes.size());
+        availableDeviceTypes.add (newDeviceType);
+        lastDeviceTypeConfigs.add (new AudioDeviceSetup());
+
+        newDeviceType->addListener (callbackHandler);
+    }
 }
 
 //==============================================================================
@@ -654,7 +660,9 @@ void AudioDeviceManager::audioDeviceIOCallbackInt (const float** inputChannelDat
                                                    int numOutputChannels,
                                                    int numSamples)
 {
+    const double startTime = Time::getMillisecondCounterHiRes();
     const ScopedLock sl (audioCallbackLock);
+    const RealtimeSafetyChecker::ScopedRealtimeThread realtimeThread;
 
     if (inputLevelMeasurementEnabledCount > 0 && numInputChannels > 0)
     {
@@ -730,6 +738,8 @@ void AudioDeviceManager::audioDeviceIOCallbackInt (const float** inputChannelDat
         if (testSoundPosition >= testSound->getNumSamples())
             testSound = nullptr;
     }
+
+    callbackTimingStatistics.addCallback (startTime, Time::getMillisecondCounterHiRes(), numSamples);
 }
 
 void AudioDeviceManager::audioDeviceAboutToStartInt (AudioIODevice* const device)
@@ -745,6 +755,8 @@ void AudioDeviceManager::audioDeviceAboutToStartInt (AudioIODevice* const device
         timeToCpuScale = (msPerBlock > 0.0) ? (1.0 / msPerBlock) : 0.0;
     }
 
+    callbackTimingStatistics.prepare (sampleRate, blockSize);
+
     {
         const ScopedLock sl (audioCallbackLock);
         for (int i = callbacks.size(); --i >= 0;)
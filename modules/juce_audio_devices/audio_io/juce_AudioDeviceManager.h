@@ -27,6 +27,7 @@
 #define __JUCE_AUDIODEVICEMANAGER_JUCEHEADER__
 
 #include "juce_AudioIODeviceType.h"
+#include "juce_AudioCallbackTimingStatistics.h"
 #include "../midi_io/juce_MidiInput.h"
 #include "../midi_io/juce_MidiOutput.h"
 
@@ -62,7 +63,8 @@
     re-registering with different midi devices if they are changed or deleted.
 
     And yet another neat trick is that amount of CPU time being used is measured and
-    available with the getCpuUsage() method.
+    available with the getCpuUsage() method, with more detailed figures available from
+    getCallbackTimingStatistics().
 
     The AudioDeviceManager is a ChangeBroadcaster, and will send a change message to
     listeners whenever one of its settings is changed.
@@ -308,6 +310,17 @@ public:
     */
     double getCpuUsage() const;
 
+    /** Returns the detailed timing statistics that are gathered for the audio callbacks.
+
+        These are reset each time the device starts. They include histograms of the time
+        taken by each callback and of the intervals between callbacks, and details of the
+        callbacks that overran, and can be exported as JSON.
+
+        The statistics object is updated without locking on the audio thread, and can be
+        read from the message thread while the device is running.
+    */
+    AudioCallbackTimingStatistics& getCallbackTimingStatistics() noexcept    { return callbackTimingStatistics; }
+
     //==============================================================================
     /** Enables or disables a midi input device.
 
@@ -475,6 +488,7 @@ private:
     CriticalSection audioCallbackLock, midiCallbackLock;
 
     double cpuUsageMs, timeToCpuScale;
+    AudioCallbackTimingStatistics callbackTimingStatistics;
 
     //==============================================================================
     class CallbackHandler;
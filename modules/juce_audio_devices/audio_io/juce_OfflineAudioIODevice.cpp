@@ -0,0 +1,610 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+OfflineAudioIODevice::RenderStatistics::RenderStatistics() noexcept
+    : numCallbacks (0),
+      numSamples (0),
+      totalCallbackTimeMs (0),
+      minCallbackTimeMs (0),
+      maxCallbackTimeMs (0),
+      elapsedTimeMs (0),
+      sampleRate (0)
+{
+}
+
+double OfflineAudioIODevice::RenderStatistics::getAverageCallbackTimeMs() const noexcept
+{
+    return numCallbacks > 0 ? totalCallbackTimeMs / (double) numCallbacks : 0.0;
+}
+
+double OfflineAudioIODevice::RenderStatistics::getRealtimeFactor() const noexcept
+{
+    return (elapsedTimeMs > 0 && sampleRate > 0) ? (numSamples * 1000.0 / sampleRate) / elapsedTimeMs : 0.0;
+}
+
+//==============================================================================
+OfflineAudioIODevice::OfflineAudioIODevice (const String& deviceName, const RenderMode mode,
+                                            const int numIns, const int numOuts)
+    : AudioIODevice (deviceName, "Offline"),
+      Thread ("Juce Offline Audio"),
+      renderMode (mode),
+      numInputChannels (jmax (0, numIns)),
+      numOutputChannels (jmax (1, numOuts)),
+      sampleRate (44100.0),
+      bufferSize (512),
+      deviceIsOpen (false),
+      callback (nullptr),
+      inputBuffer (nullptr),
+      outputBuffer (nullptr),
+      inputData (1, 1),
+      outputData (1, 1),
+      rendering (false),
+      numSamplesToRender (0),
+      numSamplesRendered (0),
+      renderStartTime (0),
+      renderFinishedEvent (true)
+{
+}
+
+OfflineAudioIODevice::~OfflineAudioIODevice()
+{
+    close();
+}
+
+//==============================================================================
+void OfflineAudioIODevice::setInputSource (AudioFormatReader* const reader, const bool deleteReaderWhenDone)
+{
+    jassert (! rendering); // you can't change the source while a render is running!
+
+    const ScopedLock sl (callbackLock);
+    inputBuffer = nullptr;
+    inputReader.set (reader, deleteReaderWhenDone);
+}
+
+void OfflineAudioIODevice::setInputSource (const AudioSampleBuffer* const buffer)
+{
+    jassert (! rendering); // you can't change the source while a render is running!
+
+    const ScopedLock sl (callbackLock);
+    inputReader.set (nullptr, false);
+    inputBuffer = buffer;
+}
+
+void OfflineAudioIODevice::setOutputDestination (AudioFormatWriter* const writer, const bool deleteWriterWhenDone)
+{
+    jassert (! rendering); // you can't change the destination while a render is running!
+
+    // the writer gets the active output channels in order, so it can't have more channels than the device
+    jassert (writer == nullptr || writer->getNumChannels() <= numOutputChannels);
+
+    const ScopedLock sl (callbackLock);
+    outputBuffer = nullptr;
+    outputWriter.set (writer, deleteWriterWhenDone);
+}
+
+void OfflineAudioIODevice::setOutputDestination (AudioSampleBuffer* const buffer)
+{
+    jassert (! rendering); // you can't change the destination while a render is running!
+
+    const ScopedLock sl (callbackLock);
+    outputWriter.set (nullptr, false);
+    outputBuffer = buffer;
+}
+
+//==============================================================================
+void OfflineAudioIODevice::startRendering (const int64 numSamples)
+{
+    jassert (deviceIsOpen); // the device needs to be opened before it can render anything
+
+    stopRendering();
+
+    {
+        const ScopedLock sl (callbackLock);
+        numSamplesToRender = numSamples;
+        numSamplesRendered = 0;
+        renderStartTime = Time::getMillisecondCounterHiRes();
+
+        const SpinLock::ScopedLockType ssl (statisticsLock);
+        statistics = RenderStatistics();
+        statistics.sampleRate = sampleRate;
+    }
+
+    renderFinishedEvent.reset();
+    rendering = true;
+    renderStartedEvent.signal();
+}
+
+void OfflineAudioIODevice::stopRendering()
+{
+    if (rendering)
+    {
+        rendering = false;
+        notify();
+
+        // make sure the block that was being processed has finished
+        const ScopedLock sl (callbackLock);
+    }
+
+    renderFinishedEvent.signal();
+}
+
+bool OfflineAudioIODevice::waitForRenderToFinish (const int timeOutMilliseconds)
+{
+    return (! rendering) || renderFinishedEvent.wait (timeOutMilliseconds);
+}
+
+OfflineAudioIODevice::RenderStatistics OfflineAudioIODevice::getStatistics() const
+{
+    const SpinLock::ScopedLockType sl (statisticsLock);
+    return statistics;
+}
+
+//==============================================================================
+StringArray OfflineAudioIODevice::getOutputChannelNames()
+{
+    StringArray s;
+
+    for (int i = 0; i < numOutputChannels; ++i)
+        s.add ("Output " + String (i + 1));
+
+    return s;
+}
+
+StringArray OfflineAudioIODevice::getInputChannelNames()
+{
+    StringArray s;
+
+    for (int i = 0; i < numInputChannels; ++i)
+        s.add ("Input " + String (i + 1));
+
+    return s;
+}
+
+namespace OfflineDeviceHelpers
+{
+    static const double sampleRates[] = { 8000.0, 11025.0, 16000.0, 22050.0, 32000.0, 44100.0,
+                                          48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+    static const int bufferSizes[] = { 16, 32, 64, 96, 128, 192, 256, 384, 512, 768,
+                                       1024, 1536, 2048, 4096, 8192 };
+}
+
+int OfflineAudioIODevice::getNumSampleRates()                   { return numElementsInArray (OfflineDeviceHelpers::sampleRates); }
+double OfflineAudioIODevice::getSampleRate (int index)          { return OfflineDeviceHelpers::sampleRates [jlimit (0, getNumSampleRates() - 1, index)]; }
+int OfflineAudioIODevice::getNumBufferSizesAvailable()          { return numElementsInArray (OfflineDeviceHelpers::bufferSizes); }
+int OfflineAudioIODevice::getBufferSizeSamples (int index)      { return OfflineDeviceHelpers::bufferSizes [jlimit (0, getNumBufferSizesAvailable() - 1, index)]; }
+int OfflineAudioIODevice::getDefaultBufferSize()                { return 512; }
+
+String OfflineAudioIODevice::open (const BigInteger& inputChannels, const BigInteger& outputChannels,
+                                   double newSampleRate, int newBufferSize)
+{
+    close();
+    lastError = String::empty;
+
+    // unlike a real device, any rate and block size can be used here
+    sampleRate = newSampleRate > 0 ? newSampleRate : 44100.0;
+    bufferSize = newBufferSize > 0 ? newBufferSize : getDefaultBufferSize();
+
+    activeInputChannels = inputChannels;
+    activeInputChannels.setRange (numInputChannels, activeInputChannels.getHighestBit() + 1 - numInputChannels, false);
+    activeOutputChannels = outputChannels;
+    activeOutputChannels.setRange (numOutputChannels, activeOutputChannels.getHighestBit() + 1 - numOutputChannels, false);
+
+    inputData.setSize (jmax (1, numInputChannels), bufferSize);
+    outputData.setSize (numOutputChannels, bufferSize);
+    inputData.clear();
+    outputData.clear();
+
+    inputChannelPointers.calloc ((size_t) numInputChannels + 1);
+    outputChannelPointers.calloc ((size_t) numOutputChannels + 1);
+    readerChannelPointers.calloc ((size_t) numInputChannels + 1);
+
+    for (int i = 0, chan = 0; i < numInputChannels; ++i)
+    {
+        if (activeInputChannels[i])
+        {
+            inputChannelPointers[chan] = inputData.getSampleData (chan);
+            readerChannelPointers[i] = reinterpret_cast<int*> (inputData.getSampleData (chan));
+            ++chan;
+        }
+    }
+
+    for (int i = 0; i < activeOutputChannels.countNumberOfSetBits(); ++i)
+        outputChannelPointers[i] = outputData.getSampleData (i);
+
+    deviceIsOpen = true;
+    startThread (9);
+
+    return lastError;
+}
+
+void OfflineAudioIODevice::close()
+{
+    if (deviceIsOpen)
+    {
+        stop();
+        stopRendering();
+
+        signalThreadShouldExit();
+        renderStartedEvent.signal();
+        stopThread (5000);
+
+        deviceIsOpen = false;
+    }
+}
+
+bool OfflineAudioIODevice::isOpen()                             { return deviceIsOpen; }
+bool OfflineAudioIODevice::isPlaying()                          { return callback != nullptr; }
+String OfflineAudioIODevice::getLastError()                     { return lastError; }
+int OfflineAudioIODevice::getCurrentBufferSizeSamples()         { return bufferSize; }
+double OfflineAudioIODevice::getCurrentSampleRate()             { return sampleRate; }
+int OfflineAudioIODevice::getCurrentBitDepth()                  { return 32; }
+BigInteger OfflineAudioIODevice::getActiveOutputChannels() const { return activeOutputChannels; }
+BigInteger OfflineAudioIODevice::getActiveInputChannels() const { return activeInputChannels; }
+int OfflineAudioIODevice::getOutputLatencyInSamples()           { return 0; }
+int OfflineAudioIODevice::getInputLatencyInSamples()            { return 0; }
+
+void OfflineAudioIODevice::start (AudioIODeviceCallback* newCallback)
+{
+    if (! deviceIsOpen)
+        newCallback = nullptr;
+
+    if (newCallback != nullptr)
+        newCallback->audioDeviceAboutToStart (this);
+
+    const ScopedLock sl (callbackLock);
+    callback = newCallback;
+}
+
+void OfflineAudioIODevice::stop()
+{
+    AudioIODeviceCallback* oldCallback;
+
+    {
+        const ScopedLock sl (callbackLock);
+        oldCallback = callback;
+        callback = nullptr;
+    }
+
+    if (oldCallback != nullptr)
+        oldCallback->audioDeviceStopped();
+}
+
+//==============================================================================
+void OfflineAudioIODevice::run()
+{
+    uint32 lastPauseTime = Time::getMillisecondCounter();
+
+    while (! threadShouldExit())
+    {
+        if (! rendering)
+        {
+            renderStartedEvent.wait (100);
+            lastPauseTime = Time::getMillisecondCounter();
+            continue;
+        }
+
+        const int numThisTime = numSamplesToRender < 0 ? bufferSize
+                                                       : (int) jmin ((int64) bufferSize, numSamplesToRender - numSamplesRendered);
+
+        if (numThisTime > 0)
+        {
+            if (renderMode == renderInRealTime)
+            {
+                waitForNextBlockDeadline();
+            }
+            else if (Time::getMillisecondCounter() - lastPauseTime > 50)
+            {
+                // this thread has an audio priority but never sleeps while it's rendering
+                // as fast as possible, so it takes a short break now and then to avoid
+                // starving everything else on the machine
+                wait (1);
+                lastPauseTime = Time::getMillisecondCounter();
+            }
+
+            renderNextBlock (numThisTime);
+        }
+        else
+        {
+            rendering = false;
+            renderFinishedEvent.signal();
+        }
+    }
+}
+
+void OfflineAudioIODevice::waitForNextBlockDeadline()
+{
+    const double blockDeadline = renderStartTime + numSamplesRendered * 1000.0 / sampleRate;
+
+    for (;;)
+    {
+        const int msToWait = (int) (blockDeadline - Time::getMillisecondCounterHiRes());
+
+        if (msToWait <= 0 || threadShouldExit() || ! rendering)
+            break;
+
+        wait (msToWait);
+    }
+}
+
+void OfflineAudioIODevice::renderNextBlock (const int numSamples)
+{
+    const ScopedLock sl (callbackLock);
+
+    if (! rendering)
+        return;
+
+    readInput (numSamples);
+
+    const int numActiveIns  = activeInputChannels.countNumberOfSetBits();
+    const int numActiveOuts = activeOutputChannels.countNumberOfSetBits();
+
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    if (callback != nullptr)
+    {
+        callback->audioDeviceIOCallback (inputChannelPointers, numActiveIns,
+                                         outputChannelPointers, numActiveOuts,
+                                         numSamples);
+    }
+    else
+    {
+        outputData.clear (0, numSamples);
+    }
+
+    const double callbackMs = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+    writeOutput (numSamples);
+    numSamplesRendered += numSamples;
+
+    const SpinLock::ScopedLockType ssl (statisticsLock);
+
+    if (statistics.numCallbacks == 0)
+    {
+        statistics.minCallbackTimeMs = callbackMs;
+        statistics.maxCallbackTimeMs = callbackMs;
+    }
+    else
+    {
+        statistics.minCallbackTimeMs = jmin (statistics.minCallbackTimeMs, callbackMs);
+        statistics.maxCallbackTimeMs = jmax (statistics.maxCallbackTimeMs, callbackMs);
+    }
+
+    ++statistics.numCallbacks;
+    statistics.numSamples = numSamplesRendered;
+    statistics.totalCallbackTimeMs += callbackMs;
+    statistics.elapsedTimeMs = Time::getMillisecondCounterHiRes() - renderStartTime;
+}
+
+void OfflineAudioIODevice::readInput (const int numSamples)
+{
+    inputData.clear (0, numSamples);
+
+    if (inputReader != nullptr)
+    {
+        inputReader->read (readerChannelPointers, numInputChannels, numSamplesRendered, numSamples, false);
+
+        if (! inputReader->usesFloatingPointData)
+        {
+            const float multiplier = 1.0f / 0x7fffffff;
+
+            for (int i = 0; i < numInputChannels; ++i)
+            {
+                if (float* const d = reinterpret_cast<float*> (readerChannelPointers[i]))
+                    for (int j = 0; j < numSamples; ++j)
+                        d[j] = *reinterpret_cast<int*> (d + j) * multiplier;
+            }
+        }
+    }
+    else if (inputBuffer != nullptr)
+    {
+        const int numAvailable = (int) jlimit ((int64) 0, (int64) numSamples,
+                                               inputBuffer->getNumSamples() - numSamplesRendered);
+
+        if (numAvailable > 0)
+        {
+            for (int i = 0, chan = 0; i < numInputChannels; ++i)
+            {
+                if (activeInputChannels[i])
+                {
+                    if (i < inputBuffer->getNumChannels())
+                        inputData.copyFrom (chan, 0, *inputBuffer, i, (int) numSamplesRendered, numAvailable);
+
+                    ++chan;
+                }
+            }
+        }
+    }
+}
+
+void OfflineAudioIODevice::writeOutput (const int numSamples)
+{
+    const int numActiveOuts = activeOutputChannels.countNumberOfSetBits();
+
+    if (numActiveOuts < outputData.getNumChannels())
+        for (int i = numActiveOuts; i < outputData.getNumChannels(); ++i)
+            outputData.clear (i, 0, numSamples);
+
+    if (outputWriter != nullptr)
+    {
+        outputWriter->writeFromAudioSampleBuffer (outputData, 0, numSamples);
+    }
+    else if (outputBuffer != nullptr)
+    {
+        const int numToCopy = (int) jlimit ((int64) 0, (int64) numSamples,
+                                            outputBuffer->getNumSamples() - numSamplesRendered);
+
+        if (numToCopy > 0)
+            for (int i = jmin (numActiveOuts, outputBuffer->getNumChannels()); --i >= 0;)
+                outputBuffer->copyFrom (i, (int) numSamplesRendered, outputData, i, 0, numToCopy);
+    }
+}
+
+//==============================================================================
+const char* const OfflineAudioIODeviceType::fastDeviceName     = "Offline (as fast as possible)";
+const char* const OfflineAudioIODeviceType::realTimeDeviceName = "Offline (real-time)";
+
+OfflineAudioIODeviceType::OfflineAudioIODeviceType (const int numIns, const int numOuts)
+    : AudioIODeviceType ("Offline"),
+      numInputChannels (numIns),
+      numOutputChannels (numOuts)
+{
+}
+
+OfflineAudioIODeviceType::~OfflineAudioIODeviceType()
+{
+}
+
+void OfflineAudioIODeviceType::scanForDevices()
+{
+}
+
+StringArray OfflineAudioIODeviceType::getDeviceNames (bool) const
+{
+    StringArray s;
+    s.add (fastDeviceName);
+    s.add (realTimeDeviceName);
+    return s;
+}
+
+int OfflineAudioIODeviceType::getDefaultDeviceIndex (bool) const
+{
+    return 0;
+}
+
+int OfflineAudioIODeviceType::getIndexOfDevice (AudioIODevice* device, bool) const
+{
+    return device != nullptr ? getDeviceNames (false).indexOf (device->getName()) : -1;
+}
+
+bool OfflineAudioIODeviceType::hasSeparateInputsAndOutputs() const
+{
+    return false;
+}
+
+AudioIODevice* OfflineAudioIODeviceType::createDevice (const String& outputDeviceName,
+                                                       const String& inputDeviceName)
+{
+    const String deviceName (outputDeviceName.isNotEmpty() ? outputDeviceName : inputDeviceName);
+
+    if (deviceName == fastDeviceName)
+        return new OfflineAudioIODevice (deviceName, OfflineAudioIODevice::renderAsFastAsPossible,
+                                         numInputChannels, numOutputChannels);
+
+    if (deviceName == realTimeDeviceName)
+        return new OfflineAudioIODevice (deviceName, OfflineAudioIODevice::renderInRealTime,
+                                         numInputChannels, numOutputChannels);
+
+    return nullptr;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class OfflineAudioIODeviceTests  : public UnitTest
+{
+public:
+    OfflineAudioIODeviceTests() : UnitTest ("Offline audio device") {}
+
+    struct PassThroughCallback  : public AudioIODeviceCallback
+    {
+        PassThroughCallback() : numCallbacks (0), largestBlock (0) {}
+
+        void audioDeviceIOCallback (const float** ins, int numIns, float** outs, int numOuts, int numSamples)
+        {
+            ++numCallbacks;
+            largestBlock = jmax (largestBlock, numSamples);
+
+            for (int i = 0; i < numOuts; ++i)
+            {
+                if (i < numIns)
+                    memcpy (outs[i], ins[i], sizeof (float) * (size_t) numSamples);
+                else
+                    zeromem (outs[i], sizeof (float) * (size_t) numSamples);
+            }
+        }
+
+        void audioDeviceAboutToStart (AudioIODevice*) {}
+        void audioDeviceStopped() {}
+
+        int numCallbacks, largestBlock;
+    };
+
+    void runTest()
+    {
+        beginTest ("Rendering as fast as possible");
+
+        const int numSamples = 1000, blockSize = 128;
+
+        AudioSampleBuffer source (2, numSamples), dest (2, numSamples);
+        Random r;
+
+        for (int chan = 0; chan < 2; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                *source.getSampleData (chan, i) = r.nextFloat() * 2.0f - 1.0f;
+
+        dest.clear();
+
+        OfflineAudioIODevice device ("test", OfflineAudioIODevice::renderAsFastAsPossible, 2, 2);
+        BigInteger chans;
+        chans.setRange (0, 2, true);
+
+        expect (device.open (chans, chans, 12345.0, blockSize).isEmpty());
+        expect (device.getCurrentSampleRate() == 12345.0);
+
+        PassThroughCallback callback;
+        device.start (&callback);
+        device.setInputSource (&source);
+        device.setOutputDestination (&dest);
+
+        device.startRendering (numSamples);
+        expect (device.waitForRenderToFinish (10000));
+        expect (! device.isRendering());
+        expect (device.getNumSamplesRendered() == numSamples);
+
+        expectEquals (callback.numCallbacks, (numSamples + blockSize - 1) / blockSize);
+        expectEquals (callback.largestBlock, blockSize);
+
+        bool allEqual = true;
+
+        for (int chan = 0; chan < 2; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                allEqual = allEqual && *source.getSampleData (chan, i) == *dest.getSampleData (chan, i);
+
+        expect (allEqual);
+
+        const OfflineAudioIODevice::RenderStatistics stats (device.getStatistics());
+        expect (stats.numCallbacks == callback.numCallbacks);
+        expect (stats.numSamples == numSamples);
+        expect (stats.minCallbackTimeMs <= stats.maxCallbackTimeMs);
+
+        device.stop();
+        device.close();
+    }
+};
+
+static OfflineAudioIODeviceTests offlineAudioIODeviceTests;
+
+#endif
@@ -0,0 +1,316 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_OFFLINEAUDIOIODEVICE_JUCEHEADER__
+#define __JUCE_OFFLINEAUDIOIODEVICE_JUCEHEADER__
+
+#include "juce_AudioIODeviceType.h"
+
+
+//==============================================================================
+/**
+    A virtual audio device that drives its callback without any audio hardware.
+
+    Instead of being clocked by a soundcard, this device runs its own thread which
+    calls the AudioIODeviceCallback either as fast as the callback can process the
+    data, or paced against the system clock so that it behaves like a real device.
+
+    The incoming audio can be read from an AudioFormatReader or an AudioSampleBuffer
+    (or will be silence), and the outgoing audio can be sent to an AudioFormatWriter
+    or an AudioSampleBuffer. Timing statistics for the callbacks are recorded, so
+    it can also be used for benchmarking the exact path that a real device would use.
+
+    Because an AudioDeviceManager starts its devices as soon as they're opened, the
+    device doesn't call back until you explicitly ask it to with startRendering(). A
+    typical use would be something like:
+
+    @code
+    AudioDeviceManager manager;
+    manager.addAudioDeviceType (new OfflineAudioIODeviceType());
+    manager.setCurrentAudioDeviceType ("Offline", true);
+    manager.initialise (0, 2, nullptr, false);
+    manager.addAudioCallback (&myPlayer);
+
+    if (OfflineAudioIODevice* device = dynamic_cast <OfflineAudioIODevice*> (manager.getCurrentAudioDevice()))
+    {
+        device->setOutputDestination (myWavWriter, true);
+        device->startRendering (numSamplesToBounce);
+        device->waitForRenderToFinish (-1);
+    }
+    @endcode
+
+    @see OfflineAudioIODeviceType, AudioIODevice
+*/
+class JUCE_API  OfflineAudioIODevice  : public AudioIODevice,
+                                        private Thread
+{
+public:
+    //==============================================================================
+    /** The ways in which the device can schedule its callbacks. */
+    enum RenderMode
+    {
+        renderAsFastAsPossible,   /**< Each block is processed as soon as the previous one has finished. */
+        renderInRealTime          /**< Blocks are paced to the wall clock, like a real soundcard. */
+    };
+
+    /** Creates a device.
+        Normally you'd let an OfflineAudioIODeviceType create these for you.
+    */
+    OfflineAudioIODevice (const String& deviceName,
+                          RenderMode mode,
+                          int numInputChannels,
+                          int numOutputChannels);
+
+    /** Destructor. */
+    ~OfflineAudioIODevice();
+
+    /** Returns the mode that was passed to the constructor. */
+    RenderMode getRenderMode() const noexcept                   { return renderMode; }
+
+    //==============================================================================
+    /** Sets a reader from which the incoming audio data will be read.
+
+        Each render starts reading from the beginning of the reader, and the data is
+        padded with silence if the render is longer than the reader.
+        This must not be called while a render is in progress.
+    */
+    void setInputSource (AudioFormatReader* reader, bool deleteReaderWhenDone);
+
+    /** Sets a buffer from which the incoming audio data will be read.
+
+        The buffer isn't copied, so it must stay valid until the device is deleted or
+        another input source is set. Pass nullptr to use silence as the input.
+        This must not be called while a render is in progress.
+    */
+    void setInputSource (const AudioSampleBuffer* buffer);
+
+    /** Sets a writer to which the output of the callback will be written.
+        This must not be called while a render is in progress.
+    */
+    void setOutputDestination (AudioFormatWriter* writer, bool deleteWriterWhenDone);
+
+    /** Sets a buffer into which the output of the callback will be copied.
+
+        The buffer isn't resized, so anything that doesn't fit into it is discarded.
+        It isn't copied either, so must stay valid until the device is deleted or
+        another destination is set. Pass nullptr to discard the output.
+        This must not be called while a render is in progress.
+    */
+    void setOutputDestination (AudioSampleBuffer* buffer);
+
+    //==============================================================================
+    /** Starts calling the callback.
+
+        The device must have been opened and started before this will do anything.
+
+        @param numSamplesToRender   the total number of samples to process before the render
+                                    stops. If this is negative, it'll keep going until
+                                    stopRendering() is called. The last block may be shorter
+                                    than the device's buffer size so that the exact length
+                                    is rendered.
+    */
+    void startRendering (int64 numSamplesToRender);
+
+    /** Stops any render that's in progress. */
+    void stopRendering();
+
+    /** Returns true if a render has been started and hasn't yet finished. */
+    bool isRendering() const noexcept                           { return rendering; }
+
+    /** Blocks until the current render has finished.
+        @param timeOutMilliseconds  the maximum time to wait, or -1 to wait forever
+        @returns true if the render has finished
+    */
+    bool waitForRenderToFinish (int timeOutMilliseconds);
+
+    /** Returns the number of samples that have been processed by the current or last render. */
+    int64 getNumSamplesRendered() const noexcept                { return numSamplesRendered; }
+
+    //==============================================================================
+    /** Timing information about the callbacks made during a render. */
+    struct JUCE_API  RenderStatistics
+    {
+        RenderStatistics() noexcept;
+
+        int64 numCallbacks;               /**< The number of blocks that were processed. */
+        int64 numSamples;                 /**< The total number of samples that were processed. */
+        double totalCallbackTimeMs;       /**< The total time spent inside the callback. */
+        double minCallbackTimeMs;         /**< The quickest callback. */
+        double maxCallbackTimeMs;         /**< The slowest callback. */
+        double elapsedTimeMs;             /**< The wall-clock time since the render started. */
+        double sampleRate;                /**< The rate at which the device was running. */
+
+        /** Returns the mean time spent in the callback. */
+        double getAverageCallbackTimeMs() const noexcept;
+
+        /** Returns the length of audio that was processed, divided by the time it took to
+            process it. A value of 10 means that the callback could run 10 times faster
+            than real-time.
+        */
+        double getRealtimeFactor() const noexcept;
+    };
+
+    /** Returns the timing information for the current or last render. */
+    RenderStatistics getStatistics() const;
+
+    //==============================================================================
+    /** @internal */
+    StringArray getOutputChannelNames();
+    /** @internal */
+    StringArray getInputChannelNames();
+    /** @internal */
+    int getNumSampleRates();
+    /** @internal */
+    double getSampleRate (int index);
+    /** @internal */
+    int getNumBufferSizesAvailable();
+    /** @internal */
+    int getBufferSizeSamples (int index);
+    /** @internal */
+    int getDefaultBufferSize();
+    /** @internal */
+    String open (const BigInteger& inputChannels, const BigInteger& outputChannels,
+                 double sampleRate, int bufferSizeSamples);
+    /** @internal */
+    void close();
+    /** @internal */
+    bool isOpen();
+    /** @internal */
+    void start (AudioIODeviceCallback* callback);
+    /** @internal */
+    void stop();
+    /** @internal */
+    bool isPlaying();
+    /** @internal */
+    String getLastError();
+    /** @internal */
+    int getCurrentBufferSizeSamples();
+    /** @internal */
+    double getCurrentSampleRate();
+    /** @internal */
+    int getCurrentBitDepth();
+    /** @internal */
+    BigInteger getActiveOutputChannels() const;
+    /** @internal */
+    BigInteger getActiveInputChannels() const;
+    /** @internal */
+    int getOutputLatencyInSamples();
+    /** @internal */
+    int getInputLatencyInSamples();
+
+private:
+    //==============================================================================
+    const RenderMode renderMode;
+    const int numInputChannels, numOutputChannels;
+    double sampleRate;
+    int bufferSize;
+    bool deviceIsOpen;
+    BigInteger activeInputChannels, activeOutputChannels;
+    String lastError;
+
+    AudioIODeviceCallback* callback;
+    CriticalSection callbackLock;
+
+    OptionalScopedPointer<AudioFormatReader> inputReader;
+    const AudioSampleBuffer* inputBuffer;
+    OptionalScopedPointer<AudioFormatWriter> outputWriter;
+    AudioSampleBuffer* outputBuffer;
+
+    AudioSampleBuffer inputData, outputData;
+    HeapBlock<const float*> inputChannelPointers;
+    HeapBlock<float*> outputChannelPointers;
+    HeapBlock<int*> readerChannelPointers;
+
+    volatile bool rendering;
+    int64 numSamplesToRender, numSamplesRendered;
+    double renderStartTime;
+    WaitableEvent renderStartedEvent, renderFinishedEvent;
+
+    RenderStatistics statistics;
+    SpinLock statisticsLock;
+
+    void run();
+    void renderNextBlock (int numSamples);
+    void readInput (int numSamples);
+    void writeOutput (int numSamples);
+    void waitForNextBlockDeadline();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineAudioIODevice)
+};
+
+
+//==============================================================================
+/**
+    An AudioIODeviceType that creates OfflineAudioIODevice objects.
+
+    This type isn't included in the list that AudioDeviceManager::createAudioDeviceTypes()
+    returns, because it's not something that you'd want to offer to an end-user. To use
+    it, add one to your AudioDeviceManager with AudioDeviceManager::addAudioDeviceType().
+
+    It provides two devices: one which renders as fast as possible, and one which paces
+    its callbacks to the system clock.
+
+    @see OfflineAudioIODevice
+*/
+class JUCE_API  OfflineAudioIODeviceType  : public AudioIODeviceType
+{
+public:
+    //==============================================================================
+    /** Creates the device type.
+        The numbers of channels specify how many channels the devices will offer.
+    */
+    OfflineAudioIODeviceType (int numInputChannels = 2,
+                              int numOutputChannels = 2);
+
+    /** Destructor. */
+    ~OfflineAudioIODeviceType();
+
+    /** The name of the device that renders as fast as possible. */
+    static const char* const fastDeviceName;
+    /** The name of the device that renders in real-time. */
+    static const char* const realTimeDeviceName;
+
+    //==============================================================================
+    /** @internal */
+    void scanForDevices();
+    /** @internal */
+    StringArray getDeviceNames (bool wantInputNames) const;
+    /** @internal */
+    int getDefaultDeviceIndex (bool forInput) const;
+    /** @internal */
+    int getIndexOfDevice (AudioIODevice* device, bool asInput) const;
+    /** @internal */
+    bool hasSeparateInputsAndOutputs() const;
+    /** @internal */
+    AudioIODevice* createDevice (const String& outputDeviceName, const String& inputDeviceName);
+
+private:
+    const int numInputChannels, numOutputChannels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineAudioIODeviceType)
+};
+
+
+#endif   // __JUCE_OFFLINEAUDIOIODEVICE_JUCEHEADER__
@@ -102,6 +102,9 @@ namespace juce
 {
 
 // START_AUTOINCLUDE audio_io, midi_io, sources, audio_cd
+#ifndef __JUCE_AUDIOCALLBACKTIMINGSTATISTICS_JUCEHEADER__
+ #include "audio_io/juce_AudioCallbackTimingStatistics.h"
+#endif
 #ifndef __JUCE_AUDIODEVICEMANAGER_JUCEHEADER__
  #include "audio_io/juce_AudioDeviceManager.h"
 #endif
@@ -111,6 +114,9 @@ namespace juce
 #ifndef __JUCE_AUDIOIODEVICETYPE_JUCEHEADER__
  #include "audio_io/juce_AudioIODeviceType.h"
 #endif
+#ifndef __JUCE_OFFLINEAUDIOIODEVICE_JUCEHEADER__
+ #include "audio_io/juce_OfflineAudioIODevice.h"
+#endif
 #ifndef __JUCE_MIDIINPUT_JUCEHEADER__
  #include "midi_io/juce_MidiInput.h"
 #endif
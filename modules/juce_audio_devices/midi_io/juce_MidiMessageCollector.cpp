@@ -23,10 +23,17 @@
   ==============================================================================
 */
 
-MidiMessageCollector::MidiMessageCollector()
+MidiMessageCollector::MidiMessageCollector (const int queueSizeInBytes)
     : lastCallbackTime (0),
+      fifo (queueSizeInBytes),
+      currentGeneration (0),
+      newSampleRate (44100.0001),
+      resetTime (0),
+      maxMessageSize (jmax (256, queueSizeInBytes)),
       sampleRate (44100.0001)
 {
+    messageData.malloc ((size_t) maxMessageSize);
+    incomingMessages.ensureSize ((size_t) maxMessageSize);
 }
 
 MidiMessageCollector::~MidiMessageCollector()
@@ -38,45 +45,71 @@ void MidiMessageCollector::reset (const double sampleRate_)
 {
     jassert (sampleRate_ > 0);
 
-    const ScopedLock sl (midiCallbackLock);
-    sampleRate = sampleRate_;
-    incomingMessages.clear();
-    lastCallbackTime = Time::getMillisecondCounterHiRes();
+    // Only the audio thread may read from the queue, so rather than emptying it here,
+    // this bumps the generation number, and removeNextBlockOfMessages() will throw
+    // away any messages that were queued before it changed. The audio thread picks up
+    // the new sample rate at the same time, so it's passed over under the lock.
+    const SpinLock::ScopedLockType sl (resetLock);
+
+    newSampleRate = sampleRate_;
+    resetTime = Time::getMillisecondCounterHiRes();
+    ++resetGeneration;
 }
 
 void MidiMessageCollector::addMessageToQueue (const MidiMessage& message)
 {
     // you need to call reset() to set the correct sample rate before using this object
-    jassert (sampleRate != 44100.0001);
+    jassert (resetGeneration.get() != 0);
 
     // the messages that come in here need to be time-stamped correctly - see MidiInput
     // for details of what the number should be.
     jassert (message.getTimeStamp() != 0);
 
-    const ScopedLock sl (midiCallbackLock);
+    fifo.push (message, resetGeneration.get());
+}
 
-    const int sampleNumber
-        = (int) ((message.getTimeStamp() - 0.001 * lastCallbackTime) * sampleRate);
+void MidiMessageCollector::fillIncomingMessages (const double previousCallbackTime)
+{
+    incomingMessages.clear();
 
-    incomingMessages.addEvent (message, sampleNumber);
+    const int generation = currentGeneration;
+    int numBytes, tag;
+    double timeStamp;
 
-    // if the messages don't get used for over a second, we'd better
-    // get rid of any old ones to avoid the queue getting too big
-    if (sampleNumber > sampleRate)
-        incomingMessages.clear (0, sampleNumber - (int) sampleRate);
+    while (fifo.pop (messageData, maxMessageSize, numBytes, timeStamp, &tag))
+    {
+        if (numBytes > 0 && tag == generation)
+        {
+            const int sampleNumber = (int) ((timeStamp - 0.001 * previousCallbackTime) * sampleRate);
+            incomingMessages.addEvent (messageData, numBytes, sampleNumber);
+        }
+    }
 }
 
 void MidiMessageCollector::removeNextBlockOfMessages (MidiBuffer& destBuffer,
                                                       const int numSamples)
 {
     // you need to call reset() to set the correct sample rate before using this object
-    jassert (sampleRate != 44100.0001);
+    jassert (resetGeneration.get() != 0);
     jassert (numSamples > 0);
 
+    if (resetGeneration.get() != currentGeneration)
+    {
+        const SpinLock::ScopedTryLockType sl (resetLock);
+
+        // if reset() is halfway through, just leave the queue alone until the next block
+        if (! sl.isLocked())
+            return;
+
+        sampleRate = newSampleRate;
+        lastCallbackTime = resetTime;
+        currentGeneration = resetGeneration.get();
+    }
+
     const double timeNow = Time::getMillisecondCounterHiRes();
     const double msElapsed = timeNow - lastCallbackTime;
 
-    const ScopedLock sl (midiCallbackLock);
+    fillIncomingMessages (lastCallbackTime);
     lastCallbackTime = timeNow;
 
     if (! incomingMessages.isEmpty())
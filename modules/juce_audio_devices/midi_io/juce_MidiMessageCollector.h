@@ -44,8 +44,12 @@ class JUCE_API  MidiMessageCollector    : public MidiKeyboardStateListener,
 {
 public:
     //==============================================================================
-    /** Creates a MidiMessageCollector. */
-    MidiMessageCollector();
+    /** Creates a MidiMessageCollector.
+
+        @param queueSizeInBytes     the amount of space to preallocate for messages that
+                                    are waiting to be collected
+    */
+    explicit MidiMessageCollector (int queueSizeInBytes = 32768);
 
     /** Destructor. */
     ~MidiMessageCollector();
@@ -55,6 +59,11 @@ public:
 
         You need to call this method before starting to use the collector, so that
         it knows the correct sample rate to use.
+
+        The queue isn't actually emptied until the next call to removeNextBlockOfMessages(),
+        which discards everything that was added before the reset and starts using the new
+        sample rate, so this can safely be called while the audio thread is running. It
+        shouldn't be called by more than one thread at a time, though.
     */
     void reset (double sampleRate);
 
@@ -64,7 +73,10 @@ public:
         of the block returned by the next call to removeNextBlockOfMessages().
 
         This method is fully thread-safe when overlapping calls are made with
-        removeNextBlockOfMessages().
+        removeNextBlockOfMessages(), and can be called from more than one thread.
+        The messages are stored in a preallocated queue, so if far too many arrive
+        between two calls to removeNextBlockOfMessages(), the excess ones will be
+        dropped.
     */
     void addMessageToQueue (const MidiMessage& message);
 
@@ -78,7 +90,8 @@ public:
         midi event positions.
 
         This method is fully thread-safe when overlapping calls are made with
-        addMessageToQueue().
+        addMessageToQueue(), and it never blocks or allocates any memory (unless
+        destBuffer needs to grow), so is safe to call from an audio thread.
 
         Precondition: numSamples must be greater than 0.
     */
@@ -96,10 +109,18 @@ public:
 private:
     //==============================================================================
     double lastCallbackTime;
-    CriticalSection midiCallbackLock;
+    MidiMessageFifo fifo;
+    Atomic<int> resetGeneration;
+    int currentGeneration;
+    SpinLock resetLock;
+    double newSampleRate, resetTime;
     MidiBuffer incomingMessages;
+    HeapBlock<uint8> messageData;
+    const int maxMessageSize;
     double sampleRate;
 
+    void fillIncomingMessages (double previousCallbackTime);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiMessageCollector)
 };
 
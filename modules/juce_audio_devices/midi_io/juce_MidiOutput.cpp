@@ -23,21 +23,209 @@
   ==============================================================================
 */
 
-struct MidiOutput::PendingMessage
+//==============================================================================
+/*  A time-ordered queue of messages waiting to be sent.
+
+    The messages live in a pool of slots that is allocated up-front, and a binary
+    heap of slot pointers keeps the earliest one at the front, so adding and removing
+    messages doesn't need to touch the heap allocator unless the pool is exhausted.
+*/
+class MidiOutput::PendingMessageQueue
 {
-    PendingMessage (const void* const data, const int len, const double timeStamp)
-        : message (data, len, timeStamp)
-    {}
+public:
+    PendingMessageQueue (const int initialCapacity)
+        : numUsed (0), numFree (0), nextSequenceNumber (0)
+    {
+        addSlots (initialCapacity);
+    }
+
+    bool isEmpty() const noexcept               { return numUsed == 0; }
+    double getNextEventTime() const noexcept    { jassert (numUsed > 0); return heap[0]->time; }
+
+    void add (const uint8* const data, const int numBytes, const double time)
+    {
+        if (numFree == 0)
+            addSlots (slots.size());
+
+        Slot* const slot = freeSlots [--numFree];
+        slot->setData (data, numBytes);
+        slot->time = time;
+        slot->sequenceNumber = nextSequenceNumber++;
+
+        int i = numUsed++;
+
+        while (i > 0)
+        {
+            const int parent = (i - 1) / 2;
+
+            if (! slot->isEarlierThan (*heap[parent]))
+                break;
+
+            heap[i] = heap[parent];
+            i = parent;
+        }
+
+        heap[i] = slot;
+    }
+
+    void removeNext (MidiBuffer* const dest)
+    {
+        jassert (numUsed > 0);
+        Slot* const first = heap[0];
+
+        if (dest != nullptr)
+            dest->addEvent (first->data, first->numBytes, 0);
+
+        freeSlots [numFree++] = first;
+
+        Slot* const last = heap [--numUsed];
+        int i = 0;
+
+        for (;;)
+        {
+            const int child1 = i * 2 + 1;
+            const int child2 = child1 + 1;
+            int earliest = i;
+            Slot* earliestSlot = last;
+
+            if (child1 < numUsed && heap[child1]->isEarlierThan (*earliestSlot))
+            {
+                earliest = child1;
+                earliestSlot = heap[child1];
+            }
+
+            if (child2 < numUsed && heap[child2]->isEarlierThan (*earliestSlot))
+            {
+                earliest = child2;
+                earliestSlot = heap[child2];
+            }
+
+            heap[i] = earliestSlot;
+
+            if (earliest == i)
+                break;
+
+            i = earliest;
+        }
+    }
+
+    void clear()
+    {
+        while (numUsed > 0)
+            freeSlots [numFree++] = heap [--numUsed];
+    }
+
+private:
+    struct Slot
+    {
+        Slot() : time (0), sequenceNumber (0), data (8), numBytes (0), allocatedSize (8) {}
 
-    MidiMessage message;
-    PendingMessage* next;
+        void setData (const uint8* const newData, const int newSize)
+        {
+            if (newSize > allocatedSize)
+            {
+                allocatedSize = newSize;
+                data.malloc ((size_t) allocatedSize);
+            }
+
+            memcpy (data, newData, (size_t) newSize);
+            numBytes = newSize;
+        }
+
+        bool isEarlierThan (const Slot& other) const noexcept
+        {
+            return time < other.time
+                    || (time == other.time && (int) (sequenceNumber - other.sequenceNumber) < 0);
+        }
+
+        double time;
+        uint32 sequenceNumber;
+        HeapBlock<uint8> data;
+        int numBytes, allocatedSize;
+    };
+
+    OwnedArray<Slot> slots;
+    HeapBlock<Slot*> heap, freeSlots;
+    int numUsed, numFree;
+    uint32 nextSequenceNumber;
+
+    void addSlots (const int numToAdd)
+    {
+        const int newSize = slots.size() + jmax (1, numToAdd);
+        slots.ensureStorageAllocated (newSize);
+        heap.realloc ((size_t) newSize);
+        freeSlots.realloc ((size_t) newSize);
+
+        while (slots.size() < newSize)
+        {
+            Slot* const slot = new Slot();
+            slots.add (slot);
+            freeSlots [numFree++] = slot;
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (PendingMessageQueue)
 };
 
+//==============================================================================
+namespace MidiOutputHelpers
+{
+    // Sleeps until the millisecond counter reaches a time which is no more than a few
+    // milliseconds away, with as much precision as the platform allows. Where there's no
+    // absolute sleep, it sleeps until it's close, and only spins for the last moment.
+    static void waitUntil (const double targetTime) noexcept
+    {
+       #if JUCE_LINUX || JUCE_ANDROID
+        const double msToWait = targetTime - Time::getMillisecondCounterHiRes();
+
+        if (msToWait > 0)
+        {
+            timespec t;
+            clock_gettime (CLOCK_MONOTONIC, &t);
+
+            const int64 targetNanos = t.tv_nsec + (int64) (msToWait * 1000000.0);
+            t.tv_sec += (time_t) (targetNanos / 1000000000);
+            t.tv_nsec = (long) (targetNanos % 1000000000);
+
+            while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &t, nullptr) == EINTR)
+            {}
+        }
+       #else
+        const double spinTime = 0.1;
+
+        for (;;)
+        {
+            const double msToWait = targetTime - Time::getMillisecondCounterHiRes();
+
+            if (msToWait <= spinTime)
+                break;
+
+           #if JUCE_WINDOWS
+            // (Sleep() can't do less than a millisecond, so anything shorter just gives up the time-slice)
+            Sleep (msToWait > 1.5 ? 1 : 0);
+           #else
+            const int64 nanosToWait = (int64) ((msToWait - spinTime) * 1000000.0);
+
+            timespec t;
+            t.tv_sec = (time_t) (nanosToWait / 1000000000);
+            t.tv_nsec = (long) (nanosToWait % 1000000000);
+            nanosleep (&t, nullptr);
+           #endif
+        }
+
+        while (Time::getMillisecondCounterHiRes() < targetTime)
+        {}
+       #endif
+    }
+}
+
+//==============================================================================
 MidiOutput::MidiOutput()
     : Thread ("midi out"),
       internal (nullptr),
-      firstMessage (nullptr)
+      pendingMessages (new PendingMessageQueue (2048))
 {
+    messagesDue.ensureSize (8192);
 }
 
 void MidiOutput::sendBlockOfMessages (const MidiBuffer& buffer,
@@ -56,45 +244,30 @@ void MidiOutput::sendBlockOfMessages (const MidiBuffer& buffer,
 
     const uint8* data;
     int len, time;
+    bool needsWakeUp = false;
 
-    while (i.getNextEvent (data, len, time))
     {
-        const double eventTime = millisecondCounterToStartAt + timeScaleFactor * time;
-
-        PendingMessage* const m = new PendingMessage (data, len, eventTime);
-
         const ScopedLock sl (lock);
 
-        if (firstMessage == nullptr || firstMessage->message.getTimeStamp() > eventTime)
-        {
-            m->next = firstMessage;
-            firstMessage = m;
-        }
-        else
-        {
-            PendingMessage* mm = firstMessage;
+        const double previousFirstTime = pendingMessages->isEmpty() ? std::numeric_limits<double>::max()
+                                                                    : pendingMessages->getNextEventTime();
 
-            while (mm->next != nullptr && mm->next->message.getTimeStamp() <= eventTime)
-                mm = mm->next;
+        while (i.getNextEvent (data, len, time))
+            pendingMessages->add (data, len, millisecondCounterToStartAt + timeScaleFactor * time);
 
-            m->next = mm->next;
-            mm->next = m;
-        }
+        needsWakeUp = ! pendingMessages->isEmpty()
+                        && pendingMessages->getNextEventTime() < previousFirstTime;
     }
 
-    notify();
+    // only wake the thread if these messages are due before the one it's waiting for
+    if (needsWakeUp)
+        notify();
 }
 
 void MidiOutput::clearAllPendingMessages()
 {
     const ScopedLock sl (lock);
-
-    while (firstMessage != nullptr)
-    {
-        PendingMessage* const m = firstMessage;
-        firstMessage = firstMessage->next;
-        delete m;
-    }
+    pendingMessages->clear();
 }
 
 void MidiOutput::startBackgroundThread()
@@ -107,57 +280,211 @@ void MidiOutput::stopBackgroundThread()
     stopThread (5000);
 }
 
+#if ! (JUCE_LINUX && JUCE_ALSA)
+void MidiOutput::sendMessagesNow (const MidiBuffer& messages)
+{
+    MidiBuffer::Iterator i (messages);
+    const uint8* data;
+    int len, time;
+
+    while (i.getNextEvent (data, len, time))
+        sendMessageNow (MidiMessage (data, len, 0.0));
+}
+#endif
+
 void MidiOutput::run()
 {
+    // The thread sleeps on its event until it's close to the next message's time,
+    // so that it can be woken if something earlier arrives, then uses a more precise
+    // wait for the last couple of milliseconds.
+    const double preciseWaitTime = 2.0;
+
     while (! threadShouldExit())
     {
-        uint32 now = Time::getMillisecondCounter();
-        uint32 eventTime = 0;
-        uint32 timeToWait = 500;
+        double eventTime = 0;
+        bool anyPending;
+
+        {
+            const ScopedLock sl (lock);
+            anyPending = ! pendingMessages->isEmpty();
+
+            if (anyPending)
+                eventTime = pendingMessages->getNextEventTime();
+        }
 
-        PendingMessage* message;
+        if (! anyPending)
+        {
+            wait (500);
+            continue;
+        }
 
+        double now = Time::getMillisecondCounterHiRes();
+
+        if (eventTime > now + preciseWaitTime)
         {
+            wait (jmin (500, (int) (eventTime - now - preciseWaitTime)));
+            continue;
+        }
+
+        MidiOutputHelpers::waitUntil (eventTime);
+
+        if (threadShouldExit())
+            break;
+
+        now = Time::getMillisecondCounterHiRes();
+        messagesDue.clear();
+
+        {
+            // send everything that's now due in a single batch
             const ScopedLock sl (lock);
-            message = firstMessage;
 
-            if (message != nullptr)
+            while (! pendingMessages->isEmpty())
+            {
+                const double nextTime = pendingMessages->getNextEventTime();
+
+                if (nextTime > now)
+                    break;
+
+                // (messages that are very late get dropped rather than sent)
+                pendingMessages->removeNext (nextTime > now - 200.0 ? &messagesDue : nullptr);
+            }
+        }
+
+        if (! messagesDue.isEmpty())
+            sendMessagesNow (messagesDue);
+    }
+
+    clearAllPendingMessages();
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MidiOutputTests  : public UnitTest
+{
+public:
+    MidiOutputTests() : UnitTest ("MidiOutput") {}
+
+    // An output that just records when each message arrives, and which one it was
+    class TimingOutput  : public MidiOutput
+    {
+    public:
+        TimingOutput (const int maxMessages_)
+            : times ((size_t) maxMessages_), indexes ((size_t) maxMessages_),
+              maxMessages (maxMessages_), numReceived (0)
+        {
+        }
+
+        ~TimingOutput()
+        {
+            stopBackgroundThread();
+        }
+
+        void sendMessageNow (const MidiMessage& message)
+        {
+            if (numReceived < maxMessages)
             {
-                eventTime = (uint32) roundToInt (message->message.getTimeStamp());
-
-                if (eventTime > now + 20)
-                {
-                    timeToWait = eventTime - (now + 20);
-                    message = nullptr;
-                }
-                else
-                {
-                    firstMessage = message->next;
-                }
+                times [numReceived] = Time::getMillisecondCounterHiRes();
+                indexes [numReceived] = message.getPitchWheelValue();
+                ++numReceived;
             }
         }
 
-        if (message != nullptr)
+        HeapBlock<double> times;
+        HeapBlock<int> indexes;
+        const int maxMessages;
+        int numReceived;
+    };
+
+    void runTest()
+    {
+        beginTest ("Scheduling accuracy");
+
+        // Ten events per 10ms block, each block being sent a few blocks ahead of time,
+        // like an audio callback would do.
+        const int numBlocks = 100, eventsPerBlock = 10;
+        const double sampleRate = 44100.0, blockLengthMs = 10.0;
+        const int numEvents = numBlocks * eventsPerBlock;
+
+        TimingOutput output (numEvents);
+        HeapBlock<double> expectedTimes ((size_t) numEvents);
+        output.startBackgroundThread();
+
+        const double startTime = Time::getMillisecondCounterHiRes() + 50.0;
+
+        for (int block = 0; block < numBlocks; ++block)
         {
-            const ScopedPointer<PendingMessage> messageDeleter (message);
+            const double blockStartTime = startTime + block * blockLengthMs;
+            MidiBuffer buffer;
 
-            if (eventTime > now)
+            for (int i = 0; i < eventsPerBlock; ++i)
             {
-                Time::waitForMillisecondCounter (eventTime);
+                const int index = block * eventsPerBlock + i;
+                const int samplePosition = (i * 441) / 10;
 
-                if (threadShouldExit())
-                    break;
+                buffer.addEvent (MidiMessage::pitchWheel (1, index), samplePosition);
+                expectedTimes [index] = blockStartTime + samplePosition * 1000.0 / sampleRate;
             }
 
-            if (eventTime > now - 200)
-                sendMessageNow (message->message);
+            output.sendBlockOfMessages (buffer, blockStartTime, sampleRate);
+
+            while (Time::getMillisecondCounterHiRes() < blockStartTime - 30.0)
+                Thread::sleep (1);
+        }
+
+        Thread::sleep ((int) (startTime + numBlocks * blockLengthMs - Time::getMillisecondCounterHiRes()) + 100);
+        output.stopBackgroundThread();
+
+        expectEquals (output.numReceived, numEvents);
+
+        bool allInOrder = true;
+        double totalError = 0, maxError = 0;
+
+        for (int i = 0; i < output.numReceived; ++i)
+        {
+            allInOrder = allInOrder && output.indexes[i] == i;
+
+            const double error = std::abs (output.times[i] - expectedTimes[i]);
+            totalError += error;
+            maxError = jmax (maxError, error);
+        }
+
+        expect (allInOrder);
+
+        const double meanError = totalError / jmax (1, output.numReceived);
+        logMessage ("Sent " + String (output.numReceived) + " events: mean timing error " + String (meanError, 3)
+                     + "ms, max " + String (maxError, 3) + "ms");
+
+        // (this is only a sanity check - a busy machine can delay any thread)
+        expect (meanError < 1.0);
+
+       #if JUCE_LINUX && JUCE_ALSA
+        beginTest ("ALSA output");
+
+        // This just checks that batches go through a real sequencer port without any problems.
+        ScopedPointer<MidiOutput> alsaOutput (MidiOutput::createNewDevice ("JUCE MidiOutput test"));
+
+        if (alsaOutput == nullptr)
+        {
+            logMessage ("(no ALSA sequencer is available, so this was skipped)");
         }
         else
         {
-            jassert (timeToWait < 1000 * 30);
-            wait ((int) timeToWait);
+            alsaOutput->startBackgroundThread();
+
+            MidiBuffer buffer;
+
+            for (int i = 0; i < 100; ++i)
+                buffer.addEvent (MidiMessage::controllerEvent (1, 7, i), (i / 10) * 441);
+
+            alsaOutput->sendBlockOfMessages (buffer, Time::getMillisecondCounterHiRes() + 10.0, sampleRate);
+            Thread::sleep (100);
+            alsaOutput->stopBackgroundThread();
         }
+       #endif
     }
+};
 
-    clearAllPendingMessages();
-}
+static MidiOutputTests midiOutputTests;
+
+#endif
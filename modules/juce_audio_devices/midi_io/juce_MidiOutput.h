@@ -108,6 +108,11 @@ public:
         used by the MidiBuffer. Each event in a MidiBuffer has a sample position, and the
         samplesPerSecondForBuffer value is needed to convert this sample position to a
         real time.
+
+        The pending messages are kept in storage that's allocated when the MidiOutput is
+        created, so as long as there are fewer than a few thousand messages waiting
+        (and they aren't sysex messages longer than a few bytes), this won't allocate
+        any memory, which makes it suitable for calling from an audio callback.
     */
     virtual void sendBlockOfMessages (const MidiBuffer& buffer,
                                       double millisecondCounterToStartAt,
@@ -134,11 +139,13 @@ protected:
     //==============================================================================
     void* internal;
     CriticalSection lock;
-    struct PendingMessage;
-    PendingMessage* firstMessage;
+    class PendingMessageQueue;
+    ScopedPointer<PendingMessageQueue> pendingMessages;
+    MidiBuffer messagesDue;
 
     MidiOutput();
     void run();
+    void sendMessagesNow (const MidiBuffer& messages);
 
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiOutput)
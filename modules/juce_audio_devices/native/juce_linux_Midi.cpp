@@ -192,7 +192,8 @@ public:
         :
           midiOutput (midiOutput_),
           seqHandle (seqHandle_),
-          maxEventSize (16 * 1024)
+          maxEventSize (16 * 1024),
+          drainDeferred (false)
     {
         jassert (seqHandle != 0 && midiOutput != 0);
         snd_midi_event_new (maxEventSize, &midiParser);
@@ -206,9 +207,34 @@ public:
 
     void sendMessageNow (const MidiMessage& message)
     {
-        if (message.getRawDataSize() > maxEventSize)
+        outputMessage (message.getRawData(), message.getRawDataSize());
+
+        if (! drainDeferred)
+            snd_seq_drain_output (seqHandle);
+    }
+
+    // While this is set, sendMessageNow() leaves its events in the sequencer's
+    // output buffer, and they're all flushed when it gets cleared again.
+    void setDrainDeferred (const bool shouldDefer)
+    {
+        drainDeferred = shouldDefer;
+
+        if (! shouldDefer)
+            snd_seq_drain_output (seqHandle);
+    }
+
+private:
+    MidiOutput* const midiOutput;
+    snd_seq_t* const seqHandle;
+    snd_midi_event_t* midiParser;
+    int maxEventSize;
+    bool drainDeferred;
+
+    void outputMessage (const uint8* data, int numBytes)
+    {
+        if (numBytes > maxEventSize)
         {
-            maxEventSize = message.getRawDataSize();
+            maxEventSize = numBytes;
             snd_midi_event_free (midiParser);
             snd_midi_event_new (maxEventSize, &midiParser);
         }
@@ -216,16 +242,15 @@ public:
         snd_seq_event_t event;
         snd_seq_ev_clear (&event);
 
-        long numBytes = (long) message.getRawDataSize();
-        const uint8* data = message.getRawData();
+        long numLeft = (long) numBytes;
 
-        while (numBytes > 0)
+        while (numLeft > 0)
         {
-            const long numSent = snd_midi_event_encode (midiParser, data, numBytes, &event);
+            const long numSent = snd_midi_event_encode (midiParser, data, numLeft, &event);
             if (numSent <= 0)
                 break;
 
-            numBytes -= numSent;
+            numLeft -= numSent;
             data += numSent;
 
             snd_seq_ev_set_source (&event, 0);
@@ -235,16 +260,9 @@ public:
             snd_seq_event_output (seqHandle, &event);
         }
 
-        snd_seq_drain_output (seqHandle);
         snd_midi_event_reset_encode (midiParser);
     }
 
-private:
-    MidiOutput* const midiOutput;
-    snd_seq_t* const seqHandle;
-    snd_midi_event_t* midiParser;
-    int maxEventSize;
-
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiOutputDevice)
 };
 
@@ -298,7 +316,28 @@ MidiOutput::~MidiOutput()
 
 void MidiOutput::sendMessageNow (const MidiMessage& message)
 {
-    static_cast <MidiOutputDevice*> (internal)->sendMessageNow (message);
+    if (MidiOutputDevice* const device = static_cast <MidiOutputDevice*> (internal))
+        device->sendMessageNow (message);
+}
+
+void MidiOutput::sendMessagesNow (const MidiBuffer& messages)
+{
+    MidiOutputDevice* const device = static_cast <MidiOutputDevice*> (internal);
+
+    // (the messages still go through the virtual sendMessageNow(), but the device
+    // only flushes the sequencer once for the whole batch)
+    if (device != nullptr)
+        device->setDrainDeferred (true);
+
+    MidiBuffer::Iterator i (messages);
+    const uint8* data;
+    int len, time;
+
+    while (i.getNextEvent (data, len, time))
+        sendMessageNow (MidiMessage (data, len, 0.0));
+
+    if (device != nullptr)
+        device->setDrainDeferred (false);
 }
 
 
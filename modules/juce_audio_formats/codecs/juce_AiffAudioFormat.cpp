@@ -439,28 +439,9 @@ public:
 
             jassert (! usesFloatingPointData); // (would need to add support for this if it's possible)
 
-            if (littleEndian)
-            {
-                switch (bitsPerSample)
-                {
-                    case 8:     ReadHelper<AudioData::Int32, AudioData::Int8,  AudioData::LittleEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, tempBuffer, (int) numChannels, numThisTime); break;
-                    case 16:    ReadHelper<AudioData::Int32, AudioData::Int16, AudioData::LittleEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, tempBuffer, (int) numChannels, numThisTime); break;
-                    case 24:    ReadHelper<AudioData::Int32, AudioData::Int24, AudioData::LittleEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, tempBuffer, (int) numChannels, numThisTime); break;
-                    case 32:    ReadHelper<AudioData::Int32, AudioData::Int32, AudioData::LittleEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, tempBuffer, (int) numChannels, numThisTime); break;
-                    default:    jassertfalse; break;
-                }
-            }
-            else
-            {
-                switch (bitsPerSample)
-                {
-                    case 8:     ReadHelper<AudioData::Int32, AudioData::Int8,  AudioData::BigEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, tempBuffer, (int) numChannels, numThisTime); break;
-                    case 16:    ReadHelper<AudioData::Int32, AudioData::Int16, AudioData::BigEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, tempBuffer, (int) numChannels, numThisTime); break;
-                    case 24:    ReadHelper<AudioData::Int32, AudioData::Int24, AudioData::BigEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, tempBuffer, (int) numChannels, numThisTime); break;
-                    case 32:    ReadHelper<AudioData::Int32, AudioData::Int32, AudioData::BigEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, tempBuffer, (int) numChannels, numThisTime); break;
-                    default:    jassertfalse; break;
-                }
-            }
+            copySampleData (bitsPerSample, littleEndian,
+                            destSamples, startOffsetInDestBuffer, numDestChannels,
+                            tempBuffer, (int) numChannels, numThisTime);
 
             startOffsetInDestBuffer += numThisTime;
             numSamples -= numThisTime;
@@ -469,6 +450,34 @@ public:
         return true;
     }
 
+    static void copySampleData (unsigned int bitsPerSample, bool littleEndian,
+                                int** destSamples, int startOffsetInDestBuffer, int numDestChannels,
+                                const void* sourceData, int numChannels, int numSamples) noexcept
+    {
+        if (littleEndian)
+        {
+            switch (bitsPerSample)
+            {
+                case 8:     ReadHelper<AudioData::Int32, AudioData::Int8,  AudioData::LittleEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+                case 16:    ReadHelper<AudioData::Int32, AudioData::Int16, AudioData::LittleEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+                case 24:    ReadHelper<AudioData::Int32, AudioData::Int24, AudioData::LittleEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+                case 32:    ReadHelper<AudioData::Int32, AudioData::Int32, AudioData::LittleEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+                default:    jassertfalse; break;
+            }
+        }
+        else
+        {
+            switch (bitsPerSample)
+            {
+                case 8:     ReadHelper<AudioData::Int32, AudioData::Int8,  AudioData::BigEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+                case 16:    ReadHelper<AudioData::Int32, AudioData::Int16, AudioData::BigEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+                case 24:    ReadHelper<AudioData::Int32, AudioData::Int24, AudioData::BigEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+                case 32:    ReadHelper<AudioData::Int32, AudioData::Int32, AudioData::BigEndian>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+                default:    jassertfalse; break;
+            }
+        }
+    }
+
     int bytesPerFrame;
     int64 dataChunkStart;
     bool littleEndian;
@@ -477,6 +486,38 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AiffAudioFormatReader)
 };
 
+//==============================================================================
+class MemoryMappedAiffReader   : public MemoryMappedAudioFormatReader
+{
+public:
+    MemoryMappedAiffReader (const File& file, const AiffAudioFormatReader& reader)
+        : MemoryMappedAudioFormatReader (file, reader, reader.dataChunkStart, reader.bytesPerFrame),
+          littleEndian (reader.littleEndian)
+    {
+    }
+
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      int64 startSampleInFile, int numSamples)
+    {
+        numSamples = clearSamplesBeyondEnd (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                            startSampleInFile, numSamples);
+
+        if (numSamples < 0)
+            return false;
+
+        if (numSamples > 0)
+            AiffAudioFormatReader::copySampleData (bitsPerSample, littleEndian,
+                                                   destSamples, startOffsetInDestBuffer, numDestChannels,
+                                                   sampleToPointer (startSampleInFile), (int) numChannels, numSamples);
+        return true;
+    }
+
+private:
+    const bool littleEndian;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryMappedAiffReader)
+};
+
 //==============================================================================
 class AiffAudioFormatWriter  : public AudioFormatWriter
 {
@@ -698,6 +739,15 @@ bool AiffAudioFormat::canHandleFile (const File& f)
 }
 #endif
 
+bool AiffAudioFormat::matchesSignature (const void* headerData, int numBytes)
+{
+    const char* const d = static_cast <const char*> (headerData);
+
+    return numBytes >= 12
+            && memcmp (d, "FORM", 4) == 0
+            && (memcmp (d + 8, "AIFF", 4) == 0 || memcmp (d + 8, "AIFC", 4) == 0);
+}
+
 AudioFormatReader* AiffAudioFormat::createReaderFor (InputStream* sourceStream, const bool deleteStreamIfOpeningFails)
 {
     ScopedPointer <AiffAudioFormatReader> w (new AiffAudioFormatReader (sourceStream));
@@ -711,6 +761,21 @@ AudioFormatReader* AiffAudioFormat::createReaderFor (InputStream* sourceStream,
     return nullptr;
 }
 
+MemoryMappedAudioFormatReader* AiffAudioFormat::createMemoryMappedReader (const File& file)
+{
+    FileInputStream* const fin = file.createInputStream();
+
+    if (fin != nullptr)
+    {
+        AiffAudioFormatReader reader (fin);
+
+        if (reader.lengthInSamples > 0)
+            return new MemoryMappedAiffReader (file, reader);
+    }
+
+    return nullptr;
+}
+
 AudioFormatWriter* AiffAudioFormat::createWriterFor (OutputStream* out,
                                                      double sampleRate,
                                                      unsigned int numberOfChannels,
@@ -49,10 +49,14 @@ public:
     bool canHandleFile (const File& fileToTest);
    #endif
 
+    bool matchesSignature (const void* headerData, int numBytes);
+
     //==============================================================================
     AudioFormatReader* createReaderFor (InputStream* sourceStream,
                                         bool deleteStreamIfOpeningFails);
 
+    MemoryMappedAudioFormatReader* createMemoryMappedReader (const File& file);
+
     AudioFormatWriter* createWriterFor (OutputStream* streamToWriteTo,
                                         double sampleRateToUse,
                                         unsigned int numberOfChannels,
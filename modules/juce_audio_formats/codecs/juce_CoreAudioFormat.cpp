@@ -234,6 +234,15 @@ bool CoreAudioFormat::canDoStereo()     { return true; }
 bool CoreAudioFormat::canDoMono()       { return true; }
 
 //==============================================================================
+bool CoreAudioFormat::matchesSignature (const void* headerData, int numBytes)
+{
+    const char* const d = static_cast <const char*> (headerData);
+
+    return numBytes >= 8
+            && (memcmp (d, "caff", 4) == 0          // CAF
+                 || memcmp (d + 4, "ftyp", 4) == 0); // MPEG-4 (m4a, aac, alac..)
+}
+
 AudioFormatReader* CoreAudioFormat::createReaderFor (InputStream* sourceStream,
                                                      bool deleteStreamIfOpeningFails)
 {
@@ -50,6 +50,8 @@ public:
     bool canDoStereo();
     bool canDoMono();
 
+    bool matchesSignature (const void* headerData, int numBytes);
+
     //==============================================================================
     AudioFormatReader* createReaderFor (InputStream* sourceStream,
                                         bool deleteStreamIfOpeningFails);
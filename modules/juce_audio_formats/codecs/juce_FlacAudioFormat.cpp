@@ -25,9 +25,13 @@
 
 #if JUCE_USE_FLAC
 
+#if JUCE_INCLUDE_FLAC_CODE || ! defined (JUCE_INCLUDE_FLAC_CODE)
+ #define JUCE_FLAC_CODE_IS_BUILT_IN 1
+#endif
+
 namespace FlacNamespace
 {
-#if JUCE_INCLUDE_FLAC_CODE || ! defined (JUCE_INCLUDE_FLAC_CODE)
+#if JUCE_FLAC_CODE_IS_BUILT_IN
 
  #undef VERSION
  #define VERSION "1.2.1"
@@ -321,17 +325,7 @@ public:
     {
         using namespace FlacNamespace;
         encoder = FLAC__stream_encoder_new();
-
-        if (qualityOptionIndex > 0)
-            FLAC__stream_encoder_set_compression_level (encoder, (uint32) jmin (8, qualityOptionIndex));
-
-        FLAC__stream_encoder_set_do_mid_side_stereo (encoder, numChannels == 2);
-        FLAC__stream_encoder_set_loose_mid_side_stereo (encoder, numChannels == 2);
-        FLAC__stream_encoder_set_channels (encoder, numChannels);
-        FLAC__stream_encoder_set_bits_per_sample (encoder, jmin ((unsigned int) 24, bitsPerSample));
-        FLAC__stream_encoder_set_sample_rate (encoder, (unsigned int) sampleRate);
-        FLAC__stream_encoder_set_blocksize (encoder, 0);
-        FLAC__stream_encoder_set_do_escape_coding (encoder, true);
+        setEncoderOptions (encoder, sampleRate, numChannels, bitsPerSample, qualityOptionIndex);
 
         ok = FLAC__stream_encoder_init_stream (encoder,
                                                encodeWriteCallback, encodeSeekCallback,
@@ -394,6 +388,23 @@ public:
         return output->write (data, size);
     }
 
+    static void setEncoderOptions (FlacNamespace::FLAC__StreamEncoder* const encoder, const double sampleRate,
+                                   const uint32 numChannels, const uint32 bitsPerSample, const int qualityOptionIndex)
+    {
+        using namespace FlacNamespace;
+
+        if (qualityOptionIndex > 0)
+            FLAC__stream_encoder_set_compression_level (encoder, (uint32) jmin (8, qualityOptionIndex));
+
+        FLAC__stream_encoder_set_do_mid_side_stereo (encoder, numChannels == 2);
+        FLAC__stream_encoder_set_loose_mid_side_stereo (encoder, numChannels == 2);
+        FLAC__stream_encoder_set_channels (encoder, numChannels);
+        FLAC__stream_encoder_set_bits_per_sample (encoder, jmin ((unsigned int) 24, bitsPerSample));
+        FLAC__stream_encoder_set_sample_rate (encoder, (unsigned int) sampleRate);
+        FLAC__stream_encoder_set_blocksize (encoder, 0);
+        FLAC__stream_encoder_set_do_escape_coding (encoder, true);
+    }
+
     static void packUint32 (FlacNamespace::FLAC__uint32 val, FlacNamespace::FLAC__byte* b, const int bytes)
     {
         b += bytes;
@@ -405,12 +416,9 @@ public:
         }
     }
 
-    void writeMetaData (const FlacNamespace::FLAC__StreamMetadata* metadata)
+    static void packStreamInfo (const FlacNamespace::FLAC__StreamMetadata_StreamInfo& info, FlacNamespace::FLAC__byte* const buffer)
     {
         using namespace FlacNamespace;
-        const FLAC__StreamMetadata_StreamInfo& info = metadata->data.stream_info;
-
-        unsigned char buffer [FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
         const unsigned int channelsMinus1 = info.channels - 1;
         const unsigned int bitsMinus1 = info.bits_per_sample - 1;
 
@@ -424,6 +432,13 @@ public:
         buffer[13] = (FLAC__byte) (((bitsMinus1 & 0x0f) << 4) | (unsigned int) ((info.total_samples >> 32) & 0x0f));
         packUint32 ((FLAC__uint32) info.total_samples, buffer + 14, 4);
         memcpy (buffer + 18, info.md5sum, 16);
+    }
+
+    void writeMetaData (const FlacNamespace::FLAC__StreamMetadata* metadata)
+    {
+        using namespace FlacNamespace;
+        unsigned char buffer [FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
+        packStreamInfo (metadata->data.stream_info, buffer);
 
         const bool seekOk = output->setPosition (4);
         (void) seekOk;
@@ -480,6 +495,493 @@ private:
 };
 
 
+//==============================================================================
+namespace FlacFrameHelpers
+{
+    struct CRCTables
+    {
+        CRCTables() noexcept
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                int c8 = i, c16 = i << 8;
+
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    c8  = (c8 & 0x80) != 0    ? ((c8 << 1) ^ 0x07)    : (c8 << 1);
+                    c16 = (c16 & 0x8000) != 0 ? ((c16 << 1) ^ 0x8005) : (c16 << 1);
+                }
+
+                crc8[i]  = (uint8) c8;
+                crc16[i] = (uint16) c16;
+            }
+        }
+
+        uint8 crc8[256];
+        uint16 crc16[256];
+    };
+
+    static const CRCTables crcTables;
+
+    static uint8 crc8 (const uint8* data, const size_t numBytes) noexcept
+    {
+        uint8 crc = 0;
+
+        for (const uint8* const end = data + numBytes; data < end; ++data)
+            crc = crcTables.crc8 [crc ^ *data];
+
+        return crc;
+    }
+
+    static int crc16 (const uint8* data, const size_t numBytes) noexcept
+    {
+        int crc = 0;
+
+        for (const uint8* const end = data + numBytes; data < end; ++data)
+            crc = ((crc << 8) ^ crcTables.crc16 [(crc >> 8) ^ *data]) & 0xffff;
+
+        return crc;
+    }
+
+    // Multiplies two polynomials modulo the CRC-16 polynomial.
+    static int multiplyCRC16 (const int a, const int b) noexcept
+    {
+        int result = 0;
+
+        for (int bit = 15; bit >= 0; --bit)
+        {
+            result <<= 1;
+
+            if ((result & 0x10000) != 0)
+                result ^= 0x18005;
+
+            if ((b & (1 << bit)) != 0)
+                result ^= a;
+        }
+
+        return result;
+    }
+
+    /** Returns the CRC-16 of some data that has the same tail as another block whose CRC is
+        known, but a different head. Because CRCs are linear, the difference between the two
+        heads' CRCs just needs shifting along by the length of the tail, which avoids having
+        to scan the whole frame again.
+    */
+    static int replaceCRC16Head (const int oldCRC, const int oldHeadCRC, const int newHeadCRC, size_t tailSize) noexcept
+    {
+        int shift = 1, power = 2;
+
+        for (uint64 n = 8 * (uint64) tailSize; n != 0; n >>= 1)
+        {
+            if ((n & 1) != 0)
+                shift = multiplyCRC16 (shift, power);
+
+            power = multiplyCRC16 (power, power);
+        }
+
+        return oldCRC ^ multiplyCRC16 (oldHeadCRC ^ newHeadCRC, shift);
+    }
+
+    static int getCodedNumberLength (const uint8 firstByte) noexcept
+    {
+        int numBytes = 1;
+
+        if ((firstByte & 0x80) != 0)
+            for (uint8 mask = 0x40; (firstByte & mask) != 0 && mask > 1; mask >>= 1)
+                ++numBytes;
+
+        return numBytes;
+    }
+
+    static void writeCodedNumber (MemoryOutputStream& out, const uint32 n)
+    {
+        if (n < 0x80)
+        {
+            out.writeByte ((char) n);
+        }
+        else
+        {
+            int numExtraBytes = 1;
+            while (numExtraBytes < 5 && n >= (1u << (6 + 5 * numExtraBytes)))
+                ++numExtraBytes;
+
+            out.writeByte ((char) ((0xff00 >> (numExtraBytes + 1)) | (n >> (6 * numExtraBytes))));
+
+            for (int i = numExtraBytes; --i >= 0;)
+                out.writeByte ((char) (0x80 | ((n >> (6 * i)) & 0x3f)));
+        }
+    }
+
+    /** Copies an encoded fixed-blocksize frame, replacing the frame number in its header
+        and recalculating both of its CRCs.
+    */
+    static void writeRenumberedFrame (MemoryOutputStream& out, const uint8* const frame,
+                                      const size_t frameSize, const uint32 newFrameNumber)
+    {
+        const int blockSizeCode  = frame[2] >> 4;
+        const int sampleRateCode = frame[2] & 0x0f;
+
+        const size_t oldNumberEnd = 4 + (size_t) getCodedNumberLength (frame[4]);
+        const size_t headerEnd = oldNumberEnd
+                                  + (blockSizeCode == 6 ? 1 : (blockSizeCode == 7 ? 2 : 0))
+                                  + (sampleRateCode == 12 ? 1 : ((sampleRateCode == 13 || sampleRateCode == 14) ? 2 : 0));
+
+        jassert (frameSize > headerEnd + 3);
+
+        MemoryOutputStream header (32);
+        header.write (frame, 4);
+        writeCodedNumber (header, newFrameNumber);
+        header.write (frame + oldNumberEnd, (int) (headerEnd - oldNumberEnd));
+        header.writeByte ((char) crc8 (static_cast <const uint8*> (header.getData()), header.getDataSize()));
+
+        const size_t bodySize = frameSize - headerEnd - 3;
+        const int oldCRC = (frame [frameSize - 2] << 8) | frame [frameSize - 1];
+        const int newCRC = replaceCRC16Head (oldCRC, crc16 (frame, headerEnd + 1),
+                                             crc16 (static_cast <const uint8*> (header.getData()), header.getDataSize()),
+                                             bodySize);
+
+        out << header;
+        out.write (frame + headerEnd + 1, (int) bodySize);
+        out.writeShortBigEndian ((short) newCRC);
+    }
+}
+
+//==============================================================================
+class FlacParallelWriter  : public AudioFormatWriter
+{
+public:
+    //==============================================================================
+    FlacParallelWriter (OutputStream* const out, double sampleRate_, uint32 numChannels_,
+                        uint32 bitsPerSample_, const int qualityOptionIndex_, ThreadPool& threadPool_)
+        : AudioFormatWriter (out, TRANS (flacFormatName), sampleRate_, numChannels_, bitsPerSample_),
+          ok (false),
+          threadPool (threadPool_),
+          qualityOptionIndex (qualityOptionIndex_),
+          maxJobsInProgress (jmax (2, 2 * SystemStats::getNumCpus())),
+          blockSize (0), framesPerJob (0), samplesPerJob (0), nextFrameNumber (0), totalSamples (0),
+          minFrameSize (0), maxFrameSize (0), failed (false)
+    {
+        using namespace FlacNamespace;
+
+        // make a dummy encoder, just to find out the block size it's going to use..
+        if (FLAC__StreamEncoder* const encoder = FLAC__stream_encoder_new())
+        {
+            FlacWriter::setEncoderOptions (encoder, sampleRate, numChannels, bitsPerSample, qualityOptionIndex);
+
+            if (FLAC__stream_encoder_init_stream (encoder, EncoderJob::discardOutputCallback,
+                                                  nullptr, nullptr, nullptr, nullptr) == FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+            {
+                blockSize = (int) FLAC__stream_encoder_get_blocksize (encoder);
+
+                // With loose mid-side stereo, the encoder only re-evaluates the channel assignment
+                // every few frames, counting from the start of the stream. Each job starts counting
+                // afresh, so for the frames to match a single encoder's, every job has to start on
+                // one of those re-evaluations. This is the same sum that libFLAC uses for the interval.
+                int interval = 1;
+
+                if (blockSize > 0 && FLAC__stream_encoder_get_loose_mid_side_stereo (encoder))
+                    interval = jmax (1, (int) ((double) (unsigned int) sampleRate * 0.4 / (double) blockSize + 0.5));
+
+                framesPerJob = interval * ((minFramesPerJob + interval - 1) / interval);
+
+                FLAC__stream_encoder_finish (encoder);
+            }
+
+            FLAC__stream_encoder_delete (encoder);
+        }
+
+        samplesPerJob = blockSize * framesPerJob;
+
+        // The stream info gets filled-in when the writer is deleted.
+        const uint8 header[] = { 'f', 'L', 'a', 'C', 0x80, 0, 0, FLAC__STREAM_METADATA_STREAMINFO_LENGTH };
+        uint8 emptyStreamInfo [FLAC__STREAM_METADATA_STREAMINFO_LENGTH] = { 0 };
+
+        ok = blockSize > 0
+              && output->write (header, (int) sizeof (header))
+              && output->write (emptyStreamInfo, (int) sizeof (emptyStreamInfo));
+    }
+
+    ~FlacParallelWriter()
+    {
+        if (ok)
+        {
+            if (currentJob != nullptr && currentJob->numSamples > 0)
+                startCurrentJob();
+
+            writeFinishedJobs (0);
+            writeStreamInfo();
+            output->flush();
+        }
+        else
+        {
+            output = nullptr; // to stop the base class deleting this, as it needs to be returned
+                              // to the caller of createWriter()
+        }
+    }
+
+    //==============================================================================
+    bool write (const int** samplesToWrite, int numSamples)
+    {
+        if (! ok || failed)
+            return false;
+
+        const int bitsToShift = 32 - (int) bitsPerSample;
+        int sourceOffset = 0;
+
+        while (numSamples > 0)
+        {
+            if (currentJob == nullptr)
+                currentJob = new EncoderJob (*this, nextFrameNumber);
+
+            const int numToCopy = jmin (numSamples, samplesPerJob - currentJob->numSamples);
+
+            for (int i = 0; i < (int) numChannels; ++i)
+            {
+                int* const dest = currentJob->getChannel (i) + currentJob->numSamples;
+
+                if (samplesToWrite[i] == nullptr)
+                    zeromem (dest, sizeof (int) * (size_t) numToCopy);
+                else
+                    for (int j = 0; j < numToCopy; ++j)
+                        dest[j] = samplesToWrite[i][sourceOffset + j] >> bitsToShift;
+            }
+
+            currentJob->numSamples += numToCopy;
+            sourceOffset += numToCopy;
+            numSamples -= numToCopy;
+
+            if (currentJob->numSamples == samplesPerJob)
+                startCurrentJob();
+        }
+
+        return ! failed;
+    }
+
+    bool ok;
+
+private:
+    //==============================================================================
+    /** Encodes a run of whole frames with its own libFLAC encoder, keeping just the frames
+        and renumbering them to match their position in the final stream.
+    */
+    class EncoderJob  : public ThreadPoolJob
+    {
+    public:
+        EncoderJob (const FlacParallelWriter& owner_, const uint32 firstFrameNumber_)
+            : ThreadPoolJob ("FLAC encoder"),
+              numSamples (0), numFrames (0), minFrameSize (0), maxFrameSize (0), succeeded (false),
+              owner (owner_), firstFrameNumber (firstFrameNumber_),
+              samples ((size_t) owner_.numChannels * (size_t) owner_.samplesPerJob)
+        {
+        }
+
+        int* getChannel (const int channel) const noexcept      { return samples + (size_t) channel * (size_t) owner.samplesPerJob; }
+
+        JobStatus runJob()
+        {
+            using namespace FlacNamespace;
+
+            if (FLAC__StreamEncoder* const encoder = FLAC__stream_encoder_new())
+            {
+                FlacWriter::setEncoderOptions (encoder, owner.sampleRate, owner.numChannels,
+                                               owner.bitsPerSample, owner.qualityOptionIndex);
+
+                if (FLAC__stream_encoder_init_stream (encoder, encodeWriteCallback, nullptr, nullptr, nullptr, this)
+                      == FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+                {
+                    HeapBlock<const FLAC__int32*> channels (owner.numChannels);
+
+                    for (int i = 0; i < (int) owner.numChannels; ++i)
+                        channels[i] = (const FLAC__int32*) getChannel (i);
+
+                    succeeded = FLAC__stream_encoder_process (encoder, channels, (unsigned int) numSamples) != 0;
+                    succeeded = (FLAC__stream_encoder_finish (encoder) != 0) && succeeded;
+                }
+
+                FLAC__stream_encoder_delete (encoder);
+            }
+
+            return jobHasFinished;
+        }
+
+        static FlacNamespace::FLAC__StreamEncoderWriteStatus encodeWriteCallback (const FlacNamespace::FLAC__StreamEncoder*,
+                                                                                  const FlacNamespace::FLAC__byte buffer[],
+                                                                                  size_t bytes, unsigned int samples,
+                                                                                  unsigned int /*current_frame*/,
+                                                                                  void* client_data)
+        {
+            using namespace FlacNamespace;
+
+            // libFLAC calls this once for each frame, and with samples == 0 for the metadata
+            if (samples > 0)
+                static_cast <EncoderJob*> (client_data)->addFrame (buffer, bytes);
+
+            return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+        }
+
+        static FlacNamespace::FLAC__StreamEncoderWriteStatus discardOutputCallback (const FlacNamespace::FLAC__StreamEncoder*,
+                                                                                    const FlacNamespace::FLAC__byte*,
+                                                                                    size_t, unsigned int, unsigned int, void*)
+        {
+            return FlacNamespace::FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+        }
+
+        MemoryOutputStream encodedFrames;
+        int numSamples, numFrames;
+        uint32 minFrameSize, maxFrameSize;
+        bool succeeded;
+
+    private:
+        const FlacParallelWriter& owner;
+        const uint32 firstFrameNumber;
+        HeapBlock<int> samples;
+
+        void addFrame (const uint8* const frame, const size_t size)
+        {
+            const size_t oldSize = encodedFrames.getDataSize();
+
+            if (firstFrameNumber == 0)
+                encodedFrames.write (frame, (int) size);
+            else
+                FlacFrameHelpers::writeRenumberedFrame (encodedFrames, frame, size, firstFrameNumber + (uint32) numFrames);
+
+            const uint32 frameSize = (uint32) (encodedFrames.getDataSize() - oldSize);
+            minFrameSize = numFrames == 0 ? frameSize : jmin (minFrameSize, frameSize);
+            maxFrameSize = jmax (maxFrameSize, frameSize);
+            ++numFrames;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (EncoderJob)
+    };
+
+    //==============================================================================
+    // Keeps the MD5 of the stream's raw samples, which has to be done in order, so is done on
+    // the writer's thread. If libFLAC isn't built in, the MD5 is left empty ("unknown").
+    struct StreamMD5
+    {
+       #if JUCE_FLAC_CODE_IS_BUILT_IN
+        StreamMD5() : finished (false)              { FlacNamespace::FLAC__MD5Init (&context); }
+        ~StreamMD5()                                { FlacNamespace::FLAC__byte digest[16]; getResult (digest); }
+
+        void add (const int* const* channels, uint32 numChannels, int numSamples, uint32 bitsPerSample)
+        {
+            FlacNamespace::FLAC__MD5Accumulate (&context, (const FlacNamespace::FLAC__int32* const*) channels,
+                                                numChannels, (unsigned int) numSamples, (bitsPerSample + 7) / 8);
+        }
+
+        void getResult (FlacNamespace::FLAC__byte* const digest)
+        {
+            if (! finished)
+            {
+                FlacNamespace::FLAC__MD5Final (result, &context);
+                finished = true;
+            }
+
+            memcpy (digest, result, sizeof (result));
+        }
+
+    private:
+        FlacNamespace::FLAC__MD5Context context;
+        FlacNamespace::FLAC__byte result[16];
+        bool finished;
+       #else
+        void add (const int* const*, uint32, int, uint32)           {}
+        void getResult (FlacNamespace::FLAC__byte* const digest)    { zeromem (digest, 16); }
+       #endif
+    };
+
+    //==============================================================================
+    enum { minFramesPerJob = 32 };
+
+    ThreadPool& threadPool;
+    const int qualityOptionIndex, maxJobsInProgress;
+    int blockSize, framesPerJob, samplesPerJob;
+    uint32 nextFrameNumber;
+    int64 totalSamples;
+    uint32 minFrameSize, maxFrameSize;
+    bool failed;
+    ScopedPointer<EncoderJob> currentJob;
+    OwnedArray<EncoderJob> jobsInProgress;
+    StreamMD5 md5;
+
+    void startCurrentJob()
+    {
+        HeapBlock<const int*> channels (numChannels);
+
+        for (int i = 0; i < (int) numChannels; ++i)
+            channels[i] = currentJob->getChannel (i);
+
+        md5.add (channels, numChannels, currentJob->numSamples, jmin ((uint32) 24, bitsPerSample));
+
+        totalSamples += currentJob->numSamples;
+        nextFrameNumber += (uint32) (currentJob->numSamples / blockSize);
+
+        threadPool.addJob (currentJob, false);
+        jobsInProgress.add (currentJob.release());
+
+        writeFinishedJobs (maxJobsInProgress);
+    }
+
+    // Writes out any jobs at the front of the queue that have finished, waiting for some
+    // more of them if there are more than maxJobsToLeave still in progress.
+    void writeFinishedJobs (const int maxJobsToLeave)
+    {
+        while (jobsInProgress.size() > 0)
+        {
+            EncoderJob* const job = jobsInProgress.getFirst();
+
+            if (jobsInProgress.size() <= maxJobsToLeave && threadPool.contains (job))
+                break;
+
+            threadPool.waitForJobToFinish (job, -1);
+
+            if (! failed)
+            {
+                failed = ! (job->succeeded && output->write (job->encodedFrames.getData(), (int) job->encodedFrames.getDataSize()));
+
+                if (job->numFrames > 0)
+                {
+                    minFrameSize = (minFrameSize == 0) ? job->minFrameSize : jmin (minFrameSize, job->minFrameSize);
+                    maxFrameSize = jmax (maxFrameSize, job->maxFrameSize);
+                }
+            }
+
+            jobsInProgress.remove (0);
+        }
+    }
+
+    void writeStreamInfo()
+    {
+        using namespace FlacNamespace;
+
+        FLAC__StreamMetadata_StreamInfo info;
+        zerostruct (info);
+        info.min_blocksize = info.max_blocksize = (unsigned int) blockSize;
+        info.min_framesize = minFrameSize;
+        info.max_framesize = maxFrameSize;
+        info.sample_rate = (unsigned int) sampleRate;
+        info.channels = numChannels;
+        info.bits_per_sample = jmin ((uint32) 24, bitsPerSample);
+        info.total_samples = (FLAC__uint64) totalSamples;
+        md5.getResult (info.md5sum);
+
+        unsigned char buffer [FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
+        FlacWriter::packStreamInfo (info, buffer);
+
+        const bool seekOk = output->setPosition (8);
+        (void) seekOk;
+
+        // if this fails, you've given it an output stream that can't seek! It needs
+        // to be able to seek back to write the header
+        jassert (seekOk);
+
+        output->write (buffer, FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FlacParallelWriter)
+};
+
+
 //==============================================================================
 FlacAudioFormat::FlacAudioFormat()
     : AudioFormat (TRANS (flacFormatName), StringArray (flacExtensions))
@@ -506,6 +1008,11 @@ bool FlacAudioFormat::canDoStereo()     { return true; }
 bool FlacAudioFormat::canDoMono()       { return true; }
 bool FlacAudioFormat::isCompressed()    { return true; }
 
+bool FlacAudioFormat::matchesSignature (const void* headerData, int numBytes)
+{
+    return numBytes >= 4 && memcmp (headerData, "fLaC", 4) == 0;
+}
+
 AudioFormatReader* FlacAudioFormat::createReaderFor (InputStream* in, const bool deleteStreamIfOpeningFails)
 {
     ScopedPointer<FlacReader> r (new FlacReader (in));
@@ -537,10 +1044,149 @@ AudioFormatWriter* FlacAudioFormat::createWriterFor (OutputStream* out,
     return nullptr;
 }
 
+AudioFormatWriter* FlacAudioFormat::createParallelWriterFor (OutputStream* out,
+                                                             double sampleRate,
+                                                             unsigned int numberOfChannels,
+                                                             int bitsPerSample,
+                                                             int qualityOptionIndex,
+                                                             ThreadPool& threadPool)
+{
+    if (getPossibleBitDepths().contains (bitsPerSample))
+    {
+        ScopedPointer<FlacParallelWriter> w (new FlacParallelWriter (out, sampleRate, numberOfChannels,
+                                                                     (uint32) bitsPerSample, qualityOptionIndex,
+                                                                     threadPool));
+        if (w->ok)
+            return w.release();
+    }
+
+    return nullptr;
+}
+
 StringArray FlacAudioFormat::getQualityOptions()
 {
     const char* options[] = { "0 (Fastest)", "1", "2", "3", "4", "5 (Default)","6", "7", "8 (Highest quality)", 0 };
     return StringArray (options);
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class FlacParallelWriterTests  : public UnitTest
+{
+public:
+    FlacParallelWriterTests() : UnitTest ("FLAC parallel writer") {}
+
+    void runTest()
+    {
+        beginTest ("Output matches the single-threaded writer");
+
+        // long enough for the frame numbers to need more than one byte
+        checkMatchesSerialWriter (44100.0, 600000);
+
+        // at 48kHz, loose mid-side stereo re-evaluates every 5 frames rather than 4
+        beginTest ("Output matches at 48kHz");
+        checkMatchesSerialWriter (48000.0, 300000);
+
+        beginTest ("Stream isn't taken on failure");
+        {
+            FlacAudioFormat flac;
+            ThreadPool threadPool (1);
+            ScopedPointer<MemoryOutputStream> out (new MemoryOutputStream());
+
+            // (an unsupported bit depth)
+            expect (flac.createParallelWriterFor (out, 44100.0, 2, 12, 5, threadPool) == nullptr);
+            out->writeByte (1);
+            expectEquals ((int) out->getDataSize(), 1);
+        }
+    }
+
+    void checkMatchesSerialWriter (const double sampleRate, const int numSamples)
+    {
+        AudioSampleBuffer source (2, numSamples);
+        Random r (1234);
+
+        // This switches between near-identical channels and unrelated ones every couple of
+        // frames, so that the best channel assignment keeps changing. That makes sure the jobs
+        // re-evaluate it in the same places that a single encoder would.
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float sine = (float) std::sin (i * 0.01);
+            const float noise1 = r.nextFloat() - 0.5f;
+            const float noise2 = r.nextFloat() - 0.5f;
+
+            if (((i / 8192) & 1) == 0)
+            {
+                *source.getSampleData (0, i) = 0.5f * sine + 0.01f * noise1;
+                *source.getSampleData (1, i) = 0.5f * sine + 0.01f * noise2;
+            }
+            else
+            {
+                *source.getSampleData (0, i) = 0.5f * noise1;
+                *source.getSampleData (1, i) = 0.02f * noise2;
+            }
+        }
+
+        ThreadPool threadPool (3);
+        MemoryBlock serial, parallel;
+        write (source, serial, sampleRate, nullptr);
+        write (source, parallel, sampleRate, &threadPool);
+
+        const size_t serialFrames = findFirstFrame (serial);
+        const size_t parallelFrames = findFirstFrame (parallel);
+
+        expect (serialFrames > 0 && parallelFrames > 0);
+
+        if (serialFrames == 0 || parallelFrames == 0)
+            return;
+
+        // the STREAMINFO blocks (including the MD5) and all the frames should be identical
+        expect (memcmp (addBytesToPointer (serial.getData(), 8), addBytesToPointer (parallel.getData(), 8),
+                        FLAC__STREAM_METADATA_STREAMINFO_LENGTH) == 0);
+        expectEquals ((int) (serial.getSize() - serialFrames), (int) (parallel.getSize() - parallelFrames));
+        expect (memcmp (addBytesToPointer (serial.getData(), serialFrames),
+                        addBytesToPointer (parallel.getData(), parallelFrames),
+                        jmin (serial.getSize() - serialFrames, parallel.getSize() - parallelFrames)) == 0);
+
+        FlacAudioFormat flac;
+        ScopedPointer<AudioFormatReader> reader (flac.createReaderFor (new MemoryInputStream (parallel, false), true));
+        expect (reader != nullptr && reader->lengthInSamples == numSamples);
+    }
+
+    static void write (const AudioSampleBuffer& source, MemoryBlock& dest,
+                       const double sampleRate, ThreadPool* const threadPool)
+    {
+        FlacAudioFormat flac;
+        MemoryOutputStream* const out = new MemoryOutputStream (dest, false);
+
+        ScopedPointer<AudioFormatWriter> writer (threadPool != nullptr
+                                                    ? flac.createParallelWriterFor (out, sampleRate, 2, 16, 5, *threadPool)
+                                                    : flac.createWriterFor (out, sampleRate, 2, 16, StringPairArray(), 5));
+
+        for (int pos = 0; pos < source.getNumSamples(); pos += 7777)
+            writer->writeFromAudioSampleBuffer (source, pos, jmin (7777, source.getNumSamples() - pos));
+    }
+
+    static size_t findFirstFrame (const MemoryBlock& data)
+    {
+        const uint8* const d = static_cast <const uint8*> (data.getData());
+        size_t pos = 4;
+
+        while (pos + 4 <= data.getSize())
+        {
+            const bool isLast = (d[pos] & 0x80) != 0;
+            pos += 4 + (size_t) ((d[pos + 1] << 16) | (d[pos + 2] << 8) | d[pos + 3]);
+
+            if (isLast)
+                return pos;
+        }
+
+        return 0;
+    }
+};
+
+static FlacParallelWriterTests flacParallelWriterTests;
+
+#endif
+
 #endif
@@ -48,6 +48,8 @@ public:
     bool isCompressed();
     StringArray getQualityOptions();
 
+    bool matchesSignature (const void* headerData, int numBytes);
+
     //==============================================================================
     AudioFormatReader* createReaderFor (InputStream* sourceStream,
                                         bool deleteStreamIfOpeningFails);
@@ -58,6 +60,29 @@ public:
                                         int bitsPerSample,
                                         const StringPairArray& metadataValues,
                                         int qualityOptionIndex);
+
+    /** Creates a writer that encodes on several threads at once.
+
+        FLAC frames don't depend on each other, so this writer collects the incoming
+        audio into runs of frames and gives each run to a job on the thread pool, writing
+        the results to the stream in order as they finish. The file that's produced is the
+        same as the one that createWriterFor() would make, apart from its metadata (there's
+        no Vorbis comment block) - i.e. the audio frames are byte-for-byte identical.
+
+        The stream must be seekable, so that the STREAMINFO block can be filled in at the
+        end. As with createWriterFor(), the writer deletes the stream when it's finished,
+        but if the writer can't be created, the stream is NOT deleted, so that the caller
+        can re-use it. The thread pool must remain valid until the writer has been deleted.
+
+        @see createWriterFor
+    */
+    AudioFormatWriter* createParallelWriterFor (OutputStream* streamToWriteTo,
+                                                double sampleRateToUse,
+                                                unsigned int numberOfChannels,
+                                                int bitsPerSample,
+                                                int qualityOptionIndex,
+                                                ThreadPool& threadPool);
+
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FlacAudioFormat)
 };
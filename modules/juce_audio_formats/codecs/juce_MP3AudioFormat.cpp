@@ -547,6 +547,10 @@ struct Constants
         initDecodeTables();
         initLayer2Tables();
         initLayer3Tables();
+
+       #if JUCE_MP3_USE_SIMD
+        initSIMDTables();
+       #endif
     }
 
     const uint8* getGroupTable (const int16 d1, const int index) const noexcept
@@ -580,6 +584,16 @@ struct Constants
     float decodeWin[512 + 32];
     float* cosTables[5];
 
+   #if JUCE_MP3_USE_SIMD
+    // The synthesis window taps for each of the 8 possible buffer offsets, arranged as
+    // [tap][row] and with their signs folded in, so that the SIMD filterbank can load
+    // the taps for 4 rows at once and just accumulate them.
+    float synthWindows[8][2][16][16];
+
+    // win and win1 interleaved, for running the IMDCT on 4 subbands at a time.
+    float win4[4][36][4];
+   #endif
+
 private:
     int mapbuf0[9][152];
     int mapbuf1[9][156];
@@ -624,6 +638,36 @@ private:
         }
     }
 
+   #if JUCE_MP3_USE_SIMD
+    void initSIMDTables()
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            const float* const window1 = decodeWin + 16 - (2 * i + 1);
+            const float* const window2 = decodeWin + 16 + (2 * i + 1);
+
+            for (int k = 0; k < 16; ++k)
+            {
+                for (int row = 0; row < 16; ++row)
+                {
+                    const float w = window1 [32 * row + k];
+                    synthWindows[i][0][k][row] = (k & 1) != 0 ? -w : w;
+                    synthWindows[i][1][k][row] = -window2 [32 * row + (k < 15 ? -1 - k : 0)];
+                }
+            }
+        }
+
+        for (int bt = 0; bt < 4; ++bt)
+        {
+            for (int i = 0; i < 36; ++i)
+            {
+                win4[bt][i][0] = win4[bt][i][2] = win[bt][i];
+                win4[bt][i][1] = win4[bt][i][3] = win1[bt][i];
+            }
+        }
+    }
+   #endif
+
     void initLayer2Tables()
     {
         static const uint8 base[3][9] =
@@ -1052,6 +1096,108 @@ struct Layer3SideInfo
     uint32 mainDataStart, privateBits;
 };
 
+//==============================================================================
+#if JUCE_MP3_USE_SIMD
+/** A wrapper around a 4-float SSE2 or NEON register.
+
+    Only plain multiplies and adds are used (never fused ones), so on SSE2 the vectorised
+    transforms round exactly the same way as the scalar code they replace.
+*/
+struct Float4
+{
+   #if JUCE_USE_SSE2_INTRINSICS
+    __m128 v;
+
+    static Float4 create (const __m128 value) noexcept                  { Float4 f; f.v = value; return f; }
+    static Float4 load (const float* const p) noexcept                  { return create (_mm_loadu_ps (p)); }
+    static Float4 loadReversed (const float* const p) noexcept          { return create (_mm_shuffle_ps (_mm_loadu_ps (p), _mm_loadu_ps (p), _MM_SHUFFLE (0, 1, 2, 3))); }
+    void store (float* const p) const noexcept                          { _mm_storeu_ps (p, v); }
+    void storeReversed (float* const p) const noexcept                  { _mm_storeu_ps (p, _mm_shuffle_ps (v, v, _MM_SHUFFLE (0, 1, 2, 3))); }
+
+    Float4 operator+ (const Float4& other) const noexcept               { return create (_mm_add_ps (v, other.v)); }
+    Float4 operator- (const Float4& other) const noexcept               { return create (_mm_sub_ps (v, other.v)); }
+    Float4 operator* (const Float4& other) const noexcept               { return create (_mm_mul_ps (v, other.v)); }
+    Float4 operator* (const float multiplier) const noexcept            { return create (_mm_mul_ps (v, _mm_set1_ps (multiplier))); }
+
+    static void transpose (Float4& a, Float4& b, Float4& c, Float4& d) noexcept
+    {
+        _MM_TRANSPOSE4_PS (a.v, b.v, c.v, d.v);
+    }
+   #else
+    float32x4_t v;
+
+    static Float4 create (const float32x4_t value) noexcept             { Float4 f; f.v = value; return f; }
+    static Float4 load (const float* const p) noexcept                  { return create (vld1q_f32 (p)); }
+    static Float4 loadReversed (const float* const p) noexcept          { return load (p).reversed(); }
+    void store (float* const p) const noexcept                          { vst1q_f32 (p, v); }
+    void storeReversed (float* const p) const noexcept                  { reversed().store (p); }
+
+    Float4 reversed() const noexcept
+    {
+        const float32x4_t r = vrev64q_f32 (v);
+        return create (vcombine_f32 (vget_high_f32 (r), vget_low_f32 (r)));
+    }
+
+    Float4 operator+ (const Float4& other) const noexcept               { return create (vaddq_f32 (v, other.v)); }
+    Float4 operator- (const Float4& other) const noexcept               { return create (vsubq_f32 (v, other.v)); }
+    Float4 operator* (const Float4& other) const noexcept               { return create (vmulq_f32 (v, other.v)); }
+    Float4 operator* (const float multiplier) const noexcept            { return create (vmulq_n_f32 (v, multiplier)); }
+
+    static void transpose (Float4& a, Float4& b, Float4& c, Float4& d) noexcept
+    {
+        const float32x4x2_t ab = vtrnq_f32 (a.v, b.v);
+        const float32x4x2_t cd = vtrnq_f32 (c.v, d.v);
+        a.v = vcombine_f32 (vget_low_f32  (ab.val[0]), vget_low_f32  (cd.val[0]));
+        b.v = vcombine_f32 (vget_low_f32  (ab.val[1]), vget_low_f32  (cd.val[1]));
+        c.v = vcombine_f32 (vget_high_f32 (ab.val[0]), vget_high_f32 (cd.val[0]));
+        d.v = vcombine_f32 (vget_high_f32 (ab.val[1]), vget_high_f32 (cd.val[1]));
+    }
+   #endif
+
+    Float4& operator+= (const Float4& other) noexcept                   { return *this = *this + other; }
+
+    /** Reads 4 rows of 18 floats, so that dest[i] holds element i of each row. */
+    static void loadColumns (Float4* const dest, const float* const rows) noexcept
+    {
+        for (int i = 0; i < 16; i += 4)
+        {
+            dest[i]     = load (rows + i);
+            dest[i + 1] = load (rows + 18 + i);
+            dest[i + 2] = load (rows + 36 + i);
+            dest[i + 3] = load (rows + 54 + i);
+            transpose (dest[i], dest[i + 1], dest[i + 2], dest[i + 3]);
+        }
+
+        for (int i = 16; i < 18; ++i)
+        {
+            const float column[] = { rows[i], rows[18 + i], rows[36 + i], rows[54 + i] };
+            dest[i] = load (column);
+        }
+    }
+
+    /** The inverse of loadColumns(). */
+    static void storeColumns (const Float4* const source, float* const rows) noexcept
+    {
+        for (int i = 0; i < 16; i += 4)
+        {
+            Float4 a (source[i]), b (source[i + 1]), c (source[i + 2]), d (source[i + 3]);
+            transpose (a, b, c, d);
+            a.store (rows + i);
+            b.store (rows + 18 + i);
+            c.store (rows + 36 + i);
+            d.store (rows + 54 + i);
+        }
+
+        for (int i = 16; i < 18; ++i)
+        {
+            float column[4];
+            source[i].store (column);
+            rows[i] = column[0]; rows[18 + i] = column[1]; rows[36 + i] = column[2]; rows[54 + i] = column[3];
+        }
+    }
+};
+#endif
+
 //==============================================================================
 namespace DCT
 {
@@ -1062,30 +1208,42 @@ namespace DCT
     static const float cos36[] = { 0.501909912f, 0.517638087f, 0.551688969f, 0.610387266f, 0.707106769f, 0.871723413f, 1.18310082f, 1.93185163f, 5.73685646f };
     static const float cos12[] = { 0.517638087f, 0.707106769f, 1.93185163f };
 
-    inline void dct36_0 (const int v, float* const ts, float* const out1, float* const out2,
-                         const float* const wintab, float sum0, const float sum1) noexcept
+    inline void storeTimeSlot (float* const ts, const float value) noexcept     { *ts = value; }
+
+   #if JUCE_MP3_USE_SIMD
+    inline void storeTimeSlot (float* const ts, const Float4& value) noexcept   { value.store (ts); }
+   #endif
+
+    // These are templated so that the same code can either run on a single subband,
+    // or on 4 adjacent subbands at once using Float4.
+    template <typename Type>
+    inline void dct36_0 (const int v, float* const ts, const Type* const out1, Type* const out2,
+                         const Type* const wintab, const Type& sum0, const Type& sum1) noexcept
     {
-        const float tmp = sum0 + sum1;
+        const Type tmp (sum0 + sum1);
         out2[9 + v] = tmp * wintab[27 + v];
         out2[8 - v] = tmp * wintab[26 - v];
-        sum0 -= sum1;
-        ts[SBLIMIT * (8 - v)] = out1[8 - v] + sum0 * wintab[8 - v];
-        ts[SBLIMIT * (9 + v)] = out1[9 + v] + sum0 * wintab[9 + v];
+        const Type diff (sum0 - sum1);
+        storeTimeSlot (ts + SBLIMIT * (8 - v), out1[8 - v] + diff * wintab[8 - v]);
+        storeTimeSlot (ts + SBLIMIT * (9 + v), out1[9 + v] + diff * wintab[9 + v]);
     }
 
-    inline void dct36_1 (const int v, float* const ts, float* const out1, float* const out2, const float* const wintab,
-                         const float tmp1a, const float tmp1b, const float tmp2a, const float tmp2b) noexcept
+    template <typename Type>
+    inline void dct36_1 (const int v, float* const ts, const Type* const out1, Type* const out2, const Type* const wintab,
+                         const Type& tmp1a, const Type& tmp1b, const Type& tmp2a, const Type& tmp2b) noexcept
     {
         dct36_0 (v, ts, out1, out2, wintab, tmp1a + tmp2a, (tmp1b + tmp2b) * cos36[v]);
     }
 
-    inline void dct36_2 (const int v, float* const ts, float* const out1, float* const out2, const float* const wintab,
-                         const float tmp1a, const float tmp1b, const float tmp2a, const float tmp2b) noexcept
+    template <typename Type>
+    inline void dct36_2 (const int v, float* const ts, const Type* const out1, Type* const out2, const Type* const wintab,
+                         const Type& tmp1a, const Type& tmp1b, const Type& tmp2a, const Type& tmp2b) noexcept
     {
         dct36_0 (v, ts, out1, out2, wintab, tmp2a - tmp1a, (tmp2b - tmp1b) * cos36[v]);
     }
 
-    void dct36 (float* const in, float* const out1, float* const out2, const float* const wintab, float* const ts) noexcept
+    template <typename Type>
+    void dct36 (Type* const in, const Type* const out1, Type* const out2, const Type* const wintab, float* const ts) noexcept
     {
         in[17] += in[16]; in[16] += in[15]; in[15] += in[14]; in[14] += in[13]; in[13] += in[12];
         in[12] += in[11]; in[11] += in[10]; in[10] += in[9];  in[9]  += in[8];  in[8]  += in[7];
@@ -1093,52 +1251,70 @@ namespace DCT
         in[2]  += in[1];  in[1]  += in[0];  in[17] += in[15]; in[15] += in[13]; in[13] += in[11];
         in[11] += in[9];  in[9]  += in[7];  in[7]  += in[5];  in[5]  += in[3];  in[3]  += in[1];
 
-        const float ta33 = in[6]  * cos9[3];
-        const float ta66 = in[12] * cos9[6];
-        const float tb33 = in[7]  * cos9[3];
-        const float tb66 = in[13] * cos9[6];
+        const Type ta33 = in[6]  * cos9[3];
+        const Type ta66 = in[12] * cos9[6];
+        const Type tb33 = in[7]  * cos9[3];
+        const Type tb66 = in[13] * cos9[6];
 
         {
-            const float tmp1a = in[2] * cos9[1] + ta33 + in[10] * cos9[5] + in[14] * cos9[7];
-            const float tmp1b = in[3] * cos9[1] + tb33 + in[11] * cos9[5] + in[15] * cos9[7];
-            const float tmp2a = in[0] + in[4] * cos9[2] + in[8] * cos9[4] + ta66 + in[16] * cos9[8];
-            const float tmp2b = in[1] + in[5] * cos9[2] + in[9] * cos9[4] + tb66 + in[17] * cos9[8];
+            const Type tmp1a = in[2] * cos9[1] + ta33 + in[10] * cos9[5] + in[14] * cos9[7];
+            const Type tmp1b = in[3] * cos9[1] + tb33 + in[11] * cos9[5] + in[15] * cos9[7];
+            const Type tmp2a = in[0] + in[4] * cos9[2] + in[8] * cos9[4] + ta66 + in[16] * cos9[8];
+            const Type tmp2b = in[1] + in[5] * cos9[2] + in[9] * cos9[4] + tb66 + in[17] * cos9[8];
             dct36_1 (0, ts, out1, out2, wintab, tmp1a, tmp1b, tmp2a, tmp2b);
             dct36_2 (8, ts, out1, out2, wintab, tmp1a, tmp1b, tmp2a, tmp2b);
         }
 
         {
-            const float tmp1a = (in[2] - in[10] - in[14]) * cos9[3];
-            const float tmp1b = (in[3] - in[11] - in[15]) * cos9[3];
-            const float tmp2a = (in[4] - in[8] - in[16]) * cos9[6] - in[12] + in[0];
-            const float tmp2b = (in[5] - in[9] - in[17]) * cos9[6] - in[13] + in[1];
+            const Type tmp1a = (in[2] - in[10] - in[14]) * cos9[3];
+            const Type tmp1b = (in[3] - in[11] - in[15]) * cos9[3];
+            const Type tmp2a = (in[4] - in[8] - in[16]) * cos9[6] - in[12] + in[0];
+            const Type tmp2b = (in[5] - in[9] - in[17]) * cos9[6] - in[13] + in[1];
             dct36_1 (1, ts, out1, out2, wintab, tmp1a, tmp1b, tmp2a, tmp2b);
             dct36_2 (7, ts, out1, out2, wintab, tmp1a, tmp1b, tmp2a, tmp2b);
         }
 
         {
-            const float tmp1a = in[2] * cos9[5] - ta33 - in[10] * cos9[7] + in[14] * cos9[1];
-            const float tmp1b = in[3] * cos9[5] - tb33 - in[11] * cos9[7] + in[15] * cos9[1];
-            const float tmp2a = in[0] - in[4] * cos9[8] - in[8] * cos9[2] + ta66 + in[16] * cos9[4];
-            const float tmp2b = in[1] - in[5] * cos9[8] - in[9] * cos9[2] + tb66 + in[17] * cos9[4];
+            const Type tmp1a = in[2] * cos9[5] - ta33 - in[10] * cos9[7] + in[14] * cos9[1];
+            const Type tmp1b = in[3] * cos9[5] - tb33 - in[11] * cos9[7] + in[15] * cos9[1];
+            const Type tmp2a = in[0] - in[4] * cos9[8] - in[8] * cos9[2] + ta66 + in[16] * cos9[4];
+            const Type tmp2b = in[1] - in[5] * cos9[8] - in[9] * cos9[2] + tb66 + in[17] * cos9[4];
             dct36_1 (2, ts, out1, out2, wintab, tmp1a, tmp1b, tmp2a, tmp2b);
             dct36_2 (6, ts, out1, out2, wintab, tmp1a, tmp1b, tmp2a, tmp2b);
         }
 
         {
-            const float tmp1a = in[2] * cos9[7] - ta33 + in[10] * cos9[1] - in[14] * cos9[5];
-            const float tmp1b = in[3] * cos9[7] - tb33 + in[11] * cos9[1] - in[15] * cos9[5];
-            const float tmp2a = in[0] - in[4] * cos9[4] + in[8] * cos9[8] + ta66 - in[16] * cos9[2];
-            const float tmp2b = in[1] - in[5] * cos9[4] + in[9] * cos9[8] + tb66 - in[17] * cos9[2];
+            const Type tmp1a = in[2] * cos9[7] - ta33 + in[10] * cos9[1] - in[14] * cos9[5];
+            const Type tmp1b = in[3] * cos9[7] - tb33 + in[11] * cos9[1] - in[15] * cos9[5];
+            const Type tmp2a = in[0] - in[4] * cos9[4] + in[8] * cos9[8] + ta66 - in[16] * cos9[2];
+            const Type tmp2b = in[1] - in[5] * cos9[4] + in[9] * cos9[8] + tb66 - in[17] * cos9[2];
             dct36_1 (3, ts, out1, out2, wintab, tmp1a, tmp1b, tmp2a, tmp2b);
             dct36_2 (5, ts, out1, out2, wintab, tmp1a, tmp1b, tmp2a, tmp2b);
         }
 
-        const float sum0 =  in[0] - in[4] + in[8] - in[12] + in[16];
-        const float sum1 = (in[1] - in[5] + in[9] - in[13] + in[17]) * cos36[4];
+        const Type sum0 =  in[0] - in[4] + in[8] - in[12] + in[16];
+        const Type sum1 = (in[1] - in[5] + in[9] - in[13] + in[17]) * cos36[4];
         dct36_0 (4, ts, out1, out2, wintab, sum0, sum1);
     }
 
+   #if JUCE_MP3_USE_SIMD
+    // Runs dct36 on 4 adjacent subbands, which must alternately use win and win1.
+    void dct36x4 (const float* const in, const float* const out1, float* const out2, const float* const wintab4, float* const ts) noexcept
+    {
+        Float4 inputs[18], prev[18], next[18], windows[36];
+
+        Float4::loadColumns (inputs, in);
+        Float4::loadColumns (prev, out1);
+
+        for (int i = 0; i < 36; ++i)
+            windows[i] = Float4::load (wintab4 + 4 * i);
+
+        dct36 (inputs, prev, next, windows, ts);
+
+        Float4::storeColumns (next, out2);
+    }
+   #endif
+
     struct DCT12Inputs
     {
         float in0, in1, in2, in3, in4, in5;
@@ -1254,66 +1430,112 @@ namespace DCT
         }
     }
 
+    // The outputs are written with the given stride: the scalar synthesis filter uses a stride
+    // of 16, but the SIMD one keeps its buffers transposed and writes them contiguously, so a
+    // stride of 1 also selects the vectorised butterflies.
+    template <int stride>
     void dct64 (float* const out0, float* const out1, float* const b1, float* const b2, const float* const samples) noexcept
     {
+       #if JUCE_MP3_USE_SIMD
+        if (stride == 1)
         {
-            const float* const costab = constants.cosTables[0];
-            b1[0x00] = samples[0x00] + samples[0x1F];   b1[0x1F] = (samples[0x00] - samples[0x1F]) * costab[0x0];
-            b1[0x01] = samples[0x01] + samples[0x1E];   b1[0x1E] = (samples[0x01] - samples[0x1E]) * costab[0x1];
-            b1[0x02] = samples[0x02] + samples[0x1D];   b1[0x1D] = (samples[0x02] - samples[0x1D]) * costab[0x2];
-            b1[0x03] = samples[0x03] + samples[0x1C];   b1[0x1C] = (samples[0x03] - samples[0x1C]) * costab[0x3];
-            b1[0x04] = samples[0x04] + samples[0x1B];   b1[0x1B] = (samples[0x04] - samples[0x1B]) * costab[0x4];
-            b1[0x05] = samples[0x05] + samples[0x1A];   b1[0x1A] = (samples[0x05] - samples[0x1A]) * costab[0x5];
-            b1[0x06] = samples[0x06] + samples[0x19];   b1[0x19] = (samples[0x06] - samples[0x19]) * costab[0x6];
-            b1[0x07] = samples[0x07] + samples[0x18];   b1[0x18] = (samples[0x07] - samples[0x18]) * costab[0x7];
-            b1[0x08] = samples[0x08] + samples[0x17];   b1[0x17] = (samples[0x08] - samples[0x17]) * costab[0x8];
-            b1[0x09] = samples[0x09] + samples[0x16];   b1[0x16] = (samples[0x09] - samples[0x16]) * costab[0x9];
-            b1[0x0A] = samples[0x0A] + samples[0x15];   b1[0x15] = (samples[0x0A] - samples[0x15]) * costab[0xA];
-            b1[0x0B] = samples[0x0B] + samples[0x14];   b1[0x14] = (samples[0x0B] - samples[0x14]) * costab[0xB];
-            b1[0x0C] = samples[0x0C] + samples[0x13];   b1[0x13] = (samples[0x0C] - samples[0x13]) * costab[0xC];
-            b1[0x0D] = samples[0x0D] + samples[0x12];   b1[0x12] = (samples[0x0D] - samples[0x12]) * costab[0xD];
-            b1[0x0E] = samples[0x0E] + samples[0x11];   b1[0x11] = (samples[0x0E] - samples[0x11]) * costab[0xE];
-            b1[0x0F] = samples[0x0F] + samples[0x10];   b1[0x10] = (samples[0x0F] - samples[0x10]) * costab[0xF];
-        }
-
-        {
-            const float* const costab = constants.cosTables[1];
-            b2[0x00] = b1[0x00] + b1[0x0F];   b2[0x0F] = (b1[0x00] - b1[0x0F]) * costab[0];
-            b2[0x01] = b1[0x01] + b1[0x0E];   b2[0x0E] = (b1[0x01] - b1[0x0E]) * costab[1];
-            b2[0x02] = b1[0x02] + b1[0x0D];   b2[0x0D] = (b1[0x02] - b1[0x0D]) * costab[2];
-            b2[0x03] = b1[0x03] + b1[0x0C];   b2[0x0C] = (b1[0x03] - b1[0x0C]) * costab[3];
-            b2[0x04] = b1[0x04] + b1[0x0B];   b2[0x0B] = (b1[0x04] - b1[0x0B]) * costab[4];
-            b2[0x05] = b1[0x05] + b1[0x0A];   b2[0x0A] = (b1[0x05] - b1[0x0A]) * costab[5];
-            b2[0x06] = b1[0x06] + b1[0x09];   b2[0x09] = (b1[0x06] - b1[0x09]) * costab[6];
-            b2[0x07] = b1[0x07] + b1[0x08];   b2[0x08] = (b1[0x07] - b1[0x08]) * costab[7];
-            b2[0x10] = b1[0x10] + b1[0x1F];   b2[0x1F] = (b1[0x1F] - b1[0x10]) * costab[0];
-            b2[0x11] = b1[0x11] + b1[0x1E];   b2[0x1E] = (b1[0x1E] - b1[0x11]) * costab[1];
-            b2[0x12] = b1[0x12] + b1[0x1D];   b2[0x1D] = (b1[0x1D] - b1[0x12]) * costab[2];
-            b2[0x13] = b1[0x13] + b1[0x1C];   b2[0x1C] = (b1[0x1C] - b1[0x13]) * costab[3];
-            b2[0x14] = b1[0x14] + b1[0x1B];   b2[0x1B] = (b1[0x1B] - b1[0x14]) * costab[4];
-            b2[0x15] = b1[0x15] + b1[0x1A];   b2[0x1A] = (b1[0x1A] - b1[0x15]) * costab[5];
-            b2[0x16] = b1[0x16] + b1[0x19];   b2[0x19] = (b1[0x19] - b1[0x16]) * costab[6];
-            b2[0x17] = b1[0x17] + b1[0x18];   b2[0x18] = (b1[0x18] - b1[0x17]) * costab[7];
-        }
-
-        {
-            const float* const costab = constants.cosTables[2];
-            b1[0x00] = b2[0x00] + b2[0x07];   b1[0x07] = (b2[0x00] - b2[0x07]) * costab[0];
-            b1[0x01] = b2[0x01] + b2[0x06];   b1[0x06] = (b2[0x01] - b2[0x06]) * costab[1];
-            b1[0x02] = b2[0x02] + b2[0x05];   b1[0x05] = (b2[0x02] - b2[0x05]) * costab[2];
-            b1[0x03] = b2[0x03] + b2[0x04];   b1[0x04] = (b2[0x03] - b2[0x04]) * costab[3];
-            b1[0x08] = b2[0x08] + b2[0x0F];   b1[0x0F] = (b2[0x0F] - b2[0x08]) * costab[0];
-            b1[0x09] = b2[0x09] + b2[0x0E];   b1[0x0E] = (b2[0x0E] - b2[0x09]) * costab[1];
-            b1[0x0A] = b2[0x0A] + b2[0x0D];   b1[0x0D] = (b2[0x0D] - b2[0x0A]) * costab[2];
-            b1[0x0B] = b2[0x0B] + b2[0x0C];   b1[0x0C] = (b2[0x0C] - b2[0x0B]) * costab[3];
-            b1[0x10] = b2[0x10] + b2[0x17];   b1[0x17] = (b2[0x10] - b2[0x17]) * costab[0];
-            b1[0x11] = b2[0x11] + b2[0x16];   b1[0x16] = (b2[0x11] - b2[0x16]) * costab[1];
-            b1[0x12] = b2[0x12] + b2[0x15];   b1[0x15] = (b2[0x12] - b2[0x15]) * costab[2];
-            b1[0x13] = b2[0x13] + b2[0x14];   b1[0x14] = (b2[0x13] - b2[0x14]) * costab[3];
-            b1[0x18] = b2[0x18] + b2[0x1F];   b1[0x1F] = (b2[0x1F] - b2[0x18]) * costab[0];
-            b1[0x19] = b2[0x19] + b2[0x1E];   b1[0x1E] = (b2[0x1E] - b2[0x19]) * costab[1];
-            b1[0x1A] = b2[0x1A] + b2[0x1D];   b1[0x1D] = (b2[0x1D] - b2[0x1A]) * costab[2];
-            b1[0x1B] = b2[0x1B] + b2[0x1C];   b1[0x1C] = (b2[0x1C] - b2[0x1B]) * costab[3];
+            for (int i = 0; i < 16; i += 4)
+            {
+                const Float4 a (Float4::load (samples + i)), b (Float4::loadReversed (samples + 28 - i));
+                (a + b).store (b1 + i);
+                ((a - b) * Float4::load (constants.cosTables[0] + i)).storeReversed (b1 + 28 - i);
+            }
+
+            for (int i = 0; i < 8; i += 4)
+            {
+                const Float4 cosines (Float4::load (constants.cosTables[1] + i));
+
+                {
+                    const Float4 a (Float4::load (b1 + i)), b (Float4::loadReversed (b1 + 12 - i));
+                    (a + b).store (b2 + i);
+                    ((a - b) * cosines).storeReversed (b2 + 12 - i);
+                }
+
+                {
+                    const Float4 a (Float4::load (b1 + 0x10 + i)), b (Float4::loadReversed (b1 + 0x1C - i));
+                    (a + b).store (b2 + 0x10 + i);
+                    ((b - a) * cosines).storeReversed (b2 + 0x1C - i);
+                }
+            }
+
+            {
+                const Float4 cosines (Float4::load (constants.cosTables[2]));
+
+                for (int i = 0; i < 32; i += 8)
+                {
+                    const Float4 a (Float4::load (b2 + i)), b (Float4::loadReversed (b2 + i + 4));
+                    (a + b).store (b1 + i);
+                    (((i & 8) != 0 ? (b - a) : (a - b)) * cosines).storeReversed (b1 + i + 4);
+                }
+            }
+        }
+        else
+       #endif
+        {
+            {
+                const float* const costab = constants.cosTables[0];
+                b1[0x00] = samples[0x00] + samples[0x1F];   b1[0x1F] = (samples[0x00] - samples[0x1F]) * costab[0x0];
+                b1[0x01] = samples[0x01] + samples[0x1E];   b1[0x1E] = (samples[0x01] - samples[0x1E]) * costab[0x1];
+                b1[0x02] = samples[0x02] + samples[0x1D];   b1[0x1D] = (samples[0x02] - samples[0x1D]) * costab[0x2];
+                b1[0x03] = samples[0x03] + samples[0x1C];   b1[0x1C] = (samples[0x03] - samples[0x1C]) * costab[0x3];
+                b1[0x04] = samples[0x04] + samples[0x1B];   b1[0x1B] = (samples[0x04] - samples[0x1B]) * costab[0x4];
+                b1[0x05] = samples[0x05] + samples[0x1A];   b1[0x1A] = (samples[0x05] - samples[0x1A]) * costab[0x5];
+                b1[0x06] = samples[0x06] + samples[0x19];   b1[0x19] = (samples[0x06] - samples[0x19]) * costab[0x6];
+                b1[0x07] = samples[0x07] + samples[0x18];   b1[0x18] = (samples[0x07] - samples[0x18]) * costab[0x7];
+                b1[0x08] = samples[0x08] + samples[0x17];   b1[0x17] = (samples[0x08] - samples[0x17]) * costab[0x8];
+                b1[0x09] = samples[0x09] + samples[0x16];   b1[0x16] = (samples[0x09] - samples[0x16]) * costab[0x9];
+                b1[0x0A] = samples[0x0A] + samples[0x15];   b1[0x15] = (samples[0x0A] - samples[0x15]) * costab[0xA];
+                b1[0x0B] = samples[0x0B] + samples[0x14];   b1[0x14] = (samples[0x0B] - samples[0x14]) * costab[0xB];
+                b1[0x0C] = samples[0x0C] + samples[0x13];   b1[0x13] = (samples[0x0C] - samples[0x13]) * costab[0xC];
+                b1[0x0D] = samples[0x0D] + samples[0x12];   b1[0x12] = (samples[0x0D] - samples[0x12]) * costab[0xD];
+                b1[0x0E] = samples[0x0E] + samples[0x11];   b1[0x11] = (samples[0x0E] - samples[0x11]) * costab[0xE];
+                b1[0x0F] = samples[0x0F] + samples[0x10];   b1[0x10] = (samples[0x0F] - samples[0x10]) * costab[0xF];
+            }
+
+            {
+                const float* const costab = constants.cosTables[1];
+                b2[0x00] = b1[0x00] + b1[0x0F];   b2[0x0F] = (b1[0x00] - b1[0x0F]) * costab[0];
+                b2[0x01] = b1[0x01] + b1[0x0E];   b2[0x0E] = (b1[0x01] - b1[0x0E]) * costab[1];
+                b2[0x02] = b1[0x02] + b1[0x0D];   b2[0x0D] = (b1[0x02] - b1[0x0D]) * costab[2];
+                b2[0x03] = b1[0x03] + b1[0x0C];   b2[0x0C] = (b1[0x03] - b1[0x0C]) * costab[3];
+                b2[0x04] = b1[0x04] + b1[0x0B];   b2[0x0B] = (b1[0x04] - b1[0x0B]) * costab[4];
+                b2[0x05] = b1[0x05] + b1[0x0A];   b2[0x0A] = (b1[0x05] - b1[0x0A]) * costab[5];
+                b2[0x06] = b1[0x06] + b1[0x09];   b2[0x09] = (b1[0x06] - b1[0x09]) * costab[6];
+                b2[0x07] = b1[0x07] + b1[0x08];   b2[0x08] = (b1[0x07] - b1[0x08]) * costab[7];
+                b2[0x10] = b1[0x10] + b1[0x1F];   b2[0x1F] = (b1[0x1F] - b1[0x10]) * costab[0];
+                b2[0x11] = b1[0x11] + b1[0x1E];   b2[0x1E] = (b1[0x1E] - b1[0x11]) * costab[1];
+                b2[0x12] = b1[0x12] + b1[0x1D];   b2[0x1D] = (b1[0x1D] - b1[0x12]) * costab[2];
+                b2[0x13] = b1[0x13] + b1[0x1C];   b2[0x1C] = (b1[0x1C] - b1[0x13]) * costab[3];
+                b2[0x14] = b1[0x14] + b1[0x1B];   b2[0x1B] = (b1[0x1B] - b1[0x14]) * costab[4];
+                b2[0x15] = b1[0x15] + b1[0x1A];   b2[0x1A] = (b1[0x1A] - b1[0x15]) * costab[5];
+                b2[0x16] = b1[0x16] + b1[0x19];   b2[0x19] = (b1[0x19] - b1[0x16]) * costab[6];
+                b2[0x17] = b1[0x17] + b1[0x18];   b2[0x18] = (b1[0x18] - b1[0x17]) * costab[7];
+            }
+
+            {
+                const float* const costab = constants.cosTables[2];
+                b1[0x00] = b2[0x00] + b2[0x07];   b1[0x07] = (b2[0x00] - b2[0x07]) * costab[0];
+                b1[0x01] = b2[0x01] + b2[0x06];   b1[0x06] = (b2[0x01] - b2[0x06]) * costab[1];
+                b1[0x02] = b2[0x02] + b2[0x05];   b1[0x05] = (b2[0x02] - b2[0x05]) * costab[2];
+                b1[0x03] = b2[0x03] + b2[0x04];   b1[0x04] = (b2[0x03] - b2[0x04]) * costab[3];
+                b1[0x08] = b2[0x08] + b2[0x0F];   b1[0x0F] = (b2[0x0F] - b2[0x08]) * costab[0];
+                b1[0x09] = b2[0x09] + b2[0x0E];   b1[0x0E] = (b2[0x0E] - b2[0x09]) * costab[1];
+                b1[0x0A] = b2[0x0A] + b2[0x0D];   b1[0x0D] = (b2[0x0D] - b2[0x0A]) * costab[2];
+                b1[0x0B] = b2[0x0B] + b2[0x0C];   b1[0x0C] = (b2[0x0C] - b2[0x0B]) * costab[3];
+                b1[0x10] = b2[0x10] + b2[0x17];   b1[0x17] = (b2[0x10] - b2[0x17]) * costab[0];
+                b1[0x11] = b2[0x11] + b2[0x16];   b1[0x16] = (b2[0x11] - b2[0x16]) * costab[1];
+                b1[0x12] = b2[0x12] + b2[0x15];   b1[0x15] = (b2[0x12] - b2[0x15]) * costab[2];
+                b1[0x13] = b2[0x13] + b2[0x14];   b1[0x14] = (b2[0x13] - b2[0x14]) * costab[3];
+                b1[0x18] = b2[0x18] + b2[0x1F];   b1[0x1F] = (b2[0x1F] - b2[0x18]) * costab[0];
+                b1[0x19] = b2[0x19] + b2[0x1E];   b1[0x1E] = (b2[0x1E] - b2[0x19]) * costab[1];
+                b1[0x1A] = b2[0x1A] + b2[0x1D];   b1[0x1D] = (b2[0x1D] - b2[0x1A]) * costab[2];
+                b1[0x1B] = b2[0x1B] + b2[0x1C];   b1[0x1C] = (b2[0x1C] - b2[0x1B]) * costab[3];
+            }
         }
 
         {
@@ -1361,29 +1583,30 @@ namespace DCT
             b1[0x1E] += b1[0x1F];    b1[0x1C] += b1[0x1E]; b1[0x1E] += b1[0x1D];  b1[0x1D] += b1[0x1F];
         }
 
-        out0[0x10 * 16] = b1[0x00];  out0[0x10 * 12] = b1[0x04]; out0[0x10 * 8]  = b1[0x02];  out0[0x10 * 4]  = b1[0x06];
-        out0[0] = b1[0x01];  out1[0]  = b1[0x01]; out1[0x10 * 4]  = b1[0x05];  out1[0x10 * 8]  = b1[0x03];
-        out1[0x10 * 12] = b1[0x07];
+        out0[stride * 16] = b1[0x00];  out0[stride * 12] = b1[0x04]; out0[stride * 8]  = b1[0x02];  out0[stride * 4]  = b1[0x06];
+        out0[0] = b1[0x01];  out1[0]  = b1[0x01]; out1[stride * 4]  = b1[0x05];  out1[stride * 8]  = b1[0x03];
+        out1[stride * 12] = b1[0x07];
 
-        b1[0x08] += b1[0x0C];  out0[0x10 * 14] = b1[0x08];  b1[0x0C] += b1[0x0a];  out0[0x10 * 10] = b1[0x0C];
-        b1[0x0A] += b1[0x0E];  out0[0x10 * 6]  = b1[0x0A];  b1[0x0E] += b1[0x09];  out0[0x10 * 2]  = b1[0x0E];
-        b1[0x09] += b1[0x0D];  out1[0x10 * 2]  = b1[0x09];  b1[0x0D] += b1[0x0B];  out1[0x10 * 6]  = b1[0x0D];
-        b1[0x0B] += b1[0x0F];  out1[0x10 * 10] = b1[0x0B];  out1[0x10 * 14] = b1[0x0F];
+        b1[0x08] += b1[0x0C];  out0[stride * 14] = b1[0x08];  b1[0x0C] += b1[0x0a];  out0[stride * 10] = b1[0x0C];
+        b1[0x0A] += b1[0x0E];  out0[stride * 6]  = b1[0x0A];  b1[0x0E] += b1[0x09];  out0[stride * 2]  = b1[0x0E];
+        b1[0x09] += b1[0x0D];  out1[stride * 2]  = b1[0x09];  b1[0x0D] += b1[0x0B];  out1[stride * 6]  = b1[0x0D];
+        b1[0x0B] += b1[0x0F];  out1[stride * 10] = b1[0x0B];  out1[stride * 14] = b1[0x0F];
 
-        b1[0x18] += b1[0x1C];  out0[0x10 * 15] = b1[0x10] + b1[0x18];   out0[0x10 * 13] = b1[0x18] + b1[0x14];
-        b1[0x1C] += b1[0x1a];  out0[0x10 * 11] = b1[0x14] + b1[0x1C];   out0[0x10 * 9]  = b1[0x1C] + b1[0x12];
-        b1[0x1A] += b1[0x1E];  out0[0x10 * 7]  = b1[0x12] + b1[0x1A];   out0[0x10 * 5]  = b1[0x1A] + b1[0x16];
-        b1[0x1E] += b1[0x19];  out0[0x10 * 3]  = b1[0x16] + b1[0x1E];   out0[0x10 * 1]  = b1[0x1E] + b1[0x11];
-        b1[0x19] += b1[0x1D];  out1[0x10 * 1]  = b1[0x11] + b1[0x19];   out1[0x10 * 3]  = b1[0x19] + b1[0x15];
-        b1[0x1D] += b1[0x1B];  out1[0x10 * 5]  = b1[0x15] + b1[0x1D];   out1[0x10 * 7]  = b1[0x1D] + b1[0x13];
-        b1[0x1B] += b1[0x1F];  out1[0x10 * 9]  = b1[0x13] + b1[0x1B];   out1[0x10 * 11] = b1[0x1B] + b1[0x17];
-        out1[0x10 * 13] = b1[0x17] + b1[0x1F];  out1[0x10 * 15] = b1[0x1F];
+        b1[0x18] += b1[0x1C];  out0[stride * 15] = b1[0x10] + b1[0x18];   out0[stride * 13] = b1[0x18] + b1[0x14];
+        b1[0x1C] += b1[0x1a];  out0[stride * 11] = b1[0x14] + b1[0x1C];   out0[stride * 9]  = b1[0x1C] + b1[0x12];
+        b1[0x1A] += b1[0x1E];  out0[stride * 7]  = b1[0x12] + b1[0x1A];   out0[stride * 5]  = b1[0x1A] + b1[0x16];
+        b1[0x1E] += b1[0x19];  out0[stride * 3]  = b1[0x16] + b1[0x1E];   out0[stride * 1]  = b1[0x1E] + b1[0x11];
+        b1[0x19] += b1[0x1D];  out1[stride * 1]  = b1[0x11] + b1[0x19];   out1[stride * 3]  = b1[0x19] + b1[0x15];
+        b1[0x1D] += b1[0x1B];  out1[stride * 5]  = b1[0x15] + b1[0x1D];   out1[stride * 7]  = b1[0x1D] + b1[0x13];
+        b1[0x1B] += b1[0x1F];  out1[stride * 9]  = b1[0x13] + b1[0x1B];   out1[stride * 11] = b1[0x1B] + b1[0x17];
+        out1[stride * 13] = b1[0x17] + b1[0x1F];  out1[stride * 15] = b1[0x1F];
     }
 
+    template <int stride>
     void dct64 (float* const a, float* const b, const float* const c) noexcept
     {
         float temp[64];
-        dct64 (a, b, temp, temp + 32, c);
+        dct64<stride> (a, b, temp, temp + 32, c);
     }
 }
 
@@ -1392,7 +1615,8 @@ struct MP3Stream
 {
     MP3Stream (InputStream& source)
         : stream (source, 8192),
-          numFrames (0), currentFrameIndex (0), vbrHeaderFound (false)
+          numFrames (0), currentFrameIndex (0), vbrHeaderFound (false),
+          useSIMD (JUCE_MP3_USE_SIMD != 0), seekIndexComplete (false)
     {
         reset();
     }
@@ -1555,16 +1779,21 @@ struct MP3Stream
     {
         frameIndex = jmax (0, frameIndex);
 
-        while (frameIndex >= frameStreamPositions.size() * storedStartPosInterval)
+        if (! seekIndexComplete)
         {
-            int dummy = 0;
-            const int result = decodeNextBlock (nullptr, nullptr, dummy);
+            scanFrameHeaders (frameIndex);
 
-            if (result < 0)
-                return false;
+            while (! seekIndexComplete && frameIndex >= frameStreamPositions.size() * storedStartPosInterval)
+            {
+                int dummy = 0;
+                const int result = decodeNextBlock (nullptr, nullptr, dummy);
 
-            if (result > 0)
-                break;
+                if (result < 0)
+                    return false;
+
+                if (result > 0)
+                    break;
+            }
         }
 
         frameIndex = jmin (frameIndex & ~(storedStartPosInterval - 1),
@@ -1575,13 +1804,39 @@ struct MP3Stream
         return true;
     }
 
+    //==============================================================================
+    enum { storedStartPosInterval = 4 };
+
+    /** Returns the stream positions of every storedStartPosInterval'th frame that's been found so far. */
+    const Array<int64>& getFrameStreamPositions() const noexcept    { return frameStreamPositions; }
+
+    /** True if the frame positions cover the whole stream. */
+    bool isSeekIndexComplete() const noexcept                       { return seekIndexComplete; }
+
+    void buildCompleteSeekIndex()
+    {
+        if (! seekIndexComplete)
+            scanFrameHeaders (std::numeric_limits<int>::max() - storedStartPosInterval);
+    }
+
+    void setCompleteSeekIndex (const Array<int64>& positions)
+    {
+        frameStreamPositions = positions;
+        seekIndexComplete = true;
+    }
+
     MP3Frame frame;
     VBRTagData vbrTagData;
     BufferedInputStream stream;
     int numFrames, currentFrameIndex;
     bool vbrHeaderFound;
 
+    // This is only cleared by the unit tests, to compare the SIMD and scalar decoders. It
+    // must not be changed once decoding has started, as they lay out their buffers differently.
+    bool useSIMD;
+
 private:
+    bool seekIndexComplete;
     bool headerParsed, sideParsed, dataParsed, needToSyncBitStream;
     bool isFreeFormat, wasFreeFormat;
     int sideInfoSize, dataSize;
@@ -1614,7 +1869,6 @@ private:
         zeromem (synthBuffers, sizeof (synthBuffers));
     }
 
-    enum { storedStartPosInterval = 4 };
     Array<int64> frameStreamPositions;
 
     struct SideInfoLayer1
@@ -1737,6 +1991,55 @@ private:
         return offset;
     }
 
+    // Extends the table of frame positions by reading just the header of each frame and
+    // jumping straight to the next one, which is much quicker than parsing the frames. This
+    // stops at anything that doesn't look like a frame of the same type (e.g. free-format
+    // frames or junk between frames), leaving the decoder to resync from there.
+    void scanFrameHeaders (const int targetFrameIndex)
+    {
+        const int64 streamLength = stream.getTotalLength();
+
+        if (frameStreamPositions.size() == 0 || streamLength <= 0)
+            return;
+
+        const int64 oldPos = stream.getPosition();
+        int index = (frameStreamPositions.size() - 1) * storedStartPosInterval;
+        int64 pos = frameStreamPositions.getLast();
+        MP3Frame f;
+
+        while (targetFrameIndex >= frameStreamPositions.size() * storedStartPosInterval)
+        {
+            if (pos + 4 > streamLength)
+            {
+                seekIndexComplete = true;
+                break;
+            }
+
+            stream.setPosition (pos);
+            const uint32 header = (uint32) stream.readIntBigEndian();
+
+            if (! isValidHeader (header, frame.layer))
+            {
+                seekIndexComplete = (header >> 8) == 0x544147; // an ID3v1 tag at the end of the file
+                break;
+            }
+
+            f.decodeHeader (header);
+
+            if (f.frameSize <= 0 || f.lsf != frame.lsf || f.mpeg25 != frame.mpeg25
+                 || f.sampleRateIndex != frame.sampleRateIndex)
+                break;
+
+            if ((index & (storedStartPosInterval - 1)) == 0)
+                frameStreamPositions.set (index / storedStartPosInterval, pos);
+
+            pos += 4 + f.frameSize;
+            ++index;
+        }
+
+        stream.setPosition (oldPos);
+    }
+
     void readVBRHeader()
     {
         int64 oldPos = stream.getPosition();
@@ -2841,6 +3144,12 @@ private:
         }
         else
         {
+           #if JUCE_MP3_USE_SIMD
+            if (useSIMD)
+                for (; sb + 2 < (int) granule.maxb; sb += 4, ts += 4, rawout1 += 72, rawout2 += 72)
+                    DCT::dct36x4 (fsIn[sb], rawout1, rawout2, constants.win4[bt][0], ts);
+           #endif
+
             for (; sb < (int) granule.maxb; sb += 2, ts += 2, rawout1 += 36, rawout2 += 36)
             {
                 DCT::dct36 (fsIn[sb], rawout1, rawout2, constants.win[bt], ts);
@@ -2867,22 +3176,105 @@ private:
 
     void synthesise (const float* bandPtr, const int channel, float* out, int& samplesDone)
     {
-        out += samplesDone;
+       #if JUCE_MP3_USE_SIMD
+        if (useSIMD)
+            synthesiseSIMD (bandPtr, channel, out + samplesDone);
+        else
+       #endif
+            synthesiseScalar (bandPtr, channel, out + samplesDone);
+
+        samplesDone += 32;
+    }
+
+   #if JUCE_MP3_USE_SIMD
+    void synthesiseSIMD (const float* bandPtr, const int channel, float* out) noexcept
+    {
         const int bo = channel == 0 ? ((synthBo - 1) & 15) : synthBo;
         float (*buf)[0x110] = synthBuffers[channel];
         float* b0;
-        int j, bo1 = bo;
+        int bo1 = bo;
+
+        // Here, the buffers hold 16 columns of 17 rows, so that each row's 16 taps are
+        // spread across the columns, and 4 rows can be loaded at a time.
+        enum { rowsPerColumn = 17 };
 
         if (bo & 1)
         {
             b0 = buf[0];
-            DCT::dct64 (buf[1] + ((bo + 1) & 15), buf[0] + bo, bandPtr);
+            DCT::dct64<1> (buf[1] + rowsPerColumn * ((bo + 1) & 15), buf[0] + rowsPerColumn * bo, bandPtr);
         }
         else
         {
             ++bo1;
             b0 = buf[1];
-            DCT::dct64 (buf[0] + bo, buf[1] + bo1, bandPtr);
+            DCT::dct64<1> (buf[0] + rowsPerColumn * bo, buf[1] + rowsPerColumn * bo1, bandPtr);
+        }
+
+        synthBo = bo;
+        const float* const windows1 = constants.synthWindows [bo1 >> 1][0][0];
+        const float* const windows2 = constants.synthWindows [bo1 >> 1][1][0];
+
+        for (int row = 0; row < 16; row += 4)
+        {
+            Float4 sum (Float4::load (windows1 + row) * Float4::load (b0 + row));
+
+            for (int k = 1; k < 16; ++k)
+                sum += Float4::load (windows1 + 16 * k + row) * Float4::load (b0 + rowsPerColumn * k + row);
+
+            sum.store (out + row);
+        }
+
+        {
+            const float* const window = constants.decodeWin + 16 - bo1 + 32 * 16;
+            float sum = window[0] * b0[16];
+
+            for (int k = 2; k < 16; k += 2)
+                sum += window[k] * b0[rowsPerColumn * k + 16];
+
+            out[16] = sum;
+        }
+
+        // the remaining rows are output in reverse order, from 15 down to 1
+        for (int row = 12; row > 0; row -= 4)
+        {
+            Float4 sum (Float4::load (windows2 + row) * Float4::load (b0 + row));
+
+            for (int k = 1; k < 16; ++k)
+                sum += Float4::load (windows2 + 16 * k + row) * Float4::load (b0 + rowsPerColumn * k + row);
+
+            sum.storeReversed (out + 29 - row);
+        }
+
+        for (int row = 3; row > 0; --row)
+        {
+            float sum = windows2[row] * b0[row];
+
+            for (int k = 1; k < 16; ++k)
+                sum += windows2[16 * k + row] * b0[rowsPerColumn * k + row];
+
+            out[32 - row] = sum;
+        }
+    }
+   #endif
+
+    void synthesiseScalar (const float* bandPtr, const int channel, float* out) noexcept
+    {
+        const int bo = channel == 0 ? ((synthBo - 1) & 15) : synthBo;
+        float (*buf)[0x110] = synthBuffers[channel];
+        float* b0;
+        int bo1 = bo;
+        int j;
+
+        if (bo & 1)
+        {
+            b0 = buf[0];
+            DCT::dct64<16> (buf[1] + ((bo + 1) & 15), buf[0] + bo, bandPtr);
+        }
+        else
+        {
+            ++bo1;
+            b0 = buf[1];
+            DCT::dct64<16> (buf[0] + bo, buf[1] + bo1, bandPtr);
         }
 
         synthBo = bo;
@@ -2923,8 +3315,6 @@ private:
             sum -= window[-15] * b0[14];  sum -= window[0]   * b0[15];
             *out++ = sum;
         }
-
-        samplesDone += 32;
     }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MP3Stream)
@@ -2934,14 +3324,93 @@ private:
 static const char* const mp3FormatName = "MP3 file";
 static const char* const mp3Extensions[] = { ".mp3", nullptr };
 
+//==============================================================================
+namespace SeekIndexCache
+{
+    // The cached tables are only valid for a source file with the same size and modification time.
+    enum { magicNumber = 0x4933504d, formatVersion = 1 };
+
+    static bool load (const File& cacheFile, const File& sourceFile, Array<int64>& positions)
+    {
+        MemoryBlock data;
+
+        if (! cacheFile.loadFileAsData (data))
+            return false;
+
+        MemoryInputStream in (data, false);
+
+        if (in.readInt() != magicNumber
+             || in.readInt() != formatVersion
+             || in.readInt() != MP3Stream::storedStartPosInterval
+             || in.readInt64() != sourceFile.getSize()
+             || in.readInt64() != sourceFile.getLastModificationTime().toMilliseconds())
+            return false;
+
+        const int numPositions = in.readInt();
+
+        if (numPositions <= 0)
+            return false;
+
+        positions.ensureStorageAllocated (numPositions);
+        int64 pos = in.readInt64();
+        positions.add (pos);
+
+        for (int i = 1; i < numPositions; ++i)
+        {
+            if (in.isExhausted())
+                return false;
+
+            const int delta = in.readCompressedInt();
+
+            if (delta <= 0)
+                return false;
+
+            pos += delta;
+            positions.add (pos);
+        }
+
+        return true;
+    }
+
+    static void save (const File& cacheFile, const File& sourceFile, const Array<int64>& positions)
+    {
+        if (positions.size() == 0)
+            return;
+
+        TemporaryFile temp (cacheFile);
+
+        {
+            FileOutputStream out (temp.getFile());
+
+            if (out.failedToOpen())
+                return;
+
+            out.writeInt (magicNumber);
+            out.writeInt (formatVersion);
+            out.writeInt (MP3Stream::storedStartPosInterval);
+            out.writeInt64 (sourceFile.getSize());
+            out.writeInt64 (sourceFile.getLastModificationTime().toMilliseconds());
+            out.writeInt (positions.size());
+            out.writeInt64 (positions.getFirst());
+
+            for (int i = 1; i < positions.size(); ++i)
+                out.writeCompressedInt ((int) (positions.getUnchecked (i) - positions.getUnchecked (i - 1)));
+        }
+
+        temp.overwriteTargetFileWithTemporary();
+    }
+}
+
 //==============================================================================
 class MP3Reader : public AudioFormatReader
 {
 public:
-    MP3Reader (InputStream* const in)
+    MP3Reader (InputStream* const in, const File& sourceFile_, const File& seekIndexCacheFile_)
         : AudioFormatReader (in, TRANS (mp3FormatName)),
           stream (*in), currentPosition (0),
-          decodedStart (0), decodedEnd (0)
+          decodedStart (0), decodedEnd (0),
+          sourceFile (sourceFile_), seekIndexCacheFile (seekIndexCacheFile_),
+          seekIndexWasLoaded (false)
     {
         skipID3();
         const int64 streamPos = stream.stream.getPosition();
@@ -2953,9 +3422,27 @@ public:
             sampleRate = stream.frame.getFrequency();
             numChannels = stream.frame.numChannels;
             lengthInSamples = findLength (streamPos);
+
+            if (seekIndexCacheFile.existsAsFile())
+            {
+                Array<int64> positions;
+
+                if (SeekIndexCache::load (seekIndexCacheFile, sourceFile, positions)
+                     && positions.getFirst() == stream.getFrameStreamPositions().getFirst())
+                {
+                    stream.setCompleteSeekIndex (positions);
+                    seekIndexWasLoaded = true;
+                }
+            }
         }
     }
 
+    ~MP3Reader()
+    {
+        if (seekIndexCacheFile != File::nonexistent && stream.isSeekIndexComplete() && ! seekIndexWasLoaded)
+            SeekIndexCache::save (seekIndexCacheFile, sourceFile, stream.getFrameStreamPositions());
+    }
+
     //==============================================================================
     bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
                       int64 startSampleInFile, int numSamples)
@@ -2964,7 +3451,15 @@ public:
 
         if (currentPosition != startSampleInFile)
         {
-            if (! stream.seek ((int) (startSampleInFile / 1152 - 1)))
+            // if the table's going to be cached, it needs to cover the whole file
+            if (seekIndexCacheFile != File::nonexistent)
+                stream.buildCompleteSeekIndex();
+
+            // The decoder starts a few frames early so that its bit reservoir and filter
+            // state have been filled by the time it reaches the requested position. This
+            // applies to every seek, so a larger pre-roll makes all random-access reads
+            // (e.g. from an AudioTransportSource or a thumbnail) decode extra frames.
+            if (! stream.seek ((int) (startSampleInFile / 1152 - numFramesOfPreRoll)))
             {
                 currentPosition = -1;
                 createEmptyDecodedData();
@@ -3029,9 +3524,11 @@ public:
 private:
     MP3Stream stream;
     int64 currentPosition;
-    enum { decodedDataSize = 1152 };
+    enum { decodedDataSize = 1152, numFramesOfPreRoll = 3 };
     float decoded0 [decodedDataSize], decoded1 [decodedDataSize];
     int decodedStart, decodedEnd;
+    const File sourceFile, seekIndexCacheFile;
+    bool seekIndexWasLoaded;
 
     void createEmptyDecodedData() noexcept
     {
@@ -3125,9 +3622,38 @@ bool MP3AudioFormat::canDoMono()                    { return true; }
 bool MP3AudioFormat::isCompressed()                 { return true; }
 StringArray MP3AudioFormat::getQualityOptions()     { return StringArray(); }
 
+bool MP3AudioFormat::matchesSignature (const void* headerData, int numBytes)
+{
+    const uint8* const d = static_cast <const uint8*> (headerData);
+
+    if (numBytes >= 3 && memcmp (d, "ID3", 3) == 0)
+        return true;
+
+    // a frame sync, with a layer field that's non-zero (to avoid matching AAC ADTS headers)
+    return numBytes >= 2 && d[0] == 0xff && (d[1] & 0xe0) == 0xe0 && (d[1] & 0x06) != 0;
+}
+
+void MP3AudioFormat::setSeekIndexCacheDirectory (const File& directory)
+{
+    seekIndexCacheDirectory = directory;
+}
+
 AudioFormatReader* MP3AudioFormat::createReaderFor (InputStream* sourceStream, const bool deleteStreamIfOpeningFails)
 {
-    ScopedPointer<MP3Decoder::MP3Reader> r (new MP3Decoder::MP3Reader (sourceStream));
+    File sourceFile, cacheFile;
+
+    if (seekIndexCacheDirectory != File::nonexistent)
+    {
+        if (FileInputStream* const fin = dynamic_cast <FileInputStream*> (sourceStream))
+        {
+            sourceFile = fin->getFile();
+            cacheFile = seekIndexCacheDirectory.getChildFile (sourceFile.getFileName() + "_"
+                                                               + String::toHexString (sourceFile.getFullPathName().hashCode64())
+                                                               + ".mp3index");
+        }
+    }
+
+    ScopedPointer<MP3Decoder::MP3Reader> r (new MP3Decoder::MP3Reader (sourceStream, sourceFile, cacheFile));
 
     if (r->lengthInSamples > 0)
         return r.release();
@@ -3145,4 +3671,208 @@ AudioFormatWriter* MP3AudioFormat::createWriterFor (OutputStream*, double /*samp
     return nullptr;
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MP3DecoderTests  : public UnitTest
+{
+public:
+    MP3DecoderTests() : UnitTest ("MP3 decoder") {}
+
+    enum { frameSize = 417 };
+
+    void runTest()
+    {
+        testFrameHeaderScan();
+        testSeekIndexCache();
+
+       #if JUCE_MP3_USE_SIMD
+        testSIMD();
+       #endif
+    }
+
+    // MPEG-1 layer 3, 128kbps, 44.1kHz, joint-stereo frames filled with random side
+    // info and main data, which exercises long, short and mixed blocks
+    static MemoryBlock createFrames (const int numFrames)
+    {
+        MemoryBlock mp3;
+        Random r (1234);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            uint8 frame [frameSize];
+
+            for (int j = 0; j < numElementsInArray (frame); ++j)
+                frame[j] = (uint8) r.nextInt (256);
+
+            frame[0] = 0xff; frame[1] = 0xfb; frame[2] = 0x90; frame[3] = 0x40;
+            frame[4] = 0; frame[5] &= 0x7f; // (main_data_begin = 0)
+
+            mp3.append (frame, sizeof (frame));
+        }
+
+        return mp3;
+    }
+
+    void testFrameHeaderScan()
+    {
+        beginTest ("Frame header scan");
+
+        const int numFrames = 50;
+        MemoryBlock mp3 (createFrames (numFrames));
+
+        // an ID3v1 tag at the end shouldn't stop the index being complete
+        char tag [128] = { 0 };
+        memcpy (tag, "TAG", 3);
+        mp3.append (tag, sizeof (tag));
+
+        Array<int64> scanned;
+
+        {
+            MemoryInputStream in (mp3, false);
+            MP3Decoder::MP3Stream stream (in);
+
+            // (this finds the first frame, which the scan starts from)
+            int dummy = 0;
+            stream.decodeNextBlock (nullptr, nullptr, dummy);
+            expectEquals (stream.getFrameStreamPositions().size(), 1);
+            expect (! stream.isSeekIndexComplete());
+
+            stream.buildCompleteSeekIndex();
+            expect (stream.isSeekIndexComplete());
+            scanned = stream.getFrameStreamPositions();
+        }
+
+        const int interval = MP3Decoder::MP3Stream::storedStartPosInterval;
+        expectEquals (scanned.size(), (numFrames + interval - 1) / interval);
+
+        for (int i = 0; i < scanned.size(); ++i)
+            expectEquals (scanned[i], (int64) (i * interval * frameSize));
+
+        // ..and the positions should be the same as the ones that decoding the frames finds
+        MemoryInputStream in (mp3, false);
+        MP3Decoder::MP3Stream stream (in);
+
+        for (;;)
+        {
+            int dummy = 0;
+            const int result = stream.decodeNextBlock (nullptr, nullptr, dummy);
+
+            if (result < 0 || (result > 0 && stream.stream.isExhausted()))
+                break;
+        }
+
+        expect (stream.getFrameStreamPositions() == scanned);
+    }
+
+    void testSeekIndexCache()
+    {
+        beginTest ("Seek index cache");
+
+        const TemporaryFile source (".mp3"), cache (".mp3index");
+        const MemoryBlock mp3 (createFrames (20));
+        expect (source.getFile().replaceWithData (mp3.getData(), mp3.getSize()));
+
+        Array<int64> positions, loaded;
+        positions.add (0);
+        positions.add (4 * frameSize);
+        positions.add (8 * frameSize + 1);
+        positions.add (12 * frameSize + 1);
+
+        MP3Decoder::SeekIndexCache::save (cache.getFile(), source.getFile(), positions);
+        expect (MP3Decoder::SeekIndexCache::load (cache.getFile(), source.getFile(), loaded));
+        expect (loaded == positions);
+
+        // a different modification time means the source may have changed..
+        const Time modTime (source.getFile().getLastModificationTime());
+        expect (source.getFile().setLastModificationTime (modTime + RelativeTime (10.0)));
+        loaded.clear();
+        expect (! MP3Decoder::SeekIndexCache::load (cache.getFile(), source.getFile(), loaded));
+
+        // ..and so does a different size, even if the time is the same
+        expect (source.getFile().appendData ("x", 1));
+        expect (source.getFile().setLastModificationTime (modTime));
+        loaded.clear();
+        expect (! MP3Decoder::SeekIndexCache::load (cache.getFile(), source.getFile(), loaded));
+
+        expect (source.getFile().replaceWithData (mp3.getData(), mp3.getSize()));
+        expect (source.getFile().setLastModificationTime (modTime));
+        loaded.clear();
+        expect (MP3Decoder::SeekIndexCache::load (cache.getFile(), source.getFile(), loaded));
+        expect (loaded == positions);
+    }
+
+    void testSIMD()
+    {
+        beginTest ("SIMD and scalar decoders match");
+
+        const MemoryBlock mp3 (createFrames (38 * 20));
+        MemoryBlock scalar, simd;
+        const double scalarTime = decode (mp3, scalar, false);
+        const double simdTime = decode (mp3, simd, true);
+
+        expect (scalar.getSize() > 0);
+        expectEquals ((int) simd.getSize(), (int) scalar.getSize());
+
+        const float* const s1 = static_cast <const float*> (scalar.getData());
+        const float* const s2 = static_cast <const float*> (simd.getData());
+        const int numSamples = (int) (jmin (scalar.getSize(), simd.getSize()) / sizeof (float));
+        float maxError = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+            maxError = jmax (maxError, std::abs (s1[i] - s2[i]));
+
+       #if JUCE_USE_SSE2_INTRINSICS
+        // SSE2 rounds exactly like the scalar code, so the results should be bit-for-bit identical..
+        expect (memcmp (s1, s2, sizeof (float) * (size_t) numSamples) == 0);
+       #else
+        // ..but the compiler may contract the scalar code into fused multiply-adds on NEON
+        expect (maxError < 1.0e-5f);
+       #endif
+
+        // (the frames are all 44.1kHz, so this is how many times faster than realtime each one ran)
+        const double durationMs = 1000.0 * (numSamples / 2) / 44100.0;
+
+        logMessage ("Decoded " + String (durationMs / 1000.0, 2) + "s of audio: scalar " + String (scalarTime, 1)
+                     + "ms (" + String (durationMs / jmax (0.001, scalarTime), 1) + "x realtime), SIMD "
+                     + String (simdTime, 1) + "ms (" + String (durationMs / jmax (0.001, simdTime), 1)
+                     + "x realtime), max difference " + String (maxError));
+    }
+
+    // decodes the whole stream into interleaved stereo samples, returning the time spent decoding
+    static double decode (const MemoryBlock& mp3, MemoryBlock& dest, const bool useSIMD)
+    {
+        MemoryInputStream in (mp3, false);
+        MP3Decoder::MP3Stream stream (in);
+        stream.useSIMD = useSIMD;
+
+        MemoryOutputStream out (dest, false);
+        float out0 [1152], out1 [1152];
+        double timeSpent = 0;
+
+        for (;;)
+        {
+            int samplesDone = 0;
+            const double startTime = Time::getMillisecondCounterHiRes();
+            const int result = stream.decodeNextBlock (out0, out1, samplesDone);
+            timeSpent += Time::getMillisecondCounterHiRes() - startTime;
+
+            if (result < 0 || (result > 0 && stream.stream.isExhausted()))
+                break;
+
+            for (int i = 0; i < samplesDone; ++i)
+            {
+                out.write (out0 + i, sizeof (float));
+                out.write (out1 + i, sizeof (float));
+            }
+        }
+
+        return timeSpent;
+    }
+};
+
+static MP3DecoderTests mp3DecoderTests;
+
+#endif
+
 #endif
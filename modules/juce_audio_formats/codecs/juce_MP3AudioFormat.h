@@ -54,12 +54,35 @@ public:
     bool isCompressed();
     StringArray getQualityOptions();
 
+    bool matchesSignature (const void* headerData, int numBytes);
+
     //==============================================================================
     AudioFormatReader* createReaderFor (InputStream*, bool deleteStreamIfOpeningFails);
 
     AudioFormatWriter* createWriterFor (OutputStream*, double sampleRateToUse,
                                         unsigned int numberOfChannels, int bitsPerSample,
                                         const StringPairArray& metadataValues, int qualityOptionIndex);
+
+    //==============================================================================
+    /** Sets a directory in which readers can keep the seek tables that they build for mp3 files.
+
+        To seek within an mp3 file, a reader needs to know where each of its frames starts, and
+        it finds this out by scanning through the file the first time it seeks beyond the part that
+        it has already read. If a cache directory is set, then once a reader has scanned the whole
+        of a file, it'll save the table in this directory when it's deleted, and any readers that
+        are opened on the same file afterwards will load it instead of scanning the file again.
+        A saved table is ignored if the file's size or modification time has changed.
+
+        This only applies to readers that are created with a FileInputStream. By default no
+        directory is set, and nothing is saved.
+    */
+    void setSeekIndexCacheDirectory (const File& directory);
+
+    /** Returns the directory that was set with setSeekIndexCacheDirectory(). */
+    const File& getSeekIndexCacheDirectory() const noexcept     { return seekIndexCacheDirectory; }
+
+private:
+    File seekIndexCacheDirectory;
 };
 
 #endif
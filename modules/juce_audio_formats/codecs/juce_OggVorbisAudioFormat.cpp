@@ -451,6 +451,11 @@ bool OggVorbisAudioFormat::canDoStereo()    { return true; }
 bool OggVorbisAudioFormat::canDoMono()      { return true; }
 bool OggVorbisAudioFormat::isCompressed()   { return true; }
 
+bool OggVorbisAudioFormat::matchesSignature (const void* headerData, int numBytes)
+{
+    return numBytes >= 4 && memcmp (headerData, "OggS", 4) == 0;
+}
+
 AudioFormatReader* OggVorbisAudioFormat::createReaderFor (InputStream* in, const bool deleteStreamIfOpeningFails)
 {
     ScopedPointer<OggReader> r (new OggReader (in));
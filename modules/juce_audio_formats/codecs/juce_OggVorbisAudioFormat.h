@@ -75,6 +75,8 @@ public:
     static const char* const id3genre;          /**< Metadata key for setting an ID3 genre. */
     static const char* const id3trackNumber;    /**< Metadata key for setting an ID3 track number. */
 
+    bool matchesSignature (const void* headerData, int numBytes);
+
     //==============================================================================
     AudioFormatReader* createReaderFor (InputStream* sourceStream,
                                         bool deleteStreamIfOpeningFails);
@@ -347,6 +347,16 @@ bool WindowsMediaAudioFormat::canDoStereo()     { return true; }
 bool WindowsMediaAudioFormat::canDoMono()       { return true; }
 
 //==============================================================================
+bool WindowsMediaAudioFormat::matchesSignature (const void* headerData, int numBytes)
+{
+    // the ASF header object's GUID
+    const uint8 asfHeaderGuid[] = { 0x30, 0x26, 0xb2, 0x75, 0x8e, 0x66, 0xcf, 0x11,
+                                    0xa6, 0xd9, 0x00, 0xaa, 0x00, 0x62, 0xce, 0x6c };
+
+    return numBytes >= (int) sizeof (asfHeaderGuid)
+            && memcmp (headerData, asfHeaderGuid, sizeof (asfHeaderGuid)) == 0;
+}
+
 AudioFormatReader* WindowsMediaAudioFormat::createReaderFor (InputStream* sourceStream, bool deleteStreamIfOpeningFails)
 {
     ScopedPointer<WindowsMediaCodec::WMAudioReader> r (new WindowsMediaCodec::WMAudioReader (sourceStream));
@@ -42,6 +42,8 @@ public:
     bool canDoStereo();
     bool canDoMono();
 
+    bool matchesSignature (const void* headerData, int numBytes);
+
     //==============================================================================
     AudioFormatReader* createReaderFor (InputStream*, bool deleteStreamIfOpeningFails);
 
@@ -43,7 +43,17 @@ bool AudioFormat::canHandleFile (const File& f)
     return false;
 }
 
+bool AudioFormat::matchesSignature (const void*, int)
+{
+    return false;
+}
+
 const String& AudioFormat::getFormatName() const                { return formatName; }
 const StringArray& AudioFormat::getFileExtensions() const       { return fileExtensions; }
 bool AudioFormat::isCompressed()                                { return false; }
 StringArray AudioFormat::getQualityOptions()                    { return StringArray(); }
+
+MemoryMappedAudioFormatReader* AudioFormat::createMemoryMappedReader (const File&)
+{
+    return nullptr;
+}
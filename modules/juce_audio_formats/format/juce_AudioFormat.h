@@ -28,6 +28,7 @@
 
 #include "juce_AudioFormatReader.h"
 #include "juce_AudioFormatWriter.h"
+class MemoryMappedAudioFormatReader;
 
 
 //==============================================================================
@@ -69,6 +70,24 @@ public:
     */
     virtual bool canHandleFile (const File& fileToTest);
 
+    /** The maximum number of bytes that will be passed to matchesSignature(). */
+    enum { maxSignatureSize = 16 };
+
+    /** Returns true if the first few bytes of a stream look like the start of a file in this format.
+
+        AudioFormatManager uses this to decide which format to try first when opening a stream,
+        so it needs to be very quick - typically it'll just check for the format's magic numbers.
+        A match doesn't need to guarantee that the stream can actually be opened, and if no format
+        matches, the manager will still try all of them in turn.
+
+        The base class implementation just returns false.
+
+        @param headerData   the data from the start of the stream
+        @param numBytes     the number of bytes in headerData - this will be maxSignatureSize unless
+                            the stream is shorter than that
+    */
+    virtual bool matchesSignature (const void* headerData, int numBytes);
+
     /** Returns a set of sample rates that the format can read and write. */
     virtual Array<int> getPossibleSampleRates() = 0;
 
@@ -113,6 +132,14 @@ public:
     virtual AudioFormatReader* createReaderFor (InputStream* sourceStream,
                                                 bool deleteStreamIfOpeningFails) = 0;
 
+    /** Attempts to create a MemoryMappedAudioFormatReader, if possible for this format.
+        If the format does not support this, the method will return nullptr.
+        The base class implementation returns nullptr, and only uncompressed formats
+        are likely to override it.
+        @see MemoryMappedAudioFormatReader
+    */
+    virtual MemoryMappedAudioFormatReader* createMemoryMappedReader (const File& file);
+
     /** Tries to create an object that can write to a stream with this audio format.
 
         The writer object that is returned can be used to write to the stream, and
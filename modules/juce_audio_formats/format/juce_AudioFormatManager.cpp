@@ -23,7 +23,7 @@
   ==============================================================================
 */
 
-AudioFormatManager::AudioFormatManager()  : defaultFormatIndex (0) {}
+AudioFormatManager::AudioFormatManager()  : defaultFormatIndex (0), blockCache (nullptr) {}
 AudioFormatManager::~AudioFormatManager() {}
 
 //==============================================================================
@@ -126,8 +126,18 @@ String AudioFormatManager::getWildcardForAllFormats() const
     return extensions.joinIntoString (";");
 }
 
+void AudioFormatManager::setDecodedBlockCache (DecodedAudioBlockCache* const cacheToUse) noexcept
+{
+    blockCache = cacheToUse;
+}
+
 //==============================================================================
 AudioFormatReader* AudioFormatManager::createReaderFor (const File& file)
+{
+    return createReaderForFile (file, true);
+}
+
+AudioFormatReader* AudioFormatManager::createReaderForFile (const File& file, const bool useCache)
 {
     // you need to actually register some formats before the manager can
     // use them to open a file!
@@ -140,7 +150,8 @@ AudioFormatReader* AudioFormatManager::createReaderFor (const File& file)
         if (af->canHandleFile (file))
             if (InputStream* const in = file.createInputStream())
                 if (AudioFormatReader* const r = af->createReaderFor (in, true))
-                    return r;
+                    return (useCache && blockCache != nullptr && af->isCompressed())
+                              ? blockCache->createCachingReader (r, file) : r;
     }
 
     return nullptr;
@@ -158,21 +169,377 @@ AudioFormatReader* AudioFormatManager::createReaderFor (InputStream* audioFileSt
     {
         const int64 originalStreamPos = in->getPosition();
 
-        for (int i = 0; i < getNumKnownFormats(); ++i)
+        // Any formats that recognise the header get the first go at opening the stream, and
+        // the rest are only tried if those fail, so that a file doesn't get parsed by every
+        // format that comes before its own one in the list.
+        char header [AudioFormat::maxSignatureSize];
+        const int headerSize = jmax (0, in->read (header, sizeof (header)));
+        in->setPosition (originalStreamPos);
+
+        for (int pass = 0; pass < 2; ++pass)
         {
-            if (AudioFormatReader* const r = getKnownFormat(i)->createReaderFor (in, false))
+            for (int i = 0; i < getNumKnownFormats(); ++i)
             {
-                in.release();
-                return r;
-            }
+                AudioFormat* const af = getKnownFormat(i);
 
-            in->setPosition (originalStreamPos);
+                if (af->matchesSignature (header, headerSize) != (pass == 0))
+                    continue;
 
-            // the stream that is passed-in must be capable of being repositioned so
-            // that all the formats can have a go at opening it.
-            jassert (in->getPosition() == originalStreamPos);
+                if (AudioFormatReader* const r = af->createReaderFor (in, false))
+                {
+                    in.release();
+                    return r;
+                }
+
+                in->setPosition (originalStreamPos);
+
+                // the stream that is passed-in must be capable of being repositioned so
+                // that all the formats can have a go at opening it.
+                jassert (in->getPosition() == originalStreamPos);
+            }
         }
     }
 
     return nullptr;
 }
+
+//==============================================================================
+namespace ParallelReadHelpers
+{
+    // Segment boundaries are kept to multiples of this, which is a whole number of
+    // FLAC blocks and of MP3 frames, so that no block needs to be decoded twice.
+    enum { segmentAlignment = 36864 };
+
+    class SegmentReader  : public ThreadPoolJob
+    {
+    public:
+        SegmentReader (AudioFormatReader* const reader_, AudioSampleBuffer& destBuffer_,
+                       const int startSample_, const int numSamples_)
+            : ThreadPoolJob ("Audio file segment reader"),
+              reader (reader_), destBuffer (destBuffer_),
+              startSample (startSample_), numSamples (numSamples_),
+              succeeded (false)
+        {
+        }
+
+        JobStatus runJob()
+        {
+            read();
+            return jobHasFinished;
+        }
+
+        void read()
+        {
+            const int numChannels = destBuffer.getNumChannels();
+            HeapBlock<int*> channels ((size_t) numChannels + 1, true);
+
+            for (int i = 0; i < numChannels; ++i)
+                channels[i] = reinterpret_cast<int*> (destBuffer.getSampleData (i, startSample));
+
+            succeeded = reader->read (channels, numChannels, startSample, numSamples, false);
+
+            if (! reader->usesFloatingPointData)
+            {
+                const float multiplier = 1.0f / 0x7fffffff;
+
+                for (int i = 0; i < numChannels; ++i)
+                {
+                    float* const d = destBuffer.getSampleData (i, startSample);
+
+                    for (int j = 0; j < numSamples; ++j)
+                        d[j] = *reinterpret_cast<int*> (d + j) * multiplier;
+                }
+            }
+        }
+
+        ScopedPointer<AudioFormatReader> reader;
+        AudioSampleBuffer& destBuffer;
+        const int startSample, numSamples;
+        bool succeeded;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE (SegmentReader)
+    };
+}
+
+bool AudioFormatManager::readFileInParallel (const File& file, AudioSampleBuffer& destBuffer,
+                                             double& sampleRate, ThreadPool& threadPool)
+{
+    using namespace ParallelReadHelpers;
+
+    // The segments are only read once, so going through the block cache would just
+    // push everything else out of it.
+    ScopedPointer<AudioFormatReader> firstReader (createReaderForFile (file, false));
+
+    if (firstReader == nullptr
+         || firstReader->numChannels == 0
+         || firstReader->lengthInSamples > std::numeric_limits<int>::max())
+        return false;
+
+    const int length = (int) firstReader->lengthInSamples;
+    sampleRate = firstReader->sampleRate;
+    destBuffer.setSize ((int) firstReader->numChannels, length);
+
+    // Aim for a couple of segments per core, but don't bother splitting the file
+    // into pieces so small that the cost of opening their readers would dominate.
+    const int minSegmentLength = 8 * segmentAlignment;
+    const int numAlignedBlocks = (length + segmentAlignment - 1) / segmentAlignment;
+    const int numSegments = jlimit (1, jmax (1, length / minSegmentLength),
+                                    jmin (numAlignedBlocks, 2 * SystemStats::getNumCpus()));
+    const int blocksPerSegment = (numAlignedBlocks + numSegments - 1) / numSegments;
+    const int segmentLength = blocksPerSegment * segmentAlignment;
+
+    OwnedArray<SegmentReader> segments;
+
+    for (int start = 0; start < length; start += segmentLength)
+    {
+        AudioFormatReader* const reader = (start == 0) ? firstReader.release() : createReaderForFile (file, false);
+
+        if (reader == nullptr)
+            return false;
+
+        segments.add (new SegmentReader (reader, destBuffer, start, jmin (segmentLength, length - start)));
+    }
+
+    for (int i = 1; i < segments.size(); ++i)
+        threadPool.addJob (segments.getUnchecked (i), false);
+
+    bool ok = true;
+
+    if (segments.size() > 0)
+    {
+        segments.getUnchecked (0)->read();
+        ok = segments.getUnchecked (0)->succeeded;
+    }
+
+    for (int i = 1; i < segments.size(); ++i)
+    {
+        SegmentReader* const s = segments.getUnchecked (i);
+        threadPool.waitForJobToFinish (s, -1);
+        ok = ok && s->succeeded;
+    }
+
+    return ok;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioFormatManagerParallelReadTests  : public UnitTest
+{
+public:
+    AudioFormatManagerParallelReadTests() : UnitTest ("AudioFormatManager parallel reading") {}
+
+    void runTest()
+    {
+        beginTest ("Parallel read of a WAV file matches a serial read");
+        WavAudioFormat wav;
+        checkRoundTrip (wav, ".wav");
+
+       #if JUCE_USE_FLAC
+        beginTest ("Parallel read of a FLAC file matches a serial read");
+        FlacAudioFormat flac;
+        checkRoundTrip (flac, ".flac");
+       #endif
+    }
+
+    void checkRoundTrip (AudioFormat& format, const String& extension)
+    {
+        const int numChannels = 3;
+        const int numSamples = 44100 * 30 + 123;
+        const TemporaryFile tempFile (extension);
+
+        {
+            AudioSampleBuffer buffer (numChannels, numSamples);
+            Random r (1234);
+
+            for (int chan = 0; chan < numChannels; ++chan)
+                for (int i = 0; i < numSamples; ++i)
+                    *buffer.getSampleData (chan, i) = r.nextFloat() * 2.0f - 1.0f;
+
+            ScopedPointer<AudioFormatWriter> writer (format.createWriterFor (tempFile.getFile().createOutputStream(),
+                                                                             44100.0, numChannels, 16,
+                                                                             StringPairArray(), 0));
+            expect (writer != nullptr);
+
+            if (writer == nullptr)
+                return;
+
+            writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+        }
+
+        AudioFormatManager manager;
+        manager.registerBasicFormats();
+
+        ScopedPointer<AudioFormatReader> reader (manager.createReaderFor (tempFile.getFile()));
+        expect (reader != nullptr);
+
+        if (reader == nullptr)
+            return;
+
+        expectEquals (reader->getFormatName(), format.getFormatName());
+
+        AudioSampleBuffer serial (numChannels, numSamples);
+        HeapBlock<int*> channels ((size_t) numChannels + 1, true);
+
+        for (int chan = 0; chan < numChannels; ++chan)
+            channels[chan] = reinterpret_cast<int*> (serial.getSampleData (chan));
+
+        expect (reader->read (channels, numChannels, 0, numSamples, false));
+
+        ThreadPool threadPool (3);
+        AudioSampleBuffer parallel (1, 1);
+        double sampleRate = 0;
+
+        expect (manager.readFileInParallel (tempFile.getFile(), parallel, sampleRate, threadPool));
+        expectEquals (sampleRate, 44100.0);
+        expectEquals (parallel.getNumChannels(), numChannels);
+        expectEquals (parallel.getNumSamples(), numSamples);
+
+        if (parallel.getNumChannels() != numChannels || parallel.getNumSamples() != numSamples)
+            return;
+
+        int numDifferences = 0;
+
+        for (int chan = 0; chan < numChannels; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                if (*parallel.getSampleData (chan, i)
+                      != *reinterpret_cast<int*> (serial.getSampleData (chan, i)) * (1.0f / 0x7fffffff))
+                    ++numDifferences;
+
+        expectEquals (numDifferences, 0);
+    }
+};
+
+static AudioFormatManagerParallelReadTests audioFormatManagerParallelReadTests;
+
+//==============================================================================
+class AudioFormatManagerSniffingTests  : public UnitTest
+{
+public:
+    AudioFormatManagerSniffingTests() : UnitTest ("AudioFormatManager format sniffing") {}
+
+    // A format that can't recognise its own header, and which opens any stream that starts
+    // with a given marker, so the tests can see when and how often it gets asked.
+    class MarkerFormat  : public AudioFormat
+    {
+    public:
+        MarkerFormat (const String& name, const char* const marker_)
+            : AudioFormat (name, StringArray (".wav")), marker (marker_), numAttempts (0)
+        {
+        }
+
+        Array<int> getPossibleSampleRates()     { return Array<int>(); }
+        Array<int> getPossibleBitDepths()       { return Array<int>(); }
+        bool canDoStereo()                      { return false; }
+        bool canDoMono()                        { return true; }
+
+        AudioFormatReader* createReaderFor (InputStream* in, const bool deleteStreamIfOpeningFails)
+        {
+            ++numAttempts;
+            char header [4] = { 0 };
+
+            if (in->read (header, sizeof (header)) == (int) sizeof (header)
+                 && memcmp (header, marker, sizeof (header)) == 0)
+                return new MarkerReader (in, getFormatName());
+
+            if (deleteStreamIfOpeningFails)
+                delete in;
+
+            return nullptr;
+        }
+
+        AudioFormatWriter* createWriterFor (OutputStream*, double, unsigned int, int, const StringPairArray&, int)
+        {
+            return nullptr;
+        }
+
+        const char* const marker;
+        int numAttempts;
+
+    private:
+        class MarkerReader  : public AudioFormatReader
+        {
+        public:
+            MarkerReader (InputStream* in, const String& name)  : AudioFormatReader (in, name)
+            {
+                sampleRate = 44100.0;
+                numChannels = 1;
+                bitsPerSample = 16;
+            }
+
+            bool readSamples (int**, int, int, int64, int)  { return false; }
+        };
+    };
+
+    void runTest()
+    {
+        AudioFormatManager manager;
+        MarkerFormat* const first = new MarkerFormat ("First marker format", "TST1");
+        MarkerFormat* const last = new MarkerFormat ("Last marker format", "TST2");
+
+        manager.registerFormat (first, false);
+        manager.registerFormat (new WavAudioFormat(), true);
+        manager.registerFormat (new AiffAudioFormat(), false);
+        manager.registerFormat (last, false);
+
+        beginTest ("A stream is opened by the format that matches its signature");
+        {
+            // (the extension is deliberately the wrong one for the data)
+            const TemporaryFile tempFile (".wav");
+            AiffAudioFormat aiff;
+
+            {
+                ScopedPointer<AudioFormatWriter> writer (aiff.createWriterFor (tempFile.getFile().createOutputStream(),
+                                                                               44100.0, 1, 16, StringPairArray(), 0));
+                expect (writer != nullptr);
+
+                if (writer != nullptr)
+                {
+                    AudioSampleBuffer buffer (1, 1000);
+                    buffer.clear();
+                    writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+                }
+            }
+
+            MemoryBlock header;
+            tempFile.getFile().loadFileAsData (header);
+            expect (aiff.matchesSignature (header.getData(), jmin ((int) header.getSize(), (int) AudioFormat::maxSignatureSize)));
+            expect (! WavAudioFormat().matchesSignature (header.getData(), jmin ((int) header.getSize(), (int) AudioFormat::maxSignatureSize)));
+
+            ScopedPointer<AudioFormatReader> reader (manager.createReaderFor (tempFile.getFile().createInputStream()));
+            expect (reader != nullptr);
+
+            if (reader != nullptr)
+            {
+                expectEquals (reader->getFormatName(), aiff.getFormatName());
+                expectEquals ((int) reader->lengthInSamples, 1000);
+            }
+
+            // the signature pass should have gone straight to the AIFF reader
+            expectEquals (first->numAttempts, 0);
+            expectEquals (last->numAttempts, 0);
+        }
+
+        beginTest ("A stream that matches no signature is offered to every format");
+        {
+            const char data[] = "TST2 and some data that no format will recognise";
+            ScopedPointer<AudioFormatReader> reader (manager.createReaderFor (new MemoryInputStream (data, sizeof (data), true)));
+            expect (reader != nullptr);
+
+            if (reader != nullptr)
+                expectEquals (reader->getFormatName(), last->getFormatName());
+
+            expectEquals (first->numAttempts, 1);
+            expectEquals (last->numAttempts, 1);
+
+            expect (manager.createReaderFor (new MemoryInputStream (data + 1, sizeof (data) - 1, true)) == nullptr);
+            expectEquals (first->numAttempts, 2);
+            expectEquals (last->numAttempts, 2);
+        }
+    }
+};
+
+static AudioFormatManagerSniffingTests audioFormatManagerSniffingTests;
+
+#endif
@@ -27,6 +27,7 @@
 #define __JUCE_AUDIOFORMATMANAGER_JUCEHEADER__
 
 #include "juce_AudioFormat.h"
+#include "juce_DecodedAudioBlockCache.h"
 
 
 //==============================================================================
@@ -111,6 +112,11 @@ public:
 
         If none of the registered formats can open the file, it'll return 0. If it
         returns a reader, it's the caller's responsibility to delete the reader.
+
+        If a DecodedAudioBlockCache has been set with setDecodedBlockCache() and the
+        file is in a compressed format, the reader that's returned will keep the
+        data that it decodes in the cache, and will use any parts of the file that
+        other readers have already put there.
     */
     AudioFormatReader* createReaderFor (const File& audioFile);
 
@@ -121,17 +127,62 @@ public:
         reader that is returned, so the caller should not keep any references to it.
 
         The stream that is passed-in must be capable of being repositioned so
-        that all the formats can have a go at opening it.
+        that all the formats can have a go at opening it. Formats whose
+        AudioFormat::matchesSignature() method recognises the start of the stream
+        are tried first, and the others are only tried if those fail.
 
         If none of the registered formats can open the stream, it'll return 0. If it
         returns a reader, it's the caller's responsibility to delete the reader.
     */
     AudioFormatReader* createReaderFor (InputStream* audioFileStream);
 
+    //==============================================================================
+    /** Reads the whole of an audio file into a buffer, decoding different sections of
+        it simultaneously on a thread pool.
+
+        The file is divided into a few large segments, each of which is decoded by its
+        own reader, so on a multi-core machine a long compressed file can be loaded much
+        more quickly than by reading it from start to finish. The calling thread decodes
+        the first segment itself while the pool's threads deal with the others.
+
+        This relies on the file's reader being able to start reading accurately at any
+        sample position. For WAV, AIFF, FLAC and Ogg-Vorbis files the result is identical
+        to reading the file serially, but an MP3 segment is decoded from a few frames of
+        pre-roll before its start, so its first samples can differ very slightly from a
+        serial decode if the bit reservoir or filter state reach back further than that.
+
+        @param file         the file to read
+        @param destBuffer   the buffer to fill - this will be resized to match the length
+                            and number of channels of the file
+        @param sampleRate   on return, this will be set to the file's sample rate
+        @param threadPool   the pool on which to run the decoding jobs
+        @returns true if the file was opened and all of it was read successfully
+    */
+    bool readFileInParallel (const File& file, AudioSampleBuffer& destBuffer,
+                             double& sampleRate, ThreadPool& threadPool);
+
+    //==============================================================================
+    /** Gives the manager a cache in which the readers that it creates for compressed
+        files should keep their decoded data.
+
+        The cache isn't owned by the manager, and must not be deleted while the manager
+        or any of the readers that it created are still using it. Several managers can
+        share the same cache. Pass nullptr to stop using a cache.
+
+        @see DecodedAudioBlockCache
+    */
+    void setDecodedBlockCache (DecodedAudioBlockCache* cacheToUse) noexcept;
+
+    /** Returns the cache that was set with setDecodedBlockCache(), if there is one. */
+    DecodedAudioBlockCache* getDecodedBlockCache() const noexcept      { return blockCache; }
+
 private:
     //==============================================================================
     OwnedArray<AudioFormat> knownFormats;
     int defaultFormatIndex;
+    DecodedAudioBlockCache* blockCache;
+
+    AudioFormatReader* createReaderForFile (const File&, bool useCache);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFormatManager)
 };
@@ -0,0 +1,482 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+class DecodedAudioBlockCache::Block  : public ReferenceCountedObject
+{
+public:
+    Block (const int numChannels_, const int numSamples_)
+        : data ((size_t) (numChannels_ * numSamples_)),
+          channels ((size_t) numChannels_ + 1, true),
+          numChannels (numChannels_), numSamples (numSamples_),
+          key (0), previous (nullptr), next (nullptr)
+    {
+        for (int i = 0; i < numChannels; ++i)
+            channels[i] = data + i * numSamples;
+    }
+
+    size_t getNumBytes() const noexcept
+    {
+        return sizeof (Block) + sizeof (int) * (size_t) (numChannels * numSamples);
+    }
+
+    HeapBlock<int> data;
+    HeapBlock<int*> channels;
+    const int numChannels, numSamples;
+
+    // these are only used by the Shard that holds the block, while its lock is held
+    int64 key;
+    Block* previous;
+    Block* next;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (Block)
+};
+
+//==============================================================================
+class DecodedAudioBlockCache::Shard
+{
+public:
+    explicit Shard (const int64 maxBytes_)
+        : maxBytes (maxBytes_), numBytesUsed (0),
+          newest (nullptr), oldest (nullptr)
+    {
+    }
+
+    ~Shard()
+    {
+        clear();
+    }
+
+    BlockPtr find (const int64 key)
+    {
+        const ScopedLock sl (lock);
+        Block* const b = blocks [key];
+
+        if (b != nullptr && b != newest)
+        {
+            unlink (b);
+            linkAsNewest (b);
+        }
+
+        return b;
+    }
+
+    void add (const int64 key, Block* const b)
+    {
+        const ScopedLock sl (lock);
+
+        // another reader may have decoded the same block while this one was doing so
+        if (blocks.contains (key))
+            return;
+
+        b->key = key;
+        b->incReferenceCount();
+        blocks.set (key, b);
+        linkAsNewest (b);
+        numBytesUsed += (int64) b->getNumBytes();
+
+        removeOldBlocks();
+    }
+
+    void setMaximumMemory (const int64 newMaxBytes)
+    {
+        const ScopedLock sl (lock);
+        maxBytes = newMaxBytes;
+        removeOldBlocks();
+    }
+
+    void clear()
+    {
+        const ScopedLock sl (lock);
+
+        while (oldest != nullptr)
+            removeOldest();
+    }
+
+    void addToStatistics (Statistics& stats) const
+    {
+        const ScopedLock sl (lock);
+        stats.numBytesUsed += numBytesUsed;
+        stats.numBlocks += blocks.size();
+    }
+
+private:
+    struct KeyHash
+    {
+        static int generateHash (const int64 key, const int upperLimit) noexcept
+        {
+            return (int) ((uint64) (key ^ (key >> 29)) % (uint64) upperLimit);
+        }
+    };
+
+    CriticalSection lock;
+    HashMap<int64, Block*, KeyHash> blocks;
+    int64 maxBytes, numBytesUsed;
+    Block* newest;
+    Block* oldest;
+
+    void linkAsNewest (Block* const b) noexcept
+    {
+        b->previous = nullptr;
+        b->next = newest;
+
+        if (newest != nullptr)
+            newest->previous = b;
+        else
+            oldest = b;
+
+        newest = b;
+    }
+
+    void unlink (Block* const b) noexcept
+    {
+        if (b->previous != nullptr)  b->previous->next = b->next;
+        else                         newest = b->next;
+
+        if (b->next != nullptr)      b->next->previous = b->previous;
+        else                         oldest = b->previous;
+    }
+
+    void removeOldest()
+    {
+        Block* const b = oldest;
+        unlink (b);
+        blocks.remove (b->key);
+        numBytesUsed -= (int64) b->getNumBytes();
+
+        // any reader that's still copying from the block keeps it alive
+        b->decReferenceCount();
+    }
+
+    void removeOldBlocks()
+    {
+        while (numBytesUsed > maxBytes && oldest != nullptr)
+            removeOldest();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Shard)
+};
+
+//==============================================================================
+class DecodedAudioBlockCache::CachingReader  : public AudioFormatReader
+{
+public:
+    CachingReader (DecodedAudioBlockCache& cache_, AudioFormatReader* const source_, const int sourceId_)
+        : AudioFormatReader (nullptr, source_->getFormatName()),
+          cache (cache_), source (source_),
+          firstKey (((int64) sourceId_) << 32)
+    {
+        sampleRate = source->sampleRate;
+        bitsPerSample = source->bitsPerSample;
+        lengthInSamples = source->lengthInSamples;
+        numChannels = source->numChannels;
+        usesFloatingPointData = source->usesFloatingPointData;
+        metadataValues = source->metadataValues;
+    }
+
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      int64 startSampleInFile, int numSamples)
+    {
+        const int blockSize = cache.blockSize;
+
+        while (numSamples > 0)
+        {
+            const int64 blockIndex = startSampleInFile / blockSize;
+            const int offsetInBlock = (int) (startSampleInFile - blockIndex * blockSize);
+            const int numToDo = jmin (numSamples, blockSize - offsetInBlock);
+
+            const BlockPtr block (getBlock (blockIndex));
+
+            if (block == nullptr)
+            {
+                for (int i = numDestChannels; --i >= 0;)
+                    if (destSamples[i] != nullptr)
+                        zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+
+                return true;
+            }
+
+            for (int i = numDestChannels; --i >= 0;)
+            {
+                if (destSamples[i] != nullptr)
+                {
+                    if (i < block->numChannels)
+                        memcpy (destSamples[i] + startOffsetInDestBuffer, block->channels[i] + offsetInBlock,
+                                sizeof (int) * (size_t) numToDo);
+                    else
+                        zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numToDo);
+                }
+            }
+
+            startOffsetInDestBuffer += numToDo;
+            startSampleInFile += numToDo;
+            numSamples -= numToDo;
+        }
+
+        return true;
+    }
+
+private:
+    DecodedAudioBlockCache& cache;
+    ScopedPointer<AudioFormatReader> source;
+    const int64 firstKey;
+
+    BlockPtr getBlock (const int64 blockIndex)
+    {
+        const int64 blockStart = blockIndex * cache.blockSize;
+
+        if (blockStart >= lengthInSamples)
+            return nullptr;
+
+        const int64 key = firstKey + blockIndex;
+        BlockPtr block (cache.findBlock (key));
+
+        if (block == nullptr)
+        {
+            const int numSamples = (int) jmin ((int64) cache.blockSize, lengthInSamples - blockStart);
+            block = new Block ((int) numChannels, numSamples);
+            source->read (block->channels, (int) numChannels, blockStart, numSamples, false);
+            cache.addBlock (key, block);
+        }
+
+        return block;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CachingReader)
+};
+
+//==============================================================================
+DecodedAudioBlockCache::DecodedAudioBlockCache (const int64 maxMemoryBytes, const int blockSizeInSamples)
+    : maxMemory (maxMemoryBytes),
+      blockSize (jmax (256, blockSizeInSamples))
+{
+    for (int i = 0; i < numShards; ++i)
+        shards.add (new Shard (maxMemory / numShards));
+}
+
+DecodedAudioBlockCache::~DecodedAudioBlockCache()
+{
+}
+
+AudioFormatReader* DecodedAudioBlockCache::createCachingReader (AudioFormatReader* const sourceReader,
+                                                                const File& sourceFile)
+{
+    if (sourceReader == nullptr)
+        return nullptr;
+
+    return new CachingReader (*this, sourceReader, getSourceId (sourceFile));
+}
+
+void DecodedAudioBlockCache::setMaximumMemory (const int64 maxMemoryBytes)
+{
+    maxMemory = maxMemoryBytes;
+
+    for (int i = 0; i < numShards; ++i)
+        shards.getUnchecked (i)->setMaximumMemory (maxMemory / numShards);
+}
+
+void DecodedAudioBlockCache::clear()
+{
+    for (int i = 0; i < numShards; ++i)
+        shards.getUnchecked (i)->clear();
+}
+
+//==============================================================================
+double DecodedAudioBlockCache::Statistics::getHitRatio() const noexcept
+{
+    const int64 total = numHits + numMisses;
+    return total > 0 ? numHits / (double) total : 0.0;
+}
+
+DecodedAudioBlockCache::Statistics DecodedAudioBlockCache::getStatistics() const
+{
+    Statistics stats;
+    stats.numHits = numHits.get();
+    stats.numMisses = numMisses.get();
+    stats.numBytesUsed = 0;
+    stats.numBlocks = 0;
+
+    for (int i = 0; i < numShards; ++i)
+        shards.getUnchecked (i)->addToStatistics (stats);
+
+    return stats;
+}
+
+void DecodedAudioBlockCache::resetStatistics() noexcept
+{
+    numHits = 0;
+    numMisses = 0;
+}
+
+//==============================================================================
+int DecodedAudioBlockCache::getSourceId (const File& file)
+{
+    // a file that's been rewritten gets a new id, so its old blocks will never be used
+    const String identifier (file.getFullPathName() + "|" + String (file.getSize())
+                               + "|" + String (file.getLastModificationTime().toMilliseconds()));
+
+    const ScopedLock sl (sourceIdLock);
+
+    if (! sourceIds.contains (identifier))
+        sourceIds.set (identifier, sourceIds.size());
+
+    return sourceIds [identifier];
+}
+
+DecodedAudioBlockCache::Shard& DecodedAudioBlockCache::getShardFor (const int64 key) const noexcept
+{
+    // neighbouring blocks of a file go into different shards, so that readers which are
+    // working through the same region don't all compete for the same lock
+    return *shards.getUnchecked ((int) ((key ^ (key >> 32)) & (numShards - 1)));
+}
+
+DecodedAudioBlockCache::BlockPtr DecodedAudioBlockCache::findBlock (const int64 key)
+{
+    BlockPtr b (getShardFor (key).find (key));
+
+    if (b != nullptr)
+        ++numHits;
+    else
+        ++numMisses;
+
+    return b;
+}
+
+void DecodedAudioBlockCache::addBlock (const int64 key, Block* const b)
+{
+    getShardFor (key).add (key, b);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class DecodedAudioBlockCacheTests  : public UnitTest
+{
+public:
+    DecodedAudioBlockCacheTests() : UnitTest ("DecodedAudioBlockCache") {}
+
+    void runTest()
+    {
+        beginTest ("Cached data matches the source");
+
+        const int numChannels = 2;
+        const int numSamples = 100000;
+        const int blockSize = 1000;
+        const TemporaryFile tempFile (".wav");
+        WavAudioFormat wav;
+
+        {
+            AudioSampleBuffer buffer (numChannels, numSamples);
+            Random r (1234);
+
+            for (int chan = 0; chan < numChannels; ++chan)
+                for (int i = 0; i < numSamples; ++i)
+                    *buffer.getSampleData (chan, i) = r.nextFloat() * 2.0f - 1.0f;
+
+            ScopedPointer<AudioFormatWriter> writer (wav.createWriterFor (tempFile.getFile().createOutputStream(),
+                                                                          44100.0, numChannels, 24,
+                                                                          StringPairArray(), 0));
+            expect (writer != nullptr);
+
+            if (writer == nullptr)
+                return;
+
+            writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+        }
+
+        // room for a few more than 20 blocks
+        const int64 maxMemory = 20 * (numChannels * blockSize * (int64) sizeof (int) + 256);
+        DecodedAudioBlockCache cache (maxMemory, blockSize);
+
+        ScopedPointer<AudioFormatReader> direct (wav.createReaderFor (tempFile.getFile().createInputStream(), true));
+        ScopedPointer<AudioFormatReader> cached1 (cache.createCachingReader (wav.createReaderFor (tempFile.getFile().createInputStream(), true), tempFile.getFile()));
+        ScopedPointer<AudioFormatReader> cached2 (cache.createCachingReader (wav.createReaderFor (tempFile.getFile().createInputStream(), true), tempFile.getFile()));
+
+        expect (direct != nullptr && cached1 != nullptr && cached2 != nullptr);
+
+        if (direct == nullptr || cached1 == nullptr || cached2 == nullptr)
+            return;
+
+        expectEquals (cached1->lengthInSamples, direct->lengthInSamples);
+
+        {
+            const int readSize = 1700;
+            AudioSampleBuffer directBuffer (numChannels, readSize), cachedBuffer (numChannels, readSize);
+            Random r (4321);
+            bool allSame = true;
+
+            for (int i = 0; i < 300; ++i)
+            {
+                const int64 pos = r.nextInt (numSamples + 5000) - 1000;
+                AudioFormatReader& reader = (i & 1) != 0 ? *cached1 : *cached2;
+
+                direct->read (&directBuffer, 0, readSize, pos, true, true);
+                reader.read (&cachedBuffer, 0, readSize, pos, true, true);
+
+                for (int chan = 0; chan < numChannels; ++chan)
+                    allSame = allSame && memcmp (directBuffer.getSampleData (chan), cachedBuffer.getSampleData (chan),
+                                                 sizeof (float) * (size_t) readSize) == 0;
+            }
+
+            expect (allSame);
+        }
+
+        beginTest ("Memory limit");
+
+        {
+            const DecodedAudioBlockCache::Statistics stats (cache.getStatistics());
+            expect (stats.numBytesUsed <= maxMemory);
+            expect (stats.numBlocks > 0);
+        }
+
+        beginTest ("Readers share blocks");
+
+        {
+            cache.clear();
+            cache.resetStatistics();
+            expectEquals (cache.getStatistics().numBlocks, 0);
+
+            AudioSampleBuffer buffer (numChannels, 5 * blockSize);
+            cached1->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+
+            DecodedAudioBlockCache::Statistics stats (cache.getStatistics());
+            expectEquals (stats.numMisses, (int64) 5);
+            expectEquals (stats.numHits, (int64) 0);
+            expectEquals (stats.numBlocks, 5);
+
+            cached2->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+
+            stats = cache.getStatistics();
+            expectEquals (stats.numMisses, (int64) 5);
+            expectEquals (stats.numHits, (int64) 5);
+            expectEquals (stats.getHitRatio(), 0.5);
+        }
+    }
+};
+
+static DecodedAudioBlockCacheTests decodedAudioBlockCacheTests;
+
+#endif
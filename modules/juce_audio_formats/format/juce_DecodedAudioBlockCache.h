@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_DECODEDAUDIOBLOCKCACHE_JUCEHEADER__
+#define __JUCE_DECODEDAUDIOBLOCKCACHE_JUCEHEADER__
+
+#include "juce_AudioFormatReader.h"
+
+
+//==============================================================================
+/**
+    A memory-limited cache of decoded audio, which can be shared by any number of
+    readers that are reading the same files.
+
+    Readers created with createCachingReader() divide their file into fixed-size
+    blocks of samples. Whenever one of these readers needs a block, it looks for it
+    in the cache first, and only decodes it if no other reader has already done so.
+    This means that when several tracks, thumbnails or analysis jobs are all reading
+    the same compressed file, each region of it only needs to be decoded once.
+
+    When the amount of memory used goes above the limit, the least recently used
+    blocks are discarded.
+
+    The cache is thread-safe: its blocks are divided into a number of separately-locked
+    groups, and a lock is only held while a block is being looked up or added, so that
+    readers on different threads rarely have to wait for each other.
+
+    The easiest way to use one of these is to pass it to
+    AudioFormatManager::setDecodedBlockCache(), after which the manager will create
+    caching readers for any compressed files that it opens. To share the blocks
+    across a whole application, create a single cache and give it to all your managers.
+
+    @see AudioFormatManager
+*/
+class JUCE_API  DecodedAudioBlockCache
+{
+public:
+    //==============================================================================
+    /** Creates a cache.
+
+        @param maxMemoryBytes       the amount of decoded data that the cache may hold before it
+                                    starts discarding the least-recently-used blocks
+        @param blockSizeInSamples   the number of samples in each of the blocks that files are
+                                    divided into
+    */
+    explicit DecodedAudioBlockCache (int64 maxMemoryBytes = 64 * 1024 * 1024,
+                                     int blockSizeInSamples = 16384);
+
+    /** Destructor.
+        Any readers that were created by this cache must be deleted before it is.
+    */
+    ~DecodedAudioBlockCache();
+
+    //==============================================================================
+    /** Creates a reader which reads from another one, keeping the blocks that it
+        decodes in this cache.
+
+        @param sourceReader     the reader that actually decodes the file. This will be
+                                deleted by the reader that is returned
+        @param sourceFile       the file that sourceReader is reading. Readers which are
+                                given the same file will share their cached blocks, as long
+                                as its size and modification time haven't changed
+        @returns a new reader, which the caller must delete, or nullptr if sourceReader was
+                 null. The cache must not be deleted while any of these readers still exist.
+    */
+    AudioFormatReader* createCachingReader (AudioFormatReader* sourceReader, const File& sourceFile);
+
+    //==============================================================================
+    /** Changes the amount of memory that the cache may use.
+        If it's already using more than this, some blocks will be discarded immediately.
+    */
+    void setMaximumMemory (int64 maxMemoryBytes);
+
+    /** Returns the maximum amount of memory that the cache may use. */
+    int64 getMaximumMemory() const noexcept                 { return maxMemory; }
+
+    /** Returns the number of samples in each block. */
+    int getBlockSize() const noexcept                       { return blockSize; }
+
+    /** Discards all the cached blocks. */
+    void clear();
+
+    //==============================================================================
+    /** Describes how well the cache is working. */
+    struct JUCE_API  Statistics
+    {
+        int64 numHits;          /**< The number of times a reader found the block it needed. */
+        int64 numMisses;        /**< The number of blocks that have had to be decoded. */
+        int64 numBytesUsed;     /**< The amount of memory currently used by cached blocks. */
+        int numBlocks;          /**< The number of blocks currently in the cache. */
+
+        /** Returns the proportion of block lookups that were hits, from 0 to 1. */
+        double getHitRatio() const noexcept;
+    };
+
+    /** Returns the current statistics. */
+    Statistics getStatistics() const;
+
+    /** Resets the hit and miss counts to zero. */
+    void resetStatistics() noexcept;
+
+private:
+    //==============================================================================
+    class Block;
+    class Shard;
+    class CachingReader;
+    friend class CachingReader;
+    typedef ReferenceCountedObjectPtr<Block> BlockPtr;
+
+    enum { numShards = 16 };
+
+    OwnedArray<Shard> shards;
+    CriticalSection sourceIdLock;
+    HashMap<String, int> sourceIds;
+    Atomic<int64> numHits, numMisses;
+    int64 maxMemory;
+    const int blockSize;
+
+    int getSourceId (const File&);
+    Shard& getShardFor (int64 key) const noexcept;
+    BlockPtr findBlock (int64 key);
+    void addBlock (int64 key, Block*);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodedAudioBlockCache)
+};
+
+
+#endif   // __JUCE_DECODEDAUDIOBLOCKCACHE_JUCEHEADER__
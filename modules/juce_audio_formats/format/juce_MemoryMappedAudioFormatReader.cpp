@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+MemoryMappedAudioFormatReader::MemoryMappedAudioFormatReader (const File& file_, const AudioFormatReader& details,
+                                                              const int64 sampleDataStart, const int bytesPerFrame_)
+    : AudioFormatReader (nullptr, details.getFormatName()),
+      file (file_),
+      dataChunkStart (sampleDataStart),
+      bytesPerFrame (bytesPerFrame_)
+{
+    sampleRate              = details.sampleRate;
+    bitsPerSample           = details.bitsPerSample;
+    lengthInSamples         = details.lengthInSamples;
+    numChannels             = details.numChannels;
+    usesFloatingPointData   = details.usesFloatingPointData;
+    metadataValues          = details.metadataValues;
+
+    jassert (bytesPerFrame > 0);
+}
+
+MemoryMappedAudioFormatReader::~MemoryMappedAudioFormatReader()
+{
+}
+
+bool MemoryMappedAudioFormatReader::mapEntireFile()
+{
+    if (map == nullptr)
+    {
+        map = new MemoryMappedFile (file, MemoryMappedFile::readOnly);
+
+        if (map->getData() == nullptr || (int64) map->getSize() < dataChunkStart)
+        {
+            map = nullptr;
+            return false;
+        }
+
+        // if the file has been truncated, only the frames that are really there can be used
+        lengthInSamples = jmin (lengthInSamples, ((int64) map->getSize() - dataChunkStart) / bytesPerFrame);
+    }
+
+    return true;
+}
+
+const void* MemoryMappedAudioFormatReader::getSampleData (const int64 sample) const noexcept
+{
+    if (map != nullptr && isPositiveAndBelow (sample, lengthInSamples))
+        return sampleToPointer (sample);
+
+    return nullptr;
+}
+
+void MemoryMappedAudioFormatReader::prefetch (int64 startSample, int64 numSamples) const noexcept
+{
+    if (map != nullptr)
+    {
+        if (startSample < 0)
+        {
+            numSamples += startSample;
+            startSample = 0;
+        }
+
+        numSamples = jmin (numSamples, lengthInSamples - startSample);
+
+        if (numSamples > 0)
+            map->prefetch ((size_t) (dataChunkStart + startSample * bytesPerFrame),
+                           (size_t) (numSamples * bytesPerFrame));
+    }
+}
+
+int MemoryMappedAudioFormatReader::clearSamplesBeyondEnd (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                                          int64 startSampleInFile, int numSamples) const noexcept
+{
+    jassert (destSamples != nullptr);
+
+    const int64 samplesAvailable = map != nullptr ? lengthInSamples - startSampleInFile : 0;
+
+    if (samplesAvailable < numSamples)
+    {
+        for (int i = numDestChannels; --i >= 0;)
+            if (destSamples[i] != nullptr)
+                zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+
+        if (map == nullptr)
+        {
+            jassertfalse; // you need to call mapEntireFile() before reading!
+            return -1;
+        }
+
+        return (int) jmax ((int64) 0, samplesAvailable);
+    }
+
+    return numSamples;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MemoryMappedAudioFormatReaderTests  : public UnitTest
+{
+public:
+    MemoryMappedAudioFormatReaderTests() : UnitTest ("Memory-mapped audio readers") {}
+
+    void runTest()
+    {
+        WavAudioFormat wav;
+        AiffAudioFormat aiff;
+
+        testFormat (wav, 16);
+        testFormat (wav, 24);
+        testFormat (aiff, 24);
+    }
+
+    void testFormat (AudioFormat& format, const int bitDepth)
+    {
+        beginTest (format.getFormatName() + " " + String (bitDepth) + "-bit");
+
+        const int numChannels = 2;
+        const int numSamples = 44100 * 20;
+        const TemporaryFile tempFile (format.getFileExtensions()[0]);
+
+        {
+            AudioSampleBuffer buffer (numChannels, numSamples);
+            Random r (1234);
+
+            for (int chan = 0; chan < numChannels; ++chan)
+                for (int i = 0; i < numSamples; ++i)
+                    *buffer.getSampleData (chan, i) = r.nextFloat() * 2.0f - 1.0f;
+
+            ScopedPointer<AudioFormatWriter> writer (format.createWriterFor (tempFile.getFile().createOutputStream(),
+                                                                             44100.0, numChannels, bitDepth,
+                                                                             StringPairArray(), 0));
+            expect (writer != nullptr);
+
+            if (writer == nullptr)
+                return;
+
+            writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+        }
+
+        ScopedPointer<AudioFormatReader> streamReader (format.createReaderFor (tempFile.getFile().createInputStream(), true));
+        ScopedPointer<MemoryMappedAudioFormatReader> mappedReader (format.createMemoryMappedReader (tempFile.getFile()));
+
+        expect (streamReader != nullptr && mappedReader != nullptr);
+
+        if (streamReader == nullptr || mappedReader == nullptr)
+            return;
+
+        expect (! mappedReader->isMapped());
+        expect (mappedReader->getSampleData (0) == nullptr);
+        expect (mappedReader->mapEntireFile());
+        expectEquals (mappedReader->lengthInSamples, streamReader->lengthInSamples);
+        expectEquals (mappedReader->getBytesPerFrame(), numChannels * bitDepth / 8);
+        expect (mappedReader->getSampleData (0) != nullptr);
+        expect (mappedReader->getSampleData (numSamples) == nullptr);
+
+        mappedReader->prefetch (0, numSamples);
+
+        // both readers should produce exactly the same data, including past the end of the file
+        {
+            const int blockSize = 1000;
+            AudioSampleBuffer streamBuffer (numChannels, blockSize), mappedBuffer (numChannels, blockSize);
+            bool allSame = true;
+
+            for (int64 pos = -500; pos < numSamples + blockSize; pos += blockSize / 3)
+            {
+                streamReader->read (&streamBuffer, 0, blockSize, pos, true, true);
+                mappedReader->read (&mappedBuffer, 0, blockSize, pos, true, true);
+
+                for (int chan = 0; chan < numChannels; ++chan)
+                    allSame = allSame && memcmp (streamBuffer.getSampleData (chan), mappedBuffer.getSampleData (chan),
+                                                 sizeof (float) * (size_t) blockSize) == 0;
+            }
+
+            expect (allSame);
+        }
+
+        logMessage ("Sequential reads: " + compareSpeeds (*streamReader, *mappedReader, false));
+        logMessage ("Random reads: " + compareSpeeds (*streamReader, *mappedReader, true));
+    }
+
+    // (These are only logged, not tested, as timings vary too much between machines)
+    String compareSpeeds (AudioFormatReader& streamReader, AudioFormatReader& mappedReader, const bool randomAccess)
+    {
+        const double streamTime = timeReads (streamReader, randomAccess);
+        const double mappedTime = timeReads (mappedReader, randomAccess);
+
+        return "stream " + String (streamTime * 1000.0, 1) + "ms, mapped " + String (mappedTime * 1000.0, 1)
+                 + "ms (" + String (streamTime / jmax (mappedTime, 1.0e-9), 2) + "x)";
+    }
+
+    static double timeReads (AudioFormatReader& reader, const bool randomAccess)
+    {
+        const int blockSize = 512;
+        const int numBlocks = (int) (reader.lengthInSamples / blockSize);
+        AudioSampleBuffer buffer ((int) reader.numChannels, blockSize);
+        Random r (42);
+
+        const int64 startTime = Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            const int64 pos = randomAccess ? (int64) r.nextInt ((int) reader.lengthInSamples - blockSize)
+                                           : (int64) i * blockSize;
+
+            reader.read (&buffer, 0, blockSize, pos, true, true);
+        }
+
+        return Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTime);
+    }
+};
+
+static MemoryMappedAudioFormatReaderTests memoryMappedAudioFormatReaderTests;
+
+#endif
@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_MEMORYMAPPEDAUDIOFORMATREADER_JUCEHEADER__
+#define __JUCE_MEMORYMAPPEDAUDIOFORMATREADER_JUCEHEADER__
+
+#include "juce_AudioFormatReader.h"
+
+
+//==============================================================================
+/**
+    An AudioFormatReader that reads from a memory-mapped file rather than a stream.
+
+    For uncompressed formats, this avoids the cost of a system call and a copy for
+    every block that's read, because the samples are converted straight from the
+    mapped region of the file. It also lets you get a pointer to the raw sample data
+    of any frame, and ask the OS to start paging in a range of the file ahead of time.
+
+    To get one of these, use AudioFormat::createMemoryMappedReader(), e.g.
+
+    @code
+    WavAudioFormat wavFormat;
+    ScopedPointer<MemoryMappedAudioFormatReader> reader (wavFormat.createMemoryMappedReader (file));
+
+    if (reader != nullptr && reader->mapEntireFile())
+    {
+        reader->prefetch (0, 44100);
+        reader->read (&buffer, 0, 44100, 0, true, true);
+    }
+    @endcode
+
+    The file isn't mapped until you call mapEntireFile(), and no samples can be read
+    before that.
+
+    @see AudioFormat::createMemoryMappedReader, MemoryMappedFile
+*/
+class JUCE_API  MemoryMappedAudioFormatReader  : public AudioFormatReader
+{
+protected:
+    //==============================================================================
+    /** Creates a reader for a file whose sample data is a single block of interleaved frames.
+
+        @param file                 the file to map
+        @param details              a reader that has already parsed the file's header - its
+                                    format, length and metadata are copied into this object
+        @param sampleDataStart      the position in the file of the first sample frame
+        @param bytesPerFrame        the size of a frame (i.e. one sample for every channel)
+    */
+    MemoryMappedAudioFormatReader (const File& file, const AudioFormatReader& details,
+                                   int64 sampleDataStart, int bytesPerFrame);
+
+public:
+    /** Destructor. */
+    ~MemoryMappedAudioFormatReader();
+
+    //==============================================================================
+    /** Returns the file that this reader is using. */
+    const File& getFile() const noexcept                    { return file; }
+
+    /** Maps the whole file into memory.
+        @returns true if it succeeded
+    */
+    bool mapEntireFile();
+
+    /** Returns true if mapEntireFile() has been called successfully. */
+    bool isMapped() const noexcept                          { return map != nullptr; }
+
+    /** Returns the number of bytes used by each sample frame. */
+    int getBytesPerFrame() const noexcept                   { return bytesPerFrame; }
+
+    /** Returns a pointer to the raw data for a given sample frame.
+
+        The data is in the file's own format, with the channels interleaved, so you'll need
+        to know the layout to make use of it - the other members of the reader tell you the
+        bit-depth and number of channels, but not the endianness or whether 8-bit samples
+        are signed, which depends on the format.
+
+        Returns nullptr if the file isn't mapped or the sample is out of range.
+    */
+    const void* getSampleData (int64 sample) const noexcept;
+
+    /** Asks the OS to start reading a range of samples into memory in the background,
+        so that reading them later is less likely to block on disk access.
+        This returns immediately, and does nothing if the file isn't mapped.
+    */
+    void prefetch (int64 startSample, int64 numSamples) const noexcept;
+
+protected:
+    //==============================================================================
+    const File file;
+    const int64 dataChunkStart;
+    const int bytesPerFrame;
+    ScopedPointer<MemoryMappedFile> map;
+
+    /** Returns a pointer to the data for a frame, which must be within the file. */
+    const void* sampleToPointer (int64 sample) const noexcept
+    {
+        return addBytesToPointer (map->getData(), (size_t) (dataChunkStart + sample * bytesPerFrame));
+    }
+
+    /** Helper for subclasses' readSamples() methods: this clears any part of the destination
+        that lies beyond the end of the file, and returns the number of samples that are left
+        to read from the mapped data. If the file hasn't been mapped, it clears everything and
+        returns -1.
+    */
+    int clearSamplesBeyondEnd (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                               int64 startSampleInFile, int numSamples) const noexcept;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryMappedAudioFormatReader)
+};
+
+
+#endif   // __JUCE_MEMORYMAPPEDAUDIOFORMATREADER_JUCEHEADER__
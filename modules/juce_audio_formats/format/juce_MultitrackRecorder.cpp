@@ -0,0 +1,658 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+class MultitrackRecorder::Track
+{
+public:
+    Track (MultitrackRecorder& owner_, AudioFormatWriter* const writer_)
+        : owner (owner_),
+          writer (writer_),
+          numChannels ((int) writer_->getNumChannels()),
+          queue (owner_.numBlocks + 1),
+          queuedBlocks ((size_t) owner_.numBlocks + 1),
+          currentBlocks ((size_t) numChannels),
+          numInCurrentBlock (0)
+    {
+        for (int i = 0; i < numChannels; ++i)
+            currentBlocks[i] = -1;
+    }
+
+    //==============================================================================
+    // called by the audio thread
+    bool write (const float* const* data, int numSamples) noexcept
+    {
+        int offset = 0;
+
+        while (numSamples > 0)
+        {
+            if (currentBlocks[0] < 0 && ! startNewBlock())
+            {
+                numSamplesDropped += numSamples;
+                ++numOverflows;
+                return false;
+            }
+
+            const int numToCopy = jmin (numSamples, owner.samplesPerBlock - numInCurrentBlock);
+
+            for (int i = 0; i < numChannels; ++i)
+                memcpy (owner.getBlockData (currentBlocks[i]) + numInCurrentBlock,
+                        data[i] + offset, sizeof (float) * (size_t) numToCopy);
+
+            numInCurrentBlock += numToCopy;
+            offset += numToCopy;
+            numSamples -= numToCopy;
+
+            if (numInCurrentBlock == owner.samplesPerBlock)
+                queueCurrentBlock();
+        }
+
+        return true;
+    }
+
+    // called when the audio thread has stopped
+    void flushPartialBlock() noexcept
+    {
+        if (currentBlocks[0] >= 0)
+        {
+            if (numInCurrentBlock > 0)
+            {
+                queueCurrentBlock();
+            }
+            else
+            {
+                for (int i = 0; i < numChannels; ++i)
+                {
+                    owner.releaseBlock (currentBlocks[i]);
+                    currentBlocks[i] = -1;
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    // called by the writing thread
+    bool writeQueuedBlocks (AudioSampleBuffer& tempBuffer, const bool writeEverything)
+    {
+        const int numReady = queue.getNumReady() / numChannels;
+
+        if (numReady == 0)
+            return false;
+
+        if (numReady > maxBlocksQueued.get())
+            maxBlocksQueued = numReady;
+
+        if (numReady < owner.blocksPerWrite && ! (writeEverything || isOldestBlockOverdue()))
+            return false;
+
+        const int numToWrite = jmin (numReady, owner.blocksPerWrite);
+        tempBuffer.setSize (numChannels, numToWrite * owner.samplesPerBlock, false, false, true);
+
+        int start1, size1, start2, size2;
+        queue.prepareToRead (numToWrite * numChannels, start1, size1, start2, size2);
+
+        const uint32 now = Time::getMillisecondCounter();
+        int numSamples = 0;
+
+        for (int i = 0; i < size1 + size2; i += numChannels)
+        {
+            const int firstBlock = queuedBlocks [i < size1 ? start1 + i : start2 + i - size1];
+            const int blockLength = owner.blockNumSamples [firstBlock];
+            const int latency = (int) (now - owner.blockTimes [firstBlock]);
+
+            if (latency > maxLatencyMs.get())
+                maxLatencyMs = latency;
+
+            for (int chan = 0; chan < numChannels; ++chan)
+            {
+                const int j = i + chan;
+                const int block = queuedBlocks [j < size1 ? start1 + j : start2 + j - size1];
+
+                tempBuffer.copyFrom (chan, numSamples, owner.getBlockData (block), blockLength);
+                owner.releaseBlock (block);
+            }
+
+            numSamples += blockLength;
+        }
+
+        queue.finishedRead (size1 + size2);
+
+        if (writer != nullptr)
+            writer->writeFromAudioSampleBuffer (tempBuffer, 0, numSamples);
+
+        numSamplesWritten += numSamples;
+        return true;
+    }
+
+    //==============================================================================
+    TrackStatistics getStatistics() const noexcept
+    {
+        TrackStatistics stats;
+        stats.numSamplesWritten = numSamplesWritten.get();
+        stats.numSamplesDropped = numSamplesDropped.get();
+        stats.numOverflows      = numOverflows.get();
+        stats.maxBlocksQueued   = maxBlocksQueued.get();
+        stats.maxLatencyMs      = maxLatencyMs.get();
+        return stats;
+    }
+
+    MultitrackRecorder& owner;
+    ScopedPointer<AudioFormatWriter> writer;
+
+private:
+    const int numChannels;
+
+    AbstractFifo queue;
+    HeapBlock<int> queuedBlocks;
+
+    HeapBlock<int> currentBlocks;
+    int numInCurrentBlock;
+
+    Atomic<int64> numSamplesWritten, numSamplesDropped;
+    Atomic<int> numOverflows, maxBlocksQueued, maxLatencyMs;
+
+    bool isOldestBlockOverdue() const noexcept
+    {
+        if (owner.getNumFreeBlocks() < owner.numBlocks / 4)
+            return true;
+
+        int start1, size1, start2, size2;
+        queue.prepareToRead (1, start1, size1, start2, size2);
+
+        const int oldestBlock = queuedBlocks [size1 > 0 ? start1 : start2];
+        return (int) (Time::getMillisecondCounter() - owner.blockTimes [oldestBlock]) >= owner.maxWriteLatencyMs;
+    }
+
+    bool startNewBlock() noexcept
+    {
+        for (int i = 0; i < numChannels; ++i)
+        {
+            currentBlocks[i] = owner.allocateBlock();
+
+            if (currentBlocks[i] < 0)
+            {
+                while (--i >= 0)
+                {
+                    owner.releaseBlock (currentBlocks[i]);
+                    currentBlocks[i] = -1;
+                }
+
+                return false;
+            }
+        }
+
+        numInCurrentBlock = 0;
+        return true;
+    }
+
+    void queueCurrentBlock() noexcept
+    {
+        owner.blockNumSamples [currentBlocks[0]] = numInCurrentBlock;
+        owner.blockTimes [currentBlocks[0]] = Time::getMillisecondCounter();
+
+        int start1, size1, start2, size2;
+        queue.prepareToWrite (numChannels, start1, size1, start2, size2);
+
+        // there's always room, because the queue is as big as the whole pool
+        jassert (size1 + size2 == numChannels);
+
+        for (int i = 0; i < size1; ++i)  queuedBlocks [start1 + i] = currentBlocks [i];
+        for (int i = 0; i < size2; ++i)  queuedBlocks [start2 + i] = currentBlocks [size1 + i];
+
+        queue.finishedWrite (size1 + size2);
+
+        for (int i = 0; i < numChannels; ++i)
+            currentBlocks[i] = -1;
+
+        numInCurrentBlock = 0;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Track)
+};
+
+//==============================================================================
+namespace MultitrackRecorderHelpers
+{
+    void preallocateFileSpace (const File& file, const int64 numBytes)
+    {
+       #if JUCE_LINUX
+        const int fd = open (file.getFullPathName().toUTF8(), O_WRONLY);
+
+        if (fd >= 0)
+        {
+            fallocate (fd, FALLOC_FL_KEEP_SIZE, 0, (off_t) numBytes);
+            close (fd);
+        }
+       #elif JUCE_MAC
+        const int fd = open (file.getFullPathName().toUTF8(), O_WRONLY);
+
+        if (fd >= 0)
+        {
+            fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t) numBytes, 0 };
+
+            if (fcntl (fd, F_PREALLOCATE, &store) == -1)
+            {
+                store.fst_flags = F_ALLOCATEALL;
+                fcntl (fd, F_PREALLOCATE, &store);
+            }
+
+            close (fd);
+        }
+       #else
+        (void) file;
+        (void) numBytes;
+       #endif
+    }
+}
+
+//==============================================================================
+MultitrackRecorder::MultitrackRecorder (const int samplesPerBlock_, const int numBlocksInPool)
+    : Thread ("Multitrack recorder"),
+      samplesPerBlock (jmax (64, samplesPerBlock_)),
+      numBlocks (jmax (1, numBlocksInPool)),
+      blocksPerWrite (8),
+      maxWriteLatencyMs (500),
+      poolData ((size_t) samplesPerBlock * (size_t) numBlocks, true),
+      nextFreeBlock ((size_t) numBlocks),
+      blockNumSamples ((size_t) numBlocks, true),
+      blockTimes ((size_t) numBlocks, true),
+      writeBuffer (2, samplesPerBlock),
+      recording (false)
+{
+    for (int i = numBlocks; --i >= 0;)
+        releaseBlock (i);
+}
+
+MultitrackRecorder::~MultitrackRecorder()
+{
+    stop();
+}
+
+//==============================================================================
+int MultitrackRecorder::addTrack (AudioFormatWriter* const writer)
+{
+    jassert (! recording); // tracks can't be added while recording!
+
+    if (writer == nullptr || recording)
+    {
+        delete writer;
+        return -1;
+    }
+
+    tracks.add (new Track (*this, writer));
+    return tracks.size() - 1;
+}
+
+int MultitrackRecorder::addTrack (AudioFormat& format, const File& file,
+                                  const double sampleRate, const unsigned int numChannels, const int bitsPerSample,
+                                  const int64 numSamplesToPreallocate)
+{
+    file.deleteFile();
+    ScopedPointer<FileOutputStream> out (file.createOutputStream());
+
+    if (out == nullptr)
+        return -1;
+
+    if (numSamplesToPreallocate > 0)
+        MultitrackRecorderHelpers::preallocateFileSpace (file, numSamplesToPreallocate * numChannels * ((bitsPerSample + 7) / 8));
+
+    AudioFormatWriter* const writer = format.createWriterFor (out, sampleRate, numChannels, bitsPerSample, StringPairArray(), 0);
+
+    if (writer == nullptr)
+    {
+        out = nullptr;
+        file.deleteFile();
+        return -1;
+    }
+
+    out.release();
+    return addTrack (writer);
+}
+
+void MultitrackRecorder::setWriteBatching (const int minBlocksPerWrite, const int maxLatencyMs)
+{
+    jassert (! recording); // this can't be changed while recording!
+
+    if (! recording)
+    {
+        blocksPerWrite = jmax (1, minBlocksPerWrite);
+        maxWriteLatencyMs = jmax (0, maxLatencyMs);
+    }
+}
+
+void MultitrackRecorder::removeAllTracks()
+{
+    jassert (! recording); // tracks can't be removed while recording!
+
+    if (! recording)
+        tracks.clear();
+}
+
+//==============================================================================
+void MultitrackRecorder::start()
+{
+    if (! recording)
+    {
+        // once a recorder has been stopped, its files are closed, so you need to
+        // call removeAllTracks() and add some new ones before starting it again
+        for (int i = tracks.size(); --i >= 0;)
+            jassert (tracks.getUnchecked (i)->writer != nullptr);
+
+        int maxChannels = 1;
+
+        for (int i = tracks.size(); --i >= 0;)
+            if (AudioFormatWriter* const w = tracks.getUnchecked (i)->writer)
+                maxChannels = jmax (maxChannels, (int) w->getNumChannels());
+
+        // allocate the writing thread's buffer here rather than while recording
+        writeBuffer.setSize (maxChannels, blocksPerWrite * samplesPerBlock, false, false, true);
+
+        recording = true;
+        startThread();
+    }
+}
+
+void MultitrackRecorder::stop()
+{
+    if (recording)
+    {
+        recording = false;
+        signalThreadShouldExit();
+        notify();
+        waitForThreadToExit (-1);
+
+        for (int i = 0; i < tracks.size(); ++i)
+            tracks.getUnchecked (i)->flushPartialBlock();
+
+        while (writeQueuedBlocks (true))
+        {}
+
+        for (int i = 0; i < tracks.size(); ++i)
+            tracks.getUnchecked (i)->writer = nullptr;
+    }
+}
+
+//==============================================================================
+bool MultitrackRecorder::write (const int trackIndex, const float* const* data, const int numSamples) noexcept
+{
+    jassert (isPositiveAndBelow (trackIndex, tracks.size()));
+
+    return recording
+            && isPositiveAndBelow (trackIndex, tracks.size())
+            && tracks.getUnchecked (trackIndex)->write (data, numSamples);
+}
+
+MultitrackRecorder::TrackStatistics MultitrackRecorder::getTrackStatistics (const int trackIndex) const
+{
+    if (const Track* const t = tracks [trackIndex])
+        return t->getStatistics();
+
+    TrackStatistics stats;
+    zerostruct (stats);
+    return stats;
+}
+
+//==============================================================================
+int MultitrackRecorder::allocateBlock() noexcept
+{
+    for (;;)
+    {
+        // The free list is a stack whose head holds the index of the top block (plus one),
+        // with a counter in the upper 32 bits that stops a block which is popped and pushed
+        // again between our read and the compare-and-swap from being mistaken for the same head.
+        const int64 head = freeListHead.get();
+        const int block = (int) (head & 0xffffffff) - 1;
+
+        if (block < 0)
+            return -1;
+
+        const uint64 counter = ((uint64) head >> 32) + 1;
+
+        if (freeListHead.compareAndSetBool ((int64) ((counter << 32) | (uint32) (nextFreeBlock[block] + 1)), head))
+        {
+            --numFreeBlocks;
+            return block;
+        }
+    }
+}
+
+void MultitrackRecorder::releaseBlock (const int block) noexcept
+{
+    for (;;)
+    {
+        const int64 head = freeListHead.get();
+        nextFreeBlock[block] = (int) (head & 0xffffffff) - 1;
+
+        const uint64 counter = ((uint64) head >> 32) + 1;
+
+        if (freeListHead.compareAndSetBool ((int64) ((counter << 32) | (uint32) (block + 1)), head))
+        {
+            ++numFreeBlocks;
+            return;
+        }
+    }
+}
+
+//==============================================================================
+void MultitrackRecorder::run()
+{
+    while (! threadShouldExit())
+        if (! writeQueuedBlocks (false))
+            wait (10);
+}
+
+bool MultitrackRecorder::writeQueuedBlocks (const bool writeEverything)
+{
+    bool anythingWritten = false;
+
+    for (int i = 0; i < tracks.size(); ++i)
+        if (tracks.getUnchecked (i)->writeQueuedBlocks (writeBuffer, writeEverything))
+            anythingWritten = true;
+
+    return anythingWritten;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MultitrackRecorderTests  : public UnitTest
+{
+public:
+    MultitrackRecorderTests() : UnitTest ("MultitrackRecorder") {}
+
+    void runTest()
+    {
+        beginTest ("Recorded files match the input");
+
+        {
+            const int numTracks = 6;
+            const int numSamples = 100000;
+            WavAudioFormat wav;
+            OwnedArray<TemporaryFile> files;
+            OwnedArray<AudioSampleBuffer> sources;
+            Random r (1234);
+
+            MultitrackRecorder recorder (1024, 256);
+
+            for (int i = 0; i < numTracks; ++i)
+            {
+                const int numChannels = 1 + i % 2;
+                files.add (new TemporaryFile (".wav"));
+                sources.add (new AudioSampleBuffer (numChannels, numSamples));
+
+                for (int chan = 0; chan < numChannels; ++chan)
+                    for (int j = 0; j < numSamples; ++j)
+                        *sources[i]->getSampleData (chan, j) = (r.nextInt (65536) - 32768) / 32768.0f;
+
+                expectEquals (recorder.addTrack (wav, files[i]->getFile(), 44100.0, (unsigned int) numChannels, 16, numSamples), i);
+            }
+
+            recorder.start();
+
+            for (int pos = 0; pos < numSamples;)
+            {
+                const int numToWrite = jmin (numSamples - pos, 1 + r.nextInt (700));
+
+                for (int i = 0; i < numTracks; ++i)
+                {
+                    HeapBlock<const float*> channels ((size_t) sources[i]->getNumChannels());
+
+                    for (int chan = 0; chan < sources[i]->getNumChannels(); ++chan)
+                        channels[chan] = sources[i]->getSampleData (chan, pos);
+
+                    while (! recorder.write (i, channels, numToWrite))
+                    {
+                        // if the pool is full, the data that didn't fit is lost, so
+                        // this test just makes sure it never fills up
+                        expect (false);
+                        return;
+                    }
+                }
+
+                pos += numToWrite;
+
+                if (recorder.getNumFreeBlocks() < 64)
+                    Thread::sleep (5);
+            }
+
+            recorder.stop();
+            expectEquals (recorder.getNumFreeBlocks(), 256);
+
+            for (int i = 0; i < numTracks; ++i)
+            {
+                const MultitrackRecorder::TrackStatistics stats (recorder.getTrackStatistics (i));
+                expectEquals (stats.numSamplesWritten, (int64) numSamples);
+                expectEquals (stats.numSamplesDropped, (int64) 0);
+
+                ScopedPointer<AudioFormatReader> reader (wav.createReaderFor (files[i]->getFile().createInputStream(), true));
+                expect (reader != nullptr);
+
+                if (reader != nullptr)
+                {
+                    expectEquals (reader->lengthInSamples, (int64) numSamples);
+
+                    AudioSampleBuffer result (sources[i]->getNumChannels(), numSamples);
+                    reader->read (&result, 0, numSamples, 0, true, true);
+
+                    float maxError = 0;
+
+                    for (int chan = 0; chan < result.getNumChannels(); ++chan)
+                        for (int j = 0; j < numSamples; ++j)
+                            maxError = jmax (maxError, std::abs (*result.getSampleData (chan, j) - *sources[i]->getSampleData (chan, j)));
+
+                    expect (maxError <= 1.0f / 32768.0f);
+                }
+            }
+        }
+
+        beginTest ("Overflow");
+
+        {
+            const TemporaryFile file (".wav");
+            WavAudioFormat wav;
+            MultitrackRecorder recorder (256, 4);
+
+            expectEquals (recorder.addTrack (wav, file.getFile(), 44100.0, 2, 16), 0);
+            recorder.start();
+
+            AudioSampleBuffer data (2, 4096);
+            data.clear();
+
+            // only two stereo blocks can fit in the pool
+            expect (! recorder.write (0, data.getArrayOfChannels(), data.getNumSamples()));
+            recorder.stop();
+
+            const MultitrackRecorder::TrackStatistics stats (recorder.getTrackStatistics (0));
+            expectEquals (stats.numOverflows, 1);
+            expectEquals (stats.numSamplesDropped, (int64) (4096 - 512));
+            expectEquals (stats.numSamplesWritten, (int64) 512);
+        }
+
+        beginTest ("Blocks are written in batches");
+
+        {
+            MultitrackRecorder recorder (256, 64);
+            recorder.setWriteBatching (4, 60000);
+
+            CountingWriter* const writer = new CountingWriter();
+            expectEquals (recorder.addTrack (writer), 0);
+            recorder.start();
+
+            AudioSampleBuffer data (1, 100);
+            data.clear();
+
+            for (int i = 0; i < 50; ++i)
+            {
+                expect (recorder.write (0, data.getArrayOfChannels(), data.getNumSamples()));
+                Thread::sleep (1);
+            }
+
+            Thread::sleep (50);
+
+            // 5000 samples fill 19 blocks, so only four batches can have been written
+            expectEquals (writer->callSizes.size(), 4);
+
+            for (int i = 0; i < writer->callSizes.size(); ++i)
+                expectEquals (writer->callSizes[i], 4 * 256);
+
+            recorder.stop();
+
+            // stopping writes the rest at once, including the partly-filled last block
+            expectEquals (writer->callSizes.size(), 5);
+            expectEquals (writer->callSizes.getLast(), 5000 - 16 * 256);
+            expectEquals (recorder.getTrackStatistics (0).numSamplesWritten, (int64) 5000);
+        }
+
+        beginTest ("A file whose writer can't be created is removed");
+
+        {
+            const TemporaryFile file (".wav");
+            WavAudioFormat wav;
+            MultitrackRecorder recorder;
+
+            expectEquals (recorder.addTrack (wav, file.getFile(), 44100.0, 2, 13), -1);
+            expect (! file.getFile().exists());
+            expectEquals (recorder.getNumTracks(), 0);
+        }
+    }
+
+private:
+    struct CountingWriter  : public AudioFormatWriter
+    {
+        CountingWriter()  : AudioFormatWriter (nullptr, "Counting writer", 44100.0, 1, 16) {}
+
+        bool write (const int**, int numSamples)
+        {
+            callSizes.add (numSamples);
+            return true;
+        }
+
+        Array<int> callSizes;
+    };
+};
+
+static MultitrackRecorderTests multitrackRecorderTests;
+
+#endif
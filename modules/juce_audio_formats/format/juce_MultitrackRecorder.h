@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_MULTITRACKRECORDER_JUCEHEADER__
+#define __JUCE_MULTITRACKRECORDER_JUCEHEADER__
+
+#include "juce_AudioFormat.h"
+
+
+//==============================================================================
+/**
+    Records a large number of tracks to disk at the same time.
+
+    Rather than giving each track its own FIFO and background task in the way that
+    AudioFormatWriter::ThreadedWriter does, all the tracks share one pool of buffer
+    blocks that is allocated when the recorder is created. Incoming audio is copied
+    into these blocks, and a single dedicated thread writes them out. It waits until a
+    track has built up several blocks (see setWriteBatching()) and then writes them all
+    in one call, so that every file gets written in large sequential chunks.
+
+    Because the space is shared, a track that's briefly falling behind can use as much
+    of the pool as it needs, and when a file is opened with addTrack(), the disk space
+    that it's expected to need can be reserved in advance so that the file system doesn't
+    have to keep extending it.
+
+    Typical use is:
+    - create the recorder and call addTrack() for each of the files to record
+    - call start()
+    - from the audio callback, call write() for each track
+    - once the audio callback has stopped calling write(), call stop(), which writes
+      any remaining data and closes all the files.
+
+    The write() method never blocks or allocates memory. If the pool runs out of space,
+    the data that can't be stored is discarded, and this is reported by the track's
+    statistics, which also show how far the writing thread has been lagging behind.
+
+    @see AudioFormatWriter::ThreadedWriter
+*/
+class JUCE_API  MultitrackRecorder  : private Thread
+{
+public:
+    //==============================================================================
+    /** Creates a recorder.
+
+        @param samplesPerBlock      the number of samples in each block of the buffer pool.
+                                    Each block holds one channel of one track
+        @param numBlocksInPool      the total number of blocks to allocate. So for example a
+                                    pool of 2048 blocks of 4096 samples would use 32MB, and
+                                    could hold about 2 seconds of data for 64 stereo tracks
+                                    at 48KHz.
+    */
+    MultitrackRecorder (int samplesPerBlock = 4096, int numBlocksInPool = 2048);
+
+    /** Destructor.
+        If the recorder is still running, this will call stop().
+    */
+    ~MultitrackRecorder();
+
+    //==============================================================================
+    /** Adds a track that will write to the given writer.
+
+        The recorder takes ownership of the writer, which will be deleted by stop() or
+        removeAllTracks(). Tracks can only be added while the recorder is stopped.
+
+        @returns the index of the new track, or -1 if the writer was null
+    */
+    int addTrack (AudioFormatWriter* writer);
+
+    /** Creates a file and adds a track that will write to it.
+
+        If the file already exists, it will be replaced.
+
+        @param format                   the format to write
+        @param file                     the file to create
+        @param sampleRate               the sample rate of the recording
+        @param numChannels              the number of channels to record
+        @param bitsPerSample            the bit depth to use
+        @param numSamplesToPreallocate  if this is greater than zero, the recorder will try to
+                                        reserve enough disk space for this many samples of
+                                        uncompressed data when it creates the file. This is
+                                        only supported on Linux and OSX
+        @returns the index of the new track, or -1 if the file couldn't be created
+    */
+    int addTrack (AudioFormat& format, const File& file,
+                  double sampleRate, unsigned int numChannels, int bitsPerSample,
+                  int64 numSamplesToPreallocate = 0);
+
+    /** Returns the number of tracks. */
+    int getNumTracks() const noexcept                   { return tracks.size(); }
+
+    /** Sets how much data the writing thread collects for each track before writing it.
+
+        A track's data is only written once at least minBlocksPerWrite of its blocks are
+        waiting, and they are then all written to the file in one call. To stop a
+        quiet track's data from sitting in memory indefinitely, its blocks are written
+        anyway once the oldest of them has been waiting for more than maxLatencyMs, or
+        when the pool is running short of free blocks.
+
+        The default is 8 blocks and 500ms. This can only be called while the recorder
+        is stopped.
+    */
+    void setWriteBatching (int minBlocksPerWrite, int maxLatencyMs);
+
+    /** Deletes all the tracks, closing any files that are still open.
+        This can only be called while the recorder is stopped.
+    */
+    void removeAllTracks();
+
+    //==============================================================================
+    /** Starts the writing thread.
+        After this, write() can be called to record data.
+    */
+    void start();
+
+    /** Writes any data that's still buffered, and closes all the tracks' files.
+
+        This must not be called until the audio thread has stopped calling write(). The
+        tracks' statistics remain available until removeAllTracks() is called.
+    */
+    void stop();
+
+    /** Returns true if start() has been called, and stop() hasn't. */
+    bool isRecording() const noexcept                   { return recording; }
+
+    //==============================================================================
+    /** Adds some incoming data to a track.
+
+        This never blocks, so it can be called from the audio thread. Each track should
+        only be written from one thread at a time, but different tracks can be written
+        from different threads.
+
+        @param trackIndex   the track to write to
+        @param data         an array with one channel of data for each of the track's
+                            channels. None of these can be null
+        @param numSamples   the number of samples to write
+        @returns false if there wasn't enough space in the pool for all the data (in
+                 which case the remainder is lost), or if the recorder isn't running
+    */
+    bool write (int trackIndex, const float* const* data, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Information about how well a track's recording is going. */
+    struct JUCE_API  TrackStatistics
+    {
+        int64 numSamplesWritten;    /**< The number of samples that have been written to the file. */
+        int64 numSamplesDropped;    /**< The number of samples that were lost because the pool was full. */
+        int numOverflows;           /**< The number of calls to write() that lost some data. */
+        int maxBlocksQueued;        /**< The largest number of this track's blocks that have been waiting to be written. */
+        int maxLatencyMs;           /**< The longest time between a block being filled and its being written. */
+    };
+
+    /** Returns the statistics for one of the tracks.
+        This can be called from any thread.
+    */
+    TrackStatistics getTrackStatistics (int trackIndex) const;
+
+    /** Returns the number of blocks in the pool that are currently unused. */
+    int getNumFreeBlocks() const noexcept               { return numFreeBlocks.get(); }
+
+private:
+    //==============================================================================
+    class Track;
+    friend class ScopedPointer<Track>;
+
+    const int samplesPerBlock, numBlocks;
+    int blocksPerWrite, maxWriteLatencyMs;
+    HeapBlock<float> poolData;
+    HeapBlock<int> nextFreeBlock;
+    Atomic<int64> freeListHead;
+    Atomic<int> numFreeBlocks;
+
+    // these are set by the audio thread for each completed block, and read by the writing thread
+    HeapBlock<int> blockNumSamples;
+    HeapBlock<uint32> blockTimes;
+
+    OwnedArray<Track> tracks;
+    AudioSampleBuffer writeBuffer;
+    volatile bool recording;
+
+    float* getBlockData (int block) const noexcept      { return poolData + (size_t) block * (size_t) samplesPerBlock; }
+    int allocateBlock() noexcept;
+    void releaseBlock (int block) noexcept;
+
+    void run();
+    bool writeQueuedBlocks (bool writeEverything);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultitrackRecorder)
+};
+
+
+#endif   // __JUCE_MULTITRACKRECORDER_JUCEHEADER__
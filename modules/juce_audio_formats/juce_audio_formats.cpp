@@ -85,6 +85,17 @@
  #endif
 #endif
 
+#if JUCE_USE_MP3AUDIOFORMAT && JUCE_MP3_USE_SIMD
+ #if JUCE_USE_SSE2_INTRINSICS
+  #include <emmintrin.h>
+ #elif JUCE_USE_ARM_NEON
+  #include <arm_neon.h>
+ #else
+  #undef JUCE_MP3_USE_SIMD
+  #define JUCE_MP3_USE_SIMD 0
+ #endif
+#endif
+
 //==============================================================================
 namespace juce
 {
@@ -104,6 +115,9 @@ namespace juce
 #include "format/juce_AudioFormatReaderSource.cpp"
 #include "format/juce_AudioFormatWriter.cpp"
 #include "format/juce_AudioSubsectionReader.cpp"
+#include "format/juce_DecodedAudioBlockCache.cpp"
+#include "format/juce_MemoryMappedAudioFormatReader.cpp"
+#include "format/juce_MultitrackRecorder.cpp"
 #include "sampler/juce_Sampler.cpp"
 #include "codecs/juce_AiffAudioFormat.cpp"
 #include "codecs/juce_CoreAudioFormat.cpp"
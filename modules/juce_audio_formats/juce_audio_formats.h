@@ -63,6 +63,18 @@
  #define JUCE_USE_MP3AUDIOFORMAT 0
 #endif
 
+/** Config: JUCE_MP3_USE_SIMD
+    Enables SSE2 or NEON versions of the MP3 decoder's synthesis filterbank and IMDCT,
+    when the compiler targets a CPU that has them. On SSE2 the output is bit-for-bit the
+    same as the plain C++ version; on NEON it may differ by a rounding error.
+    Don't expect too much from it: the rest of the decoder is unchanged, so in an optimised
+    x86-64 build the whole decode only gets about 8% faster, and in a debug build, where the
+    intrinsics aren't inlined, it's actually slower than the plain version.
+*/
+#ifndef JUCE_MP3_USE_SIMD
+ #define JUCE_MP3_USE_SIMD 1
+#endif
+
 /** Config: JUCE_USE_WINDOWS_MEDIA_FORMAT
     Enables the Windows Media SDK codecs.
 */
@@ -98,6 +110,15 @@ namespace juce
 #ifndef __JUCE_AUDIOSUBSECTIONREADER_JUCEHEADER__
  #include "format/juce_AudioSubsectionReader.h"
 #endif
+#ifndef __JUCE_DECODEDAUDIOBLOCKCACHE_JUCEHEADER__
+ #include "format/juce_DecodedAudioBlockCache.h"
+#endif
+#ifndef __JUCE_MEMORYMAPPEDAUDIOFORMATREADER_JUCEHEADER__
+ #include "format/juce_MemoryMappedAudioFormatReader.h"
+#endif
+#ifndef __JUCE_MULTITRACKRECORDER_JUCEHEADER__
+ #include "format/juce_MultitrackRecorder.h"
+#endif
 #include "codecs/juce_AiffAudioFormat.h"
 #include "codecs/juce_CoreAudioFormat.h"
 #include "codecs/juce_FlacAudioFormat.h"
@@ -595,6 +595,8 @@ struct AAXClasses
             {
                 const ScopedLock sl (pluginInstance->getCallbackLock());
 
+                pluginInstance->applyQueuedParameterChanges();
+
                 if (bypass)
                     pluginInstance->processBlockBypassed (buffer, midiBuffer);
                 else
@@ -766,6 +766,8 @@ public:
 
                 const ScopedLock sl (juceFilter->getCallbackLock());
 
+                juceFilter->applyQueuedParameterChanges();
+
                 if (juceFilter->isSuspended())
                 {
                     for (int j = 0; j < numOut; ++j)
@@ -582,6 +582,8 @@ protected:
 
                 AudioSampleBuffer chans (channels, totalChans, numSamples);
 
+                juceFilter->applyQueuedParameterChanges();
+
                 if (mBypassed)
                     juceFilter->processBlockBypassed (chans, midiEvents);
                 else
@@ -565,6 +565,8 @@ public:
                 {
                     AudioSampleBuffer chans (channels, jmax (numIn, numOut), numSamples);
 
+                    filter->applyQueuedParameterChanges();
+
                     if (isBypassed)
                         filter->processBlockBypassed (chans, midiEvents);
                     else
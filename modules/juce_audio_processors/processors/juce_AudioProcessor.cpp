@@ -30,6 +30,132 @@ void AudioProcessor::setTypeOfNextNewPlugin (AudioProcessor::WrapperType type)
     wrapperTypeBeingCreated = type;
 }
 
+//==============================================================================
+class AudioProcessor::ParameterQueue  : private Timer
+{
+public:
+    ParameterQueue (AudioProcessor& owner_)
+        : owner (owner_), fifo (queueSize), changes ((size_t) queueSize),
+          numAsyncParameters (0)
+    {
+    }
+
+    ~ParameterQueue()
+    {
+        stopTimer();
+    }
+
+    //==============================================================================
+    bool push (const ParameterChange& change) noexcept
+    {
+        const SpinLock::ScopedLockType sl (writerLock);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+            return false;
+
+        changes [start1] = change;
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    bool pop (ParameterChange& change) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+            return false;
+
+        change = changes [start1];
+        fifo.finishedRead (1);
+        return true;
+    }
+
+    //==============================================================================
+    void setAsyncNotifications (const bool shouldBeAsync)
+    {
+        if (shouldBeAsync)
+        {
+            // (the storage is never re-allocated, so that the audio thread can't see it move)
+            if (numAsyncParameters == 0)
+            {
+                numAsyncParameters = owner.getNumParameters();
+                pendingValues.calloc ((size_t) numAsyncParameters);
+                pendingFlags.calloc ((size_t) numAsyncParameters);
+            }
+
+            asyncNotifications = 1;
+            startTimer (30);
+        }
+        else
+        {
+            asyncNotifications = 0;
+            stopTimer();
+            sendPendingNotifications();
+        }
+    }
+
+    /** Records a change for the timer to deliver. Returns false if it must be sent synchronously. */
+    bool postNotification (const int parameterIndex, const float newValue) noexcept
+    {
+        if (asyncNotifications.get() == 0 || ! isPositiveAndBelow (parameterIndex, numAsyncParameters))
+            return false;
+
+        const MessageManager* const mm = MessageManager::getInstanceWithoutCreating();
+
+        if (mm != nullptr && mm->isThisTheMessageThread())
+            return false;
+
+        union { float asFloat; int asInt; } v;
+        v.asFloat = newValue;
+
+        pendingValues [parameterIndex] = v.asInt;
+        pendingFlags [parameterIndex] = 1;
+        anyPending = 1;
+        return true;
+    }
+
+    void sendPendingNotifications()
+    {
+        if (! anyPending.compareAndSetBool (0, 1))
+            return;
+
+        for (int i = 0; i < numAsyncParameters; ++i)
+        {
+            if (pendingFlags[i].compareAndSetBool (0, 1))
+            {
+                union { float asFloat; int asInt; } v;
+                v.asInt = pendingValues[i].get();
+
+                owner.sendParamChangeMessageToListeners (i, v.asFloat);
+            }
+        }
+    }
+
+private:
+    enum { queueSize = 256 };
+
+    AudioProcessor& owner;
+    AbstractFifo fifo;
+    HeapBlock<ParameterChange> changes;
+    SpinLock writerLock;
+
+    HeapBlock<Atomic<int> > pendingValues, pendingFlags;
+    int numAsyncParameters;
+    Atomic<int> asyncNotifications, anyPending;
+
+    void timerCallback()
+    {
+        sendPendingNotifications();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterQueue)
+};
+
+//==============================================================================
 AudioProcessor::AudioProcessor()
     : wrapperType (wrapperTypeBeingCreated.get()),
       playHead (nullptr),
@@ -41,6 +167,7 @@ AudioProcessor::AudioProcessor()
       suspended (false),
       nonRealtime (false)
 {
+    parameterQueue = new ParameterQueue (*this);
 }
 
 AudioProcessor::~AudioProcessor()
@@ -116,7 +243,47 @@ void AudioProcessor::setParameterNotifyingHost (const int parameterIndex,
                                                 const float newValue)
 {
     setParameter (parameterIndex, newValue);
-    sendParamChangeMessageToListeners (parameterIndex, newValue);
+
+    if (! parameterQueue->postNotification (parameterIndex, newValue))
+        sendParamChangeMessageToListeners (parameterIndex, newValue);
+}
+
+//==============================================================================
+bool AudioProcessor::queueParameterChange (const int parameterIndex, const float newValue,
+                                           const int sampleOffset, const bool notifyListeners) noexcept
+{
+    ParameterChange change;
+    change.parameterIndex = parameterIndex;
+    change.newValue = newValue;
+    change.sampleOffset = sampleOffset;
+    change.notifyListeners = notifyListeners;
+
+    return parameterQueue->push (change);
+}
+
+bool AudioProcessor::popQueuedParameterChange (ParameterChange& change) noexcept
+{
+    return parameterQueue->pop (change);
+}
+
+void AudioProcessor::applyQueuedParameterChanges()
+{
+    ParameterChange change;
+
+    while (parameterQueue->pop (change))
+    {
+        if (change.notifyListeners)
+            setParameterNotifyingHost (change.parameterIndex, change.newValue);
+        else
+            setParameter (change.parameterIndex, change.newValue);
+    }
+}
+
+void AudioProcessor::setAsyncParameterNotifications (const bool shouldBeAsync)
+{
+    jassert (MessageManager::getInstance()->currentThreadHasLockedMessageManager());
+
+    parameterQueue->setAsyncNotifications (shouldBeAsync);
 }
 
 AudioProcessorListener* AudioProcessor::getListenerLocked (const int index) const noexcept
@@ -296,3 +463,179 @@ void AudioPlayHead::CurrentPositionInfo::resetToDefault()
     timeSigDenominator = 4;
     bpm = 120;
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioProcessorParameterQueueTests  : public UnitTest,
+                                           private AudioProcessorListener
+{
+public:
+    AudioProcessorParameterQueueTests() : UnitTest ("AudioProcessor parameter queue") {}
+
+    class TestProcessor  : public AudioProcessor
+    {
+    public:
+        TestProcessor()                                         { zeromem (values, sizeof (values)); }
+
+        const String getName() const                            { return "Test"; }
+        void prepareToPlay (double, int)                        {}
+        void releaseResources()                                 {}
+        void processBlock (AudioSampleBuffer&, MidiBuffer&)     {}
+        const String getInputChannelName (int) const            { return String::empty; }
+        const String getOutputChannelName (int) const           { return String::empty; }
+        bool isInputChannelStereoPair (int) const               { return false; }
+        bool isOutputChannelStereoPair (int) const              { return false; }
+        bool silenceInProducesSilenceOut() const                { return true; }
+        bool acceptsMidi() const                                { return false; }
+        bool producesMidi() const                               { return false; }
+        AudioProcessorEditor* createEditor()                    { return nullptr; }
+        bool hasEditor() const                                  { return false; }
+        int getNumParameters()                                  { return numElementsInArray (values); }
+        const String getParameterName (int)                     { return String::empty; }
+        float getParameter (int index)                          { return values [index]; }
+        const String getParameterText (int)                     { return String::empty; }
+        void setParameter (int index, float newValue)           { values [index] = newValue; }
+        int getNumPrograms()                                    { return 1; }
+        int getCurrentProgram()                                 { return 0; }
+        void setCurrentProgram (int)                            {}
+        const String getProgramName (int)                       { return String::empty; }
+        void changeProgramName (int, const String&)             {}
+        void getStateInformation (juce::MemoryBlock&)           {}
+        void setStateInformation (const void*, int)             {}
+
+        float values [4];
+    };
+
+    class ProducerThread  : public Thread
+    {
+    public:
+        ProducerThread (TestProcessor& processor_, const int numChanges_, const bool notify_)
+            : Thread ("parameter producer"), processor (processor_), numChanges (numChanges_), notify (notify_)
+        {
+        }
+
+        void run()
+        {
+            for (int i = 0; i < numChanges && ! threadShouldExit();)
+            {
+                const float value = i / (float) numChanges;
+
+                if (notify)
+                {
+                    processor.setParameterNotifyingHost (i & 3, value);
+                    ++i;
+                }
+                else if (processor.queueParameterChange (i & 3, value, i))
+                {
+                    ++i;
+                }
+                else
+                {
+                    Thread::yield();
+                }
+            }
+        }
+
+    private:
+        TestProcessor& processor;
+        const int numChanges;
+        const bool notify;
+    };
+
+    void runTest()
+    {
+        beginTest ("Ordering between threads");
+
+        TestProcessor processor;
+        const int numChanges = 20000;
+
+        {
+            ProducerThread producer (processor, numChanges, false);
+            producer.startThread();
+
+            int numReceived = 0;
+            bool allInOrder = true;
+            AudioProcessor::ParameterChange change;
+
+            while (numReceived < numChanges)
+            {
+                if (processor.popQueuedParameterChange (change))
+                {
+                    allInOrder = allInOrder
+                                  && change.sampleOffset == numReceived
+                                  && change.parameterIndex == (numReceived & 3)
+                                  && change.newValue == numReceived / (float) numChanges;
+                    ++numReceived;
+                }
+                else
+                {
+                    Thread::yield();
+                }
+            }
+
+            expect (allInOrder);
+            expect (! processor.popQueuedParameterChange (change));
+            producer.stopThread (5000);
+        }
+
+        beginTest ("Coalesced notifications");
+
+        processor.addListener (this);
+        zeromem (numCallbacks, sizeof (numCallbacks));
+        allCallbacksOnMessageThread = true;
+
+        {
+            // (the tests may not be running on the message thread)
+            const MessageManagerLock mml;
+            processor.setAsyncParameterNotifications (true);
+        }
+
+        {
+            ProducerThread producer (processor, numChanges, true);
+            producer.startThread();
+            producer.waitForThreadToExit (10000);
+        }
+
+        {
+            // (turning the async mode off delivers anything that's still pending)
+            const MessageManagerLock mml;
+            processor.setAsyncParameterNotifications (false);
+        }
+
+        processor.removeListener (this);
+
+        // If the message loop is running, the timer may deliver some values while the producer's
+        // still going, so there can be anything from one callback per parameter to one per change..
+        for (int i = 0; i < 4; ++i)
+        {
+            expect (numCallbacks[i] >= 1 && numCallbacks[i] <= numChanges / 4);
+            expectEquals (lastValues[i], (numChanges - 4 + i) / (float) numChanges);
+        }
+
+        expect (allCallbacksOnMessageThread);
+    }
+
+private:
+    int numCallbacks [4];
+    float lastValues [4];
+    bool allCallbacksOnMessageThread;
+
+    void audioProcessorParameterChanged (AudioProcessor*, int parameterIndex, float newValue)
+    {
+        allCallbacksOnMessageThread = allCallbacksOnMessageThread
+                                        && MessageManager::getInstance()->currentThreadHasLockedMessageManager();
+
+        if (isPositiveAndBelow (parameterIndex, 4))
+        {
+            ++numCallbacks [parameterIndex];
+            lastValues [parameterIndex] = newValue;
+        }
+    }
+
+    void audioProcessorChanged (AudioProcessor*) {}
+};
+
+static AudioProcessorParameterQueueTests audioProcessorParameterQueueTests;
+
+#endif
@@ -467,6 +467,63 @@ public:
     */
     void endParameterChangeGesture (int parameterIndex);
 
+    //==============================================================================
+    /** Describes a parameter change that's waiting in the processor's queue.
+        @see queueParameterChange, popQueuedParameterChange
+    */
+    struct ParameterChange
+    {
+        int parameterIndex;     /**< The index of the parameter to change. */
+        float newValue;         /**< The value to give it, between 0 and 1.0. */
+        int sampleOffset;       /**< The position in the next block at which the change should happen. */
+        bool notifyListeners;   /**< If true, the listeners are told about it, as with setParameterNotifyingHost(). */
+    };
+
+    /** Queues a parameter change, to be applied on the audio thread.
+
+        Calling setParameter() from the message thread or a host thread while the processor
+        is running means that it can change half-way through a processBlock() call. Instead,
+        this puts the change into a lock-free queue which is emptied at the start of the next
+        block, when the host calls applyQueuedParameterChanges(). The AudioProcessorPlayer,
+        AudioProcessorGraph and the plugin wrappers all do this.
+
+        This can be called from any thread, and never allocates or waits for the audio thread.
+        Calls made by several threads at once are serialised by a SpinLock, though, so one of
+        them may have to spin briefly while another finishes adding its change. It returns
+        false if the queue was full, in which case the change is discarded.
+    */
+    bool queueParameterChange (int parameterIndex, float newValue,
+                               int sampleOffset = 0, bool notifyListeners = false) noexcept;
+
+    /** Removes the oldest change from the queue.
+        This should only be called on the audio thread. It returns false if the queue is empty.
+        @see applyQueuedParameterChanges
+    */
+    bool popQueuedParameterChange (ParameterChange& change) noexcept;
+
+    /** Applies any changes that were made with queueParameterChange().
+
+        This is called by the host on the audio thread, just before processBlock(). The
+        default implementation calls setParameter() (or setParameterNotifyingHost() if
+        requested) for each change, ignoring their sample offsets. If you want your
+        changes to be sample-accurate, you can override this and use
+        popQueuedParameterChange() to fetch them instead.
+    */
+    virtual void applyQueuedParameterChanges();
+
+    /** Makes parameter change notifications from other threads asynchronous.
+
+        When this is enabled, a call to setParameterNotifyingHost() on any thread apart from
+        the message thread doesn't call the listeners itself - it just records the new
+        value, and the listeners are called shortly afterwards on the message thread. If a
+        parameter changes several times in between, only the last value is sent. This
+        means that the audio thread never needs to lock the list of listeners, or wait
+        for a listener to finish.
+
+        This must be called on the message thread.
+    */
+    void setAsyncParameterNotifications (bool shouldBeAsync);
+
     /** The filter can call this when something (apart from a parameter value) has changed.
 
         It sends a hint to the host that something like the program, number of parameters,
@@ -632,6 +689,11 @@ private:
     BigInteger changingParams;
    #endif
 
+    class ParameterQueue;
+    friend class ParameterQueue;
+    friend class ScopedPointer<ParameterQueue>;
+    ScopedPointer<ParameterQueue> parameterQueue;
+
     AudioProcessorListener* getListenerLocked (int) const noexcept;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessor)
@@ -163,35 +163,93 @@ private:
 };
 
 //==============================================================================
-class DelayChannelOp : public AudioGraphRenderingOp
+/** A circular buffer that delays one output channel of a node.
+
+    The buffer holds the delay time plus one block, so a whole block can be written
+    into it before the delayed block is read back out, without the two overlapping.
+    Once the block has been written, any number of ops can read the delayed version.
+*/
+class DelayLine  : public ReferenceCountedObject
 {
 public:
-    DelayChannelOp (const int channel_, const int numSamplesDelay_)
-        : channel (channel_),
-          bufferSize (numSamplesDelay_ + 1),
-          readIndex (0), writeIndex (numSamplesDelay_)
+    DelayLine (const uint32 sourceNodeId_, const int sourceChannel_,
+               const int numSamplesDelay_, const int maxBlockSize)
+        : sourceNodeId (sourceNodeId_),
+          sourceChannel (sourceChannel_),
+          numSamplesDelay (numSamplesDelay_),
+          maxNumSamples (jmax (1, maxBlockSize)),
+          bufferSize (numSamplesDelay_ + maxNumSamples),
+          writePosition (0), readPosition (0)
     {
         buffer.calloc ((size_t) bufferSize);
     }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>&, const int numSamples)
+    typedef ReferenceCountedObjectPtr<DelayLine> Ptr;
+
+    bool matches (const uint32 nodeId, const int channel, const int delay) const noexcept
+    {
+        return sourceNodeId == nodeId && sourceChannel == channel && numSamplesDelay == delay;
+    }
+
+    size_t getSizeInBytes() const noexcept      { return sizeof (float) * (size_t) bufferSize; }
+
+    void write (const float* const source, const int numSamples) noexcept
     {
-        float* data = sharedBufferChans.getSampleData (channel, 0);
+        jassert (numSamples <= maxNumSamples);
 
-        for (int i = numSamples; --i >= 0;)
-        {
-            buffer [writeIndex] = *data;
-            *data++ = buffer [readIndex];
+        readPosition = writePosition - numSamplesDelay;
+        if (readPosition < 0)
+            readPosition += bufferSize;
 
-            if (++readIndex  >= bufferSize) readIndex = 0;
-            if (++writeIndex >= bufferSize) writeIndex = 0;
-        }
+        const int num1 = jmin (numSamples, bufferSize - writePosition);
+        memcpy (buffer + writePosition, source, sizeof (float) * (size_t) num1);
+        memcpy (buffer, source + num1, sizeof (float) * (size_t) (numSamples - num1));
+
+        writePosition += numSamples;
+        if (writePosition >= bufferSize)
+            writePosition -= bufferSize;
+    }
+
+    void read (float* const dest, const int numSamples) const noexcept
+    {
+        const int num1 = jmin (numSamples, bufferSize - readPosition);
+        memcpy (dest, buffer + readPosition, sizeof (float) * (size_t) num1);
+        memcpy (dest + num1, buffer, sizeof (float) * (size_t) (numSamples - num1));
     }
 
 private:
     HeapBlock<float> buffer;
-    const int channel, bufferSize;
-    int readIndex, writeIndex;
+    const uint32 sourceNodeId;
+    const int sourceChannel, numSamplesDelay, maxNumSamples, bufferSize;
+    int writePosition, readPosition;
+
+    JUCE_DECLARE_NON_COPYABLE (DelayLine)
+};
+
+//==============================================================================
+class DelayChannelOp : public AudioGraphRenderingOp
+{
+public:
+    DelayChannelOp (const int channel_, const DelayLine::Ptr& delayLine_, const bool writesToDelayLine_)
+        : channel (channel_),
+          delayLine (delayLine_),
+          writesToDelayLine (writesToDelayLine_)
+    {}
+
+    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>&, const int numSamples)
+    {
+        float* const data = sharedBufferChans.getSampleData (channel, 0);
+
+        if (writesToDelayLine)
+            delayLine->write (data, numSamples);
+
+        delayLine->read (data, numSamples);
+    }
+
+private:
+    const int channel;
+    const DelayLine::Ptr delayLine;
+    const bool writesToDelayLine;
 
     JUCE_DECLARE_NON_COPYABLE (DelayChannelOp)
 };
@@ -224,6 +282,7 @@ public:
 
         AudioSampleBuffer buffer (channels, totalChans, numSamples);
 
+        processor->applyQueuedParameterChanges();
         processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
     }
 
@@ -273,6 +332,16 @@ public:
     int getNumBuffersNeeded() const         { return nodeIds.size(); }
     int getNumMidiBuffersNeeded() const     { return midiNodeIds.size(); }
 
+    size_t getDelayLineMemoryNeeded() const
+    {
+        size_t total = 0;
+
+        for (int i = delayLines.size(); --i >= 0;)
+            total += delayLines.getUnchecked(i)->getSizeInBytes();
+
+        return total;
+    }
+
 private:
     //==============================================================================
     AudioProcessorGraph& graph;
@@ -280,13 +349,14 @@ private:
     Array <int> channels;
     Array <uint32> nodeIds, midiNodeIds;
 
-    enum { freeNodeID = 0xffffffff, zeroNodeID = 0xfffffffe };
+    enum { freeNodeID = 0xffffffff, zeroNodeID = 0xfffffffe, anonymousNodeID = 0xfffffffd };
 
     static bool isNodeBusy (uint32 nodeID) noexcept { return nodeID != freeNodeID && nodeID != zeroNodeID; }
 
     Array <uint32> nodeDelayIDs;
     Array <int> nodeDelays;
     int totalLatency;
+    ReferenceCountedArray <DelayLine> delayLines;
 
     int getNodeDelay (const uint32 nodeID) const          { return nodeDelays [nodeDelayIDs.indexOf (nodeID)]; }
 
@@ -320,6 +390,29 @@ private:
         return maxLatency;
     }
 
+    // Delays a buffer that holds the given output channel of a node. Only the first op
+    // that delays a particular channel by a particular amount feeds the delay line - any
+    // others just read back the delayed block that it wrote. Because of this, the buffer must
+    // really contain that node's output (or a copy of it), and never a stand-in like silence.
+    void addDelayOp (Array<void*>& renderingOps, const int bufIndex,
+                     const uint32 sourceNodeId, const int sourceChannel, const int numSamplesDelay)
+    {
+        for (int i = delayLines.size(); --i >= 0;)
+        {
+            DelayLine* const line = delayLines.getUnchecked(i);
+
+            if (line->matches (sourceNodeId, sourceChannel, numSamplesDelay))
+            {
+                renderingOps.add (new DelayChannelOp (bufIndex, line, false));
+                return;
+            }
+        }
+
+        DelayLine* const line = new DelayLine (sourceNodeId, sourceChannel, numSamplesDelay, graph.getBlockSize());
+        delayLines.add (line);
+        renderingOps.add (new DelayChannelOp (bufIndex, line, true));
+    }
+
     //==============================================================================
     void createRenderingOpsForNode (AudioProcessorGraph::Node* const node,
                                     Array<void*>& renderingOps,
@@ -375,8 +468,9 @@ private:
                 const int srcChan = sourceOutputChans.getUnchecked(0);
 
                 bufIndex = getBufferContaining (srcNode, srcChan);
+                const bool isFeedback = bufIndex < 0;
 
-                if (bufIndex < 0)
+                if (isFeedback)
                 {
                     // if not found, this is probably a feedback loop
                     bufIndex = getReadOnlyEmptyBuffer();
@@ -399,8 +493,10 @@ private:
 
                 const int nodeDelay = getNodeDelay (srcNode);
 
-                if (nodeDelay < maxLatency)
-                    renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay));
+                // (a feedback input is just silence, so there's nothing to delay, and writing it
+                // into a delay line would corrupt any other ops that share the same line)
+                if (nodeDelay < maxLatency && ! isFeedback)
+                    addDelayOp (renderingOps, bufIndex, srcNode, srcChan, maxLatency - nodeDelay);
             }
             else
             {
@@ -426,7 +522,8 @@ private:
 
                         const int nodeDelay = getNodeDelay (sourceNodes.getUnchecked (i));
                         if (nodeDelay < maxLatency)
-                            renderingOps.add (new DelayChannelOp (sourceBufIndex, maxLatency - nodeDelay));
+                            addDelayOp (renderingOps, sourceBufIndex, sourceNodes.getUnchecked (i),
+                                        sourceOutputChans.getUnchecked (i), maxLatency - nodeDelay);
 
                         break;
                     }
@@ -438,6 +535,9 @@ private:
                     bufIndex = getFreeBuffer (false);
                     jassert (bufIndex != 0);
 
+                    // (this stops the buffer being handed out again as scratch space for delaying the other inputs)
+                    markBufferAsContaining (bufIndex, anonymousNodeID, 0);
+
                     const int srcIndex = getBufferContaining (sourceNodes.getUnchecked (0),
                                                               sourceOutputChans.getUnchecked (0));
                     if (srcIndex < 0)
@@ -453,8 +553,9 @@ private:
                     reusableInputIndex = 0;
                     const int nodeDelay = getNodeDelay (sourceNodes.getFirst());
 
-                    if (nodeDelay < maxLatency)
-                        renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay));
+                    if (nodeDelay < maxLatency && srcIndex >= 0)
+                        addDelayOp (renderingOps, bufIndex, sourceNodes.getFirst(),
+                                    sourceOutputChans.getFirst(), maxLatency - nodeDelay);
                 }
 
                 for (int j = 0; j < sourceNodes.size(); ++j)
@@ -473,13 +574,15 @@ private:
                                                            sourceNodes.getUnchecked(j),
                                                            sourceOutputChans.getUnchecked(j)))
                                 {
-                                    renderingOps.add (new DelayChannelOp (srcIndex, maxLatency - nodeDelay));
+                                    addDelayOp (renderingOps, srcIndex, sourceNodes.getUnchecked (j),
+                                                sourceOutputChans.getUnchecked (j), maxLatency - nodeDelay);
                                 }
                                 else // buffer is reused elsewhere, can't be delayed
                                 {
                                     const int bufferToDelay = getFreeBuffer (false);
                                     renderingOps.add (new CopyChannelOp (srcIndex, bufferToDelay));
-                                    renderingOps.add (new DelayChannelOp (bufferToDelay, maxLatency - nodeDelay));
+                                    addDelayOp (renderingOps, bufferToDelay, sourceNodes.getUnchecked (j),
+                                                sourceOutputChans.getUnchecked (j), maxLatency - nodeDelay);
                                     srcIndex = bufferToDelay;
                                 }
                             }
@@ -925,6 +1028,7 @@ void AudioProcessorGraph::Node::setParentGraph (AudioProcessorGraph* const graph
 AudioProcessorGraph::AudioProcessorGraph()
     : lastNodeId (0),
       renderingBuffers (1, 1),
+      latencyCompensationMemory (0),
       currentAudioOutputBuffer (1, 1)
 {
 }
@@ -1171,6 +1275,7 @@ void AudioProcessorGraph::clearRenderingSequence()
     {
         const ScopedLock sl (getCallbackLock());
         renderingOps.swapWithArray (oldOps);
+        latencyCompensationMemory = 0;
     }
 
     deleteRenderOpArray (oldOps);
@@ -1201,6 +1306,7 @@ void AudioProcessorGraph::buildRenderingSequence()
     Array<void*> newRenderingOps;
     int numRenderingBuffersNeeded = 2;
     int numMidiBuffersNeeded = 1;
+    size_t delayLineMemoryNeeded = 0;
 
     {
         MessageManagerLock mml;
@@ -1229,6 +1335,7 @@ void AudioProcessorGraph::buildRenderingSequence()
 
         numRenderingBuffersNeeded = calculator.getNumBuffersNeeded();
         numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
+        delayLineMemoryNeeded = calculator.getDelayLineMemoryNeeded();
     }
 
     {
@@ -1245,6 +1352,7 @@ void AudioProcessorGraph::buildRenderingSequence()
             midiBuffers.add (new MidiBuffer());
 
         renderingOps.swapWithArray (newRenderingOps);
+        latencyCompensationMemory = delayLineMemoryNeeded;
     }
 
     // delete the old ones..
@@ -1515,3 +1623,166 @@ void AudioProcessorGraph::AudioGraphIOProcessor::setParentGraph (AudioProcessorG
         updateHostDisplay();
     }
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioProcessorGraphTests  : public UnitTest
+{
+public:
+    AudioProcessorGraphTests() : UnitTest ("AudioProcessorGraph") {}
+
+    /** A mono processor that really delays its input by the latency that it reports, and applies a gain. */
+    class DelayProcessor  : public AudioProcessor
+    {
+    public:
+        DelayProcessor (const int delay_, const float gain_) : delay (delay_), gain (gain_), position (0)
+        {
+            setPlayConfigDetails (1, 1, 44100.0, 64);
+            setLatencySamples (delay);
+            line.calloc ((size_t) delay + 1);
+        }
+
+        const String getName() const                            { return "Delay"; }
+        void prepareToPlay (double, int)                        {}
+        void releaseResources()                                 {}
+
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)
+        {
+            float* const data = buffer.getSampleData (0);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                line [position] = data[i];
+                position = (position + 1) % (delay + 1);
+                data[i] = line [position] * gain;
+            }
+        }
+
+        const String getInputChannelName (int) const            { return String::empty; }
+        const String getOutputChannelName (int) const           { return String::empty; }
+        bool isInputChannelStereoPair (int) const               { return false; }
+        bool isOutputChannelStereoPair (int) const              { return false; }
+        bool silenceInProducesSilenceOut() const                { return true; }
+        bool acceptsMidi() const                                { return false; }
+        bool producesMidi() const                               { return false; }
+        AudioProcessorEditor* createEditor()                    { return nullptr; }
+        bool hasEditor() const                                  { return false; }
+        int getNumParameters()                                  { return 0; }
+        const String getParameterName (int)                     { return String::empty; }
+        float getParameter (int)                                { return 0; }
+        const String getParameterText (int)                     { return String::empty; }
+        void setParameter (int, float)                          {}
+        int getNumPrograms()                                    { return 1; }
+        int getCurrentProgram()                                 { return 0; }
+        void setCurrentProgram (int)                            {}
+        const String getProgramName (int)                       { return String::empty; }
+        void changeProgramName (int, const String&)             {}
+        void getStateInformation (juce::MemoryBlock&)           {}
+        void setStateInformation (const void*, int)             {}
+
+    private:
+        const int delay;
+        const float gain;
+        HeapBlock<float> line;
+        int position;
+    };
+
+    enum { blockSize = 64 };
+
+    void runTest()
+    {
+        beginTest ("Parallel paths with different latencies");
+
+        {
+            AudioProcessorGraph graph;
+            const uint32 in = createIONodes (graph);
+
+            addNodeBetween (graph, in, outputNodeId, 10);
+            addNodeBetween (graph, in, outputNodeId, 30);
+            graph.prepareToPlay (44100.0, blockSize);
+
+            expectEquals (graph.getLatencySamples(), 30);
+            expectImpulseAt (graph, 30, 2.0f);
+        }
+
+        beginTest ("Shared delay lines");
+
+        {
+            AudioProcessorGraph graph;
+            const uint32 in = createIONodes (graph);
+
+            // the output of 'fast' has to be delayed by 20 samples to line up with 'slow'
+            // before it reaches each of the two mixers, and both should share one delay line.
+            // The paths have different gains, so that losing or doubling either one will show up.
+            const uint32 fast = addNodeBetween (graph, in, 0, 0);
+            const uint32 slow = addNodeBetween (graph, in, 0, 20, 3.0f);
+
+            for (int i = 0; i < 2; ++i)
+            {
+                const uint32 mixer = addNodeBetween (graph, fast, outputNodeId, 0);
+                graph.addConnection (slow, 0, mixer, 0);
+            }
+
+            graph.prepareToPlay (44100.0, blockSize);
+
+            expectEquals ((int) graph.getLatencyCompensationMemorySize(), (int) ((20 + blockSize) * sizeof (float)));
+            expectImpulseAt (graph, 20, 8.0f);
+        }
+    }
+
+private:
+    uint32 outputNodeId;
+
+    uint32 createIONodes (AudioProcessorGraph& graph)
+    {
+        graph.setPlayConfigDetails (1, 1, 44100.0, blockSize);
+
+        outputNodeId = graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode))->nodeId;
+        return graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioInputNode))->nodeId;
+    }
+
+    // adds a DelayProcessor, fed from the source and feeding the destination (if it's not 0)
+    static uint32 addNodeBetween (AudioProcessorGraph& graph, const uint32 source, const uint32 dest,
+                                  const int delay, const float gain = 1.0f)
+    {
+        const uint32 nodeId = graph.addNode (new DelayProcessor (delay, gain))->nodeId;
+        graph.addConnection (source, 0, nodeId, 0);
+
+        if (dest != 0)
+            graph.addConnection (nodeId, 0, dest, 0);
+
+        return nodeId;
+    }
+
+    // sends an impulse through the graph, and checks that the output is silent apart
+    // from one sample, i.e. that all the paths arrived at the same time
+    void expectImpulseAt (AudioProcessorGraph& graph, const int expectedPosition, const float expectedLevel)
+    {
+        AudioSampleBuffer buffer (1, blockSize);
+        MidiBuffer midi;
+        int numWrong = 0;
+
+        for (int block = 0; block < 3; ++block)
+        {
+            buffer.clear();
+
+            if (block == 0)
+                buffer.getSampleData (0)[0] = 1.0f;
+
+            graph.processBlock (buffer, midi);
+
+            const float* const data = buffer.getSampleData (0);
+
+            for (int i = 0; i < blockSize; ++i)
+                if (data[i] != (block * blockSize + i == expectedPosition ? expectedLevel : 0.0f))
+                    ++numWrong;
+        }
+
+        expectEquals (numWrong, 0);
+    }
+};
+
+static AudioProcessorGraphTests audioProcessorGraphTests;
+
+#endif
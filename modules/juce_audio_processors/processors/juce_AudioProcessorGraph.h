@@ -248,6 +248,16 @@ public:
     */
     bool removeIllegalConnections();
 
+    //==============================================================================
+    /** Returns the number of bytes that are currently allocated for the delay lines
+        which compensate for the latencies of the graph's nodes.
+
+        Each channel that needs to be delayed to line up with the other inputs of its
+        destination gets a delay line, but destinations which need the same output
+        channel delayed by the same amount will share one.
+    */
+    size_t getLatencyCompensationMemorySize() const noexcept            { return latencyCompensationMemory; }
+
     //==============================================================================
     /** A special number that represents the midi channel of a node.
 
@@ -397,6 +407,7 @@ private:
     AudioSampleBuffer renderingBuffers;
     OwnedArray <MidiBuffer> midiBuffers;
     Array<void*> renderingOps;
+    size_t latencyCompensationMemory;
 
     friend class AudioGraphIOProcessor;
     AudioSampleBuffer* currentAudioInputBuffer;
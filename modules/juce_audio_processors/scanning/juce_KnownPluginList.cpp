@@ -23,13 +23,82 @@
   ==============================================================================
 */
 
+//==============================================================================
+/*  Hash tables for looking up the types by identifier string and by file. This is
+    built lazily, updated as types are added, and thrown away by anything else that
+    changes the list.
+*/
+class KnownPluginList::TypeIndex
+{
+public:
+    TypeIndex (const OwnedArray<PluginDescription>& types)
+        : byIdentifier (jmax (101, types.size() * 2)),
+          byFile (jmax (101, types.size() * 2))
+    {
+        for (int i = 0; i < types.size(); ++i)
+            add (types.getUnchecked(i));
+    }
+
+    void add (PluginDescription* const desc)
+    {
+        byIdentifier.set (desc->createIdentifierString(), desc);
+
+        Array<PluginDescription*>* list = getTypesForFile (desc->fileOrIdentifier);
+
+        if (list == nullptr)
+        {
+            byFile.set (desc->fileOrIdentifier, typesForFile.size());
+            list = new Array<PluginDescription*>();
+            typesForFile.add (list);
+        }
+
+        list->add (desc);
+    }
+
+    void identifierChanged (const String& oldIdentifierString, PluginDescription* const desc)
+    {
+        byIdentifier.remove (oldIdentifierString);
+        byIdentifier.set (desc->createIdentifierString(), desc);
+    }
+
+    PluginDescription* getTypeForIdentifier (const String& identifierString) const
+    {
+        return byIdentifier [identifierString];
+    }
+
+    Array<PluginDescription*>* getTypesForFile (const String& fileOrIdentifier) const
+    {
+        return byFile.contains (fileOrIdentifier) ? typesForFile [byFile [fileOrIdentifier]]
+                                                  : nullptr;
+    }
+
+private:
+    HashMap<String, PluginDescription*> byIdentifier;
+    HashMap<String, int> byFile;
+    OwnedArray<Array<PluginDescription*> > typesForFile;
+
+    JUCE_DECLARE_NON_COPYABLE (TypeIndex)
+};
+
+//==============================================================================
 KnownPluginList::KnownPluginList()  {}
 KnownPluginList::~KnownPluginList() {}
 
+KnownPluginList::TypeIndex& KnownPluginList::getIndex() const
+{
+    if (index == nullptr)
+        index = new TypeIndex (types);
+
+    return *index;
+}
+
 void KnownPluginList::clear()
 {
+    fileSizes.clear();
+
     if (types.size() > 0)
     {
+        index = nullptr;
         types.clear();
         sendChangeMessage();
     }
@@ -37,56 +106,97 @@ void KnownPluginList::clear()
 
 PluginDescription* KnownPluginList::getTypeForFile (const String& fileOrIdentifier) const
 {
-    for (int i = 0; i < types.size(); ++i)
-        if (types.getUnchecked(i)->fileOrIdentifier == fileOrIdentifier)
-            return types.getUnchecked(i);
+    if (const Array<PluginDescription*>* const typesForFile = getIndex().getTypesForFile (fileOrIdentifier))
+        return typesForFile->getFirst();
 
     return nullptr;
 }
 
 PluginDescription* KnownPluginList::getTypeForIdentifierString (const String& identifierString) const
 {
-    for (int i = 0; i < types.size(); ++i)
-        if (types.getUnchecked(i)->createIdentifierString() == identifierString)
-            return types.getUnchecked(i);
+    PluginDescription* desc = getIndex().getTypeForIdentifier (identifierString);
 
-    return nullptr;
+    // If a type has been changed since the index was made, it'll need rebuilding..
+    if (desc != nullptr && desc->createIdentifierString() != identifierString)
+    {
+        index = nullptr;
+        desc = getIndex().getTypeForIdentifier (identifierString);
+    }
+
+    return desc;
 }
 
 bool KnownPluginList::addType (const PluginDescription& type)
 {
-    for (int i = types.size(); --i >= 0;)
+    TypeIndex& typeIndex = getIndex();
+
+    if (const Array<PluginDescription*>* const typesForFile = typeIndex.getTypesForFile (type.fileOrIdentifier))
     {
-        if (types.getUnchecked(i)->isDuplicateOf (type))
+        for (int i = typesForFile->size(); --i >= 0;)
         {
-            // strange - found a duplicate plugin with different info..
-            jassert (types.getUnchecked(i)->name == type.name);
-            jassert (types.getUnchecked(i)->isInstrument == type.isInstrument);
+            PluginDescription* const existing = typesForFile->getUnchecked (i);
 
-            *types.getUnchecked(i) = type;
-            return false;
+            if (existing->isDuplicateOf (type))
+            {
+                // strange - found a duplicate plugin with different info..
+                jassert (existing->name == type.name);
+                jassert (existing->isInstrument == type.isInstrument);
+
+                const String oldIdentifierString (existing->createIdentifierString());
+                *existing = type;
+                typeIndex.identifierChanged (oldIdentifierString, existing);
+                return false;
+            }
         }
     }
 
-    types.add (new PluginDescription (type));
+    PluginDescription* const newType = new PluginDescription (type);
+    types.add (newType);
+    typeIndex.add (newType);
     sendChangeMessage();
     return true;
 }
 
-void KnownPluginList::removeType (const int index)
+void KnownPluginList::removeType (const int index_)
 {
-    types.remove (index);
+    index = nullptr;
+    types.remove (index_);
     sendChangeMessage();
 }
 
 namespace
 {
-    Time getPluginFileModTime (const String& fileOrIdentifier)
+    // Finds a plugin file's modification time and size with one call to the file system,
+    // rather than the two that File::getLastModificationTime() and File::getSize() would
+    // need, because this gets done for every plugin each time a folder is re-scanned.
+    // The results are the same as those methods would return.
+    void getPluginFileDetails (const String& fileOrIdentifier, Time& modificationTime, int64& size)
     {
-        if (fileOrIdentifier.startsWithChar ('/') || fileOrIdentifier[1] == ':')
-            return File (fileOrIdentifier).getLastModificationTime();
+        modificationTime = Time();
+        size = 0;
+
+        if (! (fileOrIdentifier.startsWithChar ('/') || fileOrIdentifier[1] == ':'))
+            return;
+
+       #if JUCE_WINDOWS
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+        if (GetFileAttributesEx (fileOrIdentifier.toWideCharPointer(), GetFileExInfoStandard, &attributes))
+        {
+            const ULARGE_INTEGER* const writeTime = reinterpret_cast<const ULARGE_INTEGER*> (&attributes.ftLastWriteTime);
+
+            modificationTime = Time ((int64) ((writeTime->QuadPart - literal64bit (116444736000000000)) / 10000));
+            size = (((int64) attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+        }
+       #else
+        struct stat info;
 
-        return Time();
+        if (stat (fileOrIdentifier.toUTF8(), &info) == 0)
+        {
+            modificationTime = Time ((int64) info.st_mtime * 1000);
+            size = (int64) info.st_size;
+        }
+       #endif
     }
 
     bool timesAreDifferent (const Time& t1, const Time& t2) noexcept
@@ -99,21 +209,21 @@ namespace
 
 bool KnownPluginList::isListingUpToDate (const String& fileOrIdentifier) const
 {
-    if (getTypeForFile (fileOrIdentifier) == nullptr)
+    const Array<PluginDescription*>* const typesForFile = getIndex().getTypesForFile (fileOrIdentifier);
+
+    if (typesForFile == nullptr)
         return false;
 
-    for (int i = types.size(); --i >= 0;)
-    {
-        const PluginDescription* const d = types.getUnchecked(i);
+    Time fileTime;
+    int64 fileSize;
+    getPluginFileDetails (fileOrIdentifier, fileTime, fileSize);
 
-        if (d->fileOrIdentifier == fileOrIdentifier
-             && timesAreDifferent (d->lastFileModTime, getPluginFileModTime (fileOrIdentifier)))
-        {
+    for (int i = typesForFile->size(); --i >= 0;)
+        if (timesAreDifferent (typesForFile->getUnchecked(i)->lastFileModTime, fileTime))
             return false;
-        }
-    }
 
-    return true;
+    return ! (fileSizes.contains (fileOrIdentifier)
+               && fileSizes [fileOrIdentifier] != fileSize);
 }
 
 bool KnownPluginList::scanAndAddFile (const String& fileOrIdentifier,
@@ -121,26 +231,15 @@ bool KnownPluginList::scanAndAddFile (const String& fileOrIdentifier,
                                       OwnedArray <PluginDescription>& typesFound,
                                       AudioPluginFormat& format)
 {
-    if (dontRescanIfAlreadyInList
-         && getTypeForFile (fileOrIdentifier) != nullptr)
+    if (dontRescanIfAlreadyInList && isListingUpToDate (fileOrIdentifier))
     {
-        bool needsRescanning = false;
+        const Array<PluginDescription*>& typesForFile = *getIndex().getTypesForFile (fileOrIdentifier);
 
-        for (int i = types.size(); --i >= 0;)
-        {
-            const PluginDescription* const d = types.getUnchecked(i);
+        for (int i = typesForFile.size(); --i >= 0;)
+            if (typesForFile.getUnchecked(i)->pluginFormatName == format.getName())
+                typesFound.add (new PluginDescription (*typesForFile.getUnchecked(i)));
 
-            if (d->fileOrIdentifier == fileOrIdentifier && d->pluginFormatName == format.getName())
-            {
-                if (timesAreDifferent (d->lastFileModTime, getPluginFileModTime (fileOrIdentifier)))
-                    needsRescanning = true;
-                else
-                    typesFound.add (new PluginDescription (*d));
-            }
-        }
-
-        if (! needsRescanning)
-            return false;
+        return false;
     }
 
     if (blacklist.contains (fileOrIdentifier))
@@ -149,6 +248,14 @@ bool KnownPluginList::scanAndAddFile (const String& fileOrIdentifier,
     OwnedArray <PluginDescription> found;
     format.findAllTypesForFile (found, fileOrIdentifier);
 
+    if (found.size() > 0)
+    {
+        Time fileTime;
+        int64 fileSize;
+        getPluginFileDetails (fileOrIdentifier, fileTime, fileSize);
+        fileSizes.set (fileOrIdentifier, fileSize);
+    }
+
     for (int i = 0; i < found.size(); ++i)
     {
         PluginDescription* const desc = found.getUnchecked(i);
@@ -305,6 +412,139 @@ void KnownPluginList::recreateFromXml (const XmlElement& xml)
     }
 }
 
+//==============================================================================
+namespace PluginScanCacheHelpers
+{
+    static inline int getMagicHeader() noexcept    { return (int) ByteOrder::littleEndianInt ("KPLC"); }
+    static inline int getMagicFooter() noexcept    { return (int) ByteOrder::littleEndianInt ("KPLE"); }
+
+    // This must be bumped whenever the layout below (or PluginDescription) changes.
+    enum { formatVersion = 1 };
+
+    static void write (OutputStream& out, const PluginDescription& d, const int64 fileSize)
+    {
+        out.writeString (d.name);
+        out.writeString (d.descriptiveName);
+        out.writeString (d.pluginFormatName);
+        out.writeString (d.category);
+        out.writeString (d.manufacturerName);
+        out.writeString (d.version);
+        out.writeString (d.fileOrIdentifier);
+        out.writeInt64 (d.lastFileModTime.toMilliseconds());
+        out.writeInt64 (fileSize);
+        out.writeInt (d.uid);
+        out.writeBool (d.isInstrument);
+        out.writeInt (d.numInputChannels);
+        out.writeInt (d.numOutputChannels);
+    }
+
+    static void read (InputStream& in, PluginDescription& d, int64& fileSize)
+    {
+        d.name              = in.readString();
+        d.descriptiveName   = in.readString();
+        d.pluginFormatName  = in.readString();
+        d.category          = in.readString();
+        d.manufacturerName  = in.readString();
+        d.version           = in.readString();
+        d.fileOrIdentifier  = in.readString();
+        d.lastFileModTime   = Time (in.readInt64());
+        fileSize            = in.readInt64();
+        d.uid               = in.readInt();
+        d.isInstrument      = in.readBool();
+        d.numInputChannels  = in.readInt();
+        d.numOutputChannels = in.readInt();
+    }
+}
+
+bool KnownPluginList::saveToScanCache (const File& cacheFile) const
+{
+    using namespace PluginScanCacheHelpers;
+
+    TemporaryFile temp (cacheFile);
+
+    {
+        FileOutputStream out (temp.getFile());
+
+        if (out.failedToOpen())
+            return false;
+
+        out.writeInt (getMagicHeader());
+        out.writeInt (formatVersion);
+        out.writeInt (types.size());
+
+        for (int i = 0; i < types.size(); ++i)
+        {
+            const PluginDescription& d = *types.getUnchecked(i);
+            write (out, d, fileSizes.contains (d.fileOrIdentifier) ? fileSizes [d.fileOrIdentifier] : -1);
+        }
+
+        out.writeInt (blacklist.size());
+
+        for (int i = 0; i < blacklist.size(); ++i)
+            out.writeString (blacklist[i]);
+
+        out.writeInt (getMagicFooter());
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+bool KnownPluginList::loadFromScanCache (const File& cacheFile)
+{
+    using namespace PluginScanCacheHelpers;
+
+    const MemoryMappedFile mappedFile (cacheFile, MemoryMappedFile::readOnly);
+
+    if (mappedFile.getData() == nullptr)
+        return false;
+
+    MemoryInputStream in (mappedFile.getData(), mappedFile.getSize(), false);
+
+    if (in.readInt() != getMagicHeader() || in.readInt() != formatVersion)
+        return false;
+
+    const int numTypes = in.readInt();
+
+    if (numTypes < 0 || numTypes > (int) (mappedFile.getSize() / 32))
+        return false;
+
+    OwnedArray<PluginDescription> newTypes;
+    HashMap<String, int64> newFileSizes (jmax (101, numTypes * 2));
+
+    for (int i = 0; i < numTypes; ++i)
+    {
+        PluginDescription* const d = new PluginDescription();
+        newTypes.add (d);
+
+        int64 fileSize;
+        read (in, *d, fileSize);
+
+        if (fileSize >= 0)
+            newFileSizes.set (d->fileOrIdentifier, fileSize);
+    }
+
+    StringArray newBlacklist;
+
+    for (int i = in.readInt(); --i >= 0 && ! in.isExhausted();)
+        newBlacklist.add (in.readString());
+
+    // (the footer makes sure that nothing got truncated)
+    if (in.readInt() != getMagicFooter())
+        return false;
+
+    index = nullptr;
+    types.swapWithArray (newTypes);
+    fileSizes.swapWith (newFileSizes);
+    blacklist.swapWith (newBlacklist);
+
+    sendChangeMessage();
+    return true;
+}
+
 //==============================================================================
 struct PluginTreeUtils
 {
@@ -479,3 +719,111 @@ int KnownPluginList::getIndexChosenByMenu (const int menuResultCode) const
     const int i = menuResultCode - menuIdBase;
     return isPositiveAndBelow (i, types.size()) ? i : -1;
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class KnownPluginListTests  : public UnitTest
+{
+public:
+    KnownPluginListTests() : UnitTest ("KnownPluginList") {}
+
+    // Finds two plugin types in every file
+    class TestFormat  : public AudioPluginFormat
+    {
+    public:
+        TestFormat() {}
+
+        String getName() const                                                          { return "Test"; }
+        AudioPluginInstance* createInstanceFromDescription (const PluginDescription&)   { return nullptr; }
+        bool fileMightContainThisPluginType (const String&)                             { return true; }
+        String getNameOfPluginFromIdentifier (const String& f)                          { return f; }
+        bool doesPluginStillExist (const PluginDescription&)                            { return true; }
+        bool canScanForPlugins() const                                                  { return true; }
+        StringArray searchPathsForPlugins (const FileSearchPath&, bool)                 { return StringArray(); }
+        FileSearchPath getDefaultLocationsToSearch()                                    { return FileSearchPath(); }
+
+        void findAllTypesForFile (OwnedArray <PluginDescription>& results, const String& fileOrIdentifier)
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                PluginDescription* const desc = new PluginDescription();
+                desc->name = "Plugin " + String (i);
+                desc->descriptiveName = "A test plugin";
+                desc->pluginFormatName = getName();
+                desc->category = "Effect";
+                desc->manufacturerName = "Tester";
+                desc->version = "1.0";
+                desc->fileOrIdentifier = fileOrIdentifier;
+                desc->lastFileModTime = File (fileOrIdentifier).getLastModificationTime();
+                desc->uid = 1000 + i;
+                desc->isInstrument = (i == 1);
+                desc->numInputChannels = 2;
+                desc->numOutputChannels = 2 + i;
+                results.add (desc);
+            }
+        }
+    };
+
+    static bool listsAreEqual (const KnownPluginList& list1, const KnownPluginList& list2)
+    {
+        const ScopedPointer<XmlElement> xml1 (list1.createXml()), xml2 (list2.createXml());
+        return xml1->isEquivalentTo (xml2, false);
+    }
+
+    void runTest()
+    {
+        beginTest ("Scan cache round-trip");
+
+        const File dir (File::createTempFile ("plugincache"));
+        dir.createDirectory();
+
+        const File pluginFile (dir.getChildFile ("plugin.so")), cacheFile (dir.getChildFile ("plugins.cache"));
+        pluginFile.replaceWithText ("plugin");
+
+        KnownPluginList list;
+        TestFormat format;
+        OwnedArray<PluginDescription> found;
+        expect (list.scanAndAddFile (pluginFile.getFullPathName(), true, found, format));
+        expectEquals (list.getNumTypes(), 2);
+
+        PluginDescription other;
+        other.name = "Not a file";
+        other.pluginFormatName = "Test";
+        other.fileOrIdentifier = "com.test.identifier";
+        list.addType (other);
+
+        list.addToBlacklist (dir.getChildFile ("crashes.so").getFullPathName());
+        list.addToBlacklist ("com.test.crashes");
+
+        expect (list.saveToScanCache (cacheFile));
+
+        KnownPluginList loaded;
+        expect (loaded.loadFromScanCache (cacheFile));
+        expect (listsAreEqual (list, loaded));
+        expect (loaded.isListingUpToDate (pluginFile.getFullPathName()));
+
+        // the cache remembers each file's size, so a change that keeps the same
+        // modification time is still noticed
+        const Time modTime (pluginFile.getLastModificationTime());
+        pluginFile.replaceWithText ("modified plugin");
+        pluginFile.setLastModificationTime (modTime);
+        expect (! loaded.isListingUpToDate (pluginFile.getFullPathName()));
+
+        beginTest ("Damaged scan cache");
+
+        MemoryBlock cacheData;
+        expect (cacheFile.loadFileAsData (cacheData));
+        cacheFile.replaceWithData (cacheData.getData(), cacheData.getSize() - 5);
+
+        // a truncated file is rejected, and the list is left as it was
+        expect (! loaded.loadFromScanCache (cacheFile));
+        expect (listsAreEqual (list, loaded));
+
+        dir.deleteRecursively();
+    }
+};
+
+static KnownPluginListTests knownPluginListTests;
+
+#endif
@@ -103,6 +103,9 @@ public:
 
     /** Returns true if the specified file is already known about and if it
         hasn't been modified since our entry was created.
+
+        A file counts as modified if its modification time has changed, or if its
+        size is different from when it was scanned.
     */
     bool isListingUpToDate (const String& possiblePluginFileOrIdentifier) const;
 
@@ -165,6 +168,28 @@ public:
     /** Recreates the state of this list from its stored XML format. */
     void recreateFromXml (const XmlElement& xml);
 
+    //==============================================================================
+    /** Writes the list to a compact binary file.
+
+        This is much quicker to reload than the XML format, so it's a good way for a
+        host to keep its plugin list between sessions. As well as the plugin types and
+        the blacklist, it stores the size and modification time of each plugin file when
+        it was scanned, so that after reloading, isListingUpToDate() (and hence
+        PluginDirectoryScanner) only needs to check each file's details to avoid
+        re-scanning it.
+
+        @see loadFromScanCache
+    */
+    bool saveToScanCache (const File& cacheFile) const;
+
+    /** Replaces the contents of this list with a file written by saveToScanCache().
+
+        If the file is missing, damaged or was written by an incompatible version,
+        this returns false and leaves the list unchanged, in which case you'd
+        normally just re-scan.
+    */
+    bool loadFromScanCache (const File& cacheFile);
+
     //==============================================================================
     /** A structure that recursively holds a tree of plugins.
         @see KnownPluginList::createTree()
@@ -183,6 +208,13 @@ private:
     //==============================================================================
     OwnedArray <PluginDescription> types;
     StringArray blacklist;
+    HashMap <String, int64> fileSizes;
+
+    class TypeIndex;
+    friend class ScopedPointer<TypeIndex>;
+    mutable ScopedPointer<TypeIndex> index;
+
+    TypeIndex& getIndex() const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KnownPluginList)
 };
@@ -31,6 +31,107 @@ static StringArray readDeadMansPedalFile (const File& file)
     return lines;
 }
 
+//==============================================================================
+namespace ChildProcessScanHelpers
+{
+    static const char* const commandLinePrefix = "--juce-plugin-scan:";
+
+    // The plugin may print its own junk to stdout or stderr, so the results are
+    // wrapped in these markers. If the end marker is missing, the process must have died.
+    static const char* const resultsStartMarker = "<<<JUCE_PLUGIN_SCAN_RESULTS>>>";
+    static const char* const resultsEndMarker   = "<<<JUCE_PLUGIN_SCAN_END>>>";
+
+    /** Returns the xml that a child process wrote, or nullptr if it didn't finish. */
+    static XmlElement* createResultsXml (const String& output)
+    {
+        const int start = output.indexOf (resultsStartMarker);
+        const int end = output.lastIndexOf (resultsEndMarker);
+
+        if (start < 0 || end < start)
+            return nullptr;
+
+        return XmlDocument::parse (output.substring (start + (int) strlen (resultsStartMarker), end));
+    }
+}
+
+class PluginDirectoryScanner::ChildProcessScan  : public ThreadPoolJob
+{
+public:
+    ChildProcessScan (const File& executable_, const String& formatName,
+                      const String& fileOrIdentifier_, WaitableEvent& finishedEvent_)
+        : ThreadPoolJob ("Plugin scan"),
+          fileOrIdentifier (fileOrIdentifier_),
+          executable (executable_),
+          startTime (Time::getMillisecondCounter()),
+          finishedEvent (finishedEvent_),
+          hasBeenKilled (false),
+          hasStarted (false)
+    {
+        // (all the parameters are packed into a single argument, so that they don't get
+        // mangled by quoting when the child reassembles its command line)
+        const String params (formatName + "\n" + fileOrIdentifier);
+        const MemoryBlock paramData ((const char*) params.toUTF8(), params.getNumBytesAsUTF8());
+
+        arguments.add (executable.getFullPathName());
+        arguments.add (ChildProcessScanHelpers::commandLinePrefix + paramData.toBase64Encoding());
+    }
+
+    JobStatus runJob()
+    {
+        {
+            const ScopedLock sl (processLock);
+
+            // (on some platforms start() succeeds even if the executable can't be run,
+            // which would look just like a crash, so check that it's there first)
+            hasStarted = ! hasBeenKilled && executable.existsAsFile() && process.start (arguments);
+        }
+
+        if (hasStarted)
+        {
+            output = process.readAllProcessOutput();
+            process.waitForProcessToFinish (1000);
+        }
+
+        finished = 1;
+        finishedEvent.signal();
+        return jobHasFinished;
+    }
+
+    void kill()
+    {
+        const ScopedLock sl (processLock);
+
+        if (! hasBeenKilled)
+        {
+            hasBeenKilled = true;
+            process.kill();
+        }
+    }
+
+    bool isFinished() const noexcept                { return finished.get() != 0; }
+    bool hasTimedOut (int timeoutMs) const noexcept { return (int) (Time::getMillisecondCounter() - startTime) > timeoutMs; }
+
+    /** True if the process couldn't be launched at all, as opposed to being killed or crashing. */
+    bool failedToStart() const noexcept             { return isFinished() && ! (hasStarted || hasBeenKilled); }
+
+    XmlElement* createResultsXml() const            { return ChildProcessScanHelpers::createResultsXml (output); }
+
+    const String fileOrIdentifier;
+
+private:
+    const File executable;
+    StringArray arguments;
+    const uint32 startTime;
+    WaitableEvent& finishedEvent;
+    ChildProcess process;
+    CriticalSection processLock;
+    bool hasBeenKilled, hasStarted;
+    String output;
+    Atomic<int> finished;
+
+    JUCE_DECLARE_NON_COPYABLE (ChildProcessScan)
+};
+
 PluginDirectoryScanner::PluginDirectoryScanner (KnownPluginList& listToAddTo,
                                                 AudioPluginFormat& formatToLookFor,
                                                 FileSearchPath directoriesToSearch,
@@ -40,7 +141,9 @@ PluginDirectoryScanner::PluginDirectoryScanner (KnownPluginList& listToAddTo,
       format (formatToLookFor),
       deadMansPedalFile (deadMansPedal),
       nextIndex (0),
-      progress (0)
+      progress (0),
+      numChildProcesses (0),
+      childTimeoutMs (0)
 {
     directoriesToSearch.removeRedundantPaths();
 
@@ -64,6 +167,12 @@ PluginDirectoryScanner::PluginDirectoryScanner (KnownPluginList& listToAddTo,
 
 PluginDirectoryScanner::~PluginDirectoryScanner()
 {
+    for (int i = childScans.size(); --i >= 0;)
+    {
+        ChildProcessScan* const scan = childScans.getUnchecked (i);
+        scan->kill();
+        childScanPool->removeJob (scan, true, -1);
+    }
 }
 
 //==============================================================================
@@ -74,6 +183,9 @@ const String PluginDirectoryScanner::getNextPluginFileThatWillBeScanned() const
 
 bool PluginDirectoryScanner::scanNextFile (const bool dontRescanIfAlreadyInList)
 {
+    if (childScanPool != nullptr)
+        return scanNextFileInChildProcesses (dontRescanIfAlreadyInList);
+
     String file (filesOrIdentifiersToScan [nextIndex]);
 
     if (file.isNotEmpty() && ! list.isListingUpToDate (file))
@@ -108,6 +220,144 @@ bool PluginDirectoryScanner::skipNextFile()
     return nextIndex < filesOrIdentifiersToScan.size();
 }
 
+//==============================================================================
+void PluginDirectoryScanner::setScanInChildProcesses (const File& scannerExecutable,
+                                                      const int numProcesses,
+                                                      const int timeoutMs)
+{
+    jassert (childScans.size() == 0); // this must be called before scanning begins!
+
+    childScannerExecutable = scannerExecutable;
+    numChildProcesses = numProcesses > 0 ? numProcesses : SystemStats::getNumCpus();
+    childTimeoutMs = timeoutMs;
+    childScanPool = new ThreadPool (numChildProcesses);
+}
+
+bool PluginDirectoryScanner::scanNextFileInChildProcesses (const bool dontRescanIfAlreadyInList)
+{
+    // Files that don't need scanning are filtered out here, before any processes get launched.
+    // There's no need for the dead-man's-pedal, because a crash can only kill the child.
+    while (childScans.size() < numChildProcesses && nextIndex < filesOrIdentifiersToScan.size())
+    {
+        const String file (filesOrIdentifiersToScan [nextIndex++]);
+
+        if (file.isNotEmpty()
+             && ! (dontRescanIfAlreadyInList && list.isListingUpToDate (file))
+             && ! list.getBlacklistedFiles().contains (file))
+        {
+            ChildProcessScan* const scan = new ChildProcessScan (childScannerExecutable, format.getName(),
+                                                                 file, childScanFinished);
+            childScans.add (scan);
+            childScanPool->addJob (scan, false);
+        }
+    }
+
+    while (childScans.size() > 0)
+    {
+        bool anyFinished = false;
+
+        for (int i = childScans.size(); --i >= 0;)
+        {
+            ChildProcessScan* const scan = childScans.getUnchecked (i);
+
+            if (scan->isFinished())
+            {
+                addResultsFromChildProcess (*scan);
+                childScanPool->removeJob (scan, false, -1);
+                childScans.remove (i);
+                anyFinished = true;
+            }
+            else if (scan->hasTimedOut (childTimeoutMs))
+            {
+                scan->kill();
+            }
+        }
+
+        if (anyFinished)
+            break;
+
+        childScanFinished.wait (50);
+    }
+
+    progress = (nextIndex - childScans.size()) / (float) jmax (1, filesOrIdentifiersToScan.size());
+
+    return childScans.size() > 0 || nextIndex < filesOrIdentifiersToScan.size();
+}
+
+void PluginDirectoryScanner::addResultsFromChildProcess (const ChildProcessScan& scan)
+{
+    if (scan.failedToStart())
+    {
+        // this says nothing about the plugin itself, so it's reported rather than blacklisted..
+        failedFiles.add (scan.fileOrIdentifier);
+        return;
+    }
+
+    const ScopedPointer<XmlElement> results (scan.createResultsXml());
+
+    if (results == nullptr)
+    {
+        // the plugin crashed or hung, so make sure it doesn't get tried again..
+        list.addToBlacklist (scan.fileOrIdentifier);
+        return;
+    }
+
+    int numFound = 0;
+
+    forEachXmlChildElement (*results, e)
+    {
+        PluginDescription desc;
+
+        if (desc.loadFromXml (*e))
+        {
+            list.addType (desc);
+            ++numFound;
+        }
+    }
+
+    if (numFound == 0)
+        failedFiles.add (scan.fileOrIdentifier);
+}
+
+bool PluginDirectoryScanner::performScanInChildProcess (const String& commandLine,
+                                                        AudioPluginFormatManager& formatManager)
+{
+    using namespace ChildProcessScanHelpers;
+
+    if (! commandLine.contains (commandLinePrefix))
+        return false;
+
+    MemoryBlock paramData;
+    paramData.fromBase64Encoding (commandLine.fromFirstOccurrenceOf (commandLinePrefix, false, false)
+                                             .upToFirstOccurrenceOf (" ", false, false).trim());
+
+    const String params (String::fromUTF8 ((const char*) paramData.getData(), (int) paramData.getSize()));
+    const String formatName (params.upToFirstOccurrenceOf ("\n", false, false));
+    const String fileOrIdentifier (params.fromFirstOccurrenceOf ("\n", false, false));
+
+    XmlElement results ("PLUGINS");
+
+    for (int i = 0; i < formatManager.getNumFormats(); ++i)
+    {
+        AudioPluginFormat* const f = formatManager.getFormat (i);
+
+        if (f->getName() == formatName)
+        {
+            OwnedArray <PluginDescription> found;
+            f->findAllTypesForFile (found, fileOrIdentifier);
+
+            for (int j = 0; j < found.size(); ++j)
+                results.addChildElement (found.getUnchecked (j)->createXml());
+        }
+    }
+
+    std::cout << resultsStartMarker
+              << results.createDocument (String::empty, true, false).toUTF8().getAddress()
+              << resultsEndMarker << std::endl;
+
+    return true;
+}
+
 void PluginDirectoryScanner::setDeadMansPedalFile (const StringArray& newContents)
 {
     if (deadMansPedalFile != File::nonexistent)
@@ -123,3 +373,101 @@ void PluginDirectoryScanner::applyBlacklistingsFromDeadMansPedal (KnownPluginLis
     for (int i = 0; i < crashedPlugins.size(); ++i)
         list.addToBlacklist (crashedPlugins[i]);
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class PluginDirectoryScannerTests  : public UnitTest
+{
+public:
+    PluginDirectoryScannerTests() : UnitTest ("PluginDirectoryScanner") {}
+
+    class TestFormat  : public AudioPluginFormat
+    {
+    public:
+        TestFormat (const StringArray& files_) : files (files_) {}
+
+        String getName() const                                                          { return "Test"; }
+        void findAllTypesForFile (OwnedArray <PluginDescription>&, const String&)       {}
+        AudioPluginInstance* createInstanceFromDescription (const PluginDescription&)   { return nullptr; }
+        bool fileMightContainThisPluginType (const String&)                             { return true; }
+        String getNameOfPluginFromIdentifier (const String& f)                          { return f; }
+        bool doesPluginStillExist (const PluginDescription&)                            { return true; }
+        bool canScanForPlugins() const                                                  { return true; }
+        StringArray searchPathsForPlugins (const FileSearchPath&, bool)                 { return files; }
+        FileSearchPath getDefaultLocationsToSearch()                                    { return FileSearchPath(); }
+
+    private:
+        StringArray files;
+    };
+
+    void runTest()
+    {
+        beginTest ("Parsing child process results");
+
+        PluginDescription desc;
+        desc.name = "Test Plugin";
+        desc.pluginFormatName = "Test";
+        desc.fileOrIdentifier = "/plugins/test.so";
+
+        XmlElement plugins ("PLUGINS");
+        plugins.addChildElement (desc.createXml());
+
+        const String xml (plugins.createDocument (String::empty, true, false));
+        const String start (ChildProcessScanHelpers::resultsStartMarker);
+        const String end (ChildProcessScanHelpers::resultsEndMarker);
+
+        {
+            const ScopedPointer<XmlElement> results (ChildProcessScanHelpers::createResultsXml ("plugin junk\n" + start + xml + end + "\nmore junk"));
+            expect (results != nullptr && results->getNumChildElements() == 1);
+
+            PluginDescription loaded;
+            expect (results != nullptr && loaded.loadFromXml (*results->getFirstChildElement()));
+            expect (loaded.isDuplicateOf (desc) && loaded.name == desc.name);
+        }
+
+        expect (ChildProcessScanHelpers::createResultsXml (start + xml) == nullptr);
+        expect (ChildProcessScanHelpers::createResultsXml (String::empty) == nullptr);
+
+        beginTest ("Scanner that can't be launched");
+
+        const File dir (File::createTempFile ("scantest"));
+        dir.createDirectory();
+
+        const File upToDateFile (dir.getChildFile ("known.so")), newFile (dir.getChildFile ("new.so"));
+        upToDateFile.replaceWithText ("x");
+        newFile.replaceWithText ("x");
+
+        KnownPluginList list;
+        desc.fileOrIdentifier = upToDateFile.getFullPathName();
+        desc.lastFileModTime = upToDateFile.getLastModificationTime();
+        list.addType (desc);
+
+        StringArray files;
+        files.add (upToDateFile.getFullPathName());
+        files.add (newFile.getFullPathName());
+        TestFormat format (files);
+
+        {
+            PluginDirectoryScanner scanner (list, format, FileSearchPath(), false, File::nonexistent);
+            scanner.setScanInChildProcesses (dir.getChildFile ("missing-scanner"), 2, 10000);
+
+            while (scanner.scanNextFile (true))
+            {}
+
+            // the file that was already known mustn't have been handed to a child..
+            expectEquals (scanner.getFailedFiles().size(), 1);
+            expect (scanner.getFailedFiles().contains (newFile.getFullPathName()));
+        }
+
+        // ..and a process that never ran mustn't get its plugin blacklisted
+        expectEquals (list.getBlacklistedFiles().size(), 0);
+        expectEquals (list.getNumTypes(), 1);
+
+        dir.deleteRecursively();
+    }
+};
+
+static PluginDirectoryScannerTests pluginDirectoryScannerTests;
+
+#endif
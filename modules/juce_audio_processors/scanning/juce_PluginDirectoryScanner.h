@@ -109,6 +109,49 @@ public:
     static void applyBlacklistingsFromDeadMansPedal (KnownPluginList& listToApplyTo,
                                                      const File& deadMansPedalFile);
 
+    //==============================================================================
+    /** Makes the scanner load the plugins in separate processes rather than in this one.
+
+        After this has been called, scanNextFile() will keep up to numProcesses copies of
+        the given executable running at once, each one scanning a single file, and each call
+        will wait until at least one of them has finished before adding its results to the
+        list. A plugin that crashes its process, or takes longer than timeoutMs to scan,
+        gets added to the list's blacklist, but can't take down the host. If the executable
+        can't be launched, the files it was meant to scan are added to getFailedFiles() instead.
+
+        The executable is normally your own app. It'll be launched with a special argument,
+        and it must pass its command line to performScanInChildProcess() as early as possible,
+        quitting straight away if that returns true, e.g.
+        @code
+        void initialise (const String& commandLine)
+        {
+            AudioPluginFormatManager formatManager;
+            formatManager.addDefaultFormats();
+
+            if (PluginDirectoryScanner::performScanInChildProcess (commandLine, formatManager))
+            {
+                quit();
+                return;
+            }
+            ...
+        @endcode
+
+        If numProcesses is zero or less, one process per CPU core will be used.
+    */
+    void setScanInChildProcesses (const File& scannerExecutable,
+                                  int numProcesses = 0,
+                                  int timeoutMs = 60000);
+
+    /** Performs a scan that was requested by a PluginDirectoryScanner in another process.
+
+        If the command line is one that was created by a scanner that's using
+        setScanInChildProcesses(), this loads the plugin file, writes the results to
+        stdout and returns true, in which case the app should quit. For any other
+        command line it does nothing and returns false.
+    */
+    static bool performScanInChildProcess (const String& commandLine,
+                                           AudioPluginFormatManager& formatManager);
+
 private:
     //==============================================================================
     KnownPluginList& list;
@@ -119,7 +162,17 @@ private:
     int nextIndex;
     float progress;
 
+    class ChildProcessScan;
+    friend class OwnedArray<ChildProcessScan>;
+    OwnedArray<ChildProcessScan> childScans;
+    ScopedPointer<ThreadPool> childScanPool;
+    WaitableEvent childScanFinished;
+    File childScannerExecutable;
+    int numChildProcesses, childTimeoutMs;
+
     void setDeadMansPedalFile (const StringArray& newContents);
+    bool scanNextFileInChildProcesses (bool dontRescanIfAlreadyInList);
+    void addResultsFromChildProcess (const ChildProcessScan&);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginDirectoryScanner)
 };
@@ -72,24 +72,86 @@ private:
     char values[2];
 };
 
+//==============================================================================
+namespace ThumbnailHelpers
+{
+    static void findMinAndMax (const float* values, int numValues, float& lowest, float& highest) noexcept
+    {
+       #if JUCE_USE_SSE2_INTRINSICS || JUCE_USE_ARM_NEON
+        if (numValues >= 8)
+        {
+           #if JUCE_USE_SSE2_INTRINSICS
+            __m128 mn = _mm_loadu_ps (values);
+            __m128 mx = mn;
+
+            for (numValues -= 4; numValues >= 4; numValues -= 4)
+            {
+                values += 4;
+                const __m128 v = _mm_loadu_ps (values);
+                mn = _mm_min_ps (mn, v);
+                mx = _mm_max_ps (mx, v);
+            }
+
+            float mins[4], maxes[4];
+            _mm_storeu_ps (mins, mn);
+            _mm_storeu_ps (maxes, mx);
+           #else
+            float32x4_t mn = vld1q_f32 (values);
+            float32x4_t mx = mn;
+
+            for (numValues -= 4; numValues >= 4; numValues -= 4)
+            {
+                values += 4;
+                const float32x4_t v = vld1q_f32 (values);
+                mn = vminq_f32 (mn, v);
+                mx = vmaxq_f32 (mx, v);
+            }
+
+            float mins[4], maxes[4];
+            vst1q_f32 (mins, mn);
+            vst1q_f32 (maxes, mx);
+           #endif
+
+            lowest  = jmin (jmin (mins[0], mins[1]), jmin (mins[2], mins[3]));
+            highest = jmax (jmax (maxes[0], maxes[1]), jmax (maxes[2], maxes[3]));
+
+            for (int i = 0; i < numValues; ++i)
+            {
+                const float v = values [4 + i];
+                lowest  = jmin (lowest, v);
+                highest = jmax (highest, v);
+            }
+
+            return;
+        }
+       #endif
+
+        juce::findMinAndMax (values, numValues, lowest, highest);
+    }
+}
+
 //==============================================================================
 class AudioThumbnail::LevelDataSource   : public TimeSliceClient
 {
 public:
     LevelDataSource (AudioThumbnail& owner_, AudioFormatReader* newReader, int64 hash)
         : lengthInSamples (0), numSamplesFinished (0), sampleRate (0), numChannels (0),
-          hashCode (hash), owner (owner_), reader (newReader)
+          hashCode (hash), sourceStamp (0), owner (owner_), reader (newReader), thumbHasBeenStored (0), scanHasFailed (0)
     {
     }
 
     LevelDataSource (AudioThumbnail& owner_, InputSource* source_)
         : lengthInSamples (0), numSamplesFinished (0), sampleRate (0), numChannels (0),
-          hashCode (source_->hashCode()), owner (owner_), source (source_)
+          hashCode (source_->hashCode()), sourceStamp (getStampFor (*source_)),
+          owner (owner_), source (source_), thumbHasBeenStored (0), scanHasFailed (0)
     {
     }
 
     ~LevelDataSource()
     {
+        for (int i = scanJobs.size(); --i >= 0;)
+            owner.cache.getThreadPool().removeJob (scanJobs.getUnchecked (i), true, -1);
+
         owner.cache.getTimeSliceThread().removeTimeSliceClient (this);
     }
 
@@ -110,9 +172,15 @@ public:
             sampleRate = reader->sampleRate;
 
             if (lengthInSamples <= 0 || isFullyLoaded())
+            {
                 reader = nullptr;
+            }
             else
+            {
+                lastReaderUseTime = Time::getMillisecondCounter();
+                startScanning();
                 owner.cache.getTimeSliceThread().addTimeSliceClient (this);
+            }
         }
     }
 
@@ -151,7 +219,10 @@ public:
 
     int useTimeSlice()
     {
-        if (isFullyLoaded())
+        // the scanning is done by the cache's thread pool, so this just closes the reader
+        // once it's no longer being used. If a section couldn't be read, the thumbnail will
+        // never be complete, so there's nothing to wait for.
+        if (isFullyLoaded() || scanHasFailed.get() != 0)
         {
             if (reader != nullptr && source != nullptr)
             {
@@ -164,25 +235,6 @@ public:
             return -1;
         }
 
-        bool justFinished = false;
-
-        {
-            const ScopedLock sl (readerLock);
-
-            createReader();
-
-            if (reader != nullptr)
-            {
-                if (! readNextBlock())
-                    return 0;
-
-                justFinished = true;
-            }
-        }
-
-        if (justFinished)
-            owner.cache.storeThumb (owner, hashCode);
-
         return 200;
     }
 
@@ -191,71 +243,202 @@ public:
         return numSamplesFinished >= lengthInSamples;
     }
 
-    inline int sampleToThumbSample (const int64 originalSample) const noexcept
-    {
-        return (int) (originalSample / owner.samplesPerThumbSample);
-    }
-
     int64 lengthInSamples, numSamplesFinished;
     double sampleRate;
     unsigned int numChannels;
-    int64 hashCode;
+    int64 hashCode, sourceStamp;
 
 private:
+    //==============================================================================
+    /** Scans one section of the file. */
+    class ScanJob  : public ThreadPoolJob
+    {
+    public:
+        ScanJob (LevelDataSource& owner_, const int64 startSample_, const int64 endSample_)
+            : ThreadPoolJob ("Thumbnail scanner"),
+              owner (owner_), startSample (startSample_), endSample (endSample_),
+              position (startSample_)
+        {
+        }
+
+        JobStatus runJob()
+        {
+            const int samplesPerThumbSample = owner.owner.samplesPerThumbSample;
+            const int numThumbSampsPerBlock = 256;
+            const int blockSize = numThumbSampsPerBlock * samplesPerThumbSample;
+
+            // Each section reads from its own reader, unless the thumbnail was given a reader
+            // rather than a source, in which case they all have to share that one.
+            ScopedPointer<AudioFormatReader> sectionReader (owner.createNewReader());
+
+            if (sectionReader == nullptr && owner.source != nullptr)
+                return sectionFailed();
+
+            AudioSampleBuffer buffer (2, blockSize);
+            HeapBlock<MinMaxValue> levelData ((size_t) numThumbSampsPerBlock * 2);
+            MinMaxValue* levels[2] = { levelData, levelData + numThumbSampsPerBlock };
+
+            while (position.get() < endSample)
+            {
+                if (shouldExit())
+                    return jobHasFinished;
+
+                const int64 start = position.get();
+                const int numToDo = (int) jmin ((int64) blockSize, endSample - start);
+                const int numThumbSamps = (numToDo + samplesPerThumbSample - 1) / samplesPerThumbSample;
+
+                if (sectionReader != nullptr)
+                {
+                    sectionReader->read (&buffer, 0, numToDo, start, true, true);
+                }
+                else
+                {
+                    const ScopedLock sl (owner.readerLock);
+                    owner.createReader();
+
+                    if (owner.reader == nullptr)
+                        return sectionFailed();
+
+                    owner.reader->read (&buffer, 0, numToDo, start, true, true);
+                    owner.lastReaderUseTime = Time::getMillisecondCounter();
+                }
+
+                for (int chan = 0; chan < 2; ++chan)
+                {
+                    const float* const data = buffer.getSampleData (chan);
+
+                    for (int i = 0; i < numThumbSamps; ++i)
+                    {
+                        const int offset = i * samplesPerThumbSample;
+                        float low, high;
+                        ThumbnailHelpers::findMinAndMax (data + offset, jmin (samplesPerThumbSample, numToDo - offset), low, high);
+                        levels[chan][i].setFloat (low, high);
+                    }
+                }
+
+                owner.owner.setLevels (levels, (int) (start / samplesPerThumbSample), 2, numThumbSamps);
+
+                position = start + numToDo;
+                owner.sectionProgressChanged();
+            }
+
+            return jobHasFinished;
+        }
+
+        LevelDataSource& owner;
+        const int64 startSample, endSample;
+        Atomic<int64> position;
+
+    private:
+        // The rest of this section is left empty, and the thumbnail is never marked as
+        // fully loaded, so it won't be stored in the cache.
+        JobStatus sectionFailed()
+        {
+            owner.scanHasFailed = 1;
+            return jobHasFinished;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (ScanJob)
+    };
+
+    friend class ScanJob;
+
     AudioThumbnail& owner;
     ScopedPointer <InputSource> source;
     ScopedPointer <AudioFormatReader> reader;
-    CriticalSection readerLock;
+    CriticalSection readerLock, progressLock;
+    OwnedArray<ScanJob> scanJobs;
+    Atomic<int> thumbHasBeenStored, scanHasFailed;
     uint32 lastReaderUseTime;
 
-    void createReader()
+    // Identifies the version of the source's data, so the cache can tell when a file has been
+    // changed, even if its hash code doesn't include the modification time
+    static int64 getStampFor (InputSource& inputSource)
     {
-        if (reader == nullptr && source != nullptr)
+        const ScopedPointer<InputStream> stream (inputSource.createInputStream());
+
+        if (stream == nullptr)
+            return 0;
+
+        int64 stamp = stream->getTotalLength();
+
+        if (const FileInputStream* const fileStream = dynamic_cast <const FileInputStream*> (stream.get()))
+            stamp = stamp * 1000003 + fileStream->getFile().getLastModificationTime().toMilliseconds();
+
+        return stamp;
+    }
+
+    AudioFormatReader* createNewReader()
+    {
+        if (source != nullptr)
             if (InputStream* audioFileStream = source->createInputStream())
-                reader = owner.formatManagerToUse.createReaderFor (audioFileStream);
+                return owner.formatManagerToUse.createReaderFor (audioFileStream);
+
+        return nullptr;
     }
 
-    bool readNextBlock()
+    void createReader()
     {
-        jassert (reader != nullptr);
+        if (reader == nullptr)
+            reader = createNewReader();
+    }
 
-        if (! isFullyLoaded())
-        {
-            const int numToDo = (int) jmin (256 * (int64) owner.samplesPerThumbSample, lengthInSamples - numSamplesFinished);
+    void startScanning()
+    {
+        // Long files are divided into a few sections for each core, but each section needs its
+        // own reader, so they're kept big enough for opening the file not to be a big overhead.
+        const int64 samplesPerThumbSample = owner.samplesPerThumbSample;
+        const int64 minSectionLength = samplesPerThumbSample * 256 * 16;
+        const int64 numToDo = lengthInSamples - numSamplesFinished;
 
-            if (numToDo > 0)
-            {
-                int64 startSample = numSamplesFinished;
+        const int numSections = source == nullptr ? 1
+                                  : (int) jlimit ((int64) 1, (int64) (2 * SystemStats::getNumCpus()),
+                                                  numToDo / minSectionLength);
 
-                const int firstThumbIndex = sampleToThumbSample (startSample);
-                const int lastThumbIndex  = sampleToThumbSample (startSample + numToDo);
-                const int numThumbSamps = lastThumbIndex - firstThumbIndex;
+        const int64 sectionLength = samplesPerThumbSample
+                                      * ((numToDo / numSections + samplesPerThumbSample - 1) / samplesPerThumbSample);
 
-                HeapBlock<MinMaxValue> levelData ((size_t) numThumbSamps * 2);
-                MinMaxValue* levels[2] = { levelData, levelData + numThumbSamps };
+        for (int64 start = numSamplesFinished; start < lengthInSamples; start += sectionLength)
+            scanJobs.add (new ScanJob (*this, start, jmin (lengthInSamples, start + sectionLength)));
 
-                for (int i = 0; i < numThumbSamps; ++i)
-                {
-                    float lowestLeft, highestLeft, lowestRight, highestRight;
+        for (int i = 0; i < scanJobs.size(); ++i)
+            owner.cache.getThreadPool().addJob (scanJobs.getUnchecked (i), false);
+    }
 
-                    reader->readMaxLevels ((firstThumbIndex + i) * owner.samplesPerThumbSample, owner.samplesPerThumbSample,
-                                           lowestLeft, highestLeft, lowestRight, highestRight);
+    void sectionProgressChanged()
+    {
+        int64 finished = 0;
 
-                    levels[0][i].setFloat (lowestLeft, highestLeft);
-                    levels[1][i].setFloat (lowestRight, highestRight);
-                }
+        {
+            // the thumbnail counts as loaded up to the end of the first section that hasn't been finished
+            const ScopedLock sl (progressLock);
 
-                {
-                    const ScopedUnlock su (readerLock);
-                    owner.setLevels (levels, firstThumbIndex, 2, numThumbSamps);
-                }
+            for (int i = 0; i < scanJobs.size(); ++i)
+            {
+                const ScanJob* const job = scanJobs.getUnchecked (i);
+                finished = job->position.get();
 
-                numSamplesFinished += numToDo;
-                lastReaderUseTime = Time::getMillisecondCounter();
+                if (finished < job->endSample)
+                    break;
             }
+
+            if (finished <= numSamplesFinished)
+                return;
+
+            numSamplesFinished = finished;
         }
 
-        return isFullyLoaded();
+        {
+            const ScopedLock sl (owner.lock);
+
+            if (finished > owner.numSamplesFinished)
+                owner.numSamplesFinished = finished;
+        }
+
+        owner.sendChangeMessage();
+
+        if (isFullyLoaded() && thumbHasBeenStored.compareAndSetBool (1, 0))
+            owner.cache.storeThumb (owner, hashCode, sourceStamp);
     }
 };
 
@@ -289,16 +472,27 @@ public:
             char mx = -128;
             char mn = 127;
 
-            while (startSample <= endSample)
+            // Any whole blocks in the middle of the range are taken from the coarser levels,
+            // so the cost of this doesn't depend on how far the view is zoomed out.
+            const Array<MinMaxValue>* level = &data;
+            int levelIndex = 0;
+
+            while (levelIndex < levels.size() && endSample - startSample >= 2 * levelScale)
             {
-                const MinMaxValue& v = data.getReference (startSample);
+                while (startSample % levelScale != 0)
+                    accumulate (level->getReference (startSample++), mn, mx);
 
-                if (v.getMinValue() < mn)  mn = v.getMinValue();
-                if (v.getMaxValue() > mx)  mx = v.getMaxValue();
+                while ((endSample + 1) % levelScale != 0)
+                    accumulate (level->getReference (endSample--), mn, mx);
 
-                ++startSample;
+                level = levels.getUnchecked (levelIndex++);
+                startSample /= levelScale;
+                endSample = (endSample + 1) / levelScale - 1;
             }
 
+            while (startSample <= endSample)
+                accumulate (level->getReference (startSample++), mn, mx);
+
             if (mn <= mx)
             {
                 result.set (mn, mx);
@@ -320,6 +514,39 @@ public:
 
         for (int i = 0; i < numValues; ++i)
             dest[i] = values[i];
+
+        updateLevels (startIndex, numValues);
+    }
+
+    /** Recalculates the summary levels that cover a range of the full-resolution data. */
+    void updateLevels (int startIndex, int numValues)
+    {
+        const Array<MinMaxValue>* source = &data;
+
+        for (int levelIndex = 0; levelIndex < levels.size() && numValues > 0; ++levelIndex)
+        {
+            Array<MinMaxValue>& dest = *levels.getUnchecked (levelIndex);
+
+            const int endIndex = jmin ((startIndex + numValues + levelScale - 1) / levelScale, dest.size());
+            startIndex /= levelScale;
+            numValues = endIndex - startIndex;
+
+            for (int i = startIndex; i < endIndex; ++i)
+            {
+                char mx = -128;
+                char mn = 127;
+
+                for (int j = i * levelScale; j < jmin ((i + 1) * levelScale, source->size()); ++j)
+                    accumulate (source->getReference (j), mn, mx);
+
+                if (mn <= mx)
+                    dest.getReference (i).set (mn, mx);
+                else
+                    dest.getReference (i).set (0, 0);
+            }
+
+            source = &dest;
+        }
     }
 
     void resetPeak() noexcept
@@ -331,9 +558,11 @@ public:
     {
         if (peakLevel < 0)
         {
-            for (int i = 0; i < data.size(); ++i)
+            const Array<MinMaxValue>& top = levels.size() > 0 ? *levels.getLast() : data;
+
+            for (int i = 0; i < top.size(); ++i)
             {
-                const int peak = data[i].getPeak();
+                const int peak = top.getReference (i).getPeak();
                 if (peak > peakLevel)
                     peakLevel = peak;
             }
@@ -344,13 +573,41 @@ public:
 
 private:
     Array <MinMaxValue> data;
+    OwnedArray <Array <MinMaxValue> > levels;
     int peakLevel;
 
+    enum { levelScale = 4 };
+
+    static inline void accumulate (const MinMaxValue& v, char& mn, char& mx) noexcept
+    {
+        if (v.getMinValue() < mn)  mn = v.getMinValue();
+        if (v.getMaxValue() > mx)  mx = v.getMaxValue();
+    }
+
     void ensureSize (const int thumbSamples)
     {
-        const int extraNeeded = thumbSamples - data.size();
+        const int oldSize = data.size();
+        const int extraNeeded = thumbSamples - oldSize;
+
         if (extraNeeded > 0)
+        {
             data.insertMultiple (-1, MinMaxValue(), extraNeeded);
+
+            int levelSize = thumbSamples;
+
+            for (int i = 0; levelSize > levelScale; ++i)
+            {
+                levelSize = (levelSize + levelScale - 1) / levelScale;
+
+                if (i >= levels.size())
+                    levels.add (new Array<MinMaxValue>());
+
+                Array<MinMaxValue>& level = *levels.getUnchecked (i);
+                level.insertMultiple (-1, MinMaxValue(), levelSize - level.size());
+            }
+
+            updateLevels (jmax (0, oldSize - 1), thumbSamples - jmax (0, oldSize - 1));
+        }
     }
 };
 
@@ -595,6 +852,8 @@ void AudioThumbnail::loadFrom (InputStream& rawInput)
     for (int i = 0; i < numThumbnailSamples; ++i)
         for (int chan = 0; chan < numChannels; ++chan)
             channels.getUnchecked(chan)->getData(i)->read (input);
+    for (int chan = 0; chan < numChannels; ++chan)
+        channels.getUnchecked(chan)->updateLevels (0, numThumbnailSamples);
 }
 
 void AudioThumbnail::saveTo (OutputStream& output) const
@@ -625,7 +884,7 @@ bool AudioThumbnail::setDataSource (LevelDataSource* newSource)
 
     numSamplesFinished = 0;
 
-    if (cache.loadThumb (*this, newSource->hashCode) && isFullyLoaded())
+    if (cache.loadThumb (*this, newSource->hashCode, newSource->sourceStamp) && isFullyLoaded())
     {
         source = newSource; // (make sure this isn't done before loadThumb is called)
 
@@ -796,3 +1055,132 @@ void AudioThumbnail::drawChannels (Graphics& g, const Rectangle<int>& area, doub
                      startTimeSeconds, endTimeSeconds, i, verticalZoomFactor);
     }
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioThumbnailTests  : public UnitTest
+{
+public:
+    AudioThumbnailTests() : UnitTest ("AudioThumbnail") {}
+
+    // Supplies a WAV file, but only the first few times it's asked for one
+    class UnreliableSource  : public InputSource
+    {
+    public:
+        UnreliableSource (const MemoryBlock& data_, const int numSuccessfulOpens)
+            : data (data_), opensRemaining (numSuccessfulOpens)
+        {
+        }
+
+        InputStream* createInputStream()
+        {
+            return --opensRemaining >= 0 ? new MemoryInputStream (data, false) : nullptr;
+        }
+
+        InputStream* createInputStreamFor (const String&)      { return nullptr; }
+        int64 hashCode() const                                  { return 0x1234567; }
+
+    private:
+        const MemoryBlock& data;
+        Atomic<int> opensRemaining;
+    };
+
+    void runTest()
+    {
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        AudioThumbnailCache cache (4);
+        Random r (1234);
+
+        beginTest ("Summary levels");
+
+        {
+            // with a sample rate equal to the thumbnail's resolution, each second is one thumbnail sample
+            const int samplesPerThumbSample = 64;
+            const int numThumbSamples = 5000;
+            const int numSamples = samplesPerThumbSample * numThumbSamples;
+
+            AudioThumbnail thumb (samplesPerThumbSample, formatManager, cache);
+            thumb.reset (1, (double) samplesPerThumbSample, numSamples);
+
+            AudioSampleBuffer buffer (1, numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+                *buffer.getSampleData (0, i) = r.nextFloat() * r.nextFloat() * (r.nextBool() ? 1.0f : -1.0f);
+
+            for (int pos = 0; pos < numSamples;)
+            {
+                const int num = jmin (numSamples - pos, 1 + r.nextInt (10000));
+                thumb.addBlock (pos, buffer, pos, num);
+                pos += num;
+            }
+
+            // overwriting part of it must update the coarser levels too
+            buffer.applyGain (1000 * samplesPerThumbSample, 300 * samplesPerThumbSample, 0.1f);
+            thumb.addBlock (1000 * samplesPerThumbSample, buffer, 1000 * samplesPerThumbSample, 300 * samplesPerThumbSample);
+
+            HeapBlock<float> mins ((size_t) numThumbSamples), maxes ((size_t) numThumbSamples);
+
+            for (int i = 0; i < numThumbSamples; ++i)
+                thumb.getApproximateMinMax (i, i, 0, mins[i], maxes[i]);
+
+            int numMismatches = 0;
+
+            for (int i = 0; i < 1000; ++i)
+            {
+                const int start = r.nextInt (numThumbSamples);
+                const int end = start + r.nextInt (numThumbSamples - start);
+
+                float expectedMin = mins[start], expectedMax = maxes[start];
+
+                for (int j = start + 1; j <= end; ++j)
+                {
+                    expectedMin = jmin (expectedMin, mins[j]);
+                    expectedMax = jmax (expectedMax, maxes[j]);
+                }
+
+                float mn, mx;
+                thumb.getApproximateMinMax (start, end, 0, mn, mx);
+
+                if (mn != expectedMin || mx != expectedMax)
+                    ++numMismatches;
+            }
+
+            expectEquals (numMismatches, 0);
+        }
+
+        beginTest ("Source that stops opening");
+
+        {
+            MemoryBlock wavData;
+
+            {
+                AudioSampleBuffer buffer (1, 44100);
+                buffer.clear();
+
+                WavAudioFormat wav;
+                ScopedPointer<AudioFormatWriter> writer (wav.createWriterFor (new MemoryOutputStream (wavData, false),
+                                                                              44100.0, 1, 16, StringPairArray(), 0));
+                writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+            }
+
+            // the thumbnail opens the source to check its length and to create its reader,
+            // but the scanning job's attempt to open it fails
+            AudioThumbnail thumb (512, formatManager, cache);
+            expect (thumb.setSource (new UnreliableSource (wavData, 2)));
+
+            // the source must stop asking for time-slices once its reader has timed out,
+            // rather than waiting forever for the missing section
+            for (int i = 0; i < 100 && cache.getTimeSliceThread().getNumClients() > 0; ++i)
+                Thread::sleep (100);
+
+            expectEquals (cache.getTimeSliceThread().getNumClients(), 0);
+            expect (! thumb.isFullyLoaded());
+        }
+    }
+};
+
+static AudioThumbnailTests audioThumbnailTests;
+
+#endif
@@ -56,12 +56,16 @@ private:
 };
 
 //==============================================================================
-AudioThumbnailCache::AudioThumbnailCache (const int maxNumThumbsToStore_)
+AudioThumbnailCache::AudioThumbnailCache (const int maxNumThumbsToStore_, const int numScanningThreads)
     : thread ("thumb cache"),
-      maxNumThumbsToStore (maxNumThumbsToStore_)
+      pool (numScanningThreads > 0 ? numScanningThreads : SystemStats::getNumCpus()),
+      maxNumThumbsToStore (maxNumThumbsToStore_),
+      maxBytesOnDisk (0),
+      bytesOnDisk (0)
 {
     jassert (maxNumThumbsToStore > 0);
     thread.startThread (2);
+    pool.setThreadPriorities (2);
 }
 
 AudioThumbnailCache::~AudioThumbnailCache()
@@ -96,40 +100,61 @@ int AudioThumbnailCache::findOldestThumb() const
     return oldest;
 }
 
-bool AudioThumbnailCache::loadThumb (AudioThumbnailBase& thumb, const int64 hashCode)
+AudioThumbnailCache::ThumbnailCacheEntry* AudioThumbnailCache::createThumbFor (const int64 hash)
 {
-    const ScopedLock sl (lock);
+    ThumbnailCacheEntry* const te = new ThumbnailCacheEntry (hash);
+
+    if (thumbs.size() < maxNumThumbsToStore)
+        thumbs.add (te);
+    else
+        thumbs.set (findOldestThumb(), te);
+
+    return te;
+}
 
-    if (ThumbnailCacheEntry* te = findThumbFor (hashCode))
+bool AudioThumbnailCache::loadThumb (AudioThumbnailBase& thumb, const int64 hashCode, const int64 sourceStamp)
+{
     {
-        te->lastUsed = Time::getMillisecondCounter();
+        const ScopedLock sl (lock);
 
-        MemoryInputStream in (te->data, false);
-        thumb.loadFrom (in);
-        return true;
+        if (ThumbnailCacheEntry* te = findThumbFor (hashCode))
+        {
+            te->lastUsed = Time::getMillisecondCounter();
+
+            MemoryInputStream in (te->data, false);
+            thumb.loadFrom (in);
+            return true;
+        }
     }
 
-    return false;
+    return loadThumbFromDisk (thumb, hashCode, sourceStamp);
 }
 
 void AudioThumbnailCache::storeThumb (const AudioThumbnailBase& thumb,
-                                      const int64 hashCode)
+                                      const int64 hashCode,
+                                      const int64 sourceStamp)
 {
-    const ScopedLock sl (lock);
-    ThumbnailCacheEntry* te = findThumbFor (hashCode);
+    MemoryBlock dataForDisk;
 
-    if (te == nullptr)
     {
-        te = new ThumbnailCacheEntry (hashCode);
+        const ScopedLock sl (lock);
+        ThumbnailCacheEntry* te = findThumbFor (hashCode);
 
-        if (thumbs.size() < maxNumThumbsToStore)
-            thumbs.add (te);
-        else
-            thumbs.set (findOldestThumb(), te);
+        if (te == nullptr)
+            te = createThumbFor (hashCode);
+
+        {
+            MemoryOutputStream out (te->data, false);
+            thumb.saveTo (out);
+        }
+
+        if (getDiskCacheDirectory() != File::nonexistent)
+            dataForDisk = te->data;
     }
 
-    MemoryOutputStream out (te->data, false);
-    thumb.saveTo (out);
+    // (the file is written outside the lock, so that other thumbnails aren't held up by the disk)
+    if (dataForDisk.getSize() > 0)
+        saveThumbToDisk (hashCode, sourceStamp, dataForDisk);
 }
 
 void AudioThumbnailCache::clear()
@@ -168,3 +193,363 @@ void AudioThumbnailCache::writeToStream (OutputStream& out)
     for (int i = 0; i < thumbs.size(); ++i)
         thumbs.getUnchecked(i)->write (out);
 }
+
+//==============================================================================
+namespace ThumbnailDiskCacheHelpers
+{
+    static const char* const fileSuffix = ".thumb";
+
+    // This must be incremented whenever the format of the data written by
+    // AudioThumbnail::saveTo() changes, so that old files get thrown away.
+    enum { formatVersion = 2 };
+
+    // the magic number, version, hash and source stamp
+    enum { headerSize = 4 + 4 + 8 + 8 };
+
+    static inline int getMagicHeader() noexcept
+    {
+        return (int) ByteOrder::littleEndianInt ("ThmD");
+    }
+
+    // File times may only be stored to the nearest second, so the usage times are all
+    // rounded the same way, otherwise a file that had just been touched could look older
+    // than one that was written a moment before it.
+    static int64 roundToSeconds (const Time& t) noexcept
+    {
+        return t.toMilliseconds() - t.toMilliseconds() % 1000;
+    }
+}
+
+void AudioThumbnailCache::setDiskCacheDirectory (const File& directory, const int64 maxBytes)
+{
+    const ScopedLock sl (diskLock);
+
+    diskCacheDirectory = directory;
+    maxBytesOnDisk = jmax ((int64) 0, maxBytes);
+    diskEntries.clear();
+    bytesOnDisk = 0;
+
+    if (directory != File::nonexistent)
+    {
+        directory.createDirectory();
+
+        Array<File> files;
+        directory.findChildFiles (files, File::findFiles, false, String ("*") + ThumbnailDiskCacheHelpers::fileSuffix);
+
+        for (int i = 0; i < files.size(); ++i)
+        {
+            const File& f = files.getReference (i);
+
+            DiskCacheEntry entry;
+            entry.hash = f.getFileNameWithoutExtension().getHexValue64();
+            entry.size = f.getSize();
+            entry.lastUsed = ThumbnailDiskCacheHelpers::roundToSeconds (f.getLastModificationTime());
+
+            diskEntries.add (entry);
+            bytesOnDisk += entry.size;
+        }
+
+        trimDiskCache();
+    }
+}
+
+File AudioThumbnailCache::getDiskCacheDirectory() const
+{
+    const ScopedLock sl (diskLock);
+    return diskCacheDirectory;
+}
+
+int64 AudioThumbnailCache::getDiskCacheSize() const
+{
+    const ScopedLock sl (diskLock);
+    return bytesOnDisk;
+}
+
+void AudioThumbnailCache::clearDiskCache()
+{
+    const ScopedLock sl (diskLock);
+
+    for (int i = diskEntries.size(); --i >= 0;)
+        getDiskCacheFileFor (diskEntries.getReference(i).hash).deleteFile();
+
+    diskEntries.clear();
+    bytesOnDisk = 0;
+}
+
+int AudioThumbnailCache::findDiskEntryFor (const int64 hash) const
+{
+    for (int i = diskEntries.size(); --i >= 0;)
+        if (diskEntries.getReference(i).hash == hash)
+            return i;
+
+    return -1;
+}
+
+File AudioThumbnailCache::getDiskCacheFileFor (const int64 hash) const
+{
+    return diskCacheDirectory.getChildFile (String::toHexString (hash) + ThumbnailDiskCacheHelpers::fileSuffix);
+}
+
+bool AudioThumbnailCache::loadThumbFromDisk (AudioThumbnailBase& thumb, const int64 hash, const int64 sourceStamp)
+{
+    MemoryBlock data;
+
+    {
+        const ScopedLock sl (diskLock);
+
+        const int index = findDiskEntryFor (hash);
+
+        if (index < 0)
+            return false;
+
+        const File file (getDiskCacheFileFor (hash));
+
+        {
+            const MemoryMappedFile mappedFile (file, MemoryMappedFile::readOnly);
+
+            if (mappedFile.getData() != nullptr)
+            {
+                MemoryInputStream in (mappedFile.getData(), mappedFile.getSize(), false);
+
+                if (in.readInt() == ThumbnailDiskCacheHelpers::getMagicHeader()
+                     && in.readInt() == ThumbnailDiskCacheHelpers::formatVersion
+                     && in.readInt64() == hash
+                     && in.readInt64() == sourceStamp)
+                {
+                    data.append (addBytesToPointer (mappedFile.getData(), (int) ThumbnailDiskCacheHelpers::headerSize),
+                                 mappedFile.getSize() - ThumbnailDiskCacheHelpers::headerSize);
+                }
+            }
+        }
+
+        if (data.getSize() == 0)
+        {
+            // if the file is missing, unreadable or out-of-date, get rid of it
+            file.deleteFile();
+            bytesOnDisk -= diskEntries.getReference (index).size;
+            diskEntries.remove (index);
+            return false;
+        }
+
+        // the file's modification time is used to remember the LRU order between sessions
+        DiskCacheEntry& entry = diskEntries.getReference (index);
+        entry.lastUsed = ThumbnailDiskCacheHelpers::roundToSeconds (Time::getCurrentTime());
+        file.setLastModificationTime (Time (entry.lastUsed));
+    }
+
+    {
+        MemoryInputStream in (data, false);
+        thumb.loadFrom (in);
+    }
+
+    // put it back in the memory cache, so that it doesn't need to be read again
+    const ScopedLock sl (lock);
+
+    ThumbnailCacheEntry* te = findThumbFor (hash);
+
+    if (te == nullptr)
+        te = createThumbFor (hash);
+
+    te->data.swapWith (data);
+    te->lastUsed = Time::getMillisecondCounter();
+    return true;
+}
+
+void AudioThumbnailCache::saveThumbToDisk (const int64 hash, const int64 sourceStamp, const MemoryBlock& data)
+{
+    File file;
+
+    {
+        const ScopedLock sl (diskLock);
+        file = getDiskCacheFileFor (hash);
+    }
+
+    if (! file.getParentDirectory().isDirectory())
+        return;
+
+    // The file is written to a temporary and then moved into place, so a thumbnail that's
+    // being read by another thread (or an app that crashed half-way through) can't see a partial file.
+    TemporaryFile temp (file);
+
+    {
+        FileOutputStream out (temp.getFile());
+
+        if (out.failedToOpen())
+            return;
+
+        out.writeInt (ThumbnailDiskCacheHelpers::getMagicHeader());
+        out.writeInt (ThumbnailDiskCacheHelpers::formatVersion);
+        out.writeInt64 (hash);
+        out.writeInt64 (sourceStamp);
+        out << data;
+    }
+
+    const ScopedLock sl (diskLock);
+
+    if (file.getParentDirectory() != diskCacheDirectory || ! temp.overwriteTargetFileWithTemporary())
+        return;
+
+    const int index = findDiskEntryFor (hash);
+
+    if (index >= 0)
+    {
+        bytesOnDisk -= diskEntries.getReference (index).size;
+        diskEntries.remove (index);
+    }
+
+    DiskCacheEntry entry;
+    entry.hash = hash;
+    entry.size = file.getSize();
+    entry.lastUsed = ThumbnailDiskCacheHelpers::roundToSeconds (Time::getCurrentTime());
+
+    diskEntries.add (entry);
+    bytesOnDisk += entry.size;
+
+    trimDiskCache();
+}
+
+void AudioThumbnailCache::trimDiskCache()
+{
+    while (bytesOnDisk > maxBytesOnDisk && diskEntries.size() > 0)
+    {
+        int oldest = 0;
+
+        for (int i = diskEntries.size(); --i > 0;)
+            if (diskEntries.getReference(i).lastUsed < diskEntries.getReference (oldest).lastUsed)
+                oldest = i;
+
+        getDiskCacheFileFor (diskEntries.getReference (oldest).hash).deleteFile();
+        bytesOnDisk -= diskEntries.getReference (oldest).size;
+        diskEntries.remove (oldest);
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioThumbnailCacheTests  : public UnitTest
+{
+public:
+    AudioThumbnailCacheTests() : UnitTest ("AudioThumbnailCache") {}
+
+    // A thumbnail that just stores a block of data
+    class TestThumb  : public AudioThumbnailBase
+    {
+    public:
+        TestThumb() {}
+        TestThumb (const int size, const int seed)     { setData (size, seed); }
+
+        void setData (const int size, const int seed)
+        {
+            data.setSize ((size_t) size);
+
+            for (int i = 0; i < size; ++i)
+                static_cast <char*> (data.getData())[i] = (char) (i * seed);
+        }
+
+        void clear()                                            { data.setSize (0); }
+        bool setSource (InputSource* newSource)                 { delete newSource; return false; }
+        void setReader (AudioFormatReader* newReader, int64)    { delete newReader; }
+        void loadFrom (InputStream& input)                      { data.setSize (0); input.readIntoMemoryBlock (data); }
+        void saveTo (OutputStream& output) const                { output << data; }
+        int getNumChannels() const noexcept                     { return 1; }
+        double getTotalLength() const noexcept                  { return 0; }
+        void drawChannel (Graphics&, const Rectangle<int>&, double, double, int, float)  {}
+        void drawChannels (Graphics&, const Rectangle<int>&, double, double, float)      {}
+        bool isFullyLoaded() const noexcept                     { return true; }
+        int64 getNumSamplesFinished() const noexcept            { return 0; }
+        float getApproximatePeak() const                        { return 0; }
+        void getApproximateMinMax (double, double, int, float&, float&) const noexcept  {}
+        int64 getHashCode() const                               { return 0; }
+        void reset (int, double, int64)                         {}
+        void addBlock (int64, const AudioSampleBuffer&, int, int)  {}
+
+        MemoryBlock data;
+    };
+
+    void runTest()
+    {
+        const File dir (File::createTempFile ("thumbs"));
+
+        beginTest ("Disk cache round-trip");
+
+        {
+            AudioThumbnailCache cache (4);
+            cache.setDiskCacheDirectory (dir);
+            cache.storeThumb (TestThumb (1000, 3), 1234, 5678);
+            expect (cache.getDiskCacheSize() > 1000);
+        }
+
+        {
+            // a new cache finds the thumbnail from the previous session..
+            AudioThumbnailCache cache (4);
+            cache.setDiskCacheDirectory (dir);
+
+            TestThumb thumb;
+            expect (cache.loadThumb (thumb, 1234, 5678));
+            expect (thumb.data == TestThumb (1000, 3).data);
+
+            // ..and puts it in memory, so it's still there after the disk copy has gone
+            cache.clearDiskCache();
+            thumb.clear();
+            expect (cache.loadThumb (thumb, 1234, 5678));
+            expect (thumb.data == TestThumb (1000, 3).data);
+        }
+
+        beginTest ("Out-of-date thumbnails");
+
+        {
+            AudioThumbnailCache cache (4);
+            cache.setDiskCacheDirectory (dir);
+            cache.storeThumb (TestThumb (1000, 3), 1234, 5678);
+        }
+
+        {
+            // if the source's stamp has changed, the stale copy is deleted rather than used
+            AudioThumbnailCache cache (4);
+            cache.setDiskCacheDirectory (dir);
+
+            TestThumb thumb;
+            expect (! cache.loadThumb (thumb, 1234, 9999));
+            expectEquals (cache.getDiskCacheSize(), (int64) 0);
+            expect (! cache.loadThumb (thumb, 1234, 5678));
+        }
+
+        beginTest ("Disk cache eviction");
+
+        {
+            AudioThumbnailCache cache (4);
+            cache.setDiskCacheDirectory (dir, 3500);
+
+            for (int i = 0; i < 6; ++i)
+                cache.storeThumb (TestThumb (1000, i + 1), i, 0);
+
+            expect (cache.getDiskCacheSize() <= 3500);
+        }
+
+        {
+            // the most recently stored thumbnails are the ones that survive
+            AudioThumbnailCache cache (4);
+            cache.setDiskCacheDirectory (dir, 3500);
+
+            TestThumb thumb;
+
+            for (int i = 0; i < 3; ++i)
+                expect (! cache.loadThumb (thumb, i, 0));
+
+            for (int i = 3; i < 6; ++i)
+            {
+                expect (cache.loadThumb (thumb, i, 0));
+                expect (thumb.data == TestThumb (1000, i + 1).data);
+            }
+
+            cache.clearDiskCache();
+        }
+
+        dir.deleteRecursively();
+    }
+};
+
+static AudioThumbnailCacheTests audioThumbnailCacheTests;
+
+#endif
@@ -37,6 +37,9 @@
     that need it, and it maintains a set of low-res previews in memory, to avoid
     having to re-scan audio files too often.
 
+    It can also keep a copy of each preview on disk (see setDiskCacheDirectory()),
+    so that files which were seen in an earlier session don't need re-scanning.
+
     @see AudioThumbnail
 */
 class JUCE_API  AudioThumbnailCache
@@ -47,8 +50,13 @@ public:
 
         The maxNumThumbsToStore parameter lets you specify how many previews should
         be kept in memory at once.
+
+        The numScanningThreads parameter sets the number of threads in the pool that
+        thumbnails use to scan their audio files. Each file is divided into sections
+        which are scanned in parallel, and several files can be scanned at once. If
+        this is zero or less, the pool will have one thread per CPU core.
     */
-    explicit AudioThumbnailCache (int maxNumThumbsToStore);
+    explicit AudioThumbnailCache (int maxNumThumbsToStore, int numScanningThreads = 0);
 
     /** Destructor. */
     ~AudioThumbnailCache();
@@ -61,17 +69,23 @@ public:
     /** Reloads the specified thumb if this cache contains the appropriate stored
         data.
 
+        The sourceStamp identifies the version of the source's data (the AudioThumbnail
+        class uses its size and modification time). A thumbnail in the disk cache whose
+        stamp doesn't match is out-of-date, so it's deleted rather than loaded.
+
         This is called automatically by the AudioThumbnail class, so you shouldn't
         normally need to call it directly.
     */
-    bool loadThumb (AudioThumbnailBase& thumb, int64 hashCode);
+    bool loadThumb (AudioThumbnailBase& thumb, int64 hashCode, int64 sourceStamp = 0);
 
     /** Stores the cachable data from the specified thumb in this cache.
 
         This is called automatically by the AudioThumbnail class, so you shouldn't
         normally need to call it directly.
+
+        @see loadThumb
     */
-    void storeThumb (const AudioThumbnailBase& thumb, int64 hashCode);
+    void storeThumb (const AudioThumbnailBase& thumb, int64 hashCode, int64 sourceStamp = 0);
 
     //==============================================================================
     /** Attempts to re-load a saved cache of thumbnails from a stream.
@@ -85,12 +99,45 @@ public:
     */
     void writeToStream (OutputStream& stream);
 
+    //==============================================================================
+    /** Makes the cache keep a copy of each thumbnail in a directory on disk.
+
+        Every thumbnail that gets stored is also written to its own small file in this
+        directory, and loadThumb() will fall back to these files when a thumbnail isn't
+        in memory, so previews of files that were scanned in a previous session can
+        be drawn straight away. A thumbnail that's found on disk is also put back into
+        the memory cache.
+
+        The files are named by the thumbnail's hash code, and each one also records the
+        stamp that was passed to storeThumb(). For an AudioThumbnail that's reading from
+        a file, this is made from the file's size and modification time, so editing an
+        audio file will cause it to be re-scanned. If you use AudioThumbnail::setReader(),
+        there's no stamp, so the hash code you supply must change when the data does.
+
+        When the files take up more than maxBytesOnDisk, the least recently used ones
+        are deleted. Pass File::nonexistent to stop using the disk.
+    */
+    void setDiskCacheDirectory (const File& directory, int64 maxBytesOnDisk = 256 * 1024 * 1024);
+
+    /** Returns the directory set by setDiskCacheDirectory(). */
+    File getDiskCacheDirectory() const;
+
+    /** Returns the number of bytes currently used by the files in the disk cache. */
+    int64 getDiskCacheSize() const;
+
+    /** Deletes all the thumbnail files from the disk cache directory. */
+    void clearDiskCache();
+
     /** Returns the thread that client thumbnails can use. */
     TimeSliceThread& getTimeSliceThread() noexcept      { return thread; }
 
+    /** Returns the thread pool that client thumbnails use to scan their files. */
+    ThreadPool& getThreadPool() noexcept                { return pool; }
+
 private:
     //==============================================================================
     TimeSliceThread thread;
+    ThreadPool pool;
 
     class ThumbnailCacheEntry;
     friend class OwnedArray<ThumbnailCacheEntry>;
@@ -98,8 +145,25 @@ private:
     CriticalSection lock;
     int maxNumThumbsToStore;
 
+    struct DiskCacheEntry
+    {
+        int64 hash, size;
+        int64 lastUsed;     // (in milliseconds, rounded to the nearest second below)
+    };
+
+    Array<DiskCacheEntry> diskEntries;
+    CriticalSection diskLock;
+    File diskCacheDirectory;
+    int64 maxBytesOnDisk, bytesOnDisk;
+
     ThumbnailCacheEntry* findThumbFor (int64 hash) const;
+    ThumbnailCacheEntry* createThumbFor (int64 hash);
     int findOldestThumb() const;
+    int findDiskEntryFor (int64 hash) const;
+    File getDiskCacheFileFor (int64 hash) const;
+    bool loadThumbFromDisk (AudioThumbnailBase&, int64 hash, int64 sourceStamp);
+    void saveThumbToDisk (int64 hash, int64 sourceStamp, const MemoryBlock& data);
+    void trimDiskCache();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioThumbnailCache)
 };
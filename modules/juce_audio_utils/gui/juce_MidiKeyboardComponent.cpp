@@ -98,6 +98,7 @@ MidiKeyboardComponent::MidiKeyboardComponent (MidiKeyboardState& state_,
     setWantsKeyboardFocus (true);
 
     state.addListener (this);
+    state.startDeferringNotifications();
 
     startTimer (1000 / 20);
 }
@@ -105,6 +106,7 @@ MidiKeyboardComponent::MidiKeyboardComponent (MidiKeyboardState& state_,
 MidiKeyboardComponent::~MidiKeyboardComponent()
 {
     state.removeListener (this);
+    state.stopDeferringNotifications();
 }
 
 //==============================================================================
@@ -803,6 +805,8 @@ void MidiKeyboardComponent::mouseWheelMove (const MouseEvent&, const MouseWheelD
 
 void MidiKeyboardComponent::timerCallback()
 {
+    state.dispatchPendingNotifications();
+
     if (shouldCheckState)
     {
         shouldCheckState = false;
@@ -39,6 +39,12 @@
 #include "../juce_core/native/juce_BasicNativeHeaders.h"
 #include "juce_audio_utils.h"
 
+#if JUCE_USE_SSE2_INTRINSICS
+ #include <emmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
 namespace juce
 {
 
@@ -48,6 +54,7 @@ namespace juce
 #include "gui/juce_AudioThumbnailCache.cpp"
 #include "gui/juce_MidiKeyboardComponent.cpp"
 #include "players/juce_AudioProcessorPlayer.cpp"
+#include "players/juce_AudioProcessorRenderer.cpp"
 // END_AUTOINCLUDE
 
 }
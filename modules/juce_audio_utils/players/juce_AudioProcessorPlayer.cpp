@@ -30,7 +30,10 @@ AudioProcessorPlayer::AudioProcessorPlayer()
       isPrepared (false),
       numInputChans (0),
       numOutputChans (0),
-      tempBuffer (1, 1)
+      tempBuffer (1, 1),
+      fixedBlockSize (0),
+      fifoPosition (0),
+      fifoBuffer (1, 1)
 {
 }
 
@@ -47,9 +50,9 @@ void AudioProcessorPlayer::setProcessor (AudioProcessor* const processorToPlay)
         if (processorToPlay != nullptr && sampleRate > 0 && blockSize > 0)
         {
             processorToPlay->setPlayConfigDetails (numInputChans, numOutputChans,
-                                                   sampleRate, blockSize);
+                                                   sampleRate, getProcessorBlockSize());
 
-            processorToPlay->prepareToPlay (sampleRate, blockSize);
+            processorToPlay->prepareToPlay (sampleRate, getProcessorBlockSize());
         }
 
         AudioProcessor* oldOne;
@@ -66,6 +69,26 @@ void AudioProcessorPlayer::setProcessor (AudioProcessor* const processorToPlay)
     }
 }
 
+void AudioProcessorPlayer::setFixedBlockSize (const int blockSizeToUse)
+{
+    jassert (blockSizeToUse >= 0);
+
+    const ScopedLock sl (lock);
+
+    if (fixedBlockSize != blockSizeToUse)
+    {
+        fixedBlockSize = jmax (0, blockSizeToUse);
+
+        if (sampleRate > 0 && blockSize > 0)
+            prepareToPlay (sampleRate, blockSize, numInputChans, numOutputChans);
+    }
+}
+
+int AudioProcessorPlayer::getProcessorBlockSize() const noexcept
+{
+    return fixedBlockSize > 0 ? fixedBlockSize : blockSize;
+}
+
 //==============================================================================
 void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChannelData,
                                                   const int numInputChannels,
@@ -78,6 +101,67 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
 
     incomingMidi.clear();
     messageCollector.removeNextBlockOfMessages (incomingMidi, numSamples);
+
+    {
+        // The audio thread mustn't wait for the message thread, so if the processor
+        // is being changed or re-prepared at this moment, the block is just skipped.
+        const ScopedTryLock sl (lock);
+
+        if (sl.isLocked() && processor != nullptr)
+        {
+            if (fixedBlockSize > 0)
+                processInFixedSizeBlocks (inputChannelData, numInputChannels,
+                                          outputChannelData, numOutputChannels, numSamples);
+            else
+                processInDeviceSizedBlocks (inputChannelData, numInputChannels,
+                                            outputChannelData, numOutputChannels, numSamples);
+
+            return;
+        }
+    }
+
+    for (int i = 0; i < numOutputChannels; ++i)
+        zeromem (outputChannelData[i], sizeof (float) * (size_t) numSamples);
+}
+
+void AudioProcessorPlayer::processInDeviceSizedBlocks (const float** const inputChannelData,
+                                                       const int numInputChannels,
+                                                       float** const outputChannelData,
+                                                       const int numOutputChannels,
+                                                       const int numSamples)
+{
+    // Some devices occasionally deliver more samples than the buffer size they reported,
+    // so anything bigger than the size that the processor was prepared for gets split up,
+    // rather than having to reallocate the temporary buffer on the audio thread.
+    const int maxBlockSize = jmax (1, blockSize);
+
+    if (numSamples <= maxBlockSize)
+    {
+        processDeviceBlock (inputChannelData, numInputChannels, outputChannelData, numOutputChannels,
+                            0, numSamples, incomingMidi);
+        return;
+    }
+
+    for (int pos = 0; pos < numSamples; pos += maxBlockSize)
+    {
+        const int num = jmin (numSamples - pos, maxBlockSize);
+
+        chunkMidi.clear();
+        chunkMidi.addEvents (incomingMidi, pos, num, -pos);
+
+        processDeviceBlock (inputChannelData, numInputChannels, outputChannelData, numOutputChannels,
+                            pos, num, chunkMidi);
+    }
+}
+
+void AudioProcessorPlayer::processDeviceBlock (const float** const inputChannelData,
+                                               const int numInputChannels,
+                                               float** const outputChannelData,
+                                               const int numOutputChannels,
+                                               const int startSample,
+                                               const int numSamples,
+                                               MidiBuffer& midiMessages)
+{
     int totalNumChans = 0;
 
     if (numInputChannels > numOutputChannels)
@@ -90,15 +174,15 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
 
         for (int i = 0; i < numOutputChannels; ++i)
         {
-            channels[totalNumChans] = outputChannelData[i];
-            memcpy (channels[totalNumChans], inputChannelData[i], sizeof (float) * (size_t) numSamples);
+            channels[totalNumChans] = outputChannelData[i] + startSample;
+            memcpy (channels[totalNumChans], inputChannelData[i] + startSample, sizeof (float) * (size_t) numSamples);
             ++totalNumChans;
         }
 
         for (int i = numOutputChannels; i < numInputChannels; ++i)
         {
             channels[totalNumChans] = tempBuffer.getSampleData (i - numOutputChannels, 0);
-            memcpy (channels[totalNumChans], inputChannelData[i], sizeof (float) * (size_t) numSamples);
+            memcpy (channels[totalNumChans], inputChannelData[i] + startSample, sizeof (float) * (size_t) numSamples);
             ++totalNumChans;
         }
     }
@@ -106,39 +190,84 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
     {
         for (int i = 0; i < numInputChannels; ++i)
         {
-            channels[totalNumChans] = outputChannelData[i];
-            memcpy (channels[totalNumChans], inputChannelData[i], sizeof (float) * (size_t) numSamples);
+            channels[totalNumChans] = outputChannelData[i] + startSample;
+            memcpy (channels[totalNumChans], inputChannelData[i] + startSample, sizeof (float) * (size_t) numSamples);
             ++totalNumChans;
         }
 
         for (int i = numInputChannels; i < numOutputChannels; ++i)
         {
-            channels[totalNumChans] = outputChannelData[i];
+            channels[totalNumChans] = outputChannelData[i] + startSample;
             zeromem (channels[totalNumChans], sizeof (float) * (size_t) numSamples);
             ++totalNumChans;
         }
     }
 
     AudioSampleBuffer buffer (channels, totalNumChans, numSamples);
+    callProcessor (buffer, midiMessages);
+}
 
-    const ScopedLock sl (lock);
+void AudioProcessorPlayer::processInFixedSizeBlocks (const float** const inputChannelData,
+                                                     const int numInputChannels,
+                                                     float** const outputChannelData,
+                                                     const int numOutputChannels,
+                                                     const int numSamples)
+{
+    // The fifo holds the processor's output from its last block. As each sample of that
+    // is played, it gets replaced by the next input sample, so when the fifo is full
+    // again it can be processed in-place, and the signal is delayed by exactly one block.
+    const int numFifoChans = fifoBuffer.getNumChannels();
+    int pos = 0;
 
-    if (processor != nullptr)
+    while (pos < numSamples)
     {
-        const ScopedLock sl2 (processor->getCallbackLock());
+        const int num = jmin (numSamples - pos, fixedBlockSize - fifoPosition);
 
-        if (processor->isSuspended())
+        for (int i = 0; i < numOutputChannels; ++i)
         {
-            for (int i = 0; i < numOutputChannels; ++i)
-                zeromem (outputChannelData[i], sizeof (float) * (size_t) numSamples);
+            if (i < numFifoChans)
+                memcpy (outputChannelData[i] + pos, fifoBuffer.getSampleData (i, fifoPosition), sizeof (float) * (size_t) num);
+            else
+                zeromem (outputChannelData[i] + pos, sizeof (float) * (size_t) num);
         }
-        else
+
+        for (int i = 0; i < numFifoChans; ++i)
         {
-            processor->processBlock (buffer, incomingMidi);
+            if (i < numInputChannels)
+                memcpy (fifoBuffer.getSampleData (i, fifoPosition), inputChannelData[i] + pos, sizeof (float) * (size_t) num);
+            else
+                zeromem (fifoBuffer.getSampleData (i, fifoPosition), sizeof (float) * (size_t) num);
+        }
+
+        fifoMidi.addEvents (incomingMidi, pos, num, fifoPosition - pos);
+
+        pos += num;
+        fifoPosition += num;
+
+        if (fifoPosition >= fixedBlockSize)
+        {
+            callProcessor (fifoBuffer, fifoMidi);
+            fifoMidi.clear();
+            fifoPosition = 0;
         }
     }
 }
 
+void AudioProcessorPlayer::callProcessor (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+{
+    const ScopedLock sl (processor->getCallbackLock());
+
+    if (processor->isSuspended())
+    {
+        buffer.clear();
+    }
+    else
+    {
+        processor->applyQueuedParameterChanges();
+        processor->processBlock (buffer, midiMessages);
+    }
+}
+
 void AudioProcessorPlayer::prepareToPlay (double newSampleRate, int newBlockSize,
                                           int numChansIn, int numChansOut)
 {
@@ -152,6 +281,17 @@ void AudioProcessorPlayer::prepareToPlay (double newSampleRate, int newBlockSize
     messageCollector.reset (sampleRate);
     channels.calloc (jmax (numChansIn, numChansOut) + 2);
 
+    // allocate everything the audio callback could need now, so it doesn't have to
+    tempBuffer.setSize (jmax (1, numChansIn), jmax (1, blockSize));
+    incomingMidi.ensureSize (2048);
+    chunkMidi.ensureSize (2048);
+
+    fifoPosition = 0;
+    fifoBuffer.setSize (jmax (1, numChansIn, numChansOut), jmax (1, fixedBlockSize));
+    fifoBuffer.clear();
+    fifoMidi.clear();
+    fifoMidi.ensureSize (2048);
+
     if (processor != nullptr)
     {
         if (isPrepared)
@@ -188,3 +328,130 @@ void AudioProcessorPlayer::handleIncomingMidiMessage (MidiInput*, const MidiMess
 {
     messageCollector.addMessageToQueue (message);
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioProcessorPlayerTests  : public UnitTest
+{
+public:
+    AudioProcessorPlayerTests() : UnitTest ("AudioProcessorPlayer") {}
+
+    // passes its input straight through, and keeps a note of the block sizes it was given
+    class BlockSizeRecorder  : public AudioProcessor
+    {
+    public:
+        BlockSizeRecorder() {}
+
+        const String getName() const                            { return "Block size recorder"; }
+        void prepareToPlay (double, int)                        { blockSizes.clearQuick(); }
+        void releaseResources()                                 {}
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)  { blockSizes.add (buffer.getNumSamples()); }
+
+        const String getInputChannelName (int) const            { return String::empty; }
+        const String getOutputChannelName (int) const           { return String::empty; }
+        bool isInputChannelStereoPair (int) const               { return false; }
+        bool isOutputChannelStereoPair (int) const              { return false; }
+        bool silenceInProducesSilenceOut() const                { return true; }
+        bool acceptsMidi() const                                { return false; }
+        bool producesMidi() const                               { return false; }
+        AudioProcessorEditor* createEditor()                    { return nullptr; }
+        bool hasEditor() const                                  { return false; }
+        int getNumParameters()                                  { return 0; }
+        const String getParameterName (int)                     { return String::empty; }
+        float getParameter (int)                                { return 0; }
+        const String getParameterText (int)                     { return String::empty; }
+        void setParameter (int, float)                          {}
+        int getNumPrograms()                                    { return 1; }
+        int getCurrentProgram()                                 { return 0; }
+        void setCurrentProgram (int)                            {}
+        const String getProgramName (int)                       { return String::empty; }
+        void changeProgramName (int, const String&)             {}
+        void getStateInformation (juce::MemoryBlock&)           {}
+        void setStateInformation (const void*, int)             {}
+
+        Array<int> blockSizes;
+    };
+
+    // Plays an impulse through the player using a sequence of awkward callback sizes, and
+    // returns the position at which it comes out, or -1 if it doesn't.
+    int playImpulse (AudioProcessorPlayer& player, const int impulsePosition, const int totalLength)
+    {
+        static const int callbackSizes[] = { 37, 1, 100, 13, 64, 129, 7, 200, 50, 3 };
+
+        AudioSampleBuffer input (1, totalLength), output (1, totalLength);
+        input.clear();
+        output.clear();
+        *input.getSampleData (0, impulsePosition) = 1.0f;
+
+        for (int pos = 0, i = 0; pos < totalLength; ++i)
+        {
+            const int num = jmin (totalLength - pos, callbackSizes [i % numElementsInArray (callbackSizes)]);
+            const float* in = input.getSampleData (0, pos);
+            float* out = output.getSampleData (0, pos);
+
+            player.audioDeviceIOCallback (&in, 1, &out, 1, num);
+            pos += num;
+        }
+
+        for (int i = 0; i < totalLength; ++i)
+        {
+            if (*output.getSampleData (0, i) != 0.0f)
+            {
+                expectEquals (*output.getSampleData (0, i), 1.0f);
+                expectEquals (output.getMagnitude (i + 1, totalLength - i - 1), 0.0f);
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    void runTest()
+    {
+        beginTest ("Device-sized blocks");
+
+        {
+            BlockSizeRecorder processor;
+            AudioProcessorPlayer player;
+            player.prepareToPlay (44100.0, 50, 1, 1);
+            player.setProcessor (&processor);
+
+            expectEquals (player.getLatencySamples(), 0);
+            expectEquals (playImpulse (player, 300, 2000), 300);
+
+            // callbacks that are bigger than the prepared size get split up
+            int total = 0;
+
+            for (int i = 0; i < processor.blockSizes.size(); ++i)
+            {
+                expect (processor.blockSizes[i] > 0 && processor.blockSizes[i] <= 50);
+                total += processor.blockSizes[i];
+            }
+
+            expectEquals (total, 2000);
+        }
+
+        beginTest ("Fixed-size blocks");
+
+        {
+            BlockSizeRecorder processor;
+            AudioProcessorPlayer player;
+            player.setFixedBlockSize (64);
+            player.prepareToPlay (44100.0, 50, 1, 1);
+            player.setProcessor (&processor);
+
+            expectEquals (player.getLatencySamples(), 64);
+            expectEquals (playImpulse (player, 300, 2000), 300 + 64);
+
+            expectEquals (processor.blockSizes.size(), 2000 / 64);
+
+            for (int i = 0; i < processor.blockSizes.size(); ++i)
+                expectEquals (processor.blockSizes[i], 64);
+        }
+    }
+};
+
+static AudioProcessorPlayerTests audioProcessorPlayerTests;
+
+#endif
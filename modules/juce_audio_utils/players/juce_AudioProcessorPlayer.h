@@ -39,6 +39,10 @@
     It's also a MidiInputCallback, so you can connect it to both an audio and midi
     input to send both streams through the processor.
 
+    All the buffers it needs are allocated when the device starts, and the audio
+    callback never waits for any lock other than the processor's own callback lock,
+    so it won't allocate memory or block while it's running.
+
     @see AudioProcessor, AudioProcessorGraph
 */
 class JUCE_API  AudioProcessorPlayer    : public AudioIODeviceCallback,
@@ -69,6 +73,33 @@ public:
     */
     MidiMessageCollector& getMidiMessageCollector()                 { return messageCollector; }
 
+    //==============================================================================
+    /** Makes the processor get called with a fixed block size, whatever buffer size
+        the audio device is using.
+
+        When this is enabled, the device's audio is passed through a pre-allocated FIFO,
+        and the processor's processBlock() method is only called when a complete block
+        of blockSizeToUse samples is ready. This lets plugins that work best with a
+        particular block size always get exactly that, at the cost of adding
+        blockSizeToUse samples of latency.
+
+        Pass 0 to turn this off, so that each device callback is passed straight to the
+        processor, which is the default.
+    */
+    void setFixedBlockSize (int blockSizeToUse);
+
+    /** Returns the size that was set with setFixedBlockSize(), or 0 if it's not being used. */
+    int getFixedBlockSize() const noexcept                          { return fixedBlockSize; }
+
+    /** Returns the number of samples by which the player itself delays the audio.
+
+        This is the length of the fixed-size block FIFO, or 0 if setFixedBlockSize() isn't
+        being used. It doesn't include the processor's own latency, so to find the total
+        delay between the device's input and output, add this to the processor's
+        AudioProcessor::getLatencySamples().
+    */
+    int getLatencySamples() const noexcept                          { return fixedBlockSize; }
+
     //==============================================================================
     /** @internal */
     void audioDeviceIOCallback (const float** inputChannelData,
@@ -97,9 +128,19 @@ private:
     HeapBlock<float*> channels;
     AudioSampleBuffer tempBuffer;
 
-    MidiBuffer incomingMidi;
+    int fixedBlockSize, fifoPosition;
+    AudioSampleBuffer fifoBuffer;
+    MidiBuffer fifoMidi;
+
+    MidiBuffer incomingMidi, chunkMidi;
     MidiMessageCollector messageCollector;
 
+    int getProcessorBlockSize() const noexcept;
+    void processInDeviceSizedBlocks (const float**, int, float**, int, int);
+    void processDeviceBlock (const float**, int, float**, int, int, int, MidiBuffer&);
+    void processInFixedSizeBlocks (const float**, int, float**, int, int);
+    void callProcessor (AudioSampleBuffer&, MidiBuffer&);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorPlayer)
 };
 
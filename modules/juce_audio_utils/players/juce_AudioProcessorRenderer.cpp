@@ -0,0 +1,453 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+class AudioProcessorRenderer::StageThread  : public Thread
+{
+public:
+    typedef void (AudioProcessorRenderer::*StageFunction)();
+
+    StageThread (const String& name, AudioProcessorRenderer& owner_, StageFunction stage_)
+        : Thread (name), owner (owner_), stage (stage_)
+    {
+    }
+
+    void run()
+    {
+        (owner.*stage)();
+    }
+
+private:
+    AudioProcessorRenderer& owner;
+    const StageFunction stage;
+
+    JUCE_DECLARE_NON_COPYABLE (StageThread)
+};
+
+//==============================================================================
+namespace RendererHelpers
+{
+    // The number of blocks that can be in flight between the three stages at once.
+    enum { numBlocksInRing = 4 };
+
+    int64 getRenderLength (const int64 numSamplesToRender, const AudioFormatReader* const source) noexcept
+    {
+        if (numSamplesToRender >= 0)
+            return numSamplesToRender;
+
+        return source != nullptr ? source->lengthInSamples : 0;
+    }
+}
+
+AudioProcessorRenderer::AudioProcessorRenderer (AudioProcessor& processor_,
+                                                AudioFormatReader* const source_,
+                                                AudioFormatWriter& destination_,
+                                                const int64 numSamplesToRender,
+                                                const int samplesPerBlock)
+    : Thread ("Processor render"),
+      processor (processor_),
+      source (source_),
+      destination (destination_),
+      totalLength (RendererHelpers::getRenderLength (numSamplesToRender, source_)),
+      blockSize (jmax (1, samplesPerBlock)),
+      numBlocks ((int) ((totalLength + blockSize - 1) / blockSize)),
+      numInputChannels (source_ != nullptr ? (int) source_->numChannels
+                                           : processor_.getNumInputChannels()),
+      writeFailed (false)
+{
+    jassert (destination.getNumChannels() > 0);
+
+    const int numChannels = jmax (1, numInputChannels, destination.getNumChannels());
+
+    for (int i = 0; i < RendererHelpers::numBlocksInRing; ++i)
+        ring.add (new AudioSampleBuffer (numChannels, blockSize));
+
+    midiMessages.ensureSize (2048);
+}
+
+AudioProcessorRenderer::~AudioProcessorRenderer()
+{
+    cancelRendering();
+}
+
+//==============================================================================
+void AudioProcessorRenderer::startRendering()
+{
+    jassert (! isThreadRunning()); // can't start a render while one is already running!
+
+    if (! isThreadRunning())
+    {
+        numBlocksRead = 0;
+        numBlocksProcessed = 0;
+        numBlocksWritten = 0;
+        writeFailed = false;
+
+        blockRead.reset();
+        blockProcessed.reset();
+        blockWritten.reset();
+
+        startThread();
+    }
+}
+
+bool AudioProcessorRenderer::render()
+{
+    startRendering();
+    waitForThreadToExit (-1);
+    return wasSuccessful();
+}
+
+void AudioProcessorRenderer::cancelRendering()
+{
+    signalThreadShouldExit();
+    blockRead.signal();
+    blockProcessed.signal();
+    blockWritten.signal();
+    waitForThreadToExit (-1);
+}
+
+bool AudioProcessorRenderer::isRendering() const
+{
+    return isThreadRunning();
+}
+
+bool AudioProcessorRenderer::waitForRenderToFinish (const int timeOutMilliseconds) const
+{
+    return waitForThreadToExit (timeOutMilliseconds);
+}
+
+int64 AudioProcessorRenderer::getNumSamplesRendered() const noexcept
+{
+    return jmin (totalLength, numBlocksWritten.get() * (int64) blockSize);
+}
+
+double AudioProcessorRenderer::getProgress() const noexcept
+{
+    return totalLength > 0 ? getNumSamplesRendered() / (double) totalLength : 1.0;
+}
+
+bool AudioProcessorRenderer::wasSuccessful() const noexcept
+{
+    return numBlocksWritten.get() == numBlocks && ! writeFailed;
+}
+
+int AudioProcessorRenderer::getBlockLength (const int blockIndex) const noexcept
+{
+    return (int) jmin ((int64) blockSize, totalLength - blockIndex * (int64) blockSize);
+}
+
+AudioSampleBuffer& AudioProcessorRenderer::getRingBlock (const int blockIndex) const noexcept
+{
+    return *ring.getUnchecked (blockIndex % RendererHelpers::numBlocksInRing);
+}
+
+//==============================================================================
+void AudioProcessorRenderer::run()
+{
+    const bool wasNonRealtime = processor.isNonRealtime();
+
+    processor.setPlayConfigDetails (numInputChannels, destination.getNumChannels(),
+                                    destination.getSampleRate(), blockSize);
+    processor.setNonRealtime (true);
+    processor.prepareToPlay (destination.getSampleRate(), blockSize);
+
+    StageThread reader ("Processor render input", *this, &AudioProcessorRenderer::readBlocks);
+    StageThread writer ("Processor render output", *this, &AudioProcessorRenderer::writeBlocks);
+    reader.startThread();
+    writer.startThread();
+
+    processBlocks();
+
+    reader.waitForThreadToExit (-1);
+    writer.waitForThreadToExit (-1);
+
+    processor.releaseResources();
+    processor.setNonRealtime (wasNonRealtime);
+}
+
+// Each of the stages below runs on its own thread, and works its way through the
+// blocks in order. A block is passed from one stage to the next by incrementing that
+// stage's counter and signalling its event, and the reader can't get more than a
+// ring's length ahead of the writer. All the stages use this thread's exit flag, so
+// that cancelling the render stops them all.
+void AudioProcessorRenderer::readBlocks()
+{
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        while (i - numBlocksWritten.get() >= RendererHelpers::numBlocksInRing)
+        {
+            if (threadShouldExit())
+                return;
+
+            blockWritten.wait (100);
+        }
+
+        if (threadShouldExit())
+            return;
+
+        AudioSampleBuffer& block = getRingBlock (i);
+        const int64 startSample = i * (int64) blockSize;
+        const int numSamples = getBlockLength (i);
+
+        block.clear();
+
+        if (source != nullptr && startSample < source->lengthInSamples)
+        {
+            const int numChans = jmin ((int) source->numChannels, block.getNumChannels());
+            source->read (reinterpret_cast<int**> (block.getArrayOfChannels()), numChans,
+                          startSample, numSamples, false);
+
+            if (! source->usesFloatingPointData)
+            {
+                const float multiplier = 1.0f / 0x7fffffff;
+
+                for (int chan = 0; chan < numChans; ++chan)
+                {
+                    float* const d = block.getSampleData (chan);
+
+                    for (int j = 0; j < numSamples; ++j)
+                        d[j] = *reinterpret_cast<int*> (d + j) * multiplier;
+                }
+            }
+        }
+
+        ++numBlocksRead;
+        blockRead.signal();
+    }
+}
+
+void AudioProcessorRenderer::processBlocks()
+{
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        while (numBlocksRead.get() <= i)
+        {
+            if (threadShouldExit())
+                return;
+
+            blockRead.wait (100);
+        }
+
+        if (threadShouldExit())
+            return;
+
+        AudioSampleBuffer& block = getRingBlock (i);
+        AudioSampleBuffer buffer (block.getArrayOfChannels(), block.getNumChannels(), getBlockLength (i));
+        midiMessages.clear();
+
+        {
+            const ScopedLock sl (processor.getCallbackLock());
+
+            if (processor.isSuspended())
+            {
+                buffer.clear();
+            }
+            else
+            {
+                processor.applyQueuedParameterChanges();
+                processor.processBlock (buffer, midiMessages);
+            }
+        }
+
+        ++numBlocksProcessed;
+        blockProcessed.signal();
+    }
+}
+
+void AudioProcessorRenderer::writeBlocks()
+{
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        while (numBlocksProcessed.get() <= i)
+        {
+            if (threadShouldExit())
+                return;
+
+            blockProcessed.wait (100);
+        }
+
+        if (threadShouldExit())
+            return;
+
+        if (! destination.writeFromAudioSampleBuffer (getRingBlock (i), 0, getBlockLength (i)))
+        {
+            writeFailed = true;
+            signalThreadShouldExit();
+            return;
+        }
+
+        ++numBlocksWritten;
+        blockWritten.signal();
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioProcessorRendererTests  : public UnitTest
+{
+public:
+    AudioProcessorRendererTests() : UnitTest ("AudioProcessorRenderer") {}
+
+    // Generates a different, predictable value for each sample of each channel
+    class TestReader  : public AudioFormatReader
+    {
+    public:
+        TestReader (const int numChannels_, const int64 length)  : AudioFormatReader (nullptr, "Test")
+        {
+            sampleRate = 44100.0;
+            bitsPerSample = 32;
+            lengthInSamples = length;
+            numChannels = (unsigned int) numChannels_;
+            usesFloatingPointData = true;
+        }
+
+        static float getSample (const int channel, const int64 position) noexcept
+        {
+            return (float) ((position * 7919 + channel * 104729) % 2001 - 1000) / 1024.0f;
+        }
+
+        bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                          int64 startSampleInFile, int numSamples)
+        {
+            for (int chan = 0; chan < numDestChannels; ++chan)
+            {
+                if (float* const dest = reinterpret_cast<float*> (destSamples[chan]))
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const int64 pos = startSampleInFile + i;
+                        dest [startOffsetInDestBuffer + i] = pos < lengthInSamples ? getSample (chan, pos) : 0.0f;
+                    }
+                }
+            }
+
+            return true;
+        }
+    };
+
+    // Collects the floating-point data that it's given
+    class TestWriter  : public AudioFormatWriter
+    {
+    public:
+        TestWriter (const int numChannels_, const int maxLength)
+            : AudioFormatWriter (nullptr, "Test", 44100.0, (unsigned int) numChannels_, 32),
+              output (numChannels_, maxLength), numWritten (0)
+        {
+            usesFloatingPointData = true;
+            output.clear();
+        }
+
+        bool write (const int** data, int numSamples)
+        {
+            if (numWritten + numSamples > output.getNumSamples())
+                return false;
+
+            for (int chan = 0; chan < output.getNumChannels(); ++chan)
+                output.copyFrom (chan, numWritten, reinterpret_cast<const float*> (data[chan]), numSamples);
+
+            numWritten += numSamples;
+            return true;
+        }
+
+        AudioSampleBuffer output;
+        int numWritten;
+    };
+
+    class GainProcessor  : public AudioProcessor
+    {
+    public:
+        GainProcessor() {}
+
+        const String getName() const                            { return "Gain"; }
+        void prepareToPlay (double, int)                        {}
+        void releaseResources()                                 {}
+
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)
+        {
+            buffer.applyGain (0, 0, buffer.getNumSamples(), 0.5f);
+            buffer.applyGain (1, 0, buffer.getNumSamples(), -2.0f);
+        }
+
+        const String getInputChannelName (int) const            { return String::empty; }
+        const String getOutputChannelName (int) const           { return String::empty; }
+        bool isInputChannelStereoPair (int) const               { return false; }
+        bool isOutputChannelStereoPair (int) const              { return false; }
+        bool silenceInProducesSilenceOut() const                { return true; }
+        bool acceptsMidi() const                                { return false; }
+        bool producesMidi() const                               { return false; }
+        AudioProcessorEditor* createEditor()                    { return nullptr; }
+        bool hasEditor() const                                  { return false; }
+        int getNumParameters()                                  { return 0; }
+        const String getParameterName (int)                     { return String::empty; }
+        float getParameter (int)                                { return 0; }
+        const String getParameterText (int)                     { return String::empty; }
+        void setParameter (int, float)                          {}
+        int getNumPrograms()                                    { return 1; }
+        int getCurrentProgram()                                 { return 0; }
+        void setCurrentProgram (int)                            {}
+        const String getProgramName (int)                       { return String::empty; }
+        void changeProgramName (int, const String&)             {}
+        void getStateInformation (juce::MemoryBlock&)           {}
+        void setStateInformation (const void*, int)             {}
+    };
+
+    void runTest()
+    {
+        beginTest ("Rendered output matches the processor");
+
+        // the render is longer than the source, and isn't a whole number of blocks
+        const int sourceLength = 10000;
+        const int renderLength = 12345;
+
+        GainProcessor processor;
+        TestReader reader (2, sourceLength);
+        TestWriter writer (2, renderLength + 1000);
+
+        AudioProcessorRenderer renderer (processor, &reader, writer, renderLength, 1000);
+        expect (renderer.render());
+        expectEquals (renderer.getNumSamplesRendered(), (int64) renderLength);
+        expectEquals (writer.numWritten, renderLength);
+
+        int numMismatches = 0;
+
+        for (int i = 0; i < renderLength; ++i)
+        {
+            const float expected0 = i < sourceLength ? TestReader::getSample (0, i) * 0.5f : 0.0f;
+            const float expected1 = i < sourceLength ? TestReader::getSample (1, i) * -2.0f : 0.0f;
+
+            if (*writer.output.getSampleData (0, i) != expected0
+                 || *writer.output.getSampleData (1, i) != expected1)
+                ++numMismatches;
+        }
+
+        expectEquals (numMismatches, 0);
+        expect (! processor.isNonRealtime());
+    }
+};
+
+static AudioProcessorRendererTests audioProcessorRendererTests;
+
+#endif
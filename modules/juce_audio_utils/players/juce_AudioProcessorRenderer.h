@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_AUDIOPROCESSORRENDERER_JUCEHEADER__
+#define __JUCE_AUDIOPROCESSORRENDERER_JUCEHEADER__
+
+#include "../../juce_audio_processors/processors/juce_AudioProcessor.h"
+
+
+//==============================================================================
+/**
+    Renders the output of an AudioProcessor into an AudioFormatWriter, as quickly as
+    the processor can run.
+
+    This lets you bounce a processor or an AudioProcessorGraph without needing an
+    audio device. The processor is put into non-realtime mode while it's rendering.
+
+    The work is split between three threads: one reads the input, one runs the
+    processor, and one writes the output. They pass a small ring of blocks between
+    them, so the time spent reading and writing files overlaps with the processing
+    instead of adding to it.
+
+    @code
+    AudioProcessorRenderer renderer (myGraph, nullptr, *myWavWriter, numSamplesToBounce);
+    renderer.startRendering();
+
+    while (! renderer.waitForRenderToFinish (100))
+        updateProgressBar (renderer.getProgress());
+    @endcode
+
+    @see AudioProcessorPlayer, OfflineAudioIODevice
+*/
+class JUCE_API  AudioProcessorRenderer  : private Thread
+{
+public:
+    //==============================================================================
+    /** Creates a renderer.
+
+        @param processor            the processor to render. This isn't deleted by the renderer,
+                                    and it mustn't be used anywhere else while a render is running
+        @param source               a reader to take the processor's input from, or nullptr to
+                                    feed it silence. This isn't deleted by the renderer. If the
+                                    render is longer than the reader, the rest of the input is silent.
+                                    With no reader, the processor keeps its current number of input
+                                    channels
+        @param destination          the writer to send the output to. This isn't deleted by the
+                                    renderer. The processor is prepared with its sample rate and
+                                    number of channels
+        @param numSamplesToRender   the number of samples to render. If this is negative, the
+                                    length of the source is used
+        @param samplesPerBlock      the number of samples passed to each processBlock() call
+    */
+    AudioProcessorRenderer (AudioProcessor& processor,
+                            AudioFormatReader* source,
+                            AudioFormatWriter& destination,
+                            int64 numSamplesToRender = -1,
+                            int samplesPerBlock = 1024);
+
+    /** Destructor.
+        If a render is in progress, it'll be cancelled.
+    */
+    ~AudioProcessorRenderer();
+
+    //==============================================================================
+    /** Starts rendering on a background thread.
+        This returns immediately - use isRendering() or waitForRenderToFinish() to find
+        out when it's done.
+    */
+    void startRendering();
+
+    /** Renders the whole thing, and doesn't return until it has finished.
+        @returns true if all the output was written successfully
+    */
+    bool render();
+
+    /** Stops any render that's in progress, and waits for its threads to finish. */
+    void cancelRendering();
+
+    /** Returns true if a render has been started and hasn't yet finished. */
+    bool isRendering() const;
+
+    /** Blocks until the current render has finished.
+        @param timeOutMilliseconds  the maximum time to wait, or -1 to wait forever
+        @returns true if the render has finished
+    */
+    bool waitForRenderToFinish (int timeOutMilliseconds) const;
+
+    //==============================================================================
+    /** Returns the total number of samples that a render will produce. */
+    int64 getTotalLength() const noexcept                   { return totalLength; }
+
+    /** Returns the number of samples that have been written so far. */
+    int64 getNumSamplesRendered() const noexcept;
+
+    /** Returns the proportion of the render that has been written, from 0 to 1.0 */
+    double getProgress() const noexcept;
+
+    /** Returns true if the last render wrote all its output without being cancelled,
+        and without the writer reporting an error.
+    */
+    bool wasSuccessful() const noexcept;
+
+private:
+    //==============================================================================
+    class StageThread;
+
+    AudioProcessor& processor;
+    AudioFormatReader* const source;
+    AudioFormatWriter& destination;
+    const int64 totalLength;
+    const int blockSize, numBlocks;
+    int numInputChannels;
+
+    OwnedArray<AudioSampleBuffer> ring;
+    MidiBuffer midiMessages;
+    Atomic<int> numBlocksRead, numBlocksProcessed, numBlocksWritten;
+    WaitableEvent blockRead, blockProcessed, blockWritten;
+    volatile bool writeFailed;
+
+    void run();
+    void readBlocks();
+    void processBlocks();
+    void writeBlocks();
+    int getBlockLength (int blockIndex) const noexcept;
+    AudioSampleBuffer& getRingBlock (int blockIndex) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorRenderer)
+};
+
+
+#endif   // __JUCE_AUDIOPROCESSORRENDERER_JUCEHEADER__
@@ -70,6 +70,16 @@ public:
     */
     size_t getSize() const noexcept             { return length; }
 
+    /** Hints to the OS that a region of the file will soon be read.
+
+        This asks the OS to start pulling the given range of the file into memory in the
+        background, so that accessing it later is less likely to block on disk I/O. It
+        returns immediately, and on systems that don't support it, it does nothing.
+
+        @param offset     the position in the mapped data, in bytes
+        @param numBytes   the number of bytes that will be needed
+    */
+    void prefetch (size_t offset, size_t numBytes) const noexcept;
 
 private:
     //==============================================================================
@@ -86,6 +86,12 @@
  #include <android/log.h>
 #endif
 
+#if JUCE_USE_SSE2_INTRINSICS
+ #include <emmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
 
 //==============================================================================
 namespace juce
@@ -110,6 +116,7 @@ namespace juce
 #include "logging/juce_Logger.cpp"
 #include "maths/juce_BigInteger.cpp"
 #include "maths/juce_Expression.cpp"
+#include "maths/juce_FastMaths.cpp"
 #include "maths/juce_Random.cpp"
 #include "memory/juce_MemoryBlock.cpp"
 #include "misc/juce_Result.cpp"
@@ -136,6 +143,7 @@ namespace juce
 #include "text/juce_TextDiff.cpp"
 #include "threads/juce_ChildProcess.cpp"
 #include "threads/juce_ReadWriteLock.cpp"
+#include "threads/juce_RealtimeSafetyChecker.cpp"
 #include "threads/juce_Thread.cpp"
 #include "threads/juce_ThreadPool.cpp"
 #include "threads/juce_TimeSliceThread.cpp"
@@ -198,3 +206,61 @@ namespace juce
 
 #endif
 }
+
+//==============================================================================
+#if JUCE_CHECK_REALTIME_SAFETY
+// These replace the global allocation functions, so that the RealtimeSafetyChecker
+// can see any allocations that are made on a real-time thread.
+void* operator new (size_t size)
+{
+    JUCE_CHECK_REALTIME_SAFETY_VIOLATION (heapAllocation)
+
+    if (void* const p = std::malloc (size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)
+{
+    JUCE_CHECK_REALTIME_SAFETY_VIOLATION (heapAllocation)
+
+    if (void* const p = std::malloc (size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (size_t size, const std::nothrow_t&) throw()
+{
+    JUCE_CHECK_REALTIME_SAFETY_VIOLATION (heapAllocation)
+    return std::malloc (size > 0 ? size : 1);
+}
+
+void* operator new[] (size_t size, const std::nothrow_t&) throw()
+{
+    JUCE_CHECK_REALTIME_SAFETY_VIOLATION (heapAllocation)
+    return std::malloc (size > 0 ? size : 1);
+}
+
+void operator delete (void* p) throw()
+{
+    if (p != nullptr)
+    {
+        JUCE_CHECK_REALTIME_SAFETY_VIOLATION (heapDeallocation)
+        std::free (p);
+    }
+}
+
+void operator delete[] (void* p) throw()
+{
+    if (p != nullptr)
+    {
+        JUCE_CHECK_REALTIME_SAFETY_VIOLATION (heapDeallocation)
+        std::free (p);
+    }
+}
+
+void operator delete (void* p, const std::nothrow_t&) throw()     { operator delete (p); }
+void operator delete[] (void* p, const std::nothrow_t&) throw()   { operator delete[] (p); }
+#endif
@@ -96,6 +96,18 @@ namespace DummyNamespaceStatementToCatchSyntaxErrors {}
  #define JUCE_CHECK_MEMORY_LEAKS 1
 #endif
 
+//=============================================================================
+/** Config: JUCE_CHECK_REALTIME_SAFETY
+
+    Enables the RealtimeSafetyChecker, which watches any threads that are marked as
+    real-time (e.g. the audio callbacks made by an AudioDeviceManager) for memory
+    allocations, lock waits and event waits. This replaces the global operator new
+    and delete, so it's intended for debug and profiling builds only.
+*/
+#ifndef JUCE_CHECK_REALTIME_SAFETY
+ #define JUCE_CHECK_REALTIME_SAFETY 0
+#endif
+
 //=============================================================================
 /** Config: JUCE_DONT_AUTOLINK_TO_WIN32_LIBRARIES
 
@@ -229,6 +241,9 @@ namespace juce
 #ifndef __JUCE_EXPRESSION_JUCEHEADER__
  #include "maths/juce_Expression.h"
 #endif
+#ifndef __JUCE_FASTMATHS_JUCEHEADER__
+ #include "maths/juce_FastMaths.h"
+#endif
 #ifndef __JUCE_MATHSFUNCTIONS_JUCEHEADER__
  #include "maths/juce_MathsFunctions.h"
 #endif
@@ -385,6 +400,9 @@ namespace juce
 #ifndef __JUCE_READWRITELOCK_JUCEHEADER__
  #include "threads/juce_ReadWriteLock.h"
 #endif
+#ifndef __JUCE_REALTIMESAFETYCHECKER_JUCEHEADER__
+ #include "threads/juce_RealtimeSafetyChecker.h"
+#endif
 #ifndef __JUCE_SCOPEDLOCK_JUCEHEADER__
  #include "threads/juce_ScopedLock.h"
 #endif
@@ -0,0 +1,433 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#if JUCE_USE_SSE2_INTRINSICS || JUCE_USE_ARM_NEON
+
+// These mirror the scalar versions in juce_FastMaths.h, four values at a time.
+namespace FastMathsHelpers
+{
+   #if JUCE_USE_SSE2_INTRINSICS
+    typedef __m128  Vec;
+    typedef __m128i IntVec;
+
+    inline Vec load (const float* p) noexcept               { return _mm_loadu_ps (p); }
+    inline void store (float* p, Vec v) noexcept            { _mm_storeu_ps (p, v); }
+    inline Vec dup (float v) noexcept                       { return _mm_set1_ps (v); }
+    inline Vec add (Vec a, Vec b) noexcept                  { return _mm_add_ps (a, b); }
+    inline Vec sub (Vec a, Vec b) noexcept                  { return _mm_sub_ps (a, b); }
+    inline Vec mul (Vec a, Vec b) noexcept                  { return _mm_mul_ps (a, b); }
+    inline Vec div (Vec a, Vec b) noexcept                  { return _mm_div_ps (a, b); }
+    inline Vec min (Vec a, Vec b) noexcept                  { return _mm_min_ps (a, b); }
+    inline Vec max (Vec a, Vec b) noexcept                  { return _mm_max_ps (a, b); }
+    inline Vec greaterThan (Vec a, Vec b) noexcept          { return _mm_cmpgt_ps (a, b); }
+    inline Vec bitAnd (Vec a, Vec b) noexcept               { return _mm_and_ps (a, b); }
+
+    inline IntVec dupInt (int v) noexcept                   { return _mm_set1_epi32 (v); }
+    inline IntVec addInt (IntVec a, IntVec b) noexcept      { return _mm_add_epi32 (a, b); }
+    inline IntVec subInt (IntVec a, IntVec b) noexcept      { return _mm_sub_epi32 (a, b); }
+    inline IntVec andInt (IntVec a, IntVec b) noexcept      { return _mm_and_si128 (a, b); }
+    inline IntVec orInt (IntVec a, IntVec b) noexcept       { return _mm_or_si128 (a, b); }
+    inline IntVec shiftLeft23 (IntVec a) noexcept           { return _mm_slli_epi32 (a, 23); }
+    inline IntVec shiftRight23 (IntVec a) noexcept          { return _mm_srli_epi32 (a, 23); }
+    inline IntVec bitsOf (Vec a) noexcept                   { return _mm_castps_si128 (a); }
+    inline Vec fromBits (IntVec a) noexcept                 { return _mm_castsi128_ps (a); }
+    inline Vec toFloat (IntVec a) noexcept                  { return _mm_cvtepi32_ps (a); }
+
+    inline IntVec floorToInt (Vec a) noexcept
+    {
+        const IntVec n = _mm_cvttps_epi32 (a);
+        // the comparison gives -1 wherever truncation rounded up
+        return _mm_add_epi32 (n, _mm_castps_si128 (_mm_cmpgt_ps (_mm_cvtepi32_ps (n), a)));
+    }
+   #else
+    typedef float32x4_t Vec;
+    typedef int32x4_t   IntVec;
+
+    inline Vec load (const float* p) noexcept               { return vld1q_f32 (p); }
+    inline void store (float* p, Vec v) noexcept            { vst1q_f32 (p, v); }
+    inline Vec dup (float v) noexcept                       { return vdupq_n_f32 (v); }
+    inline Vec add (Vec a, Vec b) noexcept                  { return vaddq_f32 (a, b); }
+    inline Vec sub (Vec a, Vec b) noexcept                  { return vsubq_f32 (a, b); }
+    inline Vec mul (Vec a, Vec b) noexcept                  { return vmulq_f32 (a, b); }
+    inline Vec min (Vec a, Vec b) noexcept                  { return vminq_f32 (a, b); }
+    inline Vec max (Vec a, Vec b) noexcept                  { return vmaxq_f32 (a, b); }
+    inline Vec greaterThan (Vec a, Vec b) noexcept          { return vreinterpretq_f32_u32 (vcgtq_f32 (a, b)); }
+    inline Vec bitAnd (Vec a, Vec b) noexcept               { return vreinterpretq_f32_u32 (vandq_u32 (vreinterpretq_u32_f32 (a), vreinterpretq_u32_f32 (b))); }
+
+    inline Vec div (Vec a, Vec b) noexcept
+    {
+        // NEON has no division, so refine the reciprocal estimate with two Newton-Raphson steps
+        Vec r = vrecpeq_f32 (b);
+        r = vmulq_f32 (vrecpsq_f32 (b, r), r);
+        r = vmulq_f32 (vrecpsq_f32 (b, r), r);
+        return vmulq_f32 (a, r);
+    }
+
+    inline IntVec dupInt (int v) noexcept                   { return vdupq_n_s32 (v); }
+    inline IntVec addInt (IntVec a, IntVec b) noexcept      { return vaddq_s32 (a, b); }
+    inline IntVec subInt (IntVec a, IntVec b) noexcept      { return vsubq_s32 (a, b); }
+    inline IntVec andInt (IntVec a, IntVec b) noexcept      { return vandq_s32 (a, b); }
+    inline IntVec orInt (IntVec a, IntVec b) noexcept       { return vorrq_s32 (a, b); }
+    inline IntVec shiftLeft23 (IntVec a) noexcept           { return vshlq_n_s32 (a, 23); }
+    inline IntVec shiftRight23 (IntVec a) noexcept          { return vreinterpretq_s32_u32 (vshrq_n_u32 (vreinterpretq_u32_s32 (a), 23)); }
+    inline IntVec bitsOf (Vec a) noexcept                   { return vreinterpretq_s32_f32 (a); }
+    inline Vec fromBits (IntVec a) noexcept                 { return vreinterpretq_f32_s32 (a); }
+    inline Vec toFloat (IntVec a) noexcept                  { return vcvtq_f32_s32 (a); }
+
+    inline IntVec floorToInt (Vec a) noexcept
+    {
+        const IntVec n = vcvtq_s32_f32 (a);
+        return vaddq_s32 (n, vreinterpretq_s32_u32 (vcgtq_f32 (vcvtq_f32_s32 (n), a)));
+    }
+   #endif
+
+    //==============================================================================
+    inline Vec reducePhaseVec (const Vec x) noexcept
+    {
+        const Vec n = toFloat (floorToInt (add (mul (x, dup (0.159154943f)), dup (0.5f))));
+        return sub (sub (x, mul (n, dup (6.28125f))), mul (n, dup (1.93530718e-3f)));
+    }
+
+    inline Vec sinPolynomialVec (const Vec t) noexcept
+    {
+        const Vec t2 = mul (t, t);
+        Vec p = add (dup (2.75573192e-6f), mul (t2, dup (-2.50521084e-8f)));
+        p = add (dup (-1.98412698e-4f), mul (t2, p));
+        p = add (dup (8.33333333e-3f), mul (t2, p));
+        p = add (dup (-0.166666667f), mul (t2, p));
+        p = add (dup (1.0f), mul (t2, p));
+        return mul (t, p);
+    }
+
+    inline Vec sinVec (const Vec x) noexcept
+    {
+        Vec t = reducePhaseVec (x);
+        t = min (t, sub (dup (3.14159265f), t));
+        t = max (t, sub (dup (-3.14159265f), t));
+        return sinPolynomialVec (t);
+    }
+
+    inline Vec cosVec (const Vec x) noexcept
+    {
+        const Vec t = reducePhaseVec (x);
+        return sinPolynomialVec (sub (dup (1.57079633f), max (t, sub (dup (0.0f), t))));
+    }
+
+    inline Vec pow2Vec (Vec x) noexcept
+    {
+        x = max (dup (-125.0f), min (dup (126.0f), x));
+        const IntVec n = floorToInt (add (x, dup (0.5f)));
+        const Vec f = sub (x, toFloat (n));
+
+        Vec p = add (dup (1.33335581e-3f), mul (f, dup (1.54035304e-4f)));
+        p = add (dup (9.61812911e-3f), mul (f, p));
+        p = add (dup (5.55041087e-2f), mul (f, p));
+        p = add (dup (0.240226507f), mul (f, p));
+        p = add (dup (0.693147181f), mul (f, p));
+        p = add (dup (1.0f), mul (f, p));
+
+        return fromBits (addInt (bitsOf (p), shiftLeft23 (n)));
+    }
+
+    inline Vec expVec (Vec x) noexcept
+    {
+        x = max (dup (-86.5f), min (dup (87.0f), x));
+        const IntVec n = floorToInt (add (mul (x, dup (1.44269504f)), dup (0.5f)));
+        const Vec nf = toFloat (n);
+        const Vec r = sub (sub (x, mul (nf, dup (0.693145752f))), mul (nf, dup (1.42860682e-6f)));
+
+        Vec p = add (dup (8.33333333e-3f), mul (r, dup (1.38888889e-3f)));
+        p = add (dup (4.16666667e-2f), mul (r, p));
+        p = add (dup (0.166666667f), mul (r, p));
+        p = add (dup (0.5f), mul (r, p));
+        p = add (dup (1.0f), mul (r, p));
+        p = add (dup (1.0f), mul (r, p));
+
+        return fromBits (addInt (bitsOf (p), shiftLeft23 (n)));
+    }
+
+    inline Vec log2Vec (const Vec x) noexcept
+    {
+        const IntVec bits = bitsOf (max (x, dup (1.17549435e-38f)));
+        Vec exponent = toFloat (subInt (andInt (shiftRight23 (bits), dupInt (0xff)), dupInt (127)));
+        Vec m = fromBits (orInt (andInt (bits, dupInt (0x7fffff)), dupInt (0x3f800000)));
+
+        const Vec isLarge = greaterThan (m, dup (1.41421356f));
+        m = sub (m, bitAnd (isLarge, mul (m, dup (0.5f))));
+        exponent = add (exponent, bitAnd (isLarge, dup (1.0f)));
+
+        const Vec one (dup (1.0f));
+        const Vec s = div (sub (m, one), add (m, one));
+        const Vec s2 = mul (s, s);
+        Vec p = add (dup (0.142857143f), mul (s2, dup (0.111111111f)));
+        p = add (dup (0.2f), mul (s2, p));
+        p = add (dup (0.333333333f), mul (s2, p));
+        p = add (one, mul (s2, p));
+
+        return add (exponent, mul (mul (s, p), dup (2.0f * 1.44269504f)));
+    }
+
+    inline Vec tanhVec (const Vec x) noexcept
+    {
+        const Vec e = pow2Vec (mul (max (dup (-9.0f), min (dup (9.0f), x)), dup (2.88539008f)));
+        const Vec one (dup (1.0f));
+        return div (sub (e, one), add (e, one));
+    }
+}
+
+ #define JUCE_FASTMATHS_LOOP(vectorExpression) \
+    for (; numValues >= 4; numValues -= 4, dest += 4, source += 4) \
+    { \
+        using namespace FastMathsHelpers; \
+        const Vec x (load (source)); \
+        store (dest, vectorExpression); \
+    }
+#else
+ #define JUCE_FASTMATHS_LOOP(vectorExpression)
+#endif
+
+//==============================================================================
+void FastMaths::sin (float* dest, const float* source, int numValues) noexcept
+{
+    JUCE_FASTMATHS_LOOP (sinVec (x))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = sin (source[i]);
+}
+
+void FastMaths::cos (float* dest, const float* source, int numValues) noexcept
+{
+    JUCE_FASTMATHS_LOOP (cosVec (x))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = cos (source[i]);
+}
+
+void FastMaths::pow2 (float* dest, const float* source, int numValues) noexcept
+{
+    JUCE_FASTMATHS_LOOP (pow2Vec (x))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = pow2 (source[i]);
+}
+
+void FastMaths::exp (float* dest, const float* source, int numValues) noexcept
+{
+    JUCE_FASTMATHS_LOOP (expVec (x))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = exp (source[i]);
+}
+
+void FastMaths::log2 (float* dest, const float* source, int numValues) noexcept
+{
+    JUCE_FASTMATHS_LOOP (log2Vec (x))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = log2 (source[i]);
+}
+
+void FastMaths::log (float* dest, const float* source, int numValues) noexcept
+{
+    JUCE_FASTMATHS_LOOP (mul (log2Vec (x), dup (0.693147181f)))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = log (source[i]);
+}
+
+void FastMaths::tanh (float* dest, const float* source, int numValues) noexcept
+{
+    JUCE_FASTMATHS_LOOP (tanhVec (x))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = tanh (source[i]);
+}
+
+void FastMaths::decibelsToGain (float* dest, const float* source, int numValues, const float minusInfinityDb) noexcept
+{
+    JUCE_FASTMATHS_LOOP (bitAnd (greaterThan (x, dup (minusInfinityDb)),
+                                 pow2Vec (mul (x, dup (0.166096405f)))))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = decibelsToGain (source[i], minusInfinityDb);
+}
+
+void FastMaths::gainToDecibels (float* dest, const float* source, int numValues, const float minusInfinityDb) noexcept
+{
+    // (log2Vec treats zero as the smallest normalised float, which is far below minusInfinityDb)
+    JUCE_FASTMATHS_LOOP (max (dup (minusInfinityDb),
+                              mul (log2Vec (x), dup (6.02059991f))))
+
+    for (int i = 0; i < numValues; ++i)
+        dest[i] = gainToDecibels (source[i], minusInfinityDb);
+}
+
+#undef JUCE_FASTMATHS_LOOP
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class FastMathsTests  : public UnitTest
+{
+public:
+    FastMathsTests() : UnitTest ("FastMaths") {}
+
+    typedef double (*ReferenceFunction) (double);
+    typedef float (*ScalarFunction) (float);
+    typedef void (*BlockFunction) (float*, const float*, int);
+
+    static double stdSin (double x)     { return std::sin (x); }
+    static double stdCos (double x)     { return std::cos (x); }
+    static double stdPow2 (double x)    { return std::pow (2.0, x); }
+    static double stdExp (double x)     { return std::exp (x); }
+    static double stdLog2 (double x)    { return std::log (x) / std::log (2.0); }
+    static double stdLog (double x)     { return std::log (x); }
+    static double stdTanh (double x)    { return std::tanh (x); }
+
+    // The error is measured relative to the expected value, but never relative to anything smaller
+    // than minimumScale - so a minimumScale of 1.0 gives the absolute error for results below 1.0.
+    // Logarithmic spacing tests every octave of the range equally, rather than mostly the top one.
+    void checkFunction (const char* name, ReferenceFunction reference, ScalarFunction scalar, BlockFunction block,
+                        const float start, const float end, const double minimumScale, const double maxError,
+                        const bool logarithmicSpacing = false)
+    {
+        const int numValues = 100003; // (odd, so that the block version has a tail)
+        HeapBlock<float> input ((size_t) numValues), output ((size_t) numValues);
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            const double proportion = i / (double) (numValues - 1);
+
+            input[i] = logarithmicSpacing ? (float) (start * std::pow (end / (double) start, proportion))
+                                          : (float) (start + (end - start) * proportion);
+        }
+
+        block (output, input, numValues);
+
+        double worstError = 0;
+        int numMismatches = 0;
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            const double expected = reference (input[i]);
+            const double actual = scalar (input[i]);
+            const double error = std::abs (actual - expected) / jmax (minimumScale, std::abs (expected));
+
+            worstError = jmax (worstError, error);
+
+            if (std::abs (output[i] - actual) > std::abs (actual) * 1.0e-6 + 1.0e-7)
+                ++numMismatches;
+        }
+
+        expect (worstError < maxError, String (name) + " error: " + String (worstError));
+        expectEquals (numMismatches, 0);
+
+        // compare the speed of the library function with the scalar and block versions
+        const int numRepeats = 10;
+        volatile float sink = 0;
+        double t1 = Time::getMillisecondCounterHiRes();
+
+        for (int j = 0; j < numRepeats; ++j)
+            for (int i = 0; i < numValues; ++i)
+                output[i] = (float) reference (input[i]);
+
+        double t2 = Time::getMillisecondCounterHiRes();
+        sink = output[numValues / 2];
+
+        for (int j = 0; j < numRepeats; ++j)
+            for (int i = 0; i < numValues; ++i)
+                output[i] = scalar (input[i]);
+
+        double t3 = Time::getMillisecondCounterHiRes();
+        sink = output[numValues / 2];
+
+        for (int j = 0; j < numRepeats; ++j)
+            block (output, input, numValues);
+
+        double t4 = Time::getMillisecondCounterHiRes();
+        sink = output[numValues / 2];
+        (void) sink;
+
+        const double nsPerValue = 1.0e6 / (numRepeats * (double) numValues);
+
+        logMessage (String (name) + ": max error " + String (worstError, 9)
+                     + ", ns per value: std " + String ((t2 - t1) * nsPerValue, 2)
+                     + ", scalar " + String ((t3 - t2) * nsPerValue, 2)
+                     + ", block " + String ((t4 - t3) * nsPerValue, 2));
+    }
+
+    static float scalarSin (float x)    { return FastMaths::sin (x); }
+    static float scalarCos (float x)    { return FastMaths::cos (x); }
+    static float scalarPow2 (float x)   { return FastMaths::pow2 (x); }
+    static float scalarExp (float x)    { return FastMaths::exp (x); }
+    static float scalarLog2 (float x)   { return FastMaths::log2 (x); }
+    static float scalarLog (float x)    { return FastMaths::log (x); }
+    static float scalarTanh (float x)   { return FastMaths::tanh (x); }
+
+    static double stdDecibelsToGain (double x)   { return x > -100.0 ? std::pow (10.0, x * 0.05) : 0.0; }
+    static float scalarDecibelsToGain (float x)  { return FastMaths::decibelsToGain (x); }
+    static void blockDecibelsToGain (float* d, const float* s, int num)  { FastMaths::decibelsToGain (d, s, num); }
+
+    static double stdGainToDecibels (double x)   { return x > 0 ? jmax (-100.0, std::log10 (x) * 20.0) : -100.0; }
+    static float scalarGainToDecibels (float x)  { return FastMaths::gainToDecibels (x); }
+    static void blockGainToDecibels (float* d, const float* s, int num)  { FastMaths::gainToDecibels (d, s, num); }
+
+    void runTest()
+    {
+        beginTest ("Accuracy and speed");
+
+        checkFunction ("sin",  stdSin,  scalarSin,  FastMaths::sin,   -100.0f, 100.0f, 1.0, 3.0e-7);
+        checkFunction ("cos",  stdCos,  scalarCos,  FastMaths::cos,   -100.0f, 100.0f, 1.0, 3.0e-7);
+        checkFunction ("pow2", stdPow2, scalarPow2, FastMaths::pow2,  -120.0f, 120.0f, 0.0, 3.0e-7);
+        checkFunction ("exp",  stdExp,  scalarExp,  FastMaths::exp,   -80.0f,  80.0f,  0.0, 3.0e-7);
+        checkFunction ("log2", stdLog2, scalarLog2, FastMaths::log2,  1.0e-30f, 1.0e30f, 1.0, 2.0e-7, true);
+        checkFunction ("log",  stdLog,  scalarLog,  FastMaths::log,   1.0e-30f, 1.0e30f, 1.0, 2.0e-7, true);
+        checkFunction ("tanh", stdTanh, scalarTanh, FastMaths::tanh,  -10.0f,  10.0f,  1.0, 2.0e-7);
+        checkFunction ("decibelsToGain", stdDecibelsToGain, scalarDecibelsToGain, blockDecibelsToGain, -120.0f, 40.0f, 0.0, 1.0e-6);
+        checkFunction ("gainToDecibels", stdGainToDecibels, scalarGainToDecibels, blockGainToDecibels, 0.0f, 10.0f, 1.0, 3.0e-7);
+
+        beginTest ("Denormals");
+
+        {
+            float input[5] = { 1.0e-40f, 1.0e-45f, 0.0f, 1.17549435e-38f, 1.0e-40f };
+            float output[5];
+
+            FastMaths::log2 (output, input, 5);
+
+            for (int i = 0; i < 5; ++i)
+            {
+                expect (std::abs (FastMaths::log2 (input[i]) + 126.0f) < 1.0e-5f);
+                expect (std::abs (output[i] + 126.0f) < 1.0e-5f);
+            }
+
+            expectEquals (FastMaths::gainToDecibels (1.0e-40f), -100.0f);
+        }
+    }
+};
+
+static FastMathsTests fastMathsTests;
+
+#endif
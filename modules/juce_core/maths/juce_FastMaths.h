@@ -0,0 +1,243 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_FASTMATHS_JUCEHEADER__
+#define __JUCE_FASTMATHS_JUCEHEADER__
+
+#include "juce_MathsFunctions.h"
+
+//==============================================================================
+/**
+    Fast approximations of some common maths functions, for use in DSP code.
+
+    These trade a little accuracy for speed - the worst-case errors are given in the
+    description of each function, and are small enough for most audio purposes.
+    They don't check for NaNs or infinities.
+
+    Each function comes in two forms: an inline version that works on a single value,
+    and a version that processes a whole array at once, which uses SSE2 or NEON
+    instructions where they're available. The array versions can be used in-place,
+    i.e. with the source and destination pointing to the same data.
+
+    @see Decibels
+*/
+class JUCE_API  FastMaths
+{
+public:
+    //==============================================================================
+    /** Returns an approximation of sin (x).
+        The absolute error is less than 3.0e-7 for |x| < 100. It grows slowly for larger
+        arguments, so keep your phase wrapped into a small range if you need accuracy
+        after many cycles.
+    */
+    static inline float sin (const float x) noexcept
+    {
+        float t = reducePhase (x);
+        t = jmin (t, 3.14159265f - t);
+        t = jmax (t, -3.14159265f - t);
+        return sinPolynomial (t);
+    }
+
+    /** Returns an approximation of cos (x), with the same accuracy as sin(). */
+    static inline float cos (const float x) noexcept
+    {
+        return sinPolynomial (1.57079633f - std::abs (reducePhase (x)));
+    }
+
+    /** Returns an approximation of 2 to the power of x.
+        The relative error is less than 3.0e-7. Inputs are clipped to the range -125 to 126.
+    */
+    static inline float pow2 (float x) noexcept
+    {
+        x = jlimit (-125.0f, 126.0f, x);
+        const int n = floorToInt (x + 0.5f);
+        return withExponentAdded (pow2Polynomial (x - (float) n), n);
+    }
+
+    /** Returns an approximation of e to the power of x.
+        The relative error is less than 3.0e-7. Inputs are clipped to the range -86.5 to 87.
+    */
+    static inline float exp (float x) noexcept
+    {
+        x = jlimit (-86.5f, 87.0f, x);
+        const int n = floorToInt (x * 1.44269504f + 0.5f);
+        const float r = (x - (float) n * 0.693145752f) - (float) n * 1.42860682e-6f;
+        return withExponentAdded (expPolynomial (r), n);
+    }
+
+    /** Returns an approximation of the base-2 logarithm of x.
+        The error is less than 2.0e-7, relative to the result or to 1.0, whichever
+        is larger. x must be greater than zero: denormalised values, and zero, are
+        treated as the smallest normalised float (about 1.2e-38), so give -126.
+    */
+    static inline float log2 (const float x) noexcept
+    {
+        float mantissa;
+        // (a denormal's exponent and mantissa can't be split apart like a normal number's)
+        const int exponent = splitMantissa (jmax (x, 1.17549435e-38f), mantissa);
+        return (float) exponent + logPolynomial (mantissa) * 1.44269504f;
+    }
+
+    /** Returns an approximation of the natural logarithm of x.
+        The error is less than 2.0e-7, relative to the result or to 1.0, whichever
+        is larger. As with log2(), x must be greater than zero, and denormalised values
+        are treated as the smallest normalised float.
+    */
+    static inline float log (const float x) noexcept
+    {
+        return log2 (x) * 0.693147181f;
+    }
+
+    /** Returns an approximation of tanh (x).
+        The absolute error is less than 2.0e-7.
+    */
+    static inline float tanh (float x) noexcept
+    {
+        x = jlimit (-9.0f, 9.0f, x);
+        const float e = pow2 (x * 2.88539008f);
+        return (e - 1.0f) / (e + 1.0f);
+    }
+
+    /** Converts a decibel value to a gain factor, like Decibels::decibelsToGain().
+        Anything at or below minusInfinityDb gives a gain of 0. The relative error is
+        less than 1.0e-6 for levels between -120dB and +40dB.
+    */
+    static inline float decibelsToGain (const float decibels, const float minusInfinityDb = -100.0f) noexcept
+    {
+        return decibels > minusInfinityDb ? pow2 (decibels * 0.166096405f) : 0.0f;
+    }
+
+    /** Converts a gain factor to a decibel value, like Decibels::gainToDecibels().
+        Gains which are zero or too small give minusInfinityDb. The error is less
+        than 3.0e-7, relative to the result or to 1dB, whichever is larger.
+    */
+    static inline float gainToDecibels (const float gain, const float minusInfinityDb = -100.0f) noexcept
+    {
+        return gain > 0 ? jmax (minusInfinityDb, log2 (gain) * 6.02059991f)
+                        : minusInfinityDb;
+    }
+
+    //==============================================================================
+    /** Calculates sin() for an array of values. */
+    static void sin (float* dest, const float* source, int numValues) noexcept;
+    /** Calculates cos() for an array of values. */
+    static void cos (float* dest, const float* source, int numValues) noexcept;
+    /** Calculates pow2() for an array of values. */
+    static void pow2 (float* dest, const float* source, int numValues) noexcept;
+    /** Calculates exp() for an array of values. */
+    static void exp (float* dest, const float* source, int numValues) noexcept;
+    /** Calculates log2() for an array of values. */
+    static void log2 (float* dest, const float* source, int numValues) noexcept;
+    /** Calculates log() for an array of values. */
+    static void log (float* dest, const float* source, int numValues) noexcept;
+    /** Calculates tanh() for an array of values. */
+    static void tanh (float* dest, const float* source, int numValues) noexcept;
+    /** Calculates decibelsToGain() for an array of values. */
+    static void decibelsToGain (float* dest, const float* source, int numValues, float minusInfinityDb = -100.0f) noexcept;
+    /** Calculates gainToDecibels() for an array of values. */
+    static void gainToDecibels (float* dest, const float* source, int numValues, float minusInfinityDb = -100.0f) noexcept;
+
+private:
+    //==============================================================================
+    union FloatBits
+    {
+        float asFloat;
+        int32 asInt;
+    };
+
+    static inline int floorToInt (const float x) noexcept
+    {
+        const int n = (int) x;
+        return (float) n > x ? n - 1 : n;
+    }
+
+    static inline float withExponentAdded (const float x, const int exponent) noexcept
+    {
+        FloatBits bits;
+        bits.asFloat = x;
+        bits.asInt += exponent << 23;
+        return bits.asFloat;
+    }
+
+    // splits a positive number into its exponent and a mantissa between sqrt (0.5) and sqrt (2)
+    static inline int splitMantissa (const float x, float& mantissa) noexcept
+    {
+        FloatBits bits;
+        bits.asFloat = x;
+        int exponent = ((bits.asInt >> 23) & 0xff) - 127;
+        bits.asInt = (bits.asInt & 0x7fffff) | 0x3f800000;
+        mantissa = bits.asFloat;
+
+        if (mantissa > 1.41421356f)
+        {
+            mantissa *= 0.5f;
+            ++exponent;
+        }
+
+        return exponent;
+    }
+
+    // Wraps x into the range -pi to pi. 2 pi is split into two parts, so that
+    // subtracting whole cycles is exact for the first part
+    static inline float reducePhase (const float x) noexcept
+    {
+        const float n = (float) floorToInt (x * 0.159154943f + 0.5f);
+        return (x - n * 6.28125f) - n * 1.93530718e-3f;
+    }
+
+    // Taylor series for sin (t), for -pi/2 <= t <= pi/2
+    static inline float sinPolynomial (const float t) noexcept
+    {
+        const float t2 = t * t;
+        return t * (1.0f + t2 * (-0.166666667f + t2 * (8.33333333e-3f + t2 * (-1.98412698e-4f
+                        + t2 * (2.75573192e-6f + t2 * -2.50521084e-8f)))));
+    }
+
+    // Taylor series for 2^f, for -0.5 <= f <= 0.5
+    static inline float pow2Polynomial (const float f) noexcept
+    {
+        return 1.0f + f * (0.693147181f + f * (0.240226507f + f * (5.55041087e-2f
+                        + f * (9.61812911e-3f + f * (1.33335581e-3f + f * 1.54035304e-4f)))));
+    }
+
+    // Taylor series for e^r, for -ln (2) / 2 <= r <= ln (2) / 2
+    static inline float expPolynomial (const float r) noexcept
+    {
+        return 1.0f + r * (1.0f + r * (0.5f + r * (0.166666667f + r * (4.16666667e-2f
+                        + r * (8.33333333e-3f + r * 1.38888889e-3f)))));
+    }
+
+    // ln (m) = 2 * atanh ((m - 1) / (m + 1)), for sqrt (0.5) <= m <= sqrt (2)
+    static inline float logPolynomial (const float m) noexcept
+    {
+        const float s = (m - 1.0f) / (m + 1.0f);
+        const float s2 = s * s;
+        return 2.0f * s * (1.0f + s2 * (0.333333333f + s2 * (0.2f + s2 * (0.142857143f + s2 * 0.111111111f))));
+    }
+};
+
+
+#endif   // __JUCE_FASTMATHS_JUCEHEADER__
@@ -26,6 +26,8 @@
 #ifndef __JUCE_HEAPBLOCK_JUCEHEADER__
 #define __JUCE_HEAPBLOCK_JUCEHEADER__
 
+#include "../threads/juce_RealtimeSafetyChecker.h"
+
 #ifndef DOXYGEN
 namespace HeapBlockHelper
 {
@@ -129,6 +131,7 @@ public:
     */
     ~HeapBlock()
     {
+        checkDeallocation();
         std::free (data);
     }
 
@@ -261,6 +264,7 @@ public:
     */
     void free()
     {
+        checkDeallocation();
         std::free (data);
         data = nullptr;
     }
@@ -290,11 +294,22 @@ private:
     //==============================================================================
     ElementType* data;
 
-    void throwOnAllocationFailure() const
+    JUCE_CALLER_INLINE void throwOnAllocationFailure() const
     {
+        JUCE_CHECK_REALTIME_SAFETY_VIOLATION (heapAllocation)
         HeapBlockHelper::ThrowOnFail<throwOnFailure>::check (data);
     }
 
+    JUCE_CALLER_INLINE void checkDeallocation() const noexcept
+    {
+       #if JUCE_CHECK_REALTIME_SAFETY
+        if (data != nullptr)
+        {
+            JUCE_CHECK_REALTIME_SAFETY_VIOLATION (heapDeallocation)
+        }
+       #endif
+    }
+
    #if ! (defined (JUCE_DLL) || defined (JUCE_DLL_BUILD))
     JUCE_DECLARE_NON_COPYABLE (HeapBlock)
     JUCE_PREVENT_HEAP_ALLOCATION // Creating a 'new HeapBlock' would be missing the point!
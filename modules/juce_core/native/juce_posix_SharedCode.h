@@ -49,6 +49,7 @@ CriticalSection::~CriticalSection() noexcept
 
 void CriticalSection::enter() const noexcept
 {
+    JUCE_CHECK_REALTIME_SAFETY_VIOLATION (lockWait)
     pthread_mutex_lock (&internal);
 }
 
@@ -171,6 +172,11 @@ WaitableEvent::~WaitableEvent() noexcept
 
 bool WaitableEvent::wait (const int timeOutMillisecs) const noexcept
 {
+    if (timeOutMillisecs != 0)
+    {
+        JUCE_CHECK_REALTIME_SAFETY_VIOLATION (eventWait)
+    }
+
     return static_cast <WaitableEventImpl*> (internal)->wait (timeOutMillisecs);
 }
 
@@ -581,6 +587,19 @@ MemoryMappedFile::~MemoryMappedFile()
         close (fileHandle);
 }
 
+void MemoryMappedFile::prefetch (const size_t offset, const size_t numBytes) const noexcept
+{
+    if (address != nullptr && offset < length && numBytes > 0)
+    {
+        // (madvise needs a page-aligned address, but the mapping itself always starts on a page)
+        const size_t pageSize = (size_t) SystemStats::getPageSize();
+        const size_t start = offset - (offset % pageSize);
+        const size_t end = offset + jmin (numBytes, length - offset);
+
+        madvise (static_cast <char*> (address) + start, end - start, MADV_WILLNEED);
+    }
+}
+
 //==============================================================================
 #if JUCE_PROJUCER_LIVE_BUILD
 extern "C" const char* juce_getCurrentExecutablePath();
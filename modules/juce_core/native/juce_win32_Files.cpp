@@ -358,6 +358,30 @@ MemoryMappedFile::~MemoryMappedFile()
         CloseHandle ((HANDLE) fileHandle);
 }
 
+void MemoryMappedFile::prefetch (const size_t offset, const size_t numBytes) const noexcept
+{
+    // PrefetchVirtualMemory only exists in Windows 8 and later, so has to be loaded dynamically..
+    struct MemoryRangeEntry
+    {
+        void* virtualAddress;
+        SIZE_T numberOfBytes;
+    };
+
+    typedef BOOL (WINAPI* PrefetchVirtualMemoryFunc) (HANDLE, ULONG_PTR, MemoryRangeEntry*, ULONG);
+
+    static PrefetchVirtualMemoryFunc prefetchVirtualMemory
+        = (PrefetchVirtualMemoryFunc) GetProcAddress (GetModuleHandleA ("kernel32.dll"), "PrefetchVirtualMemory");
+
+    if (prefetchVirtualMemory != nullptr && address != nullptr && offset < length && numBytes > 0)
+    {
+        MemoryRangeEntry range;
+        range.virtualAddress = static_cast <char*> (address) + offset;
+        range.numberOfBytes = (SIZE_T) jmin (numBytes, length - offset);
+
+        prefetchVirtualMemory (GetCurrentProcess(), 1, &range, 0);
+    }
+}
+
 //==============================================================================
 int64 File::getSize() const
 {
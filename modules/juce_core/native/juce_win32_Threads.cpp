@@ -68,6 +68,7 @@ CriticalSection::~CriticalSection() noexcept
 
 void CriticalSection::enter() const noexcept
 {
+    JUCE_CHECK_REALTIME_SAFETY_VIOLATION (lockWait)
     EnterCriticalSection ((CRITICAL_SECTION*) internal);
 }
 
@@ -94,6 +95,11 @@ WaitableEvent::~WaitableEvent() noexcept
 
 bool WaitableEvent::wait (const int timeOutMillisecs) const noexcept
 {
+    if (timeOutMillisecs != 0)
+    {
+        JUCE_CHECK_REALTIME_SAFETY_VIOLATION (eventWait)
+    }
+
     return WaitForSingleObject (internal, (DWORD) timeOutMillisecs) == WAIT_OBJECT_0;
 }
 
@@ -37,6 +37,7 @@
     - Either JUCE_LITTLE_ENDIAN or JUCE_BIG_ENDIAN.
     - Either JUCE_INTEL or JUCE_PPC
     - Either JUCE_GCC or JUCE_MSVC
+    - JUCE_USE_SSE2_INTRINSICS or JUCE_USE_ARM_NEON, if the target supports them
 */
 
 //==============================================================================
@@ -193,4 +194,13 @@
   #error unknown compiler
 #endif
 
+//==============================================================================
+// SIMD instruction set macros.
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define JUCE_USE_SSE2_INTRINSICS 1
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+  #define JUCE_USE_ARM_NEON 1
+#endif
+
 #endif   // __JUCE_TARGETPLATFORM_JUCEHEADER__
@@ -0,0 +1,322 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#if JUCE_CHECK_REALTIME_SAFETY
+namespace RealtimeSafetyHelpers
+{
+   #if JUCE_MSVC
+    static __declspec (thread) int realtimeDepth = 0;
+    static __declspec (thread) int exemptionDepth = 0;
+   #else
+    static __thread int realtimeDepth = 0;
+    static __thread int exemptionDepth = 0;
+   #endif
+
+    // A fixed-size, open-addressed table of call sites, so that recording a
+    // violation never needs to allocate or lock.
+    struct CallSite
+    {
+        Atomic<pointer_sized_int> address;
+        Atomic<int> counts [RealtimeSafetyChecker::numViolationTypes];
+    };
+
+    enum { numCallSites = 1024 };
+
+    static CallSite callSites [numCallSites];
+    static Atomic<int> totals [RealtimeSafetyChecker::numViolationTypes];
+    static Atomic<int> numUnrecordedCallSites;
+    static Atomic<int> currentMode;
+
+    static String getFunctionName (const pointer_sized_int address)
+    {
+       #if ! JUCE_WINDOWS
+        Dl_info info;
+
+        if (dladdr ((void*) address, &info) != 0 && info.dli_sname != nullptr)
+            return String (info.dli_sname) + " + 0x" + String::toHexString ((int64) (address - (pointer_sized_int) info.dli_saddr));
+       #endif
+
+        return String::empty;
+    }
+}
+#endif
+
+//==============================================================================
+RealtimeSafetyChecker::ScopedRealtimeThread::ScopedRealtimeThread() noexcept
+{
+   #if JUCE_CHECK_REALTIME_SAFETY
+    ++RealtimeSafetyHelpers::realtimeDepth;
+   #endif
+}
+
+RealtimeSafetyChecker::ScopedRealtimeThread::~ScopedRealtimeThread() noexcept
+{
+   #if JUCE_CHECK_REALTIME_SAFETY
+    --RealtimeSafetyHelpers::realtimeDepth;
+   #endif
+}
+
+RealtimeSafetyChecker::ScopedExemption::ScopedExemption() noexcept
+{
+   #if JUCE_CHECK_REALTIME_SAFETY
+    ++RealtimeSafetyHelpers::exemptionDepth;
+   #endif
+}
+
+RealtimeSafetyChecker::ScopedExemption::~ScopedExemption() noexcept
+{
+   #if JUCE_CHECK_REALTIME_SAFETY
+    --RealtimeSafetyHelpers::exemptionDepth;
+   #endif
+}
+
+bool RealtimeSafetyChecker::isCheckingCurrentThread() noexcept
+{
+   #if JUCE_CHECK_REALTIME_SAFETY
+    return RealtimeSafetyHelpers::realtimeDepth > 0
+            && RealtimeSafetyHelpers::exemptionDepth == 0;
+   #else
+    return false;
+   #endif
+}
+
+void RealtimeSafetyChecker::setMode (const Mode newMode) noexcept
+{
+   #if JUCE_CHECK_REALTIME_SAFETY
+    RealtimeSafetyHelpers::currentMode = (int) newMode;
+   #else
+    (void) newMode;
+   #endif
+}
+
+const char* RealtimeSafetyChecker::getViolationTypeName (const ViolationType type) noexcept
+{
+    switch (type)
+    {
+        case heapAllocation:    return "heap allocation";
+        case heapDeallocation:  return "heap deallocation";
+        case lockWait:          return "lock wait";
+        case eventWait:         return "event wait";
+        default:                break;
+    }
+
+    return "";
+}
+
+//==============================================================================
+void RealtimeSafetyChecker::reportViolation (const ViolationType type, const void* const callSite) noexcept
+{
+    jassert (isPositiveAndBelow ((int) type, (int) numViolationTypes));
+
+   #if JUCE_CHECK_REALTIME_SAFETY
+    using namespace RealtimeSafetyHelpers;
+
+    // this stops anything that's done in here from being reported again
+    const ScopedExemption exemption;
+
+    ++totals [type];
+
+    const pointer_sized_int address = (pointer_sized_int) callSite;
+    const int start = (int) ((address >> 2) & (numCallSites - 1));
+
+    for (int i = 0; i < numCallSites; ++i)
+    {
+        CallSite& site = callSites [(start + i) & (numCallSites - 1)];
+
+        if (site.address.get() == 0)
+            site.address.compareAndSetBool (address, 0);
+
+        if (site.address.get() == address)
+        {
+            ++site.counts [type];
+            break;
+        }
+
+        if (i == numCallSites - 1)
+            ++numUnrecordedCallSites;
+    }
+
+    if (currentMode.get() == assertOnViolation)
+    {
+        // Something's been done on a real-time thread that could block it! Have a look
+        // up the stack to see what it was..
+        jassertfalse;
+    }
+   #else
+    (void) type;
+    (void) callSite;
+   #endif
+}
+
+int RealtimeSafetyChecker::getNumViolations (const ViolationType type) noexcept
+{
+   #if JUCE_CHECK_REALTIME_SAFETY
+    if (isPositiveAndBelow ((int) type, (int) numViolationTypes))
+        return RealtimeSafetyHelpers::totals [type].get();
+   #else
+    (void) type;
+   #endif
+
+    return 0;
+}
+
+void RealtimeSafetyChecker::resetViolations() noexcept
+{
+   #if JUCE_CHECK_REALTIME_SAFETY
+    using namespace RealtimeSafetyHelpers;
+
+    for (int i = 0; i < numViolationTypes; ++i)
+        totals[i] = 0;
+
+    for (int i = 0; i < numCallSites; ++i)
+        for (int j = 0; j < numViolationTypes; ++j)
+            callSites[i].counts[j] = 0;
+
+    numUnrecordedCallSites = 0;
+   #endif
+}
+
+String RealtimeSafetyChecker::getReport()
+{
+    const ScopedExemption exemption;
+    String report;
+
+   #if JUCE_CHECK_REALTIME_SAFETY
+    using namespace RealtimeSafetyHelpers;
+
+    for (int i = 0; i < numViolationTypes; ++i)
+        report << getViolationTypeName ((ViolationType) i) << "s: " << totals[i].get() << newLine;
+
+    for (int i = 0; i < numCallSites; ++i)
+    {
+        const CallSite& site = callSites[i];
+        const pointer_sized_int address = site.address.get();
+
+        if (address != 0)
+        {
+            String counts;
+
+            for (int j = 0; j < numViolationTypes; ++j)
+                if (site.counts[j].get() > 0)
+                    counts << "  " << getViolationTypeName ((ViolationType) j) << " x " << site.counts[j].get();
+
+            if (counts.isNotEmpty())
+            {
+                report << "0x" << String::toHexString ((int64) address);
+
+                const String name (getFunctionName (address));
+
+                if (name.isNotEmpty())
+                    report << " (" << name << ")";
+
+                report << ":" << counts << newLine;
+            }
+        }
+    }
+
+    if (numUnrecordedCallSites.get() > 0)
+        report << "(too many call sites - " << numUnrecordedCallSites.get() << " violations weren't recorded)" << newLine;
+   #else
+    report << "JUCE_CHECK_REALTIME_SAFETY is not enabled" << newLine;
+   #endif
+
+    return report;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS && JUCE_CHECK_REALTIME_SAFETY
+
+class RealtimeSafetyCheckerTests  : public UnitTest
+{
+public:
+    RealtimeSafetyCheckerTests() : UnitTest ("RealtimeSafetyChecker") {}
+
+    void runTest()
+    {
+        beginTest ("Violations");
+
+        RealtimeSafetyChecker::resetViolations();
+        CriticalSection lock;
+        Array<int> array;
+
+        array.add (1);
+        { const ScopedLock sl (lock); }
+        expectEquals (RealtimeSafetyChecker::getNumViolations (RealtimeSafetyChecker::heapAllocation), 0);
+
+        bool wasChecking, wasCheckingWhenExempt;
+
+        {
+            // (the expect() calls can't go in here, as they lock the test runner)
+            const RealtimeSafetyChecker::ScopedRealtimeThread realtime;
+            wasChecking = RealtimeSafetyChecker::isCheckingCurrentThread();
+
+            array.ensureStorageAllocated (1000);
+            { const ScopedLock sl (lock); }
+
+            {
+                const RealtimeSafetyChecker::ScopedExemption exemption;
+                wasCheckingWhenExempt = RealtimeSafetyChecker::isCheckingCurrentThread();
+                array.ensureStorageAllocated (2000);
+            }
+        }
+
+        expect (wasChecking);
+        expect (! wasCheckingWhenExempt);
+        expect (! RealtimeSafetyChecker::isCheckingCurrentThread());
+        expectEquals (RealtimeSafetyChecker::getNumViolations (RealtimeSafetyChecker::heapAllocation), 1);
+        expectEquals (RealtimeSafetyChecker::getNumViolations (RealtimeSafetyChecker::lockWait), 1);
+        expect (RealtimeSafetyChecker::getReport().contains ("lock wait x 1"));
+
+        RealtimeSafetyChecker::resetViolations();
+        expectEquals (RealtimeSafetyChecker::getNumViolations (RealtimeSafetyChecker::lockWait), 0);
+
+        beginTest ("Call sites");
+
+        {
+            // each of these should be blamed on the line here, not on the ScopedLock or
+            // HeapBlock code in between, which would lump them together
+            const RealtimeSafetyChecker::ScopedRealtimeThread realtime;
+            HeapBlock<char> block;
+
+            { const ScopedLock sl (lock); }
+            { const ScopedLock sl (lock); }
+            block.malloc (10);
+            block.malloc (20);
+        }
+
+        const String report (RealtimeSafetyChecker::getReport());
+        expectEquals (RealtimeSafetyChecker::getNumViolations (RealtimeSafetyChecker::lockWait), 2);
+        expectEquals (RealtimeSafetyChecker::getNumViolations (RealtimeSafetyChecker::heapAllocation), 2);
+        expect (report.contains ("lock wait x 1") && ! report.contains ("lock wait x 2"));
+        expect (report.contains ("heap allocation x 1") && ! report.contains ("heap allocation x 2"));
+
+        RealtimeSafetyChecker::resetViolations();
+    }
+};
+
+static RealtimeSafetyCheckerTests realtimeSafetyCheckerTests;
+
+#endif
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_REALTIMESAFETYCHECKER_JUCEHEADER__
+#define __JUCE_REALTIMESAFETYCHECKER_JUCEHEADER__
+
+
+//==============================================================================
+/**
+    A debugging aid for catching code that isn't safe to run on an audio thread.
+
+    When the JUCE_CHECK_REALTIME_SAFETY flag is enabled, any code that runs inside a
+    RealtimeSafetyChecker::ScopedRealtimeThread is watched for things that could block
+    the thread: heap allocations and deallocations (through operator new/delete and
+    HeapBlock, which covers Arrays, Strings, MemoryBlocks, etc), entering a
+    CriticalSection, and waiting on a WaitableEvent.
+
+    Each violation is counted against the address of the code that made the call, so
+    that after running some audio you can call getReport() to see where the problems
+    are. Alternatively, use setMode() to trigger an assertion as soon as one happens,
+    so you can see the full stack in the debugger.
+
+    The AudioDeviceManager marks the thread while it's calling its audio callbacks, so
+    any processing code that's run by it (e.g. an AudioProcessorGraph, Synthesiser or
+    plugin) will be checked automatically. You can also mark your own threads, e.g.
+
+    @code
+    void MyHostCallback::process (float** data, int numSamples)
+    {
+        const RealtimeSafetyChecker::ScopedRealtimeThread realtime;
+        myProcessor.processBlock (...);
+    }
+    @endcode
+
+    When JUCE_CHECK_REALTIME_SAFETY is disabled, none of the checks are compiled in, and
+    the scoped marker classes do nothing.
+
+    The flag replaces the global operator new and delete, and relies on the compiler's
+    support for thread-local variables, so it's only intended for debug/profiling builds.
+*/
+class JUCE_API  RealtimeSafetyChecker
+{
+public:
+    //==============================================================================
+    /** The kinds of operation that are watched for. */
+    enum ViolationType
+    {
+        heapAllocation = 0,     /**< Memory was allocated. */
+        heapDeallocation,       /**< Memory was freed. */
+        lockWait,               /**< A CriticalSection was entered. */
+        eventWait,              /**< The thread waited on a WaitableEvent. */
+        numViolationTypes
+    };
+
+    /** What happens when a violation is detected. */
+    enum Mode
+    {
+        countViolations,        /**< Violations are counted, and can be examined with getReport(). */
+        assertOnViolation       /**< Violations are counted, and also trigger a jassertfalse. */
+    };
+
+    //==============================================================================
+    /** Marks the current thread as a real-time thread while this object exists.
+        These can be nested.
+    */
+    class JUCE_API  ScopedRealtimeThread
+    {
+    public:
+        ScopedRealtimeThread() noexcept;
+        ~ScopedRealtimeThread() noexcept;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeThread)
+    };
+
+    /** Suspends the checks for the current thread while this object exists.
+        Use this around code that you know is acceptable, e.g. some lazy one-off
+        initialisation, to keep it out of the report.
+    */
+    class JUCE_API  ScopedExemption
+    {
+    public:
+        ScopedExemption() noexcept;
+        ~ScopedExemption() noexcept;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE (ScopedExemption)
+    };
+
+    //==============================================================================
+    /** Returns true if the current thread is inside a ScopedRealtimeThread, and isn't
+        exempted by a ScopedExemption. This always returns false if JUCE_CHECK_REALTIME_SAFETY
+        isn't enabled.
+    */
+    static bool isCheckingCurrentThread() noexcept;
+
+    /** Records a violation. This is called by the hooks in the library, but you can
+        also call it from your own code if it does something else that could block.
+        @param type       the kind of operation
+        @param callSite   the address of the code that was responsible
+    */
+    static void reportViolation (ViolationType type, const void* callSite) noexcept;
+
+    /** Changes what happens when a violation is detected. */
+    static void setMode (Mode newMode) noexcept;
+
+    //==============================================================================
+    /** Returns the total number of violations of a given type since the last reset. */
+    static int getNumViolations (ViolationType type) noexcept;
+
+    /** Returns a list of the places at which violations have happened, with the number
+        of times each one was hit. Where possible, the call sites are resolved to the
+        names of the functions that contain them.
+    */
+    static String getReport();
+
+    /** Clears all the counters. */
+    static void resetViolations() noexcept;
+
+    /** Returns a name for a type of violation. */
+    static const char* getViolationTypeName (ViolationType type) noexcept;
+};
+
+//==============================================================================
+#if JUCE_CHECK_REALTIME_SAFETY || DOXYGEN
+ // A violation is blamed on the return address of the function that contains the check, so
+ // any small helper that contains one, or that sits between the caller and a function that
+ // does, is declared JUCE_CALLER_INLINE to make sure it gets inlined into its caller. Unlike
+ // forcedinline, GCC and clang honour this even in a debug build (MSVC doesn't inline
+ // anything when optimisation is turned off, so there it can report the helper instead).
+ #if JUCE_MSVC
+  #pragma intrinsic (_ReturnAddress)
+  #define JUCE_CALLER_ADDRESS        _ReturnAddress()
+  #define JUCE_CALLER_INLINE         __forceinline
+ #else
+  #define JUCE_CALLER_ADDRESS        __builtin_return_address (0)
+  #define JUCE_CALLER_INLINE         inline __attribute__ ((always_inline))
+ #endif
+
+ /** This is used by the library to report a real-time violation to the RealtimeSafetyChecker
+     if the current thread is being checked. It does nothing unless JUCE_CHECK_REALTIME_SAFETY
+     is enabled.
+ */
+ #define JUCE_CHECK_REALTIME_SAFETY_VIOLATION(type) \
+    if (juce::RealtimeSafetyChecker::isCheckingCurrentThread()) \
+        juce::RealtimeSafetyChecker::reportViolation (juce::RealtimeSafetyChecker::type, JUCE_CALLER_ADDRESS);
+#else
+ #define JUCE_CHECK_REALTIME_SAFETY_VIOLATION(type)
+ #define JUCE_CALLER_INLINE         inline
+#endif
+
+
+#endif   // __JUCE_REALTIMESAFETYCHECKER_JUCEHEADER__
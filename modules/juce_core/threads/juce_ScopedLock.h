@@ -66,7 +66,7 @@ public:
         otherwise there are no guarantees what will happen! Best just to use it
         as a local stack object, rather than creating one with the new() operator.
     */
-    inline explicit GenericScopedLock (const LockType& lock) noexcept : lock_ (lock)     { lock.enter(); }
+    JUCE_CALLER_INLINE explicit GenericScopedLock (const LockType& lock) noexcept : lock_ (lock)     { lock.enter(); }
 
     /** Destructor.
         The lock will be released when the destructor is called.
@@ -145,7 +145,7 @@ public:
         Make sure this object is created and deleted by the same thread,
         otherwise there are no guarantees what will happen!
     */
-    inline ~GenericScopedUnlock() noexcept                                               { lock_.enter(); }
+    JUCE_CALLER_INLINE ~GenericScopedUnlock() noexcept                                               { lock_.enter(); }
 
 
 private:
@@ -79,6 +79,9 @@ public:
     /** Provides the type of scoped unlocker to use with a SpinLock. */
     typedef GenericScopedUnlock <SpinLock>     ScopedUnlockType;
 
+    /** Provides the type of scoped try-locker to use with a SpinLock. */
+    typedef GenericScopedTryLock <SpinLock>    ScopedTryLockType;
+
 private:
     //==============================================================================
     mutable Atomic<int> lock;